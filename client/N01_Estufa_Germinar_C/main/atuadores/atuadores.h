@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <driver/rmt_tx.h>  // Atualizado para a nova API
 #include <led_strip.h>
 
@@ -13,6 +14,10 @@ extern "C" {
 #define LED_STRIP_PIN 16
 #define LED_STRIP_NUM_LEDS 1
 
+// Saídas de relé do controle local (nível alto = ligado)
+#define ATUADORES_N_SAIDAS 4
+#define ATUADORES_GPIO_SAIDAS { 27, 14, 13, 23 }
+
 /**
  * @brief Inicializa todos os atuadores do sistema
  */
@@ -26,6 +31,17 @@ void atuadores_init(void);
  */
 void led_set_color(uint8_t red, uint8_t green, uint8_t blue);
 
+/**
+ * @brief Aplica o estado das saídas de relé
+ * @param mascara Bit n = saída n ligada
+ */
+void atuadores_saidas_set(uint32_t mascara);
+
+/**
+ * @brief Estado atual das saídas de relé (bit n = saída n)
+ */
+uint32_t atuadores_saidas_get(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
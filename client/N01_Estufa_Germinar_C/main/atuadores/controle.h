@@ -0,0 +1,83 @@
+#ifndef CONTROLE_H
+#define CONTROLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================
+ * Controle local por histerese
+ * ============================================================
+ * Cada regra liga uma saída quando um canal da amostra passa do
+ * limite "liga" e só desliga ao voltar além de "desliga", com tempos
+ * mínimos ligado/desligado para não ciclar o relé. Várias regras na
+ * mesma saída combinam em OU.
+ *
+ * Os valores são os canais em ponto fixo (sensores_valores_canais).
+ * Com o canal de entrada sem leitura válida a regra mantém o estado
+ * por até CONTROLE_FALHAS_MAX amostras seguidas; depois desliga (sem
+ * esperar o mínimo ligado: a entrada é desconhecida).
+ *
+ * Sem dependência do ESP-IDF: o tempo vem do chamador.
+ */
+
+#define CONTROLE_REGRAS_MAX  8
+#define CONTROLE_SAIDAS_MAX  8
+#define CONTROLE_FALHAS_MAX  3
+
+typedef enum {
+    CONTROLE_ACIMA = 0,   // liga com valor >= liga, desliga com valor <= desliga
+    CONTROLE_ABAIXO,      // liga com valor <= liga, desliga com valor >= desliga
+} controle_sentido_t;
+
+typedef struct {
+    uint8_t  canal;
+    uint8_t  saida;
+    uint8_t  sentido;
+    int32_t  liga;
+    int32_t  desliga;
+    uint32_t min_ligado_ms;
+    uint32_t min_desligado_ms;
+} controle_regra_t;
+
+typedef struct {
+    uint8_t n_regras;
+    controle_regra_t regras[CONTROLE_REGRAS_MAX];
+} controle_config_t;
+
+typedef struct {
+    controle_config_t cfg;
+    bool     ligada[CONTROLE_REGRAS_MAX];
+    bool     iniciada[CONTROLE_REGRAS_MAX];   // já mudou de estado ao menos uma vez
+    int64_t  mudou_ms[CONTROLE_REGRAS_MAX];
+    uint8_t  falhas[CONTROLE_REGRAS_MAX];     // amostras seguidas sem leitura do canal
+    uint32_t saidas;                          // máscara da última avaliação
+    uint32_t saidas_iniciadas;                // saídas que já mudaram de estado
+    int64_t  saida_mudou_ms[CONTROLE_SAIDAS_MAX];
+    int64_t  retida_ate_ms[CONTROLE_SAIDAS_MAX];  // mínimo ligado de regra removida
+} controle_t;
+
+void controle_init(controle_t *c, const controle_config_t *cfg);
+
+/**
+ * @brief Troca as regras sem reiniciar o relé.
+ *
+ * Regra com o mesmo canal, saída e sentido de uma anterior herda o estado
+ * dela (limites e tempos podem mudar). Regra nova começa no estado atual
+ * da saída, contando os mínimos da última mudança da saída. Saída ligada
+ * por regra removida fica ligada até cumprir o min_ligado_ms dela.
+ */
+void controle_configurar(controle_t *c, const controle_config_t *cfg);
+
+/**
+ * @brief Checa a coerência da regra (histerese no sentido certo, índices).
+ */
+bool controle_regra_valida(const controle_regra_t *r, int n_canais, int n_saidas);
+
+/**
+ * @brief Avalia as regras com a amostra atual.
+ * @param validos  bit i = valores[i] veio de uma leitura válida
+ * @return Máscara de bits das saídas que devem ficar ligadas
+ */
+uint32_t controle_avaliar(controle_t *c, const int32_t *valores, uint32_t validos, int64_t agora_ms);
+
+#endif // CONTROLE_H
@@ -1,29 +1,142 @@
 #include "conexoes.h"
+#include <string.h>
 #include "config.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
+#include "esp_mac.h"
 #include "mqtt_client.h"
+#include "mqtt_em_voo.h"
+#include "esp_transport_ws.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 
 #define MAX_RETRY 5
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT BIT1
+#define MQTT_PUBACK_TIMEOUT_MS 30000
+#define MQTT_ASSINATURAS_MAX 4
+
+// Reconexão: primeiro direto no canal/BSSID salvos, varredura só como fallback
+#define WIFI_TENTATIVAS_DIRETAS 2
+#define WIFI_BACKOFF_MIN_MS     1000
+#define WIFI_BACKOFF_MAX_MS     60000
+#define WIFI_NVS_NAMESPACE      "wifi"
+#define WIFI_NVS_CHAVE          "ap"
 
 
 static const char *TAG_WIFI = "WiFi";
 static const char *TAG_MQTT = "MQTT";
 
-static EventGroupHandle_t s_wifi_event_group;
+// Último AP em que a conexão funcionou (NVS)
+typedef struct {
+    uint8_t canal;
+    uint8_t bssid[6];
+} wifi_ap_cache_t;
+
 static int s_retry_num = 0;
 static esp_mqtt_client_handle_t client = NULL;
 static bool mqtt_conectado = false;
+static mqtt_em_voo_t em_voo;
+static SemaphoreHandle_t em_voo_mutex = NULL;
+static esp_timer_handle_t expira_timer = NULL;
+
+static wifi_config_t wifi_config;
+static wifi_ap_cache_t ap_cache;
+static bool ap_cache_valido = false;
+static bool modo_direto = false;
+static int falhas_diretas = 0;
+static uint32_t backoff_ms = WIFI_BACKOFF_MIN_MS;
+static esp_timer_handle_t reconexao_timer = NULL;
+static bool wifi_conectado = false;
+static int64_t inicio_conexao_us = 0;
+static const char *motivo_conexao = "boot";
+static conexao_evento_cb_t evento_cb = NULL;
+
+typedef struct {
+    const char *topico;
+    conexao_mqtt_msg_cb_t cb;
+} assinatura_t;
+
+static assinatura_t assinaturas[MQTT_ASSINATURAS_MAX];
+static int n_assinaturas = 0;
+
+static void notificar(conexao_evento_t evento)
+{
+    if (evento_cb) {
+        evento_cb(evento);
+    }
+}
+
+void conexao_set_evento_cb(conexao_evento_cb_t cb)
+{
+    evento_cb = cb;
+}
 
 // ======== WIFI ========
 
+static void carregar_ap_cache(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    size_t len = sizeof(ap_cache);
+    ap_cache_valido = (nvs_get_blob(handle, WIFI_NVS_CHAVE, &ap_cache, &len) == ESP_OK &&
+                       len == sizeof(ap_cache) && ap_cache.canal >= 1 && ap_cache.canal <= 14);
+    nvs_close(handle);
+}
+
+static void salvar_ap_cache(const wifi_ap_record_t *ap)
+{
+    // Só grava quando o AP muda, para não gastar a flash a cada reconexão
+    if (ap_cache_valido && ap_cache.canal == ap->primary &&
+        memcmp(ap_cache.bssid, ap->bssid, sizeof(ap_cache.bssid)) == 0) {
+        return;
+    }
+    ap_cache.canal = ap->primary;
+    memcpy(ap_cache.bssid, ap->bssid, sizeof(ap_cache.bssid));
+    ap_cache_valido = true;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, WIFI_NVS_CHAVE, &ap_cache, sizeof(ap_cache));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_WIFI, "Erro salvando AP no NVS (%s)", esp_err_to_name(err));
+    }
+}
+
+// Conexão direta no canal/BSSID salvos ou varredura completa
+static void configurar_modo(bool direto)
+{
+    modo_direto = direto && ap_cache_valido;
+    if (modo_direto) {
+        wifi_config.sta.channel = ap_cache.canal;
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, ap_cache.bssid, sizeof(ap_cache.bssid));
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_config.sta.channel = 0;
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+}
+
+static void reconexao_timer_cb(void *arg)
+{
+    esp_wifi_connect();
+}
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data)
 {
@@ -33,37 +146,103 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         wifi_event_sta_disconnected_t* discon = (wifi_event_sta_disconnected_t*) event_data;
         ESP_LOGW(TAG_WIFI, "Desconectado. Motivo: %d", discon->reason);
 
-        if (s_retry_num < MAX_RETRY) {
+        if (wifi_conectado) {
+            // Queda do AP: reconecta direto, sem esperar
+            wifi_conectado = false;
+            inicio_conexao_us = esp_timer_get_time();
+            motivo_conexao = "queda";
+            falhas_diretas = 0;
+            backoff_ms = WIFI_BACKOFF_MIN_MS;
+            configurar_modo(true);
             esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG_WIFI, "Tentando reconectar ao Wi-Fi...");
-        } else {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+            notificar(CONEXAO_EVT_WIFI_CAIU);
+            return;
+        }
+
+        if (modo_direto) {
+            falhas_diretas++;
+            if (falhas_diretas < WIFI_TENTATIVAS_DIRETAS && discon->reason != WIFI_REASON_NO_AP_FOUND) {
+                esp_wifi_connect();
+                return;
+            }
+            ESP_LOGI(TAG_WIFI, "AP salvo não respondeu, voltando à varredura completa");
+            configurar_modo(false);
+        }
+
+        s_retry_num++;
+        if (s_retry_num == MAX_RETRY) {
+            // Só avisa; as tentativas continuam com backoff
             ESP_LOGE(TAG_WIFI, "Falha ao conectar ao Wi-Fi");
         }
+        ESP_LOGI(TAG_WIFI, "Tentando reconectar ao Wi-Fi em %lu ms...", (unsigned long)backoff_ms);
+        esp_timer_start_once(reconexao_timer, (uint64_t)backoff_ms * 1000);
+        backoff_ms = (backoff_ms * 2 > WIFI_BACKOFF_MAX_MS) ? WIFI_BACKOFF_MAX_MS : backoff_ms * 2;
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG_WIFI, "Conectado! IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        ESP_LOGI(TAG_WIFI, "Tempo até conectar (%s): %lld ms, %s, %d falhas",
+                 motivo_conexao, (long long)((esp_timer_get_time() - inicio_conexao_us) / 1000),
+                 modo_direto ? "direto no AP salvo" : "com varredura",
+                 s_retry_num + falhas_diretas);
+
+        wifi_ap_record_t ap;
+        if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+            salvar_ap_cache(&ap);
+        }
+        wifi_conectado = true;
         s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        falhas_diretas = 0;
+        backoff_ms = WIFI_BACKOFF_MIN_MS;
+        notificar(CONEXAO_EVT_WIFI_IP);
     }
 }
 
+#if WIFI_IP_ESTATICO
+// IP fixo: dispensa o DHCP em cada conexão
+static void configurar_ip_estatico(esp_netif_t *netif)
+{
+    esp_netif_ip_info_t ip_info = {0};
+    esp_netif_str_to_ip4(WIFI_IP, &ip_info.ip);
+    esp_netif_str_to_ip4(WIFI_MASCARA, &ip_info.netmask);
+    esp_netif_str_to_ip4(WIFI_GATEWAY, &ip_info.gw);
+
+    esp_netif_dns_info_t dns = {0};
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    esp_netif_str_to_ip4(WIFI_DNS, &dns.ip.u_addr.ip4);
+
+    esp_netif_dhcpc_stop(netif);
+    esp_netif_set_ip_info(netif, &ip_info);
+    esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns);
+    ESP_LOGI(TAG_WIFI, "IP estático %s", WIFI_IP);
+}
+#endif
+
 void conexao_wifi_init(void)
 {
-    s_wifi_event_group = xEventGroupCreate();
+    inicio_conexao_us = esp_timer_get_time();
 
     esp_netif_init();
     esp_event_loop_create_default();
-    esp_netif_create_default_wifi_sta();
+    esp_netif_t *netif = esp_netif_create_default_wifi_sta();
+#if WIFI_IP_ESTATICO
+    configurar_ip_estatico(netif);
+#else
+    (void)netif;
+#endif
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     esp_wifi_init(&cfg);
 
+    const esp_timer_create_args_t timer_args = {
+        .callback = reconexao_timer_cb,
+        .name = "wifi_reconexao",
+    };
+    esp_timer_create(&timer_args, &reconexao_timer);
+
     esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, NULL);
     esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL, NULL);
 
-    wifi_config_t wifi_config = {
+    wifi_config = (wifi_config_t) {
         .sta = {
             .ssid = WIFI_SSID,
             .password = WIFI_PASS,
@@ -75,24 +254,20 @@ void conexao_wifi_init(void)
         },
     };
 
+    carregar_ap_cache();
+    if (ap_cache_valido) {
+        ESP_LOGI(TAG_WIFI, "AP salvo: canal %d, BSSID " MACSTR, ap_cache.canal, MAC2STR(ap_cache.bssid));
+    }
+
     esp_wifi_set_mode(WIFI_MODE_STA);
-    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    // A config muda a cada troca direto/varredura: mantém só em RAM
+    esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    configurar_modo(true);
     esp_wifi_start();
     esp_wifi_set_ps(WIFI_PS_NONE);
 
+    // Não bloqueia: o resultado chega por conexao_set_evento_cb
     ESP_LOGI(TAG_WIFI, "Wi-Fi inicializado. Conectando...");
-
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-                                           WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-                                           pdFALSE,
-                                           pdFALSE,
-                                           portMAX_DELAY);
-
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG_WIFI, "Conectado ao Wi-Fi com sucesso");
-    } else {
-        ESP_LOGE(TAG_WIFI, "Falha ao conectar ao Wi-Fi");
-    }
 }
 
 bool conexao_wifi_is_connected(void)
@@ -103,18 +278,54 @@ bool conexao_wifi_is_connected(void)
 
 // ======== MQTT ========
 
+static void tratar_mensagem(esp_mqtt_event_handle_t event)
+{
+    // Só mensagens inteiras: as de configuração são pequenas
+    if (event->current_data_offset != 0 || event->data_len != event->total_data_len) {
+        ESP_LOGW(TAG_MQTT, "Mensagem fragmentada ignorada (%d bytes)", event->total_data_len);
+        return;
+    }
+    for (int i = 0; i < n_assinaturas; i++) {
+        if ((int)strlen(assinaturas[i].topico) == event->topic_len &&
+            memcmp(assinaturas[i].topico, event->topic, event->topic_len) == 0) {
+            assinaturas[i].cb(event->data, event->data_len);
+        }
+    }
+}
+
 static void mqtt_event_handler_cb(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
     esp_mqtt_event_handle_t event = event_data;
+    mqtt_em_voo_resultado_t res[MQTT_EM_VOO_MAX];
+    int n;
 
     switch (event->event_id) {
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG_MQTT, "Conectado ao broker MQTT!");
             mqtt_conectado = true;
+            for (int i = 0; i < n_assinaturas; i++) {
+                esp_mqtt_client_subscribe(client, assinaturas[i].topico, 1);
+            }
+            notificar(CONEXAO_EVT_MQTT_CONECTADO);
             break;
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG_MQTT, "Desconectado do MQTT");
             mqtt_conectado = false;
+            xSemaphoreTake(em_voo_mutex, portMAX_DELAY);
+            n = mqtt_em_voo_falhar_todos(&em_voo, res);
+            xSemaphoreGive(em_voo_mutex);
+            mqtt_em_voo_entregar(res, n);
+            notificar(CONEXAO_EVT_MQTT_CAIU);
+            break;
+        case MQTT_EVENT_PUBLISHED:
+            ESP_LOGD(TAG_MQTT, "PUBACK (id=%d)", event->msg_id);
+            xSemaphoreTake(em_voo_mutex, portMAX_DELAY);
+            n = mqtt_em_voo_ack(&em_voo, event->msg_id, esp_timer_get_time(), res);
+            xSemaphoreGive(em_voo_mutex);
+            mqtt_em_voo_entregar(res, n);
+            break;
+        case MQTT_EVENT_DATA:
+            tratar_mensagem(event);
             break;
         case MQTT_EVENT_ERROR:
             ESP_LOGE(TAG_MQTT, "Erro no MQTT");
@@ -124,10 +335,43 @@ static void mqtt_event_handler_cb(void *handler_args, esp_event_base_t base, int
     }
 }
 
+static void expira_timer_cb(void *arg)
+{
+    mqtt_em_voo_resultado_t res[MQTT_EM_VOO_MAX];
+    xSemaphoreTake(em_voo_mutex, portMAX_DELAY);
+    int n = mqtt_em_voo_expirar(&em_voo, esp_timer_get_time(), res);
+    xSemaphoreGive(em_voo_mutex);
+    mqtt_em_voo_entregar(res, n);
+}
+
 // Declaração do certificado embutido (fora da função)
 extern const uint8_t greense_cert_pem_start[] asm("_binary_greense_cert_pem_start");
 extern const uint8_t greense_cert_pem_end[]   asm("_binary_greense_cert_pem_end");
 
+// WebSocket sobre o transporte TLS que guarda a sessão entre reconexões
+static esp_transport_handle_t criar_transporte(void)
+{
+    const tls_sessao_config_t tls_cfg = {
+        .cacert = (const char *)greense_cert_pem_start,
+        .cacert_len = greense_cert_pem_end - greense_cert_pem_start,
+        .tcp_keepalive_s = MQTT_TCP_KEEPALIVE_S,
+        .tcp_intervalo_s = MQTT_TCP_INTERVALO_S,
+        .tcp_sondas = MQTT_TCP_SONDAS,
+    };
+    esp_transport_handle_t tls = tls_sessao_transporte(&tls_cfg);
+    if (tls == NULL) {
+        return NULL;
+    }
+    esp_transport_handle_t ws = esp_transport_ws_init(tls);
+    if (ws == NULL) {
+        esp_transport_destroy(tls);
+        return NULL;
+    }
+    esp_transport_ws_set_subprotocol(ws, "mqtt");
+    esp_transport_set_default_port(ws, 443);
+    return ws;
+}
+
 void conexao_mqtt_start(void)
 {
     esp_mqtt_client_config_t mqtt_cfg = {
@@ -135,17 +379,34 @@ void conexao_mqtt_start(void)
             .address = {
                 .uri = "wss://" MQTT_BROKER,
             },
-            .verification = {
-                .certificate = (const char *)greense_cert_pem_start,
-            },
         },
         .credentials = {
             .client_id = MQTT_CLIENT_ID,
         },
         .session = {
             .keepalive = MQTT_KEEPALIVE,
-        }
+        },
+        .network = {
+            .transport = criar_transporte(),
+            .timeout_ms = MQTT_TIMEOUT_REDE_MS,
+            .reconnect_timeout_ms = MQTT_RECONEXAO_MS,
+        },
+    };
+    if (mqtt_cfg.network.transport == NULL) {
+        // Sem memória para o transporte próprio: segue com o do esp-mqtt, sem retomada
+        ESP_LOGW(TAG_MQTT, "Transporte TLS próprio indisponível, usando o padrão");
+        mqtt_cfg.broker.verification.certificate = (const char *)greense_cert_pem_start;
+    }
+
+    em_voo_mutex = xSemaphoreCreateMutex();
+    mqtt_em_voo_init(&em_voo, (int64_t)MQTT_PUBACK_TIMEOUT_MS * 1000);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = expira_timer_cb,
+        .name = "mqtt_expira",
     };
+    esp_timer_create(&timer_args, &expira_timer);
+    esp_timer_start_periodic(expira_timer, 1000 * 1000);
 
     client = esp_mqtt_client_init(&mqtt_cfg);
     esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler_cb, NULL);
@@ -162,14 +423,81 @@ bool conexao_mqtt_is_connected(void)
     return mqtt_conectado;
 }
 
+void conexao_mqtt_assinar(const char *topic, conexao_mqtt_msg_cb_t cb)
+{
+    if (n_assinaturas == MQTT_ASSINATURAS_MAX) {
+        ESP_LOGE(TAG_MQTT, "Limite de assinaturas atingido: %s", topic);
+        return;
+    }
+    assinaturas[n_assinaturas].topico = topic;
+    assinaturas[n_assinaturas].cb = cb;
+    n_assinaturas++;
+}
+
+void conexao_mqtt_reconectar(void)
+{
+    // Sem isso o esp-mqtt só tenta de novo no próximo reconnect_timeout
+    if (client && !mqtt_conectado) {
+        esp_mqtt_client_reconnect(client);
+    }
+}
+
 bool conexao_mqtt_publish(const char *topic, const char *message)
 {
-    if (mqtt_conectado && client) {
-        int msg_id = esp_mqtt_client_publish(client, topic, message, 0, 1, 0);
-        ESP_LOGI(TAG_MQTT, "Publicado (id=%d): %s -> %s", msg_id, topic, message);
-        return msg_id != -1;
+    conexao_pub_handle_t h = conexao_mqtt_publish_async(topic, message, 0, NULL, NULL);
+    if (h > 0) {
+        ESP_LOGI(TAG_MQTT, "Publicado (handle=%ld): %s -> %s", (long)h, topic, message);
+        return true;
+    }
+    ESP_LOGW(TAG_MQTT, "Publicação recusada (%s): %s",
+             h == CONEXAO_PUB_CHEIO ? "muitas em voo" : "MQTT não conectado", topic);
+    return false;
+}
+
+conexao_pub_handle_t conexao_mqtt_publish_async(const char *topic, const void *data, int len,
+                                                conexao_mqtt_resultado_cb_t cb, void *ctx)
+{
+    if (!mqtt_conectado || !client) {
+        return CONEXAO_PUB_DESCONECTADO;
+    }
+
+    // Reserva antes do publish: o PUBACK pode chegar antes do retorno
+    xSemaphoreTake(em_voo_mutex, portMAX_DELAY);
+    int32_t h = mqtt_em_voo_reservar(&em_voo, cb, ctx, esp_timer_get_time());
+    xSemaphoreGive(em_voo_mutex);
+    if (h < 0) {
+        return CONEXAO_PUB_CHEIO;
+    }
+
+    int msg_id = esp_mqtt_client_publish(client, topic, data, len, 1, 0);
+
+    // Uma desconexão durante o publish já falhou a entrada (e avisou o callback)
+    mqtt_em_voo_resultado_t res;
+    int n = -1;
+    xSemaphoreTake(em_voo_mutex, portMAX_DELAY);
+    if (msg_id < 0) {
+        mqtt_em_voo_cancelar(&em_voo, h);
     } else {
-        ESP_LOGW(TAG_MQTT, "MQTT não conectado ou cliente nulo");
-        return false;
+        n = mqtt_em_voo_associar(&em_voo, h, msg_id, esp_timer_get_time(), &res);
     }
+    xSemaphoreGive(em_voo_mutex);
+    mqtt_em_voo_entregar(&res, n);
+
+    return (n < 0) ? CONEXAO_PUB_DESCONECTADO : h;
+}
+
+void conexao_mqtt_get_stats(mqtt_em_voo_stats_t *stats)
+{
+    if (em_voo_mutex == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(em_voo_mutex, portMAX_DELAY);
+    mqtt_em_voo_get_stats(&em_voo, stats);
+    xSemaphoreGive(em_voo_mutex);
+}
+
+void conexao_tls_get_stats(tls_sessao_stats_t *stats)
+{
+    tls_sessao_get_stats(stats);
 }
@@ -0,0 +1,181 @@
+#include "mqtt_em_voo.h"
+#include <string.h>
+#include <stdlib.h>
+
+static mqtt_em_voo_entrada_t *buscar_handle(mqtt_em_voo_t *t, int32_t handle)
+{
+    for (int i = 0; i < MQTT_EM_VOO_MAX; i++) {
+        if (handle > 0 && t->tab[i].handle == handle) {
+            return &t->tab[i];
+        }
+    }
+    return NULL;
+}
+
+static mqtt_em_voo_entrada_t *buscar_msg_id(mqtt_em_voo_t *t, int msg_id)
+{
+    for (int i = 0; i < MQTT_EM_VOO_MAX; i++) {
+        if (t->tab[i].handle != 0 && t->tab[i].msg_id == msg_id) {
+            return &t->tab[i];
+        }
+    }
+    return NULL;
+}
+
+static void concluir(mqtt_em_voo_t *t, mqtt_em_voo_entrada_t *e, bool confirmada, int64_t agora_us,
+                     mqtt_em_voo_resultado_t *res)
+{
+    res->handle = e->handle;
+    res->confirmada = confirmada;
+    res->cb = e->cb;
+    res->ctx = e->ctx;
+
+    if (confirmada) {
+        int64_t lat_ms = (agora_us - e->enviado_us) / 1000;
+        t->lat_ms[t->n_lat % MQTT_EM_VOO_LATENCIAS] = (lat_ms < 0) ? 0 : (uint32_t)lat_ms;
+        t->n_lat++;
+        t->stats.confirmadas++;
+    } else {
+        t->stats.perdidas++;
+    }
+
+    memset(e, 0, sizeof(*e));
+    t->stats.em_voo--;
+}
+
+void mqtt_em_voo_init(mqtt_em_voo_t *t, int64_t timeout_us)
+{
+    memset(t, 0, sizeof(*t));
+    t->proximo_handle = 1;
+    t->timeout_us = timeout_us;
+}
+
+int32_t mqtt_em_voo_reservar(mqtt_em_voo_t *t, mqtt_em_voo_cb_t cb, void *ctx, int64_t agora_us)
+{
+    for (int i = 0; i < MQTT_EM_VOO_MAX; i++) {
+        mqtt_em_voo_entrada_t *e = &t->tab[i];
+        if (e->handle != 0) {
+            continue;
+        }
+        e->handle = t->proximo_handle;
+        e->msg_id = -1;
+        e->enviado_us = agora_us;
+        e->cb = cb;
+        e->ctx = ctx;
+        t->proximo_handle = (t->proximo_handle == INT32_MAX) ? 1 : t->proximo_handle + 1;
+        t->stats.em_voo++;
+        return e->handle;
+    }
+    t->stats.recusadas++;
+    return -1;
+}
+
+int mqtt_em_voo_associar(mqtt_em_voo_t *t, int32_t handle, int msg_id, int64_t agora_us,
+                         mqtt_em_voo_resultado_t *res)
+{
+    mqtt_em_voo_entrada_t *e = buscar_handle(t, handle);
+    if (e == NULL) {
+        return -1;
+    }
+    e->msg_id = msg_id;
+    t->stats.publicadas++;
+
+    // PUBACK chegou antes da associação
+    for (int i = 0; i < t->n_orfaos; i++) {
+        if (t->orfaos[i] == msg_id) {
+            t->orfaos[i] = t->orfaos[--t->n_orfaos];
+            concluir(t, e, true, agora_us, res);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void mqtt_em_voo_cancelar(mqtt_em_voo_t *t, int32_t handle)
+{
+    mqtt_em_voo_entrada_t *e = buscar_handle(t, handle);
+    if (e == NULL) {
+        return;
+    }
+    memset(e, 0, sizeof(*e));
+    t->stats.em_voo--;
+    t->stats.falhas_envio++;
+}
+
+int mqtt_em_voo_ack(mqtt_em_voo_t *t, int msg_id, int64_t agora_us, mqtt_em_voo_resultado_t *res)
+{
+    mqtt_em_voo_entrada_t *e = buscar_msg_id(t, msg_id);
+    if (e != NULL) {
+        concluir(t, e, true, agora_us, res);
+        return 1;
+    }
+
+    // Só guarda como órfão se há publicação ainda sem msg_id
+    if (buscar_msg_id(t, -1) != NULL) {
+        if (t->n_orfaos == MQTT_EM_VOO_ORFAOS) {
+            memmove(&t->orfaos[0], &t->orfaos[1], sizeof(int) * (MQTT_EM_VOO_ORFAOS - 1));
+            t->n_orfaos--;
+        }
+        t->orfaos[t->n_orfaos++] = msg_id;
+    }
+    return 0;
+}
+
+int mqtt_em_voo_expirar(mqtt_em_voo_t *t, int64_t agora_us, mqtt_em_voo_resultado_t *res)
+{
+    int n = 0;
+    for (int i = 0; i < MQTT_EM_VOO_MAX; i++) {
+        mqtt_em_voo_entrada_t *e = &t->tab[i];
+        if (e->handle != 0 && e->msg_id != -1 && agora_us - e->enviado_us > t->timeout_us) {
+            concluir(t, e, false, agora_us, &res[n++]);
+        }
+    }
+    return n;
+}
+
+int mqtt_em_voo_falhar_todos(mqtt_em_voo_t *t, mqtt_em_voo_resultado_t *res)
+{
+    int n = 0;
+    for (int i = 0; i < MQTT_EM_VOO_MAX; i++) {
+        if (t->tab[i].handle != 0) {
+            concluir(t, &t->tab[i], false, 0, &res[n++]);
+        }
+    }
+    t->n_orfaos = 0;
+    return n;
+}
+
+void mqtt_em_voo_entregar(const mqtt_em_voo_resultado_t *res, int n)
+{
+    for (int i = 0; i < n; i++) {
+        if (res[i].cb) {
+            res[i].cb(res[i].handle, res[i].confirmada, res[i].ctx);
+        }
+    }
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+void mqtt_em_voo_get_stats(const mqtt_em_voo_t *t, mqtt_em_voo_stats_t *out)
+{
+    *out = t->stats;
+    out->lat_p50_ms = out->lat_p90_ms = out->lat_p99_ms = out->lat_max_ms = 0;
+
+    uint32_t n = (t->n_lat < MQTT_EM_VOO_LATENCIAS) ? t->n_lat : MQTT_EM_VOO_LATENCIAS;
+    if (n == 0) {
+        return;
+    }
+
+    uint32_t ordenadas[MQTT_EM_VOO_LATENCIAS];
+    memcpy(ordenadas, t->lat_ms, n * sizeof(uint32_t));
+    qsort(ordenadas, n, sizeof(uint32_t), cmp_u32);
+
+    out->lat_p50_ms = ordenadas[(n - 1) * 50 / 100];
+    out->lat_p90_ms = ordenadas[(n - 1) * 90 / 100];
+    out->lat_p99_ms = ordenadas[(n - 1) * 99 / 100];
+    out->lat_max_ms = ordenadas[n - 1];
+}
@@ -0,0 +1,121 @@
+#ifndef MQTT_EM_VOO_H
+#define MQTT_EM_VOO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================
+ * Rastreamento de publicações QoS 1 em voo
+ * ============================================================
+ * Tabela limitada de publicações aguardando PUBACK, indexada por
+ * handle próprio (o msg_id só é conhecido depois do publish).
+ * Sem dependência do ESP-IDF: o tempo vem do chamador, então a
+ * lógica pode ser exercitada com uma sequência de eventos roteirizada.
+ *
+ * Fluxo: reservar -> (publish) -> associar(msg_id) -> ack / expirar /
+ * falhar_todos. Um PUBACK que chega antes de associar fica guardado
+ * como órfão e confirma a publicação na associação.
+ *
+ * As funções que concluem publicações não chamam os callbacks: devolvem
+ * os resultados em res (até MQTT_EM_VOO_MAX), e o chamador os entrega
+ * com mqtt_em_voo_entregar depois de soltar o mutex da tabela.
+ */
+
+#define MQTT_EM_VOO_MAX          8     // publicações aguardando PUBACK
+#define MQTT_EM_VOO_ORFAOS       4     // PUBACKs adiantados guardados
+#define MQTT_EM_VOO_LATENCIAS    128   // janela de latências para percentis
+
+typedef void (*mqtt_em_voo_cb_t)(int32_t handle, bool confirmada, void *ctx);
+
+typedef struct {
+    int32_t          handle;     // 0 = entrada livre
+    int              msg_id;     // -1 até associar
+    int64_t          enviado_us;
+    mqtt_em_voo_cb_t cb;
+    void            *ctx;
+} mqtt_em_voo_entrada_t;
+
+// Publicação concluída, a entregar fora do mutex
+typedef struct {
+    int32_t          handle;
+    bool             confirmada;
+    mqtt_em_voo_cb_t cb;
+    void            *ctx;
+} mqtt_em_voo_resultado_t;
+
+typedef struct {
+    uint32_t publicadas;      // associadas a um msg_id
+    uint32_t confirmadas;     // PUBACK recebido
+    uint32_t recusadas;       // tabela cheia (contrapressão)
+    uint32_t perdidas;        // timeout ou desconexão
+    uint32_t falhas_envio;    // publish recusado pelo cliente
+    uint32_t em_voo;
+    uint32_t lat_p50_ms;
+    uint32_t lat_p90_ms;
+    uint32_t lat_p99_ms;
+    uint32_t lat_max_ms;
+} mqtt_em_voo_stats_t;
+
+typedef struct {
+    mqtt_em_voo_entrada_t tab[MQTT_EM_VOO_MAX];
+    int      orfaos[MQTT_EM_VOO_ORFAOS];
+    int      n_orfaos;
+    int32_t  proximo_handle;
+    int64_t  timeout_us;
+    uint32_t lat_ms[MQTT_EM_VOO_LATENCIAS];
+    uint32_t n_lat;
+    mqtt_em_voo_stats_t stats;
+} mqtt_em_voo_t;
+
+void mqtt_em_voo_init(mqtt_em_voo_t *t, int64_t timeout_us);
+
+/**
+ * @brief Reserva uma entrada antes do publish.
+ * @return Handle (> 0) ou -1 se a tabela estiver cheia
+ */
+int32_t mqtt_em_voo_reservar(mqtt_em_voo_t *t, mqtt_em_voo_cb_t cb, void *ctx, int64_t agora_us);
+
+/**
+ * @brief Associa o msg_id retornado pelo publish.
+ * @return Resultados em res (1 se um PUBACK órfão confirmou a publicação),
+ *         ou -1 se o handle já foi concluído (falhar_todos durante o publish)
+ */
+int mqtt_em_voo_associar(mqtt_em_voo_t *t, int32_t handle, int msg_id, int64_t agora_us,
+                         mqtt_em_voo_resultado_t *res);
+
+/**
+ * @brief Libera a entrada de um publish que falhou (sem callback).
+ */
+void mqtt_em_voo_cancelar(mqtt_em_voo_t *t, int32_t handle);
+
+/**
+ * @brief PUBACK recebido (MQTT_EVENT_PUBLISHED).
+ * @return Resultados em res (0 ou 1)
+ */
+int mqtt_em_voo_ack(mqtt_em_voo_t *t, int msg_id, int64_t agora_us, mqtt_em_voo_resultado_t *res);
+
+/**
+ * @brief Falha as publicações sem PUBACK há mais de timeout_us.
+ * @return Resultados em res
+ */
+int mqtt_em_voo_expirar(mqtt_em_voo_t *t, int64_t agora_us, mqtt_em_voo_resultado_t *res);
+
+/**
+ * @brief Falha todas as publicações em voo (desconexão), inclusive as
+ *        reservadas que ainda não receberam msg_id.
+ * @return Resultados em res
+ */
+int mqtt_em_voo_falhar_todos(mqtt_em_voo_t *t, mqtt_em_voo_resultado_t *res);
+
+/**
+ * @brief Chama os callbacks dos resultados (sem o mutex da tabela).
+ */
+void mqtt_em_voo_entregar(const mqtt_em_voo_resultado_t *res, int n);
+
+/**
+ * @brief Contadores e percentis de latência publish -> PUBACK
+ *        (últimas MQTT_EM_VOO_LATENCIAS confirmações).
+ */
+void mqtt_em_voo_get_stats(const mqtt_em_voo_t *t, mqtt_em_voo_stats_t *out);
+
+#endif // MQTT_EM_VOO_H
@@ -0,0 +1,85 @@
+#ifndef FILA_H
+#define FILA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Fila persistente de amostras (store-and-forward)
+ * ============================================================
+ * Anel de slots de 32 bytes na partição "fila" (flash bruta).
+ * Cada slot guarda uma amostra compacta com número de sequência:
+ *
+ *   estado  0xFF livre, 0xFE pendente, 0xFC confirmada (PUBACK)
+ *   tamanho bytes úteis em dados
+ *   crc     CRC16 de seq, t_ms, tamanho e dados
+ *   seq     sequência global (continua entre boots)
+ *   t_ms    instante da amostra (esp_timer, desde o boot em que foi lida),
+ *           em ms módulo 2^32: dá a volta a cada ~49,7 dias de boot
+ *
+ * Mudar de estado só zera bits, então cada slot é gravado uma vez
+ * por volta do anel e cada setor é apagado uma vez por volta.
+ * Se o anel encher, o setor mais antigo é descartado.
+ */
+
+#define FILA_PARTICAO_LABEL  "fila"
+#define FILA_SLOT_BYTES      32
+#define FILA_DADOS_MAX       20
+
+typedef struct {
+    uint32_t slot;        /* posição no anel (usada em fila_confirmar) */
+    uint32_t seq;
+    int64_t  idade_ms;    /* -1 se a amostra é de um boot anterior */
+    uint32_t boot;        /* boot em que foi lida (relogio.h), 0 se desconhecido */
+    int64_t  t_ms;        /* instante da leitura, ms desde aquele boot; completo no
+                             boot atual, módulo 2^32 (como gravado) nos anteriores */
+    int64_t  unix_ms;     /* horário da leitura (SNTP), 0 se desconhecido */
+    uint8_t  tamanho;
+    uint8_t  dados[FILA_DADOS_MAX];
+} fila_item_t;
+
+typedef struct {
+    uint32_t capacidade;      /* slots no anel */
+    uint32_t pendentes;       /* amostras aguardando PUBACK */
+    uint32_t gravadas;        /* desde o boot */
+    uint32_t confirmadas;     /* desde o boot */
+    uint32_t descartadas;     /* perdidas por anel cheio, desde o boot */
+    uint32_t apagamentos;     /* setores apagados, desde o boot */
+    uint64_t bytes_gravados;  /* bytes programados na flash, desde o boot */
+} fila_stats_t;
+
+/**
+ * @brief Abre a partição e reconstrói o estado a partir da flash.
+ */
+esp_err_t fila_init(void);
+
+/**
+ * @brief Grava uma amostra no fim da fila.
+ * @param seq_out Sequência atribuída (opcional)
+ */
+esp_err_t fila_push(const void *dados, size_t tamanho, uint32_t *seq_out);
+
+/**
+ * @brief Próxima amostra pendente ainda não entregue para envio.
+ * @return false se não há mais amostras
+ */
+bool fila_proxima(fila_item_t *item);
+
+/**
+ * @brief Marca a amostra como entregue (após PUBACK).
+ *        Ignora slots já sobrescritos ou confirmados.
+ */
+esp_err_t fila_confirmar(uint32_t slot, uint32_t seq);
+
+/**
+ * @brief Volta o cursor de envio para a amostra pendente mais antiga
+ *        (reconexão ou PUBACK perdido).
+ */
+void fila_reenviar_pendentes(void);
+
+uint32_t fila_profundidade(void);
+void fila_get_stats(fila_stats_t *stats);
+
+#endif // FILA_H
@@ -0,0 +1,46 @@
+#ifndef FILA_ENVIO_H
+#define FILA_ENVIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fila.h"
+
+/* ============================================================
+ * Escoamento da fila persistente para o broker MQTT
+ * ============================================================
+ * Publica as amostras pendentes em QoS 1 com taxa limitada e
+ * janela de publicações em voo (conexao_mqtt_publish_async). A
+ * amostra só sai da fila quando a publicação é confirmada; em
+ * timeout ou desconexão o envio para, as outras publicações da janela
+ * terminam (confirmadas saem da fila) e o cursor volta para a
+ * pendente mais antiga.
+ *
+ * Com lote_amostras > 0 as amostras são agrupadas em um lote
+ * binário (lote.h), publicado ao juntar lote_amostras ou quando a
+ * mais antiga do lote passa de lote_periodo_s. Com 0, cada amostra
+ * vira um JSON (formato anterior).
+ */
+
+#define FILA_ENVIO_TAXA_MAX        10      // publicações por segundo
+#define FILA_ENVIO_JANELA          4       // publicações aguardando PUBACK
+#define FILA_ENVIO_LOTE_MAX        32      // amostras por lote
+#define FILA_ENVIO_RELATORIO_MS    60000   // período do log de estatísticas
+
+// Converte a amostra da fila no payload JSON; retorna o tamanho ou <= 0
+typedef int (*fila_envio_formatar_t)(const fila_item_t *item, char *buf, size_t len);
+
+typedef struct {
+    const char *topico;              // JSON por amostra
+    fila_envio_formatar_t formatar;
+    const char *topico_lote;         // lote binário
+    uint8_t layout;                  // identifica o sensor_amostra_t no lote
+    int lote_amostras;               // 0 = sem lote
+    int lote_periodo_s;
+} fila_envio_config_t;
+
+/**
+ * @brief Registra os callbacks MQTT e cria a tarefa de escoamento.
+ */
+void fila_envio_init(const fila_envio_config_t *cfg);
+
+#endif // FILA_ENVIO_H
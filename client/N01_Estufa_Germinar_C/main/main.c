@@ -1,17 +1,643 @@
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "nvs_flash.h"
-#include "esp_wifi.h"
+#include "nvs.h"
+#include "esp_timer.h"
+#include "cJSON.h"
 
 #include "config.h"
 #include "conexoes/conexoes.h"
 #include "sensores/sensores.h"
+#include "sensores/banda_morta.h"
+#include "fila/fila.h"
+#include "fila/fila_envio.h"
+#include "fila/relogio.h"
+#include "atuadores/controle.h"
 #include "atuadores/atuadores.h"  // Adicionado
 
+// Converte a amostra da fila no JSON publicado sem lote (campos originais + seq, boot e horário)
+static int formatar_amostra(const fila_item_t *item, char *buf, size_t len)
+{
+    if (item->tamanho != sizeof(sensor_amostra_t)) {
+        return -1;
+    }
+    sensor_amostra_t amostra;
+    sensor_data_t dados;
+    memcpy(&amostra, item->dados, sizeof(amostra));
+    sensores_expandir(&amostra, &dados);
+
+    int n = snprintf(buf, len,
+        "{\"temp\": %.2f, \"umid\": %.2f, \"co2\": %.2f, \"luz\": %.2f, \"agua_min\": %d, \"agua_max\": %d, "
+        "\"temp_reserv_int\": %.2f, \"ph\": %.2f, \"ec\": %.2f, \"temp_reserv_ext\": %.2f, "
+        "\"umid_solo_raw\": %d, \"umid_solo_pct\": %.2f"
+        ", \"seq\": %lu, \"boot\": %lu, \"t_boot_ms\": %lld, \"fila\": %lu",
+        dados.temp, dados.umid, dados.co2, dados.luz, dados.agua_min, dados.agua_max,
+        dados.temp_reserv_int, dados.ph, dados.ec, dados.temp_reserv_ext,
+        dados.umid_solo_raw, dados.umid_solo_pct,
+        (unsigned long)item->seq, (unsigned long)item->boot, (long long)item->t_ms,
+        (unsigned long)fila_profundidade());
+
+    // Horário só é conhecido depois que aquele boot sincronizou o SNTP
+    if (n > 0 && (size_t)n < len && item->unix_ms != 0) {
+        n += snprintf(buf + n, len - n, ", \"ts\": %lld", (long long)item->unix_ms);
+    }
+    // Atraso só é conhecido para amostras do boot atual
+    if (n > 0 && (size_t)n < len && item->idade_ms >= 0) {
+        n += snprintf(buf + n, len - n, ", \"atraso_ms\": %lld", (long long)item->idade_ms);
+    }
+    if (n > 0 && (size_t)n < len) {
+        n += snprintf(buf + n, len - n, "}");
+    }
+    return n;
+}
+
+// ======== BANDA MORTA ========
+
+#define BANDA_NVS_NAMESPACE  "banda"
+#define BANDA_NVS_CHAVE      "cfg"
+#define BANDA_NVS_VERSAO     1        // incrementar ao mudar a ordem de sensores_canais
+
+// Os deltas são posicionais: o blob só vale para a mesma versão e número de canais
+typedef struct {
+    uint8_t  versao;
+    uint8_t  n_canais;
+    uint16_t tamanho;                 // sizeof(banda_morta_config_t)
+    banda_morta_config_t cfg;
+} banda_nvs_t;
+
+static QueueHandle_t banda_cfg_fila;      // caixa postal (1 item) para a amostragem
+static banda_morta_config_t banda_cfg;    // config vigente, mantida pela tarefa do MQTT
+
+// Chamar só com delta finito; acima do limite do int32 o canal nunca dispara
+static int32_t delta_fixo(const sensores_canal_t *canal, double delta)
+{
+    if (delta < 0) {
+        return BANDA_MORTA_IGNORAR;
+    }
+    double fixo = delta * canal->escala + 0.5;
+    return (fixo >= (double)INT32_MAX) ? INT32_MAX : (int32_t)fixo;
+}
+
+static void banda_config_padrao(banda_morta_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->silencio_max_ms = BANDA_MORTA_SILENCIO_S * 1000;
+    for (int i = 0; i < SENSORES_N_CANAIS; i++) {
+        cfg->delta[i] = delta_fixo(&sensores_canais[i], sensores_canais[i].delta);
+    }
+}
+
+static void banda_config_carregar(banda_morta_config_t *cfg)
+{
+    banda_config_padrao(cfg);
+
+    nvs_handle_t handle;
+    if (nvs_open(BANDA_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    banda_nvs_t salva;
+    size_t len = sizeof(salva);
+    if (nvs_get_blob(handle, BANDA_NVS_CHAVE, &salva, &len) == ESP_OK) {
+        if (len == sizeof(salva) && salva.versao == BANDA_NVS_VERSAO &&
+            salva.n_canais == SENSORES_N_CANAIS && salva.tamanho == sizeof(salva.cfg)) {
+            *cfg = salva.cfg;
+            printf("Banda morta: config carregada do NVS.\n");
+        } else {
+            printf("Banda morta: config do NVS de outra versão, usando o padrão.\n");
+        }
+    }
+    nvs_close(handle);
+}
+
+static void banda_config_salvar(const banda_morta_config_t *cfg)
+{
+    const banda_nvs_t salva = {
+        .versao = BANDA_NVS_VERSAO,
+        .n_canais = SENSORES_N_CANAIS,
+        .tamanho = sizeof(salva.cfg),
+        .cfg = *cfg,
+    };
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(BANDA_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, BANDA_NVS_CHAVE, &salva, sizeof(salva));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        printf("Erro salvando banda morta no NVS (%s).\n", esp_err_to_name(err));
+    }
+}
+
+// MQTT_TOPIC_CONFIG, ex.: {"silencio_s": 600, "temp": 0.3, "co2": 50, "ph": -1}
+// Deltas em unidades de engenharia (< 0 ignora o canal); {"padrao": true} restaura.
+// Valores não finitos (ex.: 1e999) são ignorados.
+static void on_config_mqtt(const char *data, int len)
+{
+    cJSON *raiz = cJSON_ParseWithLength(data, len);
+    if (!cJSON_IsObject(raiz)) {
+        printf("Config MQTT inválida, ignorada.\n");
+        cJSON_Delete(raiz);
+        return;
+    }
+
+    banda_morta_config_t nova = banda_cfg;
+    if (cJSON_IsTrue(cJSON_GetObjectItem(raiz, "padrao"))) {
+        banda_config_padrao(&nova);
+    }
+    cJSON *item = cJSON_GetObjectItem(raiz, "silencio_s");
+    if (cJSON_IsNumber(item) && isfinite(item->valuedouble) && item->valuedouble >= 0) {
+        double ms = item->valuedouble * 1000;
+        nova.silencio_max_ms = (ms >= (double)UINT32_MAX) ? UINT32_MAX : (uint32_t)ms;
+    }
+    for (int i = 0; i < SENSORES_N_CANAIS; i++) {
+        item = cJSON_GetObjectItem(raiz, sensores_canais[i].nome);
+        if (cJSON_IsNumber(item) && isfinite(item->valuedouble)) {
+            nova.delta[i] = delta_fixo(&sensores_canais[i], item->valuedouble);
+        } else if (item != NULL) {
+            printf("Delta inválido para %s, ignorado.\n", sensores_canais[i].nome);
+        }
+    }
+    cJSON_Delete(raiz);
+
+    banda_cfg = nova;
+    banda_config_salvar(&nova);
+    xQueueOverwrite(banda_cfg_fila, &nova);
+    printf("Banda morta atualizada (heartbeat %lu s).\n", (unsigned long)(nova.silencio_max_ms / 1000));
+}
+
+// ======== CONTROLE LOCAL ========
+
+#define CONTROLE_NVS_NAMESPACE  "controle"
+#define CONTROLE_NVS_CHAVE      "regras"
+#define CONTROLE_NVS_VERSAO     1     // incrementar ao mudar controle_regra_t ou a ordem de sensores_canais
+
+// As regras guardam índices de canal e saída: o blob só vale para a mesma
+// versão e número de canais/saídas, e cada regra ainda é revalidada
+typedef struct {
+    uint8_t  versao;
+    uint8_t  n_canais;
+    uint8_t  n_saidas;
+    uint8_t  reservado;
+    uint16_t tamanho;                 // sizeof(controle_config_t)
+    controle_config_t cfg;
+} controle_nvs_t;
+
+static QueueHandle_t controle_cfg_fila;   // caixa postal (1 item) para a amostragem
+
+static bool controle_config_valida(const controle_config_t *cfg)
+{
+    if (cfg->n_regras > CONTROLE_REGRAS_MAX) {
+        return false;
+    }
+    for (int i = 0; i < cfg->n_regras; i++) {
+        if (!controle_regra_valida(&cfg->regras[i], SENSORES_N_CANAIS, ATUADORES_N_SAIDAS)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void controle_config_carregar(controle_config_t *cfg)
+{
+    // Sem regras salvas o nó só mede; as saídas ficam desligadas
+    memset(cfg, 0, sizeof(*cfg));
+
+    nvs_handle_t handle;
+    if (nvs_open(CONTROLE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    controle_nvs_t salva;
+    size_t len = sizeof(salva);
+    if (nvs_get_blob(handle, CONTROLE_NVS_CHAVE, &salva, &len) == ESP_OK) {
+        if (len == sizeof(salva) && salva.versao == CONTROLE_NVS_VERSAO &&
+            salva.n_canais == SENSORES_N_CANAIS && salva.n_saidas == ATUADORES_N_SAIDAS &&
+            salva.tamanho == sizeof(salva.cfg) && controle_config_valida(&salva.cfg)) {
+            *cfg = salva.cfg;
+            printf("Controle: %d regras carregadas do NVS.\n", cfg->n_regras);
+        } else {
+            printf("Controle: regras do NVS de outra versão ou inválidas, saídas desligadas.\n");
+        }
+    }
+    nvs_close(handle);
+}
+
+static void controle_config_salvar(const controle_config_t *cfg)
+{
+    const controle_nvs_t salva = {
+        .versao = CONTROLE_NVS_VERSAO,
+        .n_canais = SENSORES_N_CANAIS,
+        .n_saidas = ATUADORES_N_SAIDAS,
+        .tamanho = sizeof(salva.cfg),
+        .cfg = *cfg,
+    };
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(CONTROLE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, CONTROLE_NVS_CHAVE, &salva, sizeof(salva));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        printf("Erro salvando regras de controle no NVS (%s).\n", esp_err_to_name(err));
+    }
+}
+
+static int canal_por_nome(const char *nome)
+{
+    for (int i = 0; i < SENSORES_N_CANAIS; i++) {
+        if (strcmp(sensores_canais[i].nome, nome) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Limite em unidades de engenharia -> ponto fixo do canal; recusa o que não cabe no int32
+static bool limite_de_json(const cJSON *item, float escala, int32_t *out)
+{
+    if (!cJSON_IsNumber(item) || !isfinite(item->valuedouble)) {
+        return false;
+    }
+    double fixo = round(item->valuedouble * escala);
+    if (!(fixo >= (double)INT32_MIN && fixo <= (double)INT32_MAX)) {
+        return false;
+    }
+    *out = (int32_t)fixo;
+    return true;
+}
+
+// Tempo mínimo em segundos (opcional, 0 se ausente) -> ms
+static bool tempo_de_json(const cJSON *item, uint32_t *out_ms)
+{
+    if (item == NULL) {
+        *out_ms = 0;
+        return true;
+    }
+    if (!cJSON_IsNumber(item) || !isfinite(item->valuedouble) ||
+        item->valuedouble < 0 || item->valuedouble * 1000 > (double)UINT32_MAX) {
+        return false;
+    }
+    *out_ms = (uint32_t)(item->valuedouble * 1000);
+    return true;
+}
+
+static bool regra_de_json(const cJSON *obj, controle_regra_t *r)
+{
+    const cJSON *canal = cJSON_GetObjectItem(obj, "canal");
+    const cJSON *saida = cJSON_GetObjectItem(obj, "saida");
+    const cJSON *acima = cJSON_GetObjectItem(obj, "acima");
+    const cJSON *abaixo = cJSON_GetObjectItem(obj, "abaixo");
+    const cJSON *desliga = cJSON_GetObjectItem(obj, "desliga");
+    const cJSON *limite = cJSON_IsNumber(acima) ? acima : abaixo;
+
+    // Índices conferidos aqui: controle.c indexa vetores e máscaras com eles
+    int c = cJSON_IsString(canal) ? canal_por_nome(canal->valuestring) : -1;
+    if (c < 0 || c >= SENSORES_N_CANAIS ||
+        !cJSON_IsNumber(saida) || !(saida->valuedouble >= 0 && saida->valuedouble < ATUADORES_N_SAIDAS) ||
+        (cJSON_IsNumber(acima) && cJSON_IsNumber(abaixo))) {
+        return false;
+    }
+
+    // Limites em unidades de engenharia, convertidos para a escala do canal
+    float escala = sensores_canais[c].escala;
+    memset(r, 0, sizeof(*r));
+    r->canal = (uint8_t)c;
+    r->saida = (uint8_t)saida->valuedouble;
+    r->sentido = (limite == acima) ? CONTROLE_ACIMA : CONTROLE_ABAIXO;
+    if (!limite_de_json(limite, escala, &r->liga) ||
+        !limite_de_json(desliga, escala, &r->desliga) ||
+        !tempo_de_json(cJSON_GetObjectItem(obj, "min_ligado_s"), &r->min_ligado_ms) ||
+        !tempo_de_json(cJSON_GetObjectItem(obj, "min_desligado_s"), &r->min_desligado_ms)) {
+        return false;
+    }
+    return controle_regra_valida(r, SENSORES_N_CANAIS, ATUADORES_N_SAIDAS);
+}
+
+// MQTT_TOPIC_REGRAS, ex.:
+// {"regras": [{"canal": "temp", "saida": 0, "acima": 28.0, "desliga": 26.5, "min_ligado_s": 60, "min_desligado_s": 60},
+//             {"canal": "umid", "saida": 1, "abaixo": 60, "desliga": 70}]}
+// Uma regra inválida descarta o conjunto inteiro; {"regras": []} desliga o controle
+static void on_regras_mqtt(const char *data, int len)
+{
+    cJSON *raiz = cJSON_ParseWithLength(data, len);
+    cJSON *lista = cJSON_GetObjectItem(raiz, "regras");
+    int n = cJSON_GetArraySize(lista);
+    if (!cJSON_IsArray(lista) || n > CONTROLE_REGRAS_MAX) {
+        printf("Regras de controle inválidas, ignoradas.\n");
+        cJSON_Delete(raiz);
+        return;
+    }
+
+    controle_config_t nova = { .n_regras = (uint8_t)n };
+    for (int i = 0; i < n; i++) {
+        if (!regra_de_json(cJSON_GetArrayItem(lista, i), &nova.regras[i])) {
+            printf("Regra de controle %d inválida, conjunto ignorado.\n", i);
+            cJSON_Delete(raiz);
+            return;
+        }
+    }
+    cJSON_Delete(raiz);
+
+    controle_config_salvar(&nova);
+    xQueueOverwrite(controle_cfg_fila, &nova);
+    printf("Controle: %d regras ativas.\n", nova.n_regras);
+}
+
+// ======== MÁQUINA DE ESTADOS DA REDE + AMOSTRAGEM ========
+
+#define RELATORIO_MS  60000
+
+typedef enum {
+    REDE_SEM_WIFI,
+    REDE_SEM_MQTT,
+    REDE_ONLINE,
+} rede_estado_t;
+
+typedef enum {
+    MSG_CONEXAO,
+    MSG_AMOSTRA,
+} app_msg_tipo_t;
+
+typedef struct {
+    app_msg_tipo_t tipo;
+    union {
+        conexao_evento_t evento;
+        struct {
+            bool ok;
+            uint32_t seq;
+            int32_t jitter_us;     // início real - instante ideal
+            int32_t duracao_us;    // leitura + gravação na fila
+            uint32_t perdidas;     // períodos pulados (leitura atrasada)
+            banda_morta_decisao_t decisao;
+            uint8_t acionamentos;  // saídas que trocaram de estado
+            int32_t controle_us;   // início da leitura até o relé comandado
+        } amostra;
+    };
+} app_msg_t;
+
+typedef struct {
+    uint32_t amostras;
+    uint32_t falhas;
+    uint32_t perdidas;
+    uint32_t por_mudanca;
+    uint32_t por_silencio;
+    uint32_t suprimidas;
+    uint32_t acionamentos;
+    uint32_t amostras_acionando;
+    int64_t controle_total_us;
+    int32_t controle_max_us;
+    int64_t jitter_total_us;
+    int32_t jitter_max_us;
+    int64_t duracao_total_us;
+    int32_t duracao_max_us;
+    uint32_t reconexoes;
+    int64_t reconexao_total_us;
+    int64_t reconexao_max_us;
+} app_stats_t;
+
+static QueueHandle_t app_fila;
+static TaskHandle_t amostragem_handle;
+
+static const char *nome_estado(rede_estado_t e)
+{
+    switch (e) {
+        case REDE_SEM_WIFI: return "sem Wi-Fi";
+        case REDE_SEM_MQTT: return "sem MQTT";
+        default:            return "online";
+    }
+}
+
+// Chamado na tarefa de eventos do Wi-Fi/MQTT
+static void on_conexao_evento(conexao_evento_t evento)
+{
+    app_msg_t msg = { .tipo = MSG_CONEXAO, .evento = evento };
+    xQueueSend(app_fila, &msg, 0);
+}
+
+static rede_estado_t proximo_estado(rede_estado_t atual, conexao_evento_t evento)
+{
+    switch (evento) {
+        case CONEXAO_EVT_WIFI_IP:
+            return (atual == REDE_SEM_WIFI) ? REDE_SEM_MQTT : atual;
+        case CONEXAO_EVT_WIFI_CAIU:
+            return REDE_SEM_WIFI;
+        case CONEXAO_EVT_MQTT_CONECTADO:
+            return REDE_ONLINE;
+        case CONEXAO_EVT_MQTT_CAIU:
+            return (atual == REDE_ONLINE) ? REDE_SEM_MQTT : atual;
+    }
+    return atual;
+}
+
+static void relatorio(const app_stats_t *st, rede_estado_t estado)
+{
+    uint32_t n = st->amostras ? st->amostras : 1;
+    printf("Amostragem: %lu amostras (%lu falhas, %lu períodos perdidos), "
+           "jitter médio %.1f ms / máx %.1f ms, leitura média %.1f ms / máx %.1f ms\n",
+           (unsigned long)st->amostras, (unsigned long)st->falhas, (unsigned long)st->perdidas,
+           st->jitter_total_us / 1000.0 / n, st->jitter_max_us / 1000.0,
+           st->duracao_total_us / 1000.0 / n, st->duracao_max_us / 1000.0);
+    uint32_t publicadas = st->por_mudanca + st->por_silencio;
+    printf("Banda morta: %lu publicadas (%lu por heartbeat), %lu suprimidas (%.0f%%)\n",
+           (unsigned long)publicadas, (unsigned long)st->por_silencio, (unsigned long)st->suprimidas,
+           100.0 * st->suprimidas / (publicadas + st->suprimidas ? publicadas + st->suprimidas : 1));
+    uint32_t m = st->amostras_acionando ? st->amostras_acionando : 1;
+    printf("Controle: saídas 0x%02lx, %lu acionamentos, leitura->relé médio %.1f ms / máx %.1f ms\n",
+           (unsigned long)atuadores_saidas_get(), (unsigned long)st->acionamentos,
+           st->controle_total_us / 1000.0 / m, st->controle_max_us / 1000.0);
+    printf("Rede: %s, boot %lu, relógio %s, %lu reconexões, tempo médio %lld ms / máx %lld ms\n",
+           nome_estado(estado), (unsigned long)relogio_boot_atual(),
+           relogio_sincronizado() ? "sincronizado" : "sem SNTP", (unsigned long)st->reconexoes,
+           st->reconexoes ? (long long)(st->reconexao_total_us / st->reconexoes / 1000) : 0LL,
+           (long long)(st->reconexao_max_us / 1000));
+    tls_sessao_stats_t tls;
+    conexao_tls_get_stats(&tls);
+    printf("TLS (desde o boot): %lu completos (médio %lld ms / máx %lld ms), "
+           "%lu retomados (médio %lld ms / máx %lld ms), %lu falhas\n",
+           (unsigned long)tls.completos,
+           tls.completos ? (long long)(tls.completo_total_us / tls.completos / 1000) : 0LL,
+           (long long)(tls.completo_max_us / 1000),
+           (unsigned long)tls.retomados,
+           tls.retomados ? (long long)(tls.retomado_total_us / tls.retomados / 1000) : 0LL,
+           (long long)(tls.retomado_max_us / 1000), (unsigned long)tls.falhas);
+}
+
+// Estado da conectividade, LED e estatísticas; nunca bloqueia a amostragem
+static void rede_task(void *arg)
+{
+    rede_estado_t estado = REDE_SEM_WIFI;
+    int64_t offline_desde_us = esp_timer_get_time();
+    bool ja_online = false;
+    app_stats_t st = {0};
+    int64_t inicio_relatorio = esp_timer_get_time();
+
+    led_set_color(10, 0, 0);
+
+    while (true) {
+        app_msg_t msg;
+        bool recebeu = (xQueueReceive(app_fila, &msg, pdMS_TO_TICKS(1000)) == pdTRUE);
+
+        if (recebeu && msg.tipo == MSG_CONEXAO) {
+            rede_estado_t novo = proximo_estado(estado, msg.evento);
+            if (novo != estado) {
+                int64_t agora = esp_timer_get_time();
+                printf("Rede: %s -> %s\n", nome_estado(estado), nome_estado(novo));
+
+                if (novo == REDE_ONLINE) {
+                    int64_t latencia = agora - offline_desde_us;
+                    if (ja_online) {
+                        st.reconexoes++;
+                        st.reconexao_total_us += latencia;
+                        if (latencia > st.reconexao_max_us) {
+                            st.reconexao_max_us = latencia;
+                        }
+                        printf("Reconectado em %lld ms.\n", (long long)(latencia / 1000));
+                    } else {
+                        printf("Online %lld ms após o boot.\n", (long long)(agora / 1000));
+                    }
+                    ja_online = true;
+                    led_set_color(0, 0, 10);
+                } else {
+                    if (estado == REDE_ONLINE) {
+                        offline_desde_us = agora;
+                    }
+                    led_set_color(10, 0, 0);
+                }
+
+                // Com IP, o MQTT tenta na hora em vez de esperar o próprio timeout
+                if (novo == REDE_SEM_MQTT && estado == REDE_SEM_WIFI) {
+                    conexao_mqtt_reconectar();
+                }
+                estado = novo;
+            }
+        } else if (recebeu && msg.tipo == MSG_AMOSTRA) {
+            if (!msg.amostra.ok) {
+                st.falhas++;
+            }
+            st.amostras++;
+            st.perdidas += msg.amostra.perdidas;
+            switch (msg.amostra.decisao) {
+                case BANDA_MORTA_MUDOU:    st.por_mudanca++;  break;
+                case BANDA_MORTA_SILENCIO: st.por_silencio++; break;
+                default:                   st.suprimidas++;   break;
+            }
+            st.jitter_total_us += msg.amostra.jitter_us;
+            st.duracao_total_us += msg.amostra.duracao_us;
+            if (msg.amostra.jitter_us > st.jitter_max_us) {
+                st.jitter_max_us = msg.amostra.jitter_us;
+            }
+            if (msg.amostra.duracao_us > st.duracao_max_us) {
+                st.duracao_max_us = msg.amostra.duracao_us;
+            }
+            if (msg.amostra.acionamentos) {
+                st.acionamentos += msg.amostra.acionamentos;
+                st.amostras_acionando++;
+                st.controle_total_us += msg.amostra.controle_us;
+                if (msg.amostra.controle_us > st.controle_max_us) {
+                    st.controle_max_us = msg.amostra.controle_us;
+                }
+            }
+        }
+
+        int64_t agora = esp_timer_get_time();
+        if (agora - inicio_relatorio >= (int64_t)RELATORIO_MS * 1000) {
+            relatorio(&st, estado);
+            memset(&st, 0, sizeof(st));
+            inicio_relatorio = agora;
+        }
+    }
+}
+
+static void amostragem_timer_cb(void *arg)
+{
+    xTaskNotifyGive(amostragem_handle);
+}
+
+// Lê e grava na fila a cada SENSOR_READ_INTERVAL, comandada pelo esp_timer
+static void amostragem_task(void *arg)
+{
+    const int64_t periodo_us = (int64_t)SENSOR_READ_INTERVAL * 1000000;
+    int64_t ideal_us = esp_timer_get_time() + periodo_us;
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = amostragem_timer_cb,
+        .name = "amostragem",
+    };
+    esp_timer_handle_t timer;
+    esp_timer_create(&timer_args, &timer);
+    esp_timer_start_periodic(timer, periodo_us);
+
+    banda_morta_t banda;
+    banda_morta_config_t cfg;
+    xQueueReceive(banda_cfg_fila, &cfg, portMAX_DELAY);
+    banda_morta_init(&banda, SENSORES_N_CANAIS, &cfg);
+
+    controle_t controle;
+    controle_config_t regras;
+    xQueueReceive(controle_cfg_fila, &regras, portMAX_DELAY);
+    controle_init(&controle, &regras);
+
+    while (true) {
+        // Mais de uma notificação = a leitura anterior passou do período
+        uint32_t disparos = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t inicio = esp_timer_get_time();
+        ideal_us += (int64_t)(disparos - 1) * periodo_us;
+
+        sensor_data_t dados = sensores_ler_dados();
+        sensor_amostra_t amostra;
+        sensores_compactar(&dados, &amostra);
+
+        int32_t canais[SENSORES_N_CANAIS];
+        sensores_valores_canais(&amostra, canais);
+        uint32_t validos = sensores_canais_validos();
+
+        // Controle antes de qualquer E/S de rede ou flash: o relé não espera a fila
+        app_msg_t msg = { .tipo = MSG_AMOSTRA };
+        if (xQueueReceive(controle_cfg_fila, &regras, 0) == pdTRUE) {
+            controle_configurar(&controle, &regras);
+        }
+        uint32_t saidas = controle_avaliar(&controle, canais, validos, inicio / 1000);
+        uint32_t trocadas = saidas ^ atuadores_saidas_get();
+        if (trocadas) {
+            atuadores_saidas_set(saidas);
+            msg.amostra.acionamentos = (uint8_t)__builtin_popcount(trocadas);
+            msg.amostra.controle_us = (int32_t)(esp_timer_get_time() - inicio);
+        }
+
+        if (xQueueReceive(banda_cfg_fila, &cfg, 0) == pdTRUE) {
+            banda_morta_configurar(&banda, &cfg);
+        }
+        msg.amostra.decisao = banda_morta_avaliar(&banda, canais, inicio / 1000);
+        msg.amostra.ok = (msg.amostra.decisao == BANDA_MORTA_SUPRIMIR) ||
+                         (fila_push(&amostra, sizeof(amostra), &msg.amostra.seq) == ESP_OK);
+        msg.amostra.jitter_us = (int32_t)(inicio - ideal_us);
+        msg.amostra.duracao_us = (int32_t)(esp_timer_get_time() - inicio);
+        msg.amostra.perdidas = disparos - 1;
+        xQueueSend(app_fila, &msg, 0);
+
+        if (msg.amostra.decisao == BANDA_MORTA_SUPRIMIR) {
+            printf("Amostra dentro da banda morta, não publicada.\n");
+        } else if (msg.amostra.ok) {
+            printf("Amostra seq=%lu na fila (%lu pendentes).\n",
+                   (unsigned long)msg.amostra.seq, (unsigned long)fila_profundidade());
+        } else {
+            printf("Falha ao gravar amostra na fila.\n");
+        }
+        ideal_us += periodo_us;
+    }
+}
+
 void app_main(void) {
-  
+
     // Inicializa NVS
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -19,54 +645,51 @@ void app_main(void) {
         ESP_ERROR_CHECK(nvs_flash_init());
     }
 
-    // Inicializa Wi-Fi
-    conexao_wifi_init();
+    // Inicializa os atuadores (LED de estado e relés, desligados)
+    atuadores_init();
+
+    // Eventos de conectividade e amostras chegam à rede_task por esta fila
+    app_fila = xQueueCreate(16, sizeof(app_msg_t));
+    conexao_set_evento_cb(on_conexao_evento);
+
+    // Banda morta: config do NVS, ajustável por MQTT_TOPIC_CONFIG
+    banda_cfg_fila = xQueueCreate(1, sizeof(banda_morta_config_t));
+    banda_config_carregar(&banda_cfg);
+    xQueueOverwrite(banda_cfg_fila, &banda_cfg);
+    conexao_mqtt_assinar(MQTT_TOPIC_CONFIG, on_config_mqtt);
+
+    // Controle local: regras do NVS, trocadas por MQTT_TOPIC_REGRAS
+    controle_cfg_fila = xQueueCreate(1, sizeof(controle_config_t));
+    controle_config_t regras;
+    controle_config_carregar(&regras);
+    xQueueOverwrite(controle_cfg_fila, &regras);
+    conexao_mqtt_assinar(MQTT_TOPIC_REGRAS, on_regras_mqtt);
 
-    // Inicializa MQTT
+    // Inicializa Wi-Fi e MQTT (não bloqueiam; reconexão em conexoes.c)
+    conexao_wifi_init();
     conexao_mqtt_start();
 
     // Inicializa Sensores
     sensores_init();
 
-    // Inicializa os atuadores
-    atuadores_init(); 
-
-      // Usando a nova função do módulo atuadores
+    // Fila persistente: toda amostra passa por ela e é escoada ao broker
+    if (fila_init() != ESP_OK) {
+        printf("Fila persistente indisponível, amostras não serão guardadas.\n");
+    }
+    fila_envio_config_t envio_cfg = {
+        .topico = MQTT_TOPIC,
+        .formatar = formatar_amostra,
+        .topico_lote = MQTT_TOPIC_LOTE,
+        .layout = MQTT_LOTE_LAYOUT,
+        .lote_amostras = MQTT_LOTE_AMOSTRAS,
+        .lote_periodo_s = MQTT_LOTE_PERIODO_S,
+    };
+    fila_envio_init(&envio_cfg);
 
-    while (true) {
-       
-        // Verifica conexão Wi-Fi
-        if (!conexao_wifi_is_connected()) {
-            led_set_color(10, 0, 0);
-            printf("Wi-Fi está desconectado. Tentando reconectar...\n");
-            esp_wifi_disconnect();
-            vTaskDelay(2000 / portTICK_PERIOD_MS);
-            esp_wifi_connect();
-        } else {
-            printf("Wi-Fi está conectado.\n");
-            led_set_color(0, 0, 10);
-
-            // Verifica conexão MQTT
-            if (conexao_mqtt_is_connected()) {
-                // Simula leitura de sensor
-                sensor_data_t dados = sensores_ler_dados();
-                char payload[256];
-                snprintf(payload, sizeof(payload),
-                "{\"temp\": %.2f, \"umid\": %.2f, \"co2\": %.2f, \"luz\": %.2f, \"agua_min\": %d, \"agua_max\": %d, "
-                "\"temp_reserv_int\": %.2f, \"ph\": %.2f, \"ec\": %.2f, \"temp_reserv_ext\": %.2f, "
-                "\"umid_solo_raw\": %d, \"umid_solo_pct\": %.2f}",
-                dados.temp, dados.umid, dados.co2, dados.luz, dados.agua_min, dados.agua_max,
-                dados.temp_reserv_int, dados.ph, dados.ec, dados.temp_reserv_ext,
-                dados.umid_solo_raw, dados.umid_solo_pct);
-       
-                // Publica no tópico MQTT
-                conexao_mqtt_publish(MQTT_TOPIC, payload);
-            } else {
-                printf("MQTT não está conectado.\n");
-                led_set_color(10, 0, 0);
-            }
-        }
+    // Horário das amostras (boot já registrado por fila_init)
+    relogio_sntp_iniciar(SNTP_SERVIDOR);
 
-        vTaskDelay(5000 / portTICK_PERIOD_MS); // Aguarda 5 segundos
-    }
-}
\ No newline at end of file
+    xTaskCreate(rede_task, "rede", 3072, NULL, 4, NULL);
+    // Prioridade acima da rede e do escoamento: a cadência vem primeiro
+    xTaskCreate(amostragem_task, "amostragem", 4096, NULL, 6, &amostragem_handle);
+}
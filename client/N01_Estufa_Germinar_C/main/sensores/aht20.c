@@ -73,12 +73,19 @@ void aht20_reset(aht20_t *dev) {
 }
 
 bool aht20_read(aht20_t *dev, float *temperature, float *humidity) {
+    return aht20_trigger(dev) && aht20_read_result(dev, temperature, humidity);
+}
+
+bool aht20_trigger(aht20_t *dev) {
     uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
     if (aht20_write(dev, trigger_cmd, sizeof(trigger_cmd)) != ESP_OK) {
         ESP_LOGE(TAG, "Trigger command failed");
         return false;
     }
+    return true;
+}
 
+bool aht20_read_result(aht20_t *dev, float *temperature, float *humidity) {
     if (!aht20_wait_for_idle(dev)) {
         return false;
     }
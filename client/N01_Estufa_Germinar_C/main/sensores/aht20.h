@@ -28,6 +28,10 @@ esp_err_t aht20_read_bytes(aht20_t *dev, uint8_t *data, size_t len);
 bool aht20_init(aht20_t *dev, i2c_port_t i2c_port, uint8_t address);
 void aht20_reset(aht20_t *dev);
 bool aht20_read(aht20_t *dev, float *temperature, float *humidity);
+// Medição em duas etapas: dispara (~80 ms de conversão) e lê depois,
+// deixando o barramento livre para outros sensores nesse intervalo
+bool aht20_trigger(aht20_t *dev);
+bool aht20_read_result(aht20_t *dev, float *temperature, float *humidity);
 void aht20_scan_i2c_bus(i2c_port_t port);
 
 #endif
\ No newline at end of file
@@ -76,14 +76,25 @@ void ds18b20_init(gpio_num_t gpio) {
 }
 
 float ds18b20_read_temperature(gpio_num_t gpio) {
+    if (!ds18b20_start_conversion(gpio)) return -127.0;
+
+    vTaskDelay(pdMS_TO_TICKS(DS18B20_CONVERSION_MS)); // tempo de conversão
+
+    return ds18b20_read_conversion(gpio);
+}
+
+bool ds18b20_start_conversion(gpio_num_t gpio) {
     ds18b20_init(gpio);
 
-    if (!ds_reset()) return -127.0;
+    if (!ds_reset()) return false;
 
     ds_write_byte(CMD_SKIP_ROM);
     ds_write_byte(CMD_CONVERT_T);
+    return true;
+}
 
-    vTaskDelay(pdMS_TO_TICKS(750)); // tempo de conversão
+float ds18b20_read_conversion(gpio_num_t gpio) {
+    ds_gpio = gpio;
 
     if (!ds_reset()) return -127.0;
 
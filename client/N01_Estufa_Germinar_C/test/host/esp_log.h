@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdio.h>
+
+/* Substituto de host do esp_log.h: formato verificado, saída descartada */
+
+#define ESP_LOG_DESCARTAR(tag, fmt, ...) do { if (0) printf("%s " fmt, tag, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) ESP_LOG_DESCARTAR(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) ESP_LOG_DESCARTAR(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ESP_LOG_DESCARTAR(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) ESP_LOG_DESCARTAR(tag, fmt, ##__VA_ARGS__)
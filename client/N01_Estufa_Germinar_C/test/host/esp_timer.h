@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Relógio de host controlado pelo teste */
+
+int64_t esp_timer_get_time(void);
+void esp_timer_falso_ajustar(int64_t agora_us);
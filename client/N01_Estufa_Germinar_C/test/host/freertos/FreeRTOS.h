@@ -0,0 +1,10 @@
+#pragma once
+
+/* Substituto de host: os testes rodam numa thread só */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFFU)
+#define pdTRUE          1
+#define pdFALSE         0
@@ -0,0 +1,172 @@
+#include "teste.h"
+#include "fila.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include <string.h>
+
+#define SETORES          4
+#define SLOTS_SETOR      (4096 / FILA_SLOT_BYTES)
+#define CAPACIDADE       (SETORES * SLOTS_SETOR)
+
+static void empurrar(uint32_t valor, uint32_t *seq)
+{
+    VERIFICAR(fila_push(&valor, sizeof(valor), seq) == ESP_OK);
+}
+
+static uint32_t valor_de(const fila_item_t *item)
+{
+    uint32_t v;
+    memcpy(&v, item->dados, sizeof(v));
+    return v;
+}
+
+static void nova_particao(void)
+{
+    particao_falsa_criar(FILA_PARTICAO_LABEL, SETORES * 4096);
+    esp_timer_falso_ajustar(1000000);
+    VERIFICAR(fila_init() == ESP_OK);
+}
+
+static void testar_ordem_e_confirmacao(void)
+{
+    fila_item_t item;
+    uint32_t seq;
+
+    nova_particao();
+    VERIFICAR(fila_profundidade() == 0);
+    VERIFICAR(!fila_proxima(&item));
+
+    for (uint32_t i = 1; i <= 3; i++) {
+        empurrar(100 + i, &seq);
+        VERIFICAR(seq == i);
+    }
+    VERIFICAR(fila_profundidade() == 3);
+
+    VERIFICAR(fila_proxima(&item) && item.seq == 1 && valor_de(&item) == 101);
+    uint32_t slot1 = item.slot;
+    VERIFICAR(fila_proxima(&item) && item.seq == 2 && item.tamanho == 4);
+    VERIFICAR(fila_confirmar(slot1, 1) == ESP_OK);
+    VERIFICAR(fila_profundidade() == 2);
+    // Segundo PUBACK da mesma amostra, ou de outra seq no slot: ignorado
+    VERIFICAR(fila_confirmar(slot1, 1) == ESP_ERR_NOT_FOUND);
+    VERIFICAR(fila_confirmar(item.slot, 99) == ESP_ERR_NOT_FOUND);
+
+    // Reenvio volta à pendente mais antiga, pulando a confirmada
+    VERIFICAR(fila_proxima(&item) && item.seq == 3);
+    VERIFICAR(!fila_proxima(&item));
+    fila_reenviar_pendentes();
+    VERIFICAR(fila_proxima(&item) && item.seq == 2 && valor_de(&item) == 102);
+
+    VERIFICAR(particao_falsa_violacoes() == 0);
+}
+
+static void testar_reboot(void)
+{
+    fila_item_t item;
+    uint32_t seq;
+
+    nova_particao();
+    esp_timer_falso_ajustar(5000000);
+    for (uint32_t i = 1; i <= 5; i++) {
+        empurrar(i, NULL);
+    }
+    VERIFICAR(fila_proxima(&item) && item.seq == 1);
+    VERIFICAR(item.idade_ms == 0 && item.t_ms == 5000);
+    VERIFICAR(fila_confirmar(item.slot, item.seq) == ESP_OK);
+    VERIFICAR(fila_proxima(&item) && item.seq == 2);
+    VERIFICAR(fila_confirmar(item.slot, item.seq) == ESP_OK);
+
+    // Novo boot: pendentes e sequência vêm da flash
+    esp_timer_falso_ajustar(200000);
+    VERIFICAR(fila_init() == ESP_OK);
+    VERIFICAR(fila_profundidade() == 3);
+    VERIFICAR(fila_proxima(&item) && item.seq == 3 && valor_de(&item) == 3);
+    // Uptime de outro boot: sem idade, t_ms como gravado
+    VERIFICAR(item.idade_ms == -1 && item.t_ms == 5000 && item.boot == 0);
+    empurrar(6, &seq);
+    VERIFICAR(seq == 6);
+    VERIFICAR(particao_falsa_violacoes() == 0);
+}
+
+static void testar_gravacao_interrompida(void)
+{
+    fila_item_t item;
+    uint32_t seq;
+
+    nova_particao();
+    empurrar(1, NULL);
+
+    // Corpo gravado, byte de estado não: o slot não vale e fica sujo
+    particao_falsa_falhar_gravacao(2);
+    uint32_t v = 2;
+    VERIFICAR(fila_push(&v, sizeof(v), NULL) != ESP_OK);
+    VERIFICAR(fila_profundidade() == 1);
+
+    VERIFICAR(fila_init() == ESP_OK);
+    VERIFICAR(fila_profundidade() == 1);
+    empurrar(3, &seq);
+    VERIFICAR(seq == 2);
+    VERIFICAR(fila_proxima(&item) && item.seq == 1);
+    VERIFICAR(fila_proxima(&item) && item.seq == 2 && valor_de(&item) == 3);
+    // O slot sujo foi pulado, não regravado por cima
+    VERIFICAR(item.slot == 2);
+    VERIFICAR(particao_falsa_violacoes() == 0);
+
+    // Slot com CRC errado some da varredura
+    particao_falsa_dados()[2 * FILA_SLOT_BYTES + 12] ^= 0x01;
+    VERIFICAR(fila_init() == ESP_OK);
+    VERIFICAR(fila_profundidade() == 1);
+}
+
+static void testar_anel_cheio(void)
+{
+    fila_item_t item;
+    fila_stats_t st;
+
+    nova_particao();
+    // Anel cheio: a próxima gravação apaga o setor mais antigo inteiro
+    for (uint32_t i = 1; i <= CAPACIDADE; i++) {
+        empurrar(i, NULL);
+    }
+    fila_get_stats(&st);
+    VERIFICAR(st.capacidade == CAPACIDADE);
+    VERIFICAR(st.pendentes == CAPACIDADE && st.descartadas == 0);
+
+    empurrar(CAPACIDADE + 1, NULL);
+    fila_get_stats(&st);
+    VERIFICAR(st.descartadas == SLOTS_SETOR);
+    VERIFICAR(st.pendentes == CAPACIDADE - SLOTS_SETOR + 1);
+
+    // Descartadas são as mais antigas
+    VERIFICAR(fila_proxima(&item) && item.seq == SLOTS_SETOR + 1);
+
+    VERIFICAR(fila_init() == ESP_OK);
+    VERIFICAR(fila_profundidade() == CAPACIDADE - SLOTS_SETOR + 1);
+    VERIFICAR(fila_proxima(&item) && item.seq == SLOTS_SETOR + 1);
+    VERIFICAR(particao_falsa_violacoes() == 0);
+}
+
+static void testar_uptime_32_bits(void)
+{
+    fila_item_t item;
+    const int64_t volta_ms = (int64_t)1 << 32;
+
+    // Lida antes da volta dos 32 bits, entregue depois dela
+    nova_particao();
+    esp_timer_falso_ajustar((volta_ms - 1000) * 1000);
+    empurrar(1, NULL);
+    esp_timer_falso_ajustar((volta_ms + 1000) * 1000);
+    VERIFICAR(fila_proxima(&item));
+    VERIFICAR(item.t_ms == volta_ms - 1000);
+    VERIFICAR(item.idade_ms == 2000);
+}
+
+int main(void)
+{
+    testar_ordem_e_confirmacao();
+    testar_reboot();
+    testar_gravacao_interrompida();
+    testar_anel_cheio();
+    testar_uptime_32_bits();
+    return TESTE_FIM();
+}
@@ -0,0 +1,117 @@
+#include "teste.h"
+#include "lote.h"
+#include <string.h>
+
+static uint32_t le_u16(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8;
+}
+
+static uint32_t le_u32(const uint8_t *p)
+{
+    return le_u16(p) | le_u16(p + 2) << 16;
+}
+
+static uint64_t le_u64(const uint8_t *p)
+{
+    return le_u32(p) | (uint64_t)le_u32(p + 4) << 32;
+}
+
+static fila_item_t item(uint32_t seq, uint32_t boot, int64_t t_ms, int64_t idade_ms, int64_t unix_ms)
+{
+    fila_item_t it = {
+        .seq = seq,
+        .boot = boot,
+        .t_ms = t_ms,
+        .idade_ms = idade_ms,
+        .unix_ms = unix_ms,
+        .tamanho = 3,
+        .dados = { (uint8_t)seq, 0xA5, 0x5A },
+    };
+    return it;
+}
+
+static void testar_codificacao(void)
+{
+    uint8_t buf[128];
+    const int64_t ts = 1700000000000LL;
+    fila_item_t itens[4] = {
+        item(1000, 7, 50, -1, 0),                       // boot anterior sem horário
+        item(1001, 8, 60, 12345, ts),                   // primeiro com horário: ts0
+        item(1003, 8, 70, 10, ts - 2000),               // antes de ts0
+        item(1010, 8, ((int64_t)1 << 32) + 5, 0, 0),    // sem horário, t além de 2^32
+    };
+
+    size_t n = lote_codificar(1, itens, 4, 70000, buf, sizeof(buf));
+    VERIFICAR(n == LOTE_CABECALHO_BYTES + 4 * LOTE_ITEM_BYTES(3));
+
+    VERIFICAR(buf[0] == LOTE_VERSAO && buf[1] == 1 && buf[2] == 3 && buf[3] == 4);
+    VERIFICAR(le_u32(buf + 4) == 1000);
+    VERIFICAR(le_u16(buf + 8) == UINT16_MAX);     // profundidade saturada
+    VERIFICAR(le_u32(buf + 10) == 7);
+    VERIFICAR(le_u64(buf + 14) == (uint64_t)ts);
+
+    const uint8_t *p = buf + LOTE_CABECALHO_BYTES;
+    VERIFICAR(le_u16(p) == 0 && le_u32(p + 2) == LOTE_ATRASO_DESCONHECIDO);
+    VERIFICAR(p[6] == 0 && le_u32(p + 7) == 50);
+    VERIFICAR(p[11] == (uint8_t)1000 && p[12] == 0xA5 && p[13] == 0x5A);
+
+    p += LOTE_ITEM_BYTES(3);
+    VERIFICAR(le_u16(p) == 1 && le_u32(p + 2) == 12345);
+    VERIFICAR(p[6] == (LOTE_INFO_HORARIO | 1) && le_u32(p + 7) == 0);
+
+    p += LOTE_ITEM_BYTES(3);
+    VERIFICAR(le_u16(p) == 3 && le_u32(p + 2) == 10);
+    VERIFICAR(p[6] == (LOTE_INFO_HORARIO | 1) && (int32_t)le_u32(p + 7) == -2000);
+
+    p += LOTE_ITEM_BYTES(3);
+    VERIFICAR(le_u16(p) == 10 && p[6] == 1 && le_u32(p + 7) == 5);
+}
+
+static void testar_horario_fora_de_i32(void)
+{
+    uint8_t buf[64];
+    const int64_t ts = 1700000000000LL;
+    fila_item_t itens[2] = {
+        item(1, 1, 100, 0, ts),
+        item(2, 1, 200, 0, ts + ((int64_t)1 << 31)),
+    };
+
+    VERIFICAR(lote_codificar(2, itens, 2, 0, buf, sizeof(buf)) > 0);
+    const uint8_t *p = buf + LOTE_CABECALHO_BYTES + LOTE_ITEM_BYTES(3);
+    // Longe demais de ts0: vai como tempo desde o boot
+    VERIFICAR(p[6] == 0 && le_u32(p + 7) == 200);
+}
+
+static void testar_incompativeis(void)
+{
+    uint8_t buf[128];
+    fila_item_t a = item(10, 1, 0, 0, 0);
+    fila_item_t b = item(10 + UINT16_MAX + 1, 1, 0, 0, 0);
+    fila_item_t c = item(11, 1 + LOTE_BOOT_DELTA_MAX + 1, 0, 0, 0);
+    fila_item_t d = item(11, 1, 0, 0, 0);
+    d.tamanho = 4;
+
+    VERIFICAR(lote_compativel(&a, &a));
+    VERIFICAR(!lote_compativel(&a, &b));
+    VERIFICAR(!lote_compativel(&a, &c));
+    VERIFICAR(!lote_compativel(&a, &d));
+
+    fila_item_t par[2] = { a, d };
+    VERIFICAR(lote_codificar(1, par, 2, 0, buf, sizeof(buf)) == 0);
+
+    // Sem espaço para o lote inteiro
+    fila_item_t ok[2] = { a, item(12, 1, 0, 0, 0) };
+    size_t total = LOTE_CABECALHO_BYTES + 2 * LOTE_ITEM_BYTES(3);
+    VERIFICAR(lote_codificar(1, ok, 2, 0, buf, total - 1) == 0);
+    VERIFICAR(lote_codificar(1, ok, 2, 0, buf, total) == total);
+    VERIFICAR(lote_codificar(1, ok, 0, 0, buf, sizeof(buf)) == 0);
+}
+
+int main(void)
+{
+    testar_codificacao();
+    testar_horario_fora_de_i32();
+    testar_incompativeis();
+    return TESTE_FIM();
+}
@@ -0,0 +1,153 @@
+#include "teste.h"
+#include "mqtt_em_voo.h"
+#include <string.h>
+
+#define TIMEOUT_US  (10 * 1000000LL)
+
+static int chamadas;
+static int32_t ultimo_handle;
+static bool ultima_confirmada;
+
+static void ao_concluir(int32_t handle, bool confirmada, void *ctx)
+{
+    (*(int *)ctx)++;
+    chamadas++;
+    ultimo_handle = handle;
+    ultima_confirmada = confirmada;
+}
+
+static void testar_ack_e_orfao(void)
+{
+    mqtt_em_voo_t t;
+    mqtt_em_voo_resultado_t res[MQTT_EM_VOO_MAX];
+    int ctx = 0;
+
+    mqtt_em_voo_init(&t, TIMEOUT_US);
+    chamadas = 0;
+
+    int32_t h1 = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0);
+    VERIFICAR(h1 > 0);
+    VERIFICAR(mqtt_em_voo_associar(&t, h1, 11, 0, res) == 0);
+    VERIFICAR(mqtt_em_voo_ack(&t, 11, 2000, res) == 1);
+    // Resultado devolvido, callback só na entrega
+    VERIFICAR(res[0].handle == h1 && res[0].confirmada);
+    VERIFICAR(chamadas == 0);
+    mqtt_em_voo_entregar(res, 1);
+    VERIFICAR(chamadas == 1 && ctx == 1 && ultimo_handle == h1 && ultima_confirmada);
+
+    // PUBACK sem ninguém aguardando msg_id: descartado, não vira órfão
+    VERIFICAR(mqtt_em_voo_ack(&t, 12, 0, res) == 0);
+    int32_t h2 = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0);
+    VERIFICAR(mqtt_em_voo_associar(&t, h2, 12, 0, res) == 0);
+
+    // PUBACK antes da associação: guardado e aplicado ao associar
+    int32_t h3 = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0);
+    VERIFICAR(mqtt_em_voo_ack(&t, 13, 0, res) == 0);
+    VERIFICAR(mqtt_em_voo_associar(&t, h3, 13, 1000, res) == 1);
+    VERIFICAR(res[0].handle == h3 && res[0].confirmada);
+
+    mqtt_em_voo_stats_t st;
+    mqtt_em_voo_get_stats(&t, &st);
+    VERIFICAR(st.publicadas == 3 && st.confirmadas == 2 && st.em_voo == 1);
+}
+
+static void testar_expirar(void)
+{
+    mqtt_em_voo_t t;
+    mqtt_em_voo_resultado_t res[MQTT_EM_VOO_MAX];
+    int ctx = 0;
+
+    mqtt_em_voo_init(&t, TIMEOUT_US);
+    int32_t velho = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0);
+    mqtt_em_voo_associar(&t, velho, 1, 0, res);
+    int32_t novo = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 5000000);
+    mqtt_em_voo_associar(&t, novo, 2, 5000000, res);
+    // Ainda no publish (sem msg_id): não expira
+    int32_t sem_id = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0);
+
+    VERIFICAR(mqtt_em_voo_expirar(&t, TIMEOUT_US, res) == 0);
+    VERIFICAR(mqtt_em_voo_expirar(&t, TIMEOUT_US + 1, res) == 1);
+    VERIFICAR(res[0].handle == velho && !res[0].confirmada);
+
+    // PUBACK atrasado do expirado não confirma nada
+    VERIFICAR(mqtt_em_voo_ack(&t, 1, TIMEOUT_US + 2, res) == 0);
+
+    VERIFICAR(mqtt_em_voo_expirar(&t, 5000000 + TIMEOUT_US + 1, res) == 1);
+    VERIFICAR(res[0].handle == novo);
+
+    mqtt_em_voo_stats_t st;
+    mqtt_em_voo_get_stats(&t, &st);
+    VERIFICAR(st.perdidas == 2 && st.em_voo == 1);
+    VERIFICAR(mqtt_em_voo_associar(&t, sem_id, 3, 0, res) == 0);
+}
+
+static void testar_falhar_todos(void)
+{
+    mqtt_em_voo_t t;
+    mqtt_em_voo_resultado_t res[MQTT_EM_VOO_MAX];
+    int ctx = 0;
+    int32_t h[MQTT_EM_VOO_MAX];
+
+    mqtt_em_voo_init(&t, TIMEOUT_US);
+    for (int i = 0; i < MQTT_EM_VOO_MAX; i++) {
+        h[i] = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0);
+        VERIFICAR(h[i] > 0);
+    }
+    // Tabela cheia: contrapressão
+    VERIFICAR(mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0) == -1);
+
+    for (int i = 0; i < MQTT_EM_VOO_MAX / 2; i++) {
+        mqtt_em_voo_associar(&t, h[i], 100 + i, 0, res);
+    }
+    mqtt_em_voo_cancelar(&t, h[MQTT_EM_VOO_MAX - 1]);
+    mqtt_em_voo_ack(&t, 999, 0, res);   // órfão
+
+    // Desconexão: falham associadas e reservadas sem msg_id
+    chamadas = 0;
+    int n = mqtt_em_voo_falhar_todos(&t, res);
+    VERIFICAR(n == MQTT_EM_VOO_MAX - 1);
+    mqtt_em_voo_entregar(res, n);
+    VERIFICAR(chamadas == MQTT_EM_VOO_MAX - 1 && !ultima_confirmada);
+
+    // Publish que retornou depois da desconexão encontra o handle concluído
+    VERIFICAR(mqtt_em_voo_associar(&t, h[MQTT_EM_VOO_MAX - 2], 200, 0, res) == -1);
+
+    // Órfãos não sobrevivem à desconexão
+    int32_t hn = mqtt_em_voo_reservar(&t, ao_concluir, &ctx, 0);
+    VERIFICAR(mqtt_em_voo_associar(&t, hn, 999, 0, res) == 0);
+
+    mqtt_em_voo_stats_t st;
+    mqtt_em_voo_get_stats(&t, &st);
+    VERIFICAR(st.recusadas == 1 && st.falhas_envio == 1);
+    VERIFICAR(st.perdidas == MQTT_EM_VOO_MAX - 1 && st.em_voo == 1);
+}
+
+static void testar_latencias(void)
+{
+    mqtt_em_voo_t t;
+    mqtt_em_voo_resultado_t res[MQTT_EM_VOO_MAX];
+    mqtt_em_voo_stats_t st;
+
+    mqtt_em_voo_init(&t, TIMEOUT_US);
+    mqtt_em_voo_get_stats(&t, &st);
+    VERIFICAR(st.lat_max_ms == 0);
+
+    for (int i = 1; i <= 100; i++) {
+        int32_t h = mqtt_em_voo_reservar(&t, NULL, NULL, 0);
+        mqtt_em_voo_associar(&t, h, i, 0, res);
+        mqtt_em_voo_ack(&t, i, (int64_t)(101 - i) * 1000, res);
+    }
+    mqtt_em_voo_entregar(res, 1);   // sem callback: ignorado
+    mqtt_em_voo_get_stats(&t, &st);
+    VERIFICAR(st.lat_p50_ms == 50 && st.lat_p90_ms == 90);
+    VERIFICAR(st.lat_p99_ms == 99 && st.lat_max_ms == 100);
+}
+
+int main(void)
+{
+    testar_ack_e_orfao();
+    testar_expirar();
+    testar_falhar_todos();
+    testar_latencias();
+    return TESTE_FIM();
+}
@@ -1,12 +1,37 @@
 #include "atuadores.h"
 #include <esp_log.h>
 #include <esp_err.h>
+#include "driver/gpio.h"
 
 static const char* TAG = "Atuadores";
 
 // Handle do LED strip (privado)
 static led_strip_handle_t led_strip;
 
+static const int gpio_saidas[ATUADORES_N_SAIDAS] = ATUADORES_GPIO_SAIDAS;
+static uint32_t saidas_ligadas = 0;
+
+static void saidas_init(void) {
+    uint64_t mascara_gpio = 0;
+    for (int i = 0; i < ATUADORES_N_SAIDAS; i++) {
+        mascara_gpio |= 1ULL << gpio_saidas[i];
+    }
+    gpio_config_t io_conf = {
+        .pin_bit_mask = mascara_gpio,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    gpio_config(&io_conf);
+
+    // Tudo desligado até o controle decidir
+    for (int i = 0; i < ATUADORES_N_SAIDAS; i++) {
+        gpio_set_level(gpio_saidas[i], 0);
+    }
+    saidas_ligadas = 0;
+}
+
 static void leds_init(void) {
     // Configuração do LED strip
     led_strip_config_t strip_config = {
@@ -43,4 +68,20 @@ void led_set_color(uint8_t red, uint8_t green, uint8_t blue) {
 void atuadores_init(void) {
     ESP_LOGI(TAG, "Inicializando atuadores...");
     leds_init();
+    saidas_init();
+}
+
+void atuadores_saidas_set(uint32_t mascara) {
+    for (int i = 0; i < ATUADORES_N_SAIDAS; i++) {
+        bool ligar = (mascara >> i) & 1;
+        if (ligar != ((saidas_ligadas >> i) & 1)) {
+            gpio_set_level(gpio_saidas[i], ligar ? 1 : 0);
+            ESP_LOGI(TAG, "Saída %d (GPIO %d) %s", i, gpio_saidas[i], ligar ? "ligada" : "desligada");
+        }
+    }
+    saidas_ligadas = mascara & ((1u << ATUADORES_N_SAIDAS) - 1);
+}
+
+uint32_t atuadores_saidas_get(void) {
+    return saidas_ligadas;
 }
\ No newline at end of file
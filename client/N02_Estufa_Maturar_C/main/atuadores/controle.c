@@ -0,0 +1,139 @@
+#include "controle.h"
+#include <string.h>
+
+void controle_init(controle_t *c, const controle_config_t *cfg)
+{
+    memset(c, 0, sizeof(*c));
+    controle_configurar(c, cfg);
+}
+
+static bool mesma_malha(const controle_regra_t *a, const controle_regra_t *b)
+{
+    return a->canal == b->canal && a->saida == b->saida && a->sentido == b->sentido;
+}
+
+void controle_configurar(controle_t *c, const controle_config_t *cfg)
+{
+    controle_t ant = *c;
+    bool herdada[CONTROLE_REGRAS_MAX] = { false };
+
+    c->cfg = *cfg;
+    if (c->cfg.n_regras > CONTROLE_REGRAS_MAX) {
+        c->cfg.n_regras = CONTROLE_REGRAS_MAX;
+    }
+
+    for (int i = 0; i < c->cfg.n_regras; i++) {
+        const controle_regra_t *r = &c->cfg.regras[i];
+        int j = 0;
+        while (j < ant.cfg.n_regras && (herdada[j] || !mesma_malha(r, &ant.cfg.regras[j]))) {
+            j++;
+        }
+
+        if (j < ant.cfg.n_regras) {
+            herdada[j] = true;
+            c->ligada[i] = ant.ligada[j];
+            c->iniciada[i] = ant.iniciada[j];
+            c->mudou_ms[i] = ant.mudou_ms[j];
+            c->falhas[i] = ant.falhas[j];
+        } else {
+            // Regra nova assume o relé como está, com os mínimos contando da última mudança
+            uint32_t bit = 1u << r->saida;
+            c->ligada[i] = (ant.saidas & bit) != 0;
+            c->iniciada[i] = (ant.saidas_iniciadas & bit) != 0;
+            c->mudou_ms[i] = c->iniciada[i] ? ant.saida_mudou_ms[r->saida] : 0;
+            c->falhas[i] = 0;
+        }
+    }
+
+    for (int j = 0; j < ant.cfg.n_regras; j++) {
+        const controle_regra_t *r = &ant.cfg.regras[j];
+        if (herdada[j] || !ant.ligada[j] || r->saida >= CONTROLE_SAIDAS_MAX) {
+            continue;
+        }
+        int64_t ate = ant.mudou_ms[j] + r->min_ligado_ms;
+        if (ate > c->retida_ate_ms[r->saida]) {
+            c->retida_ate_ms[r->saida] = ate;
+        }
+    }
+}
+
+bool controle_regra_valida(const controle_regra_t *r, int n_canais, int n_saidas)
+{
+    if (r->canal >= n_canais || r->saida >= n_saidas || r->saida >= CONTROLE_SAIDAS_MAX) {
+        return false;
+    }
+    if (r->sentido == CONTROLE_ACIMA) {
+        return r->desliga <= r->liga;
+    }
+    if (r->sentido == CONTROLE_ABAIXO) {
+        return r->desliga >= r->liga;
+    }
+    return false;
+}
+
+uint32_t controle_avaliar(controle_t *c, const int32_t *valores, uint32_t validos, int64_t agora_ms)
+{
+    uint32_t saidas = 0;
+
+    for (int i = 0; i < c->cfg.n_regras; i++) {
+        const controle_regra_t *r = &c->cfg.regras[i];
+
+        if (!(validos & (1u << r->canal))) {
+            // Sem leitura: segura o estado por algumas amostras, depois desliga
+            if (c->falhas[i] < UINT8_MAX) {
+                c->falhas[i]++;
+            }
+            if (c->ligada[i] && c->falhas[i] > CONTROLE_FALHAS_MAX) {
+                c->ligada[i] = false;
+                c->mudou_ms[i] = agora_ms;
+            }
+            if (c->ligada[i]) {
+                saidas |= 1u << r->saida;
+            }
+            continue;
+        }
+        c->falhas[i] = 0;
+
+        int32_t v = valores[r->canal];
+        bool acima = (r->sentido == CONTROLE_ACIMA);
+
+        bool quer_ligar = acima ? (v >= r->liga) : (v <= r->liga);
+        bool quer_desligar = acima ? (v <= r->desliga) : (v >= r->desliga);
+
+        // Tempo mínimo no estado atual antes de mudar (não vale para o primeiro acionamento)
+        int64_t no_estado = agora_ms - c->mudou_ms[i];
+        uint32_t minimo = c->ligada[i] ? r->min_ligado_ms : r->min_desligado_ms;
+        bool pode_mudar = !c->iniciada[i] || no_estado >= (int64_t)minimo;
+
+        if (pode_mudar && !c->ligada[i] && quer_ligar) {
+            c->ligada[i] = true;
+            c->iniciada[i] = true;
+            c->mudou_ms[i] = agora_ms;
+        } else if (pode_mudar && c->ligada[i] && quer_desligar) {
+            c->ligada[i] = false;
+            c->mudou_ms[i] = agora_ms;
+        }
+
+        if (c->ligada[i]) {
+            saidas |= 1u << r->saida;
+        }
+    }
+
+    // Saída de regra removida cumpre o mínimo ligado antes de desligar
+    for (int s = 0; s < CONTROLE_SAIDAS_MAX; s++) {
+        uint32_t bit = 1u << s;
+        if ((c->saidas & bit) && !(saidas & bit) && agora_ms < c->retida_ate_ms[s]) {
+            saidas |= bit;
+        }
+    }
+
+    uint32_t trocadas = saidas ^ c->saidas;
+    for (int s = 0; s < CONTROLE_SAIDAS_MAX; s++) {
+        if (trocadas & (1u << s)) {
+            c->saida_mudou_ms[s] = agora_ms;
+        }
+    }
+    c->saidas_iniciadas |= trocadas;
+    c->saidas = saidas;
+    return saidas;
+}
@@ -2,12 +2,51 @@
 #define CONEXAO_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "mqtt_em_voo.h"
+#include "tls_sessao.h"
+
+// Mudanças de conectividade, avisadas na tarefa de eventos do Wi-Fi/MQTT
+// (o callback não deve bloquear)
+typedef enum {
+    CONEXAO_EVT_WIFI_IP,
+    CONEXAO_EVT_WIFI_CAIU,
+    CONEXAO_EVT_MQTT_CONECTADO,
+    CONEXAO_EVT_MQTT_CAIU,
+} conexao_evento_t;
+
+typedef void (*conexao_evento_cb_t)(conexao_evento_t evento);
+void conexao_set_evento_cb(conexao_evento_cb_t cb);
 
 void conexao_wifi_init(void);
 bool conexao_wifi_is_connected(void);
 
 void conexao_mqtt_start(void);
 bool conexao_mqtt_is_connected(void);
+void conexao_mqtt_reconectar(void);
+
+// Assina o tópico (QoS 1) a cada conexão; chamar antes de conexao_mqtt_start.
+// O callback roda na tarefa do MQTT e recebe o payload sem terminador.
+typedef void (*conexao_mqtt_msg_cb_t)(const char *data, int len);
+void conexao_mqtt_assinar(const char *topic, conexao_mqtt_msg_cb_t cb);
 bool conexao_mqtt_publish(const char *topic, const char *message);
 
+// Publicação assíncrona QoS 1: retorna um handle (> 0) e o resultado chega
+// no callback quando o PUBACK chega (confirmada) ou por timeout/desconexão.
+// O callback roda na tarefa do MQTT ou do esp_timer: não deve bloquear.
+typedef int32_t conexao_pub_handle_t;
+#define CONEXAO_PUB_DESCONECTADO  (-1)
+#define CONEXAO_PUB_CHEIO         (-2)   // limite de publicações em voo
+
+typedef void (*conexao_mqtt_resultado_cb_t)(conexao_pub_handle_t handle, bool confirmada, void *ctx);
+
+conexao_pub_handle_t conexao_mqtt_publish_async(const char *topic, const void *data, int len,
+                                                conexao_mqtt_resultado_cb_t cb, void *ctx);
+
+// Contadores e percentis de latência publish -> PUBACK
+void conexao_mqtt_get_stats(mqtt_em_voo_stats_t *stats);
+
+// Handshakes TLS completos e retomados desde o boot
+void conexao_tls_get_stats(tls_sessao_stats_t *stats);
+
 #endif // CONEXAO_H
@@ -0,0 +1,280 @@
+#include "tls_sessao.h"
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include "esp_tls.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/platform_util.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "TLS";
+
+#define MESTRE_BYTES  48
+
+typedef struct {
+    tls_sessao_config_t   cfg;
+    tls_keep_alive_cfg_t  keep_alive;
+    esp_tls_t            *tls;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    esp_tls_client_session_t *sessao;   // da última conexão; oferecida na próxima
+    bool                  tem_mestre;
+    unsigned char         mestre[MESTRE_BYTES];   // segredo mestre da sessão guardada
+#endif
+} tls_sessao_t;
+
+static tls_sessao_t estado;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static tls_sessao_stats_t stats;
+
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+// Segredo mestre da sessão em uso (TLS 1.2). Quando o servidor aceita a
+// sessão oferecida (por ID ou ticket) o mbedTLS reusa o segredo dela; um
+// handshake completo deriva outro. Campo privado: não há API pública para
+// "retomada?". Em TLS 1.3 retorna false e o handshake conta como completo.
+static bool segredo_da_sessao(esp_tls_t *tls, unsigned char *mestre)
+{
+#if defined(MBEDTLS_SSL_PROTO_TLS1_2)
+    mbedtls_ssl_context *ssl = esp_tls_get_ssl_context(tls);
+    if (ssl != NULL && ssl->MBEDTLS_PRIVATE(session) != NULL &&
+        mbedtls_ssl_get_version_number(ssl) == MBEDTLS_SSL_VERSION_TLS1_2) {
+        memcpy(mestre, ssl->MBEDTLS_PRIVATE(session)->MBEDTLS_PRIVATE(master), MESTRE_BYTES);
+        return true;
+    }
+#endif
+    return false;
+}
+
+static void esquecer_sessao(tls_sessao_t *s)
+{
+    if (s->sessao != NULL) {
+        esp_tls_free_client_session(s->sessao);
+        s->sessao = NULL;
+    }
+    mbedtls_platform_zeroize(s->mestre, sizeof(s->mestre));
+    s->tem_mestre = false;
+}
+#endif
+
+static void registrar_handshake(bool retomado, int64_t dt_us)
+{
+    portENTER_CRITICAL(&stats_lock);
+    if (retomado) {
+        stats.retomados++;
+        stats.retomado_total_us += dt_us;
+        if (dt_us > stats.retomado_max_us) {
+            stats.retomado_max_us = dt_us;
+        }
+    } else {
+        stats.completos++;
+        stats.completo_total_us += dt_us;
+        if (dt_us > stats.completo_max_us) {
+            stats.completo_max_us = dt_us;
+        }
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+static int sessao_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    tls_sessao_t *s = esp_transport_get_context_data(t);
+
+    esp_tls_cfg_t cfg = {
+        .cacert_buf = (const unsigned char *)s->cfg.cacert,
+        .cacert_bytes = s->cfg.cacert_len,
+        .timeout_ms = timeout_ms,
+        .keep_alive_cfg = s->keep_alive.keep_alive_enable ? &s->keep_alive : NULL,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .client_session = s->sessao,
+#endif
+    };
+
+    s->tls = esp_tls_init();
+    if (s->tls == NULL) {
+        return -1;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    if (esp_tls_conn_new_sync(host, strlen(host), port, &cfg, s->tls) <= 0) {
+        ESP_LOGW(TAG, "Falha na conexão TLS com %s:%d", host, port);
+        esp_tls_conn_destroy(s->tls);
+        s->tls = NULL;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        // Se a sessão guardada atrapalhou, a próxima tentativa vai sem ela
+        esquecer_sessao(s);
+#endif
+        portENTER_CRITICAL(&stats_lock);
+        stats.falhas++;
+        portEXIT_CRITICAL(&stats_lock);
+        return -1;
+    }
+    int64_t dt_us = esp_timer_get_time() - t0;
+
+    bool retomado = false;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    unsigned char mestre[MESTRE_BYTES];
+    bool tem_mestre = segredo_da_sessao(s->tls, mestre);
+    retomado = (s->sessao != NULL && tem_mestre && s->tem_mestre &&
+                memcmp(mestre, s->mestre, MESTRE_BYTES) == 0);
+
+    // Só pode ser obtida uma vez por conexão; substitui a anterior
+    esp_tls_client_session_t *nova = esp_tls_get_client_session(s->tls);
+    if (nova != NULL) {
+        esquecer_sessao(s);
+        s->sessao = nova;
+        s->tem_mestre = tem_mestre;
+        memcpy(s->mestre, mestre, MESTRE_BYTES);
+    }
+    mbedtls_platform_zeroize(mestre, sizeof(mestre));
+#endif
+
+    registrar_handshake(retomado, dt_us);
+    ESP_LOGI(TAG, "Handshake %s com %s em %lld ms", retomado ? "retomado" : "completo",
+             host, (long long)(dt_us / 1000));
+    return 0;
+}
+
+static int sessao_poll(tls_sessao_t *s, int timeout_ms, bool escrita)
+{
+    int fd = -1;
+    if (s->tls == NULL || esp_tls_get_conn_sockfd(s->tls, &fd) != ESP_OK || fd < 0) {
+        return -1;
+    }
+
+    fd_set fds, erros;
+    FD_ZERO(&fds);
+    FD_ZERO(&erros);
+    FD_SET(fd, &fds);
+    FD_SET(fd, &erros);
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+
+    int ret = select(fd + 1, escrita ? NULL : &fds, escrita ? &fds : NULL, &erros,
+                     timeout_ms < 0 ? NULL : &tv);
+    if (ret > 0 && FD_ISSET(fd, &erros)) {
+        int erro = 0;
+        socklen_t len = sizeof(erro);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &erro, &len);
+        ESP_LOGW(TAG, "Erro no socket: %d", erro);
+        return -1;
+    }
+    return ret;
+}
+
+static int sessao_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    tls_sessao_t *s = esp_transport_get_context_data(t);
+    // Registro TLS já decifrado no buffer do mbedTLS não aparece no socket
+    if (s->tls != NULL && esp_tls_get_bytes_avail(s->tls) > 0) {
+        return 1;
+    }
+    return sessao_poll(s, timeout_ms, false);
+}
+
+static int sessao_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    return sessao_poll(esp_transport_get_context_data(t), timeout_ms, true);
+}
+
+static int sessao_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    tls_sessao_t *s = esp_transport_get_context_data(t);
+
+    int poll = sessao_poll_read(t, timeout_ms);
+    if (poll <= 0) {
+        return poll < 0 ? ERR_TCP_TRANSPORT_CONNECTION_FAILED : ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+
+    int ret = esp_tls_conn_read(s->tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret == 0) {
+        // Socket legível e nada lido: o servidor fechou
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    if (ret < 0) {
+        ESP_LOGW(TAG, "Erro de leitura TLS: -0x%x", -ret);
+        return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    }
+    return ret;
+}
+
+static int sessao_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+{
+    tls_sessao_t *s = esp_transport_get_context_data(t);
+
+    int poll = sessao_poll_write(t, timeout_ms);
+    if (poll <= 0) {
+        ESP_LOGW(TAG, "Socket não liberou escrita em %d ms", timeout_ms);
+        return -1;
+    }
+
+    int ret = esp_tls_conn_write(s->tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 0;
+    }
+    if (ret < 0) {
+        ESP_LOGW(TAG, "Erro de escrita TLS: -0x%x", -ret);
+        return -1;
+    }
+    return ret;
+}
+
+static int sessao_close(esp_transport_handle_t t)
+{
+    tls_sessao_t *s = esp_transport_get_context_data(t);
+    // A sessão guardada sobrevive ao fechamento: é ela que a reconexão oferece
+    int ret = 0;
+    if (s->tls != NULL) {
+        ret = esp_tls_conn_destroy(s->tls);
+        s->tls = NULL;
+    }
+    return ret;
+}
+
+static int sessao_destroy(esp_transport_handle_t t)
+{
+    tls_sessao_t *s = esp_transport_get_context_data(t);
+    sessao_close(t);
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    esquecer_sessao(s);
+#endif
+    (void)s;
+    return 0;
+}
+
+esp_transport_handle_t tls_sessao_transporte(const tls_sessao_config_t *cfg)
+{
+    esp_transport_handle_t t = esp_transport_init();
+    if (t == NULL) {
+        return NULL;
+    }
+
+    memset(&estado, 0, sizeof(estado));
+    estado.cfg = *cfg;
+    estado.keep_alive = (tls_keep_alive_cfg_t) {
+        .keep_alive_enable = cfg->tcp_keepalive_s > 0,
+        .keep_alive_idle = cfg->tcp_keepalive_s,
+        .keep_alive_interval = cfg->tcp_intervalo_s,
+        .keep_alive_count = cfg->tcp_sondas,
+    };
+
+    esp_transport_set_context_data(t, &estado);
+    esp_transport_set_func(t, sessao_connect, sessao_read, sessao_write, sessao_close,
+                           sessao_poll_read, sessao_poll_write, sessao_destroy);
+#ifndef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    ESP_LOGW(TAG, "CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS desligado: todo handshake será completo");
+#endif
+    return t;
+}
+
+void tls_sessao_get_stats(tls_sessao_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,50 @@
+#ifndef TLS_SESSAO_H
+#define TLS_SESSAO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_transport.h"
+
+/* ============================================================
+ * Transporte TLS com retomada de sessão
+ * ============================================================
+ * O transporte SSL do esp-mqtt faz handshake completo a cada
+ * reconexão (segundos de CPU e rádio no ESP32). Este transporte usa
+ * o esp-tls diretamente e guarda a sessão (ticket ou ID) da última
+ * conexão em RAM: a próxima oferece a sessão e o servidor pode
+ * retomá-la sem troca de certificado nem ECDHE.
+ *
+ * Passado ao esp-mqtt em network.transport, embaixo do WebSocket.
+ * Também liga o keepalive TCP, que derruba uma conexão meio-aberta
+ * antes do keepalive MQTT.
+ */
+
+typedef struct {
+    const char *cacert;              // PEM com terminador
+    size_t      cacert_len;
+    int         tcp_keepalive_s;     // ocioso até a primeira sonda (0 = desligado)
+    int         tcp_intervalo_s;
+    int         tcp_sondas;
+} tls_sessao_config_t;
+
+typedef struct {
+    uint32_t completos;
+    uint32_t retomados;
+    uint32_t falhas;
+    int64_t  completo_total_us;
+    int64_t  completo_max_us;
+    int64_t  retomado_total_us;
+    int64_t  retomado_max_us;
+} tls_sessao_stats_t;
+
+/**
+ * @brief Cria o transporte (um por processo; a sessão é única).
+ */
+esp_transport_handle_t tls_sessao_transporte(const tls_sessao_config_t *cfg);
+
+/**
+ * @brief Handshakes desde o boot (tempo inclui DNS e TCP).
+ */
+void tls_sessao_get_stats(tls_sessao_stats_t *stats);
+
+#endif // TLS_SESSAO_H
@@ -4,11 +4,51 @@
 // Wi-Fi
 #include "secrets.h"
 
+// IP fixo dispensa o DHCP a cada reconexão (0 = DHCP, que já tenta
+// reaproveitar o último IP via CONFIG_LWIP_DHCP_RESTORE_LAST_IP)
+#define WIFI_IP_ESTATICO  0
+#define WIFI_IP           "192.168.0.50"
+#define WIFI_MASCARA      "255.255.255.0"
+#define WIFI_GATEWAY      "192.168.0.1"
+#define WIFI_DNS          "192.168.0.1"
+
 // MQTT (futuramente)
 #define MQTT_BROKER     "mqtt.greense.com.br" //"10.42.0.1"
 #define MQTT_TOPIC      "estufa/maturar"
 #define MQTT_CLIENT_ID  "Estufa_Maturar"
-#define MQTT_KEEPALIVE  60
+#define MQTT_KEEPALIVE  45    // s; abaixo do timeout ocioso de 60 s de proxies WebSocket
+
+// Conexão MQTT sobre WSS (conexoes/tls_sessao.h): a sessão TLS fica em RAM e
+// é oferecida na reconexão. O keepalive TCP detecta conexão meio-aberta em
+// MQTT_TCP_KEEPALIVE_S + MQTT_TCP_SONDAS * MQTT_TCP_INTERVALO_S.
+#define MQTT_TIMEOUT_REDE_MS  15000   // conexão/handshake e escrita no socket
+#define MQTT_RECONEXAO_MS     5000    // espera do esp-mqtt entre tentativas
+#define MQTT_TCP_KEEPALIVE_S  30
+#define MQTT_TCP_INTERVALO_S  5
+#define MQTT_TCP_SONDAS       3
+
+// Lote binário (fila/lote.h): publica ao juntar MQTT_LOTE_AMOSTRAS ou quando a
+// amostra mais antiga do lote tem MQTT_LOTE_PERIODO_S. Com 0 amostras cada
+// leitura é publicada em JSON em MQTT_TOPIC (formato anterior).
+#define MQTT_TOPIC_LOTE      "estufa/maturar/lote"
+#define MQTT_LOTE_LAYOUT     2
+#define MQTT_LOTE_AMOSTRAS   12
+#define MQTT_LOTE_PERIODO_S  60
+
+// Banda morta (sensores/banda_morta.h): a leitura só é publicada quando algum
+// canal muda mais que o seu delta (sensores_canais) ou a cada
+// BANDA_MORTA_SILENCIO_S; 0 publica toda leitura. Limites ajustáveis em JSON
+// no tópico MQTT_TOPIC_CONFIG e guardados no NVS.
+#define MQTT_TOPIC_CONFIG       "estufa/maturar/config"
+#define BANDA_MORTA_SILENCIO_S  300
+
+// Controle local (atuadores/controle.h): regras com histerese avaliadas a cada
+// leitura, comandando as saídas ATUADORES_GPIO_SAIDAS. Conjunto de regras em
+// JSON no tópico MQTT_TOPIC_REGRAS, guardado no NVS.
+#define MQTT_TOPIC_REGRAS       "estufa/maturar/regras"
+
+// Horário das amostras (fila/relogio.h)
+#define SNTP_SERVIDOR  "pool.ntp.org"
 
 // Sensores
 #define SENSOR_READ_INTERVAL 5  // segundos
@@ -0,0 +1,406 @@
+#include "fila.h"
+#include "relogio.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "FILA";
+
+#define ESTADO_LIVRE       0xFF
+#define ESTADO_PENDENTE    0xFE
+#define ESTADO_CONFIRMADO  0xFC
+
+#define SETOR_BYTES        4096
+#define SLOTS_POR_SETOR    (SETOR_BYTES / FILA_SLOT_BYTES)
+
+typedef struct __attribute__((packed)) {
+    uint8_t  estado;
+    uint8_t  tamanho;
+    uint16_t crc;
+    uint32_t seq;
+    uint32_t t_ms;
+    uint8_t  dados[FILA_DADOS_MAX];
+} slot_t;
+
+_Static_assert(sizeof(slot_t) == FILA_SLOT_BYTES, "slot da fila deve ter FILA_SLOT_BYTES");
+
+static const esp_partition_t *particao = NULL;
+static SemaphoreHandle_t fila_mutex = NULL;
+
+static uint32_t n_slots;
+static uint32_t cabeca;       // pendente mais antiga (== cauda se vazia)
+static uint32_t cauda;        // próximo slot a gravar
+static uint32_t cursor;       // próximo slot a entregar para envio
+static uint32_t proximo_seq;
+static uint32_t seq_boot;     // primeira sequência gravada neste boot
+static fila_stats_t stats;
+
+// ======== SLOTS ========
+
+static uint32_t proximo(uint32_t s)
+{
+    return (s + 1 == n_slots) ? 0 : s + 1;
+}
+
+// Uptime em ms; o slot guarda só os 32 bits de baixo (volta a cada ~49,7 dias)
+static int64_t agora_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+// Uptime completo de uma amostra do boot atual a partir dos 32 bits gravados:
+// ela foi lida antes de agora, há menos de 2^32 ms
+static int64_t uptime_da_amostra(uint32_t t_ms, int64_t agora)
+{
+    return agora - (uint32_t)((uint32_t)agora - t_ms);
+}
+
+static uint16_t slot_crc(const slot_t *s)
+{
+    uint16_t crc = esp_rom_crc16_le(0, &s->tamanho, 1);
+    return esp_rom_crc16_le(crc, (const uint8_t *)&s->seq,
+                            sizeof(slot_t) - offsetof(slot_t, seq));
+}
+
+static bool slot_valido(const slot_t *s)
+{
+    return (s->estado == ESTADO_PENDENTE || s->estado == ESTADO_CONFIRMADO) &&
+           s->tamanho <= FILA_DADOS_MAX &&
+           s->crc == slot_crc(s);
+}
+
+static bool slot_livre(const slot_t *s)
+{
+    const uint8_t *p = (const uint8_t *)s;
+    for (size_t i = 0; i < sizeof(slot_t); i++) {
+        if (p[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t ler_slot(uint32_t slot, slot_t *s)
+{
+    return esp_partition_read(particao, slot * FILA_SLOT_BYTES, s, sizeof(slot_t));
+}
+
+static bool slot_pendente(uint32_t slot)
+{
+    slot_t s;
+    return ler_slot(slot, &s) == ESP_OK && slot_valido(&s) && s.estado == ESTADO_PENDENTE;
+}
+
+// Avança a cabeça até a próxima pendente (ou até a cauda)
+static void avancar_cabeca(void)
+{
+    if (stats.pendentes == 0) {
+        cabeca = cauda;
+        return;
+    }
+    while (cabeca != cauda && !slot_pendente(cabeca)) {
+        cabeca = proximo(cabeca);
+    }
+}
+
+// Apaga o setor em que a cauda vai entrar; se ainda houver pendentes
+// nele o anel está cheio e elas (as mais antigas) são descartadas.
+static esp_err_t preparar_setor(uint32_t setor)
+{
+    uint32_t ini = setor * SLOTS_POR_SETOR;
+    uint32_t fim = ini + SLOTS_POR_SETOR;
+
+    if (stats.pendentes > 0 && cabeca >= ini && cabeca < fim) {
+        uint32_t perdidas = 0;
+        for (uint32_t s = cabeca; s < fim; s++) {
+            if (slot_pendente(s)) {
+                perdidas++;
+            }
+        }
+        stats.pendentes -= perdidas;
+        stats.descartadas += perdidas;
+
+        bool cursor_no_setor = (cursor >= ini && cursor < fim);
+        cabeca = (fim == n_slots) ? 0 : fim;
+        avancar_cabeca();
+        if (cursor_no_setor) {
+            cursor = cabeca;
+        }
+        ESP_LOGW(TAG, "Fila cheia: %lu amostras antigas descartadas", (unsigned long)perdidas);
+    }
+
+    esp_err_t err = esp_partition_erase_range(particao, (size_t)ini * FILA_SLOT_BYTES, SETOR_BYTES);
+    if (err == ESP_OK) {
+        stats.apagamentos++;
+    } else {
+        ESP_LOGE(TAG, "Falha ao apagar setor %lu: %s", (unsigned long)setor, esp_err_to_name(err));
+    }
+    return err;
+}
+
+// ======== API ========
+
+esp_err_t fila_init(void)
+{
+    particao = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                        FILA_PARTICAO_LABEL);
+    if (particao == NULL) {
+        ESP_LOGE(TAG, "Partição '%s' não encontrada", FILA_PARTICAO_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    n_slots = (particao->size / SETOR_BYTES) * SLOTS_POR_SETOR;
+    if (n_slots < 2 * SLOTS_POR_SETOR) {
+        ESP_LOGE(TAG, "Partição '%s' pequena demais", FILA_PARTICAO_LABEL);
+        particao = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (fila_mutex == NULL) {
+        fila_mutex = xSemaphoreCreateMutex();
+    }
+
+    slot_t *setor = malloc(SETOR_BYTES);
+    if (setor == NULL) {
+        particao = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    stats.capacidade = n_slots;
+
+    // Varre o anel: maior sequência válida marca a cauda,
+    // menor sequência pendente marca a cabeça.
+    bool achou = false, tem_pendente = false;
+    uint32_t seq_max = 0, idx_max = 0;
+    uint32_t seq_min = 0, idx_min = 0;
+    int64_t t0 = esp_timer_get_time();
+
+    for (uint32_t sec = 0; sec < n_slots / SLOTS_POR_SETOR; sec++) {
+        if (esp_partition_read(particao, (size_t)sec * SETOR_BYTES, setor, SETOR_BYTES) != ESP_OK) {
+            continue;
+        }
+        for (uint32_t j = 0; j < SLOTS_POR_SETOR; j++) {
+            const slot_t *s = &setor[j];
+            if (!slot_valido(s)) {
+                continue;
+            }
+            uint32_t idx = sec * SLOTS_POR_SETOR + j;
+            if (!achou || s->seq > seq_max) {
+                achou = true;
+                seq_max = s->seq;
+                idx_max = idx;
+            }
+            if (s->estado == ESTADO_PENDENTE) {
+                stats.pendentes++;
+                if (!tem_pendente || s->seq < seq_min) {
+                    tem_pendente = true;
+                    seq_min = s->seq;
+                    idx_min = idx;
+                }
+            }
+        }
+    }
+    free(setor);
+
+    if (achou) {
+        cauda = proximo(idx_max);
+        proximo_seq = seq_max + 1;
+    } else {
+        // Partição nova ou com lixo: começa do setor 0
+        cauda = 0;
+        proximo_seq = 1;
+        esp_err_t err = esp_partition_erase_range(particao, 0, SETOR_BYTES);
+        if (err != ESP_OK) {
+            particao = NULL;
+            return err;
+        }
+        stats.apagamentos++;
+    }
+    cabeca = tem_pendente ? idx_min : cauda;
+    cursor = cabeca;
+    seq_boot = proximo_seq;
+    relogio_init(seq_boot);
+
+    ESP_LOGI(TAG, "Fila: %lu slots, %lu pendentes, próxima seq %lu (varredura %lld ms)",
+             (unsigned long)n_slots, (unsigned long)stats.pendentes,
+             (unsigned long)proximo_seq, (long long)((esp_timer_get_time() - t0) / 1000));
+    return ESP_OK;
+}
+
+esp_err_t fila_push(const void *dados, size_t tamanho, uint32_t *seq_out)
+{
+    if (particao == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (dados == NULL || tamanho > FILA_DADOS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(fila_mutex, portMAX_DELAY);
+
+    // Setor novo é apagado; slot sujo (queda de energia no meio da gravação) é pulado
+    slot_t s;
+    esp_err_t err = ESP_OK;
+    for (uint32_t tentativas = 0; tentativas < SLOTS_POR_SETOR; tentativas++) {
+        if (cauda % SLOTS_POR_SETOR == 0) {
+            err = preparar_setor(cauda / SLOTS_POR_SETOR);
+            if (err != ESP_OK) {
+                break;
+            }
+        }
+        err = ler_slot(cauda, &s);
+        if (err == ESP_OK && slot_livre(&s)) {
+            break;
+        }
+        cauda = proximo(cauda);
+        err = ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        xSemaphoreGive(fila_mutex);
+        return err;
+    }
+
+    uint32_t slot = cauda;
+    memset(&s, 0, sizeof(s));
+    s.estado = ESTADO_LIVRE;
+    s.tamanho = (uint8_t)tamanho;
+    s.seq = proximo_seq;
+    s.t_ms = (uint32_t)agora_ms();
+    memcpy(s.dados, dados, tamanho);
+    s.crc = slot_crc(&s);
+
+    // Corpo primeiro, estado por último: o slot só vale depois do byte de estado
+    size_t off = (size_t)slot * FILA_SLOT_BYTES;
+    err = esp_partition_write(particao, off + 1, (const uint8_t *)&s + 1, sizeof(s) - 1);
+    if (err == ESP_OK) {
+        uint8_t estado = ESTADO_PENDENTE;
+        err = esp_partition_write(particao, off, &estado, 1);
+    }
+    stats.bytes_gravados += sizeof(s);
+    cauda = proximo(cauda);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao gravar slot %lu: %s", (unsigned long)slot, esp_err_to_name(err));
+        xSemaphoreGive(fila_mutex);
+        return err;
+    }
+
+    if (stats.pendentes == 0) {
+        cabeca = slot;
+        cursor = slot;
+    }
+    stats.pendentes++;
+    stats.gravadas++;
+    if (seq_out) {
+        *seq_out = proximo_seq;
+    }
+    proximo_seq++;
+
+    xSemaphoreGive(fila_mutex);
+    return ESP_OK;
+}
+
+bool fila_proxima(fila_item_t *item)
+{
+    if (particao == NULL || item == NULL) {
+        return false;
+    }
+
+    bool achou = false;
+    xSemaphoreTake(fila_mutex, portMAX_DELAY);
+    while (cursor != cauda) {
+        slot_t s;
+        uint32_t slot = cursor;
+        cursor = proximo(cursor);
+        if (ler_slot(slot, &s) != ESP_OK || !slot_valido(&s) || s.estado != ESTADO_PENDENTE) {
+            continue;
+        }
+        item->slot = slot;
+        item->seq = s.seq;
+        if (s.seq >= seq_boot) {
+            int64_t agora = agora_ms();
+            item->t_ms = uptime_da_amostra(s.t_ms, agora);
+            item->idade_ms = agora - item->t_ms;
+        } else {
+            item->t_ms = s.t_ms;
+            item->idade_ms = -1;
+        }
+        relogio_carimbar(s.seq, item->t_ms, &item->boot, &item->unix_ms);
+        item->tamanho = s.tamanho;
+        memcpy(item->dados, s.dados, s.tamanho);
+        achou = true;
+        break;
+    }
+    xSemaphoreGive(fila_mutex);
+    return achou;
+}
+
+esp_err_t fila_confirmar(uint32_t slot, uint32_t seq)
+{
+    if (particao == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (slot >= n_slots) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(fila_mutex, portMAX_DELAY);
+
+    // O slot pode ter sido descartado e regravado enquanto aguardava o PUBACK
+    slot_t s;
+    esp_err_t err = ler_slot(slot, &s);
+    if (err == ESP_OK && (!slot_valido(&s) || s.estado != ESTADO_PENDENTE || s.seq != seq)) {
+        err = ESP_ERR_NOT_FOUND;
+    }
+    if (err == ESP_OK) {
+        uint8_t estado = ESTADO_CONFIRMADO;
+        err = esp_partition_write(particao, (size_t)slot * FILA_SLOT_BYTES, &estado, 1);
+        stats.bytes_gravados += 1;
+    }
+    if (err == ESP_OK) {
+        stats.pendentes--;
+        stats.confirmadas++;
+        if (slot == cabeca) {
+            avancar_cabeca();
+        }
+    }
+
+    xSemaphoreGive(fila_mutex);
+    return err;
+}
+
+void fila_reenviar_pendentes(void)
+{
+    if (particao == NULL) {
+        return;
+    }
+    xSemaphoreTake(fila_mutex, portMAX_DELAY);
+    cursor = cabeca;
+    xSemaphoreGive(fila_mutex);
+}
+
+uint32_t fila_profundidade(void)
+{
+    return stats.pendentes;
+}
+
+void fila_get_stats(fila_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    if (fila_mutex == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(fila_mutex, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(fila_mutex);
+}
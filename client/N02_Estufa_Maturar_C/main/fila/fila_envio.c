@@ -0,0 +1,289 @@
+#include "fila_envio.h"
+#include <string.h>
+#include "conexoes.h"
+#include "lote.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+static const char *TAG = "FILA_ENVIO";
+
+#define PAYLOAD_MAX          (LOTE_CABECALHO_BYTES + FILA_ENVIO_LOTE_MAX * LOTE_ITEM_BYTES(FILA_DADOS_MAX))
+
+_Static_assert(FILA_ENVIO_JANELA <= MQTT_EM_VOO_MAX, "janela maior que a tabela de publicações em voo");
+
+typedef struct {
+    conexao_pub_handle_t handle;
+    int      n;
+    uint32_t slot[FILA_ENVIO_LOTE_MAX];
+    uint32_t seq[FILA_ENVIO_LOTE_MAX];
+} em_voo_t;
+
+typedef struct {
+    conexao_pub_handle_t handle;
+    bool confirmada;
+} resultado_t;
+
+typedef struct {
+    uint32_t publicacoes;
+    uint32_t amostras;
+    uint64_t bytes_payload;
+} envio_stats_t;
+
+static fila_envio_config_t config;
+static QueueHandle_t resultados;         // resultado_t das publicações
+static em_voo_t em_voo[FILA_ENVIO_JANELA];
+static int n_em_voo = 0;
+static bool reenviar = false;            // PUBACK perdido: volta o cursor quando a janela esvaziar
+
+// Lote em montagem
+static fila_item_t lote[FILA_ENVIO_LOTE_MAX];
+static int64_t lote_puxado_us[FILA_ENVIO_LOTE_MAX];
+static int n_lote = 0;
+static int64_t lote_limite_us;
+static fila_item_t sobra;                // item que não coube no lote atual
+static bool tem_sobra = false;
+
+static envio_stats_t envio_stats;
+
+// ======== CALLBACK (tarefa do MQTT ou do esp_timer) ========
+
+static void on_resultado(conexao_pub_handle_t handle, bool confirmada, void *ctx)
+{
+    resultado_t r = { .handle = handle, .confirmada = confirmada };
+    xQueueSend(resultados, &r, 0);
+}
+
+// ======== TAREFA ========
+
+// Só volta o cursor sem publicações em voo: as que ainda estão na janela
+// seguem rastreadas, e as confirmadas não são reenviadas
+static void rebobinar_se_vazia(void)
+{
+    if (reenviar && n_em_voo == 0) {
+        reenviar = false;
+        fila_reenviar_pendentes();
+    }
+}
+
+static void reiniciar_envio(const char *motivo)
+{
+    if (!reenviar) {
+        ESP_LOGW(TAG, "%s: reenvio da pendente mais antiga após %d publicações em voo",
+                 motivo, n_em_voo);
+    }
+    reenviar = true;
+    n_lote = 0;
+    tem_sobra = false;
+    rebobinar_se_vazia();
+}
+
+static void tratar_resultado(const resultado_t *r)
+{
+    for (int i = 0; i < n_em_voo; i++) {
+        if (em_voo[i].handle != r->handle) {
+            continue;
+        }
+        if (r->confirmada) {
+            for (int j = 0; j < em_voo[i].n; j++) {
+                fila_confirmar(em_voo[i].slot[j], em_voo[i].seq[j]);
+            }
+        }
+        em_voo[i] = em_voo[--n_em_voo];
+        if (!r->confirmada) {
+            // Timeout ou desconexão: este lote volta na próxima passada
+            reiniciar_envio("PUBACK não recebido");
+        }
+        rebobinar_se_vazia();
+        return;
+    }
+}
+
+static bool publicar(const char *topico, const void *payload, int len,
+                     const fila_item_t *itens, int n)
+{
+    conexao_pub_handle_t h = conexao_mqtt_publish_async(topico, payload, len, on_resultado, NULL);
+    if (h < 0) {
+        return false;
+    }
+
+    em_voo_t *v = &em_voo[n_em_voo++];
+    v->handle = h;
+    v->n = n;
+    for (int i = 0; i < n; i++) {
+        v->slot[i] = itens[i].slot;
+        v->seq[i] = itens[i].seq;
+    }
+
+    envio_stats.publicacoes++;
+    envio_stats.amostras += n;
+    envio_stats.bytes_payload += len;
+    ESP_LOGD(TAG, "Publicado seq=%lu..%lu (handle=%ld, %d B)",
+             (unsigned long)itens[0].seq, (unsigned long)itens[n - 1].seq, (long)h, len);
+    return true;
+}
+
+static bool puxar(fila_item_t *item)
+{
+    if (tem_sobra) {
+        *item = sobra;
+        tem_sobra = false;
+        return true;
+    }
+    return fila_proxima(item);
+}
+
+// Uma amostra por publicação, em JSON
+static void enviar_json(char *payload, size_t cap)
+{
+    fila_item_t item;
+    if (!puxar(&item)) {
+        return;
+    }
+
+    int len = config.formatar(&item, payload, cap);
+    if (len <= 0 || len >= (int)cap) {
+        // Amostra ilegível não pode travar a fila
+        ESP_LOGE(TAG, "Amostra seq=%lu inválida, descartando", (unsigned long)item.seq);
+        fila_confirmar(item.slot, item.seq);
+        return;
+    }
+
+    if (!publicar(config.topico, payload, len, &item, 1)) {
+        reiniciar_envio("Falha na publicação");
+    }
+}
+
+// Junta até lote_amostras e publica quando cheio ou vencido
+static void enviar_lote(uint8_t *payload, size_t cap)
+{
+    int64_t agora_us = esp_timer_get_time();
+    bool fechar = false;
+
+    while (n_lote < config.lote_amostras) {
+        fila_item_t item;
+        if (!puxar(&item)) {
+            break;
+        }
+        if (n_lote > 0 && !lote_compativel(&lote[0], &item)) {
+            sobra = item;
+            tem_sobra = true;
+            fechar = true;
+            break;
+        }
+        if (n_lote == 0) {
+            // Prazo conta a partir da leitura; amostra de boot anterior sai já
+            int64_t idade_us = (item.idade_ms < 0)
+                               ? (int64_t)config.lote_periodo_s * 1000000
+                               : item.idade_ms * 1000;
+            lote_limite_us = agora_us - idade_us + (int64_t)config.lote_periodo_s * 1000000;
+        }
+        lote[n_lote] = item;
+        lote_puxado_us[n_lote] = agora_us;
+        n_lote++;
+    }
+
+    if (n_lote == 0 ||
+        (n_lote < config.lote_amostras && !fechar && agora_us < lote_limite_us)) {
+        return;
+    }
+
+    // Atraso no instante da publicação
+    for (int i = 0; i < n_lote; i++) {
+        if (lote[i].idade_ms >= 0) {
+            lote[i].idade_ms += (agora_us - lote_puxado_us[i]) / 1000;
+        }
+    }
+
+    size_t len = lote_codificar(config.layout, lote, n_lote, fila_profundidade(), payload, cap);
+    if (len == 0) {
+        ESP_LOGE(TAG, "Lote seq=%lu inválido, descartando", (unsigned long)lote[0].seq);
+        for (int i = 0; i < n_lote; i++) {
+            fila_confirmar(lote[i].slot, lote[i].seq);
+        }
+        n_lote = 0;
+        return;
+    }
+
+    if (!publicar(config.topico_lote, payload, (int)len, lote, n_lote)) {
+        reiniciar_envio("Falha na publicação");
+        return;
+    }
+    n_lote = 0;
+}
+
+static void relatorio(float segundos)
+{
+    fila_stats_t st;
+    fila_get_stats(&st);
+    ESP_LOGI(TAG, "Fila: %lu pendentes, %lu descartadas, %.1f B gravados/amostra, %lu setores apagados",
+             (unsigned long)st.pendentes, (unsigned long)st.descartadas,
+             st.gravadas ? (double)st.bytes_gravados / st.gravadas : 0.0,
+             (unsigned long)st.apagamentos);
+    ESP_LOGI(TAG, "Envio: %.2f publicações/s, %.2f amostras/s, %.1f B payload/amostra",
+             envio_stats.publicacoes / segundos, envio_stats.amostras / segundos,
+             envio_stats.amostras ? (double)envio_stats.bytes_payload / envio_stats.amostras : 0.0);
+
+    mqtt_em_voo_stats_t mq;
+    conexao_mqtt_get_stats(&mq);
+    ESP_LOGI(TAG, "MQTT: PUBACK p50/p90/p99/max %lu/%lu/%lu/%lu ms, %lu confirmadas, "
+             "%lu perdidas, %lu recusadas, %lu falhas de envio",
+             (unsigned long)mq.lat_p50_ms, (unsigned long)mq.lat_p90_ms,
+             (unsigned long)mq.lat_p99_ms, (unsigned long)mq.lat_max_ms,
+             (unsigned long)mq.confirmadas, (unsigned long)mq.perdidas,
+             (unsigned long)mq.recusadas, (unsigned long)mq.falhas_envio);
+    memset(&envio_stats, 0, sizeof(envio_stats));
+}
+
+static void fila_envio_task(void *arg)
+{
+    static uint8_t payload[PAYLOAD_MAX];
+    const TickType_t intervalo = pdMS_TO_TICKS(1000 / FILA_ENVIO_TAXA_MAX);
+    TickType_t proximo_envio = xTaskGetTickCount();
+    int64_t inicio_relatorio = esp_timer_get_time();
+
+    while (true) {
+        // Espera resultados de publicação até o próximo envio permitido
+        TickType_t agora = xTaskGetTickCount();
+        TickType_t espera = ((int32_t)(proximo_envio - agora) > 0) ? proximo_envio - agora : 0;
+        resultado_t r;
+        if (xQueueReceive(resultados, &r, espera) == pdTRUE) {
+            tratar_resultado(&r);
+            continue;
+        }
+
+        int64_t agora_us = esp_timer_get_time();
+
+        if (agora_us - inicio_relatorio >= (int64_t)FILA_ENVIO_RELATORIO_MS * 1000) {
+            relatorio((agora_us - inicio_relatorio) / 1e6f);
+            inicio_relatorio = agora_us;
+        }
+
+        proximo_envio = xTaskGetTickCount() + intervalo;
+        if (!conexao_mqtt_is_connected() || reenviar || n_em_voo >= FILA_ENVIO_JANELA) {
+            continue;
+        }
+
+        if (config.lote_amostras > 0) {
+            enviar_lote(payload, sizeof(payload));
+        } else {
+            enviar_json((char *)payload, sizeof(payload));
+        }
+    }
+}
+
+void fila_envio_init(const fila_envio_config_t *cfg)
+{
+    config = *cfg;
+    if (config.lote_amostras > FILA_ENVIO_LOTE_MAX) {
+        config.lote_amostras = FILA_ENVIO_LOTE_MAX;
+    }
+    if (config.lote_amostras > 0 && config.topico_lote == NULL) {
+        config.lote_amostras = 0;
+    }
+    resultados = xQueueCreate(2 * FILA_ENVIO_JANELA + 4, sizeof(resultado_t));
+
+    xTaskCreate(fila_envio_task, "fila_envio", 4096, NULL, 5, NULL);
+}
@@ -0,0 +1,85 @@
+#include "lote.h"
+#include <string.h>
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static uint8_t *put_u64(uint8_t *p, uint64_t v)
+{
+    p = put_u32(p, (uint32_t)v);
+    return put_u32(p, (uint32_t)(v >> 32));
+}
+
+bool lote_compativel(const fila_item_t *primeiro, const fila_item_t *item)
+{
+    return item->tamanho == primeiro->tamanho &&
+           item->seq - primeiro->seq <= UINT16_MAX &&
+           item->boot - primeiro->boot <= LOTE_BOOT_DELTA_MAX;
+}
+
+size_t lote_codificar(uint8_t layout, const fila_item_t *itens, int n,
+                      uint32_t profundidade, uint8_t *out, size_t cap)
+{
+    if (itens == NULL || out == NULL || n <= 0 || n > UINT8_MAX) {
+        return 0;
+    }
+
+    uint8_t tamanho = itens[0].tamanho;
+    size_t total = LOTE_CABECALHO_BYTES + (size_t)n * LOTE_ITEM_BYTES(tamanho);
+    if (total > cap) {
+        return 0;
+    }
+
+    uint32_t seq0 = itens[0].seq;
+    int64_t ts0 = 0;
+    for (int i = 0; i < n; i++) {
+        if (!lote_compativel(&itens[0], &itens[i])) {
+            return 0;
+        }
+        if (ts0 == 0) {
+            ts0 = itens[i].unix_ms;
+        }
+    }
+
+    uint8_t *p = out;
+    *p++ = LOTE_VERSAO;
+    *p++ = layout;
+    *p++ = tamanho;
+    *p++ = (uint8_t)n;
+    p = put_u32(p, seq0);
+    p = put_u16(p, profundidade > UINT16_MAX ? UINT16_MAX : (uint16_t)profundidade);
+    p = put_u32(p, itens[0].boot);
+    p = put_u64(p, (uint64_t)ts0);
+
+    for (int i = 0; i < n; i++) {
+        int64_t idade = itens[i].idade_ms;
+        uint32_t atraso = (idade < 0 || idade >= (int64_t)LOTE_ATRASO_DESCONHECIDO)
+                          ? LOTE_ATRASO_DESCONHECIDO : (uint32_t)idade;
+        // Horário fora do alcance de i32 em relação a ts0 cai para o tempo desde o boot
+        uint8_t info = (uint8_t)(itens[i].boot - itens[0].boot);
+        uint32_t t = (uint32_t)itens[i].t_ms;   // sem horário: módulo 2^32, como no slot
+        int64_t dt = itens[i].unix_ms - ts0;
+        if (itens[i].unix_ms != 0 && dt >= INT32_MIN && dt <= INT32_MAX) {
+            info |= LOTE_INFO_HORARIO;
+            t = (uint32_t)(int32_t)dt;
+        }
+        p = put_u16(p, (uint16_t)(itens[i].seq - seq0));
+        p = put_u32(p, atraso);
+        *p++ = info;
+        p = put_u32(p, t);
+        memcpy(p, itens[i].dados, tamanho);
+        p += tamanho;
+    }
+
+    return (size_t)(p - out);
+}
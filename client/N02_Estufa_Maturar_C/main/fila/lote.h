@@ -0,0 +1,48 @@
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "fila.h"
+
+/* ============================================================
+ * Lote binário de amostras (payload MQTT, little-endian)
+ * ============================================================
+ *   0   u8   versão do esquema (LOTE_VERSAO)
+ *   1   u8   layout da amostra (1 = N01 germinar, 2 = N02 maturar)
+ *   2   u8   tamanho S de cada amostra em bytes
+ *   3   u8   número n de amostras
+ *   4   u32  seq da primeira amostra
+ *   8   u16  amostras pendentes na fila do nó
+ *  10   u32  boot da primeira amostra (boot0)
+ *  14   u64  horário Unix (ms) da primeira amostra com horário (ts0), 0 se nenhuma
+ *  22   n × { u16 seq - seq0 ; u32 atraso_ms ; u8 info ; u32 t ; S bytes da amostra }
+ *
+ * info: bits 0-6 = boot - boot0; bit 7 = t é o horário relativo a ts0
+ * (i32, ms). Sem o bit 7 o boot nunca sincronizou e t é o instante da
+ * leitura em ms desde aquele boot (u32, módulo 2^32).
+ * atraso_ms = 0xFFFFFFFF quando a amostra é de um boot anterior.
+ * Decodificador de referência: server/N01_RASP4_LAB/lote_decoder.py
+ */
+
+#define LOTE_VERSAO            2
+#define LOTE_CABECALHO_BYTES   22
+#define LOTE_ITEM_BYTES(s)     (11 + (s))
+#define LOTE_BOOT_DELTA_MAX    0x7F
+#define LOTE_INFO_HORARIO      0x80
+#define LOTE_ATRASO_DESCONHECIDO 0xFFFFFFFFUL
+
+/**
+ * @brief Se item pode entrar no lote que começa em primeiro.
+ */
+bool lote_compativel(const fila_item_t *primeiro, const fila_item_t *item);
+
+/**
+ * @brief Codifica n itens da fila (todos com o mesmo tamanho) em um lote.
+ * @return Bytes escritos, ou 0 se os itens forem incompatíveis ou cap insuficiente
+ */
+size_t lote_codificar(uint8_t layout, const fila_item_t *itens, int n,
+                      uint32_t profundidade, uint8_t *out, size_t cap);
+
+#endif // LOTE_H
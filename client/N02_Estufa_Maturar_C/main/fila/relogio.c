@@ -0,0 +1,154 @@
+#include "relogio.h"
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "esp_timer.h"
+#include "esp_sntp.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "RELOGIO";
+
+#define RELOGIO_NVS_NAMESPACE  "relogio"
+#define RELOGIO_NVS_CHAVE      "boots"
+#define RELOGIO_AJUSTE_MS      1000    // ressincronização que justifica regravar o NVS
+
+typedef struct {
+    uint32_t boot;
+    uint32_t seq_inicio;   // primeira seq gravada naquele boot
+    int64_t  epoch_ms;     // horário Unix em esp_timer = 0 (0 = nunca sincronizou)
+} boot_t;
+
+typedef struct {
+    uint32_t ultimo_boot;
+    uint32_t n;
+    boot_t   boots[RELOGIO_BOOTS];   // do mais antigo ao atual
+} tabela_t;
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static tabela_t tabela;
+static bool registrado = false;
+static int64_t epoch_atual_ms = 0;
+
+static void salvar(const tabela_t *t)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(RELOGIO_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, RELOGIO_NVS_CHAVE, t, sizeof(*t));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Falha ao salvar tabela de boots: %s", esp_err_to_name(err));
+    }
+}
+
+esp_err_t relogio_init(uint32_t seq_inicio)
+{
+    tabela_t t;
+    memset(&t, 0, sizeof(t));
+
+    nvs_handle_t handle;
+    if (nvs_open(RELOGIO_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        size_t len = sizeof(t);
+        if (nvs_get_blob(handle, RELOGIO_NVS_CHAVE, &t, &len) != ESP_OK ||
+            len != sizeof(t) || t.n > RELOGIO_BOOTS) {
+            memset(&t, 0, sizeof(t));
+        }
+        nvs_close(handle);
+    }
+
+    // Sequência voltou (partição da fila apagada): boots com seq maior não valem mais
+    while (t.n > 0 && t.boots[t.n - 1].seq_inicio > seq_inicio) {
+        t.n--;
+    }
+    if (t.n == RELOGIO_BOOTS) {
+        memmove(&t.boots[0], &t.boots[1], (RELOGIO_BOOTS - 1) * sizeof(boot_t));
+        t.n--;
+    }
+    t.ultimo_boot++;
+
+    portENTER_CRITICAL(&lock);
+    t.boots[t.n++] = (boot_t){ .boot = t.ultimo_boot, .seq_inicio = seq_inicio,
+                               .epoch_ms = epoch_atual_ms };
+    tabela = t;
+    registrado = true;
+    portEXIT_CRITICAL(&lock);
+
+    salvar(&t);
+    ESP_LOGI(TAG, "Boot %lu, primeira seq %lu", (unsigned long)t.ultimo_boot, (unsigned long)seq_inicio);
+    return ESP_OK;
+}
+
+// Chamado na tarefa do lwip a cada sincronização
+static void on_sntp(struct timeval *tv)
+{
+    static tabela_t copia;
+    int64_t epoch = (int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000 - esp_timer_get_time() / 1000;
+    bool gravar = false;
+
+    portENTER_CRITICAL(&lock);
+    bool primeira = (epoch_atual_ms == 0);
+    epoch_atual_ms = epoch;
+    if (registrado) {
+        boot_t *b = &tabela.boots[tabela.n - 1];
+        if (b->epoch_ms == 0 || llabs(b->epoch_ms - epoch) > RELOGIO_AJUSTE_MS) {
+            b->epoch_ms = epoch;
+            copia = tabela;
+            gravar = true;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (gravar) {
+        salvar(&copia);
+    }
+    if (primeira) {
+        ESP_LOGI(TAG, "Relógio sincronizado via SNTP (%lld s desde o boot)",
+                 (long long)(esp_timer_get_time() / 1000000));
+    }
+}
+
+void relogio_sntp_iniciar(const char *servidor)
+{
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, servidor);
+    sntp_set_time_sync_notification_cb(on_sntp);
+    esp_sntp_init();
+}
+
+bool relogio_sincronizado(void)
+{
+    return epoch_atual_ms != 0;
+}
+
+uint32_t relogio_boot_atual(void)
+{
+    return registrado ? tabela.ultimo_boot : 0;
+}
+
+void relogio_carimbar(uint32_t seq, int64_t t_ms, uint32_t *boot, int64_t *unix_ms)
+{
+    const boot_t *achado = NULL;
+    *boot = 0;
+    *unix_ms = 0;
+
+    portENTER_CRITICAL(&lock);
+    // seq_inicio não decresce ao longo da tabela: vale o último boot que começou antes
+    for (uint32_t i = 0; i < tabela.n; i++) {
+        if (tabela.boots[i].seq_inicio <= seq) {
+            achado = &tabela.boots[i];
+        }
+    }
+    if (achado != NULL) {
+        *boot = achado->boot;
+        if (achado->epoch_ms != 0) {
+            *unix_ms = achado->epoch_ms + t_ms;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
@@ -0,0 +1,49 @@
+#ifndef RELOGIO_H
+#define RELOGIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Boot e horário das amostras da fila
+ * ============================================================
+ * Cada boot recebe um número (contador no NVS) e registra a primeira
+ * sequência da fila gravada nele. Quando o SNTP sincroniza, o boot
+ * guarda o horário Unix correspondente a esp_timer = 0; assim uma
+ * amostra (seq, t_ms desde o boot) ganha boot e horário mesmo se foi
+ * lida antes da sincronização ou num boot anterior.
+ *
+ * A tabela guarda os RELOGIO_BOOTS boots mais recentes; amostras
+ * mais antigas que isso saem com boot 0 e sem horário.
+ *
+ * O slot da fila guarda t_ms em 32 bits. Para amostras do boot atual
+ * fila.c reconstrói o uptime completo; de um boot anterior que passou
+ * de ~49,7 dias só restam os 32 bits, e o horário sai adiantado do
+ * múltiplo de 2^32 ms perdido.
+ */
+
+#define RELOGIO_BOOTS  16
+
+/**
+ * @brief Conta o boot e registra a primeira sequência dele.
+ *        Chamado por fila_init.
+ */
+esp_err_t relogio_init(uint32_t seq_inicio);
+
+/**
+ * @brief Inicia o SNTP (não bloqueia; precisa do esp_netif pronto).
+ */
+void relogio_sntp_iniciar(const char *servidor);
+
+bool relogio_sincronizado(void);
+uint32_t relogio_boot_atual(void);
+
+/**
+ * @brief Boot e horário Unix (ms) de uma amostra da fila.
+ * @param boot    0 se o boot não está mais na tabela
+ * @param unix_ms 0 se aquele boot nunca sincronizou
+ */
+void relogio_carimbar(uint32_t seq, int64_t t_ms, uint32_t *boot, int64_t *unix_ms);
+
+#endif // RELOGIO_H
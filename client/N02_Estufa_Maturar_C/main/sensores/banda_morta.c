@@ -0,0 +1,54 @@
+#include "banda_morta.h"
+#include <string.h>
+
+void banda_morta_init(banda_morta_t *b, int n_canais, const banda_morta_config_t *cfg)
+{
+    memset(b, 0, sizeof(*b));
+    b->n_canais = (n_canais > BANDA_MORTA_CANAIS_MAX) ? BANDA_MORTA_CANAIS_MAX : n_canais;
+    b->cfg = *cfg;
+}
+
+void banda_morta_configurar(banda_morta_t *b, const banda_morta_config_t *cfg)
+{
+    b->cfg = *cfg;
+    b->tem_referencia = false;
+}
+
+static bool mudou(const banda_morta_t *b, const int32_t *valores)
+{
+    for (int i = 0; i < b->n_canais; i++) {
+        int32_t delta = b->cfg.delta[i];
+        if (delta < 0) {
+            continue;
+        }
+        int64_t dif = (int64_t)valores[i] - b->referencia[i];
+        if (dif < 0) {
+            dif = -dif;
+        }
+        if ((delta == 0 && dif != 0) || (delta > 0 && dif >= delta)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+banda_morta_decisao_t banda_morta_avaliar(banda_morta_t *b, const int32_t *valores, int64_t agora_ms)
+{
+    banda_morta_decisao_t d;
+
+    if (b->cfg.silencio_max_ms == 0 || !b->tem_referencia || mudou(b, valores)) {
+        d = BANDA_MORTA_MUDOU;
+        b->stats.mudancas++;
+    } else if (agora_ms - b->ultimo_envio_ms >= (int64_t)b->cfg.silencio_max_ms) {
+        d = BANDA_MORTA_SILENCIO;
+        b->stats.silencios++;
+    } else {
+        b->stats.suprimidas++;
+        return BANDA_MORTA_SUPRIMIR;
+    }
+
+    memcpy(b->referencia, valores, b->n_canais * sizeof(int32_t));
+    b->tem_referencia = true;
+    b->ultimo_envio_ms = agora_ms;
+    return d;
+}
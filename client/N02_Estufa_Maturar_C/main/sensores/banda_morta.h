@@ -0,0 +1,60 @@
+#ifndef BANDA_MORTA_H
+#define BANDA_MORTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================
+ * Relato por banda morta
+ * ============================================================
+ * Decide se uma amostra vale ser publicada: sai quando algum canal
+ * se afasta mais que o seu delta do último valor ENVIADO (deriva
+ * lenta acumula até passar do delta; ruído dentro da faixa não sai)
+ * ou quando passa silencio_max_ms sem envio (heartbeat).
+ *
+ * Os canais são inteiros em ponto fixo (mesma escala da amostra
+ * compacta). Sem dependência do ESP-IDF: o tempo vem do chamador.
+ */
+
+#define BANDA_MORTA_CANAIS_MAX   16
+#define BANDA_MORTA_IGNORAR      (-1)    // delta: canal não dispara envio
+
+typedef struct {
+    int32_t  delta[BANDA_MORTA_CANAIS_MAX];  // 0 = qualquer mudança
+    uint32_t silencio_max_ms;                // 0 = publica toda amostra
+} banda_morta_config_t;
+
+typedef enum {
+    BANDA_MORTA_SUPRIMIR = 0,
+    BANDA_MORTA_MUDOU,       // canal passou do delta, primeira amostra ou nova config
+    BANDA_MORTA_SILENCIO,    // heartbeat
+} banda_morta_decisao_t;
+
+typedef struct {
+    uint32_t mudancas;
+    uint32_t silencios;
+    uint32_t suprimidas;
+} banda_morta_stats_t;
+
+typedef struct {
+    int      n_canais;
+    banda_morta_config_t cfg;
+    bool     tem_referencia;
+    int32_t  referencia[BANDA_MORTA_CANAIS_MAX];
+    int64_t  ultimo_envio_ms;
+    banda_morta_stats_t stats;
+} banda_morta_t;
+
+void banda_morta_init(banda_morta_t *b, int n_canais, const banda_morta_config_t *cfg);
+
+/**
+ * @brief Troca os limites; a próxima amostra é sempre enviada.
+ */
+void banda_morta_configurar(banda_morta_t *b, const banda_morta_config_t *cfg);
+
+/**
+ * @brief Avalia a amostra; se a decisão for enviar, ela vira a referência.
+ */
+banda_morta_decisao_t banda_morta_avaliar(banda_morta_t *b, const int32_t *valores, int64_t agora_ms);
+
+#endif // BANDA_MORTA_H
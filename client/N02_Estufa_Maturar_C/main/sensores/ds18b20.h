@@ -1,6 +1,7 @@
 #ifndef DS18B20_H
 #define DS18B20_H
 
+#include <stdbool.h>
 #include "driver/gpio.h"
 
 #ifdef __cplusplus
@@ -10,6 +11,12 @@ extern "C" {
 void ds18b20_init(gpio_num_t gpio);
 float ds18b20_read_temperature(gpio_num_t gpio);
 
+// Conversão sem bloquear: inicia, faz outra coisa por DS18B20_CONVERSION_MS
+// e lê o resultado depois
+#define DS18B20_CONVERSION_MS 750
+bool ds18b20_start_conversion(gpio_num_t gpio);
+float ds18b20_read_conversion(gpio_num_t gpio);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,7 @@
 #define ENS160_OPMODE_REG 0x10
 #define ENS160_TEMP_IN_REG 0x13
 #define ENS160_RH_IN_REG 0x15
+#define ENS160_DEVICE_STATUS_REG 0x20
 #define ENS160_DATA_ECO2_REG 0x24
 
 static const char *TAG = "ENS160";
@@ -46,8 +47,17 @@ void ens160_calibrate(ens160_t *dev, float temperature, float humidity) {
     uint16_t hum_cal = (uint16_t)(humidity * 512);
     uint8_t buf_hum[3] = {ENS160_RH_IN_REG, hum_cal & 0xFF, (hum_cal >> 8) & 0xFF};
     i2c_master_write_to_device(dev->i2c_port, ENS160_ADDR, buf_hum, sizeof(buf_hum), pdMS_TO_TICKS(100));
+}
+
+// Em modo padrão o ENS160 mede sozinho a cada ~1 s; NEWDAT indica resultado novo
+bool ens160_data_ready(ens160_t *dev) {
+    if (!dev->initialized) return false;
 
-    vTaskDelay(pdMS_TO_TICKS(100));
+    uint8_t status;
+    if (ens160_read_reg(dev, ENS160_DEVICE_STATUS_REG, &status, 1) != ESP_OK) {
+        return false;
+    }
+    return (status & ENS160_STATUS_NEWDAT) != 0;
 }
 
 float ens160_get_eco2(ens160_t *dev) {
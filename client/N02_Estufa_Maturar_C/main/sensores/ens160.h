@@ -10,6 +10,7 @@ extern "C" {
 
 #define ENS160_ADDR 0x53
 #define ENS160_STANDARD_MODE 0x02
+#define ENS160_STATUS_NEWDAT 0x02   // nova medição de eCO2/TVOC disponível
 
 typedef struct {
     i2c_port_t i2c_port;
@@ -18,6 +19,7 @@ typedef struct {
 
 bool ens160_init(ens160_t *dev, i2c_port_t i2c_port);
 void ens160_calibrate(ens160_t *dev, float temperature, float humidity);
+bool ens160_data_ready(ens160_t *dev);
 float ens160_get_eco2(ens160_t *dev);
 
 #ifdef __cplusplus
@@ -6,7 +6,11 @@
 #include "driver/i2c.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include <stdlib.h>
+#include <math.h>
 #include <time.h>
 
 static const char *TAG = "SENSORES";
@@ -15,6 +19,17 @@ static aht20_t aht20_sensor;
 static ens160_t ens160_sensor;
 static bool sensors_initialized = false;
 
+// Aquisição em pipeline: a conversão do DS18B20 é iniciada no fim de um
+// ciclo e lida no próximo; o ENS160 mede sozinho em modo padrão
+#define ENS160_COMP_DELTA_TEMP  0.5f   // °C para reescrever a compensação
+#define ENS160_COMP_DELTA_UMID  2.0f   // %RH
+
+static int64_t ds18b20_inicio_us = 0;  // 0 = nenhuma conversão em andamento
+static float eco2_ultimo = -1.0f;
+static float comp_temp = -1000.0f;
+static float comp_umid = -1000.0f;
+static uint32_t canais_validos = 0;
+
 // Pinos dos sensores
 #define GPIO_BOIA_MIN 32
 #define GPIO_BOIA_MAX 33
@@ -71,22 +86,37 @@ void sensores_init(void) {
     ds18b20_init(GPIO_DS18B20);
 }
 
+// Resultado da conversão do ciclo anterior; só espera no primeiro ciclo
+static float ler_ds18b20(void) {
+    if (ds18b20_inicio_us == 0) {
+        if (!ds18b20_start_conversion(GPIO_DS18B20)) return -127.0f;
+        ds18b20_inicio_us = esp_timer_get_time();
+    }
+    int64_t resta_ms = DS18B20_CONVERSION_MS - (esp_timer_get_time() - ds18b20_inicio_us) / 1000;
+    if (resta_ms > 0) {
+        vTaskDelay(pdMS_TO_TICKS(resta_ms));
+    }
+    ds18b20_inicio_us = 0;
+    return ds18b20_read_conversion(GPIO_DS18B20);
+}
+
+// Reescreve a compensação do ENS160 só quando o ambiente mudou
+static void atualizar_compensacao(float temp, float umid) {
+    if (fabsf(temp - comp_temp) < ENS160_COMP_DELTA_TEMP &&
+        fabsf(umid - comp_umid) < ENS160_COMP_DELTA_UMID) {
+        return;
+    }
+    ens160_calibrate(&ens160_sensor, temp, umid);
+    comp_temp = temp;
+    comp_umid = umid;
+}
+
 sensor_data_t sensores_ler_dados(void) {
     sensor_data_t dados;
     float temp_real, umid_real;
 
-    if (sensors_initialized && aht20_read(&aht20_sensor, &temp_real, &umid_real)) {
-        dados.temp = temp_real;
-        dados.umid = umid_real;
-
-        ens160_calibrate(&ens160_sensor, temp_real, umid_real);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        dados.co2 = ens160_get_eco2(&ens160_sensor);
-    } else {
-        dados.temp = 0;
-        dados.umid = 0;
-        dados.co2 = 0;
-    }
+    // AHT20 converte (~80 ms) enquanto os demais sensores são lidos
+    bool aht20_disparado = sensors_initialized && aht20_trigger(&aht20_sensor);
 
     // Leitura das boias
     dados.agua_min = gpio_get_level(GPIO_BOIA_MIN);
@@ -97,7 +127,7 @@ sensor_data_t sensores_ler_dados(void) {
     dados.luz = (nivel_sensor_bruto == 0) ? 1 : 0;  // Luz está ON se sensor detectar claridade (0)
 
     // Leitura do sensor DS18B20
-    dados.temp_reserv_int = ds18b20_read_temperature(GPIO_DS18B20);
+    dados.temp_reserv_int = ler_ds18b20();
 
     // Simulações de sensores adicionais
     dados.ph = 0.0;
@@ -105,11 +135,122 @@ sensor_data_t sensores_ler_dados(void) {
     dados.temp_reserv_ext = randf(15.0, 25.0);
 
     // Leitura do DHT22 (temperatura e umidade externas)
-    if (dht_read_float_data(DHT_TYPE_AM2301, GPIO_DHT22, &dados.umid_externa, &dados.temp_externa) != ESP_OK) {
+    bool dht_ok = dht_read_float_data(DHT_TYPE_AM2301, GPIO_DHT22, &dados.umid_externa, &dados.temp_externa) == ESP_OK;
+    if (!dht_ok) {
         dados.umid_externa = 0.0;
         dados.temp_externa = 0.0;
     }
 
+    // eCO2 só é lido quando o ENS160 tem medição nova
+    if (sensors_initialized && (eco2_ultimo < 0 || ens160_data_ready(&ens160_sensor))) {
+        eco2_ultimo = ens160_get_eco2(&ens160_sensor);
+    }
+    dados.co2 = eco2_ultimo;
+
+    // Índices de sensores_canais; flags (luz e boias) sempre lidas, ph/ec/temp_reserv_ext simulados
+    canais_validos = 1u << 3;
+    if (aht20_disparado && aht20_read_result(&aht20_sensor, &temp_real, &umid_real)) {
+        dados.temp = temp_real;
+        dados.umid = umid_real;
+        atualizar_compensacao(temp_real, umid_real);
+        canais_validos |= (1u << 0) | (1u << 1);
+    } else {
+        dados.temp = 0;
+        dados.umid = 0;
+    }
+    if (dados.co2 >= 0) {
+        canais_validos |= 1u << 2;
+    }
+    if (dados.temp_reserv_int > -127.0f) {
+        canais_validos |= 1u << 4;
+    }
+    if (dht_ok) {
+        canais_validos |= (1u << 8) | (1u << 9);
+    }
+
+    // Próxima conversão do DS18B20 corre até o ciclo seguinte
+    if (ds18b20_start_conversion(GPIO_DS18B20)) {
+        ds18b20_inicio_us = esp_timer_get_time();
+    }
 
     return dados;
 }
+
+// ======== AMOSTRA COMPACTA ========
+
+static int16_t comp_i16(float v, float escala) {
+    float s = v * escala;
+    if (!(s == s)) return 0;              // NaN
+    if (s >= INT16_MAX) return INT16_MAX;
+    if (s <= INT16_MIN) return INT16_MIN;
+    return (int16_t)(s + (s >= 0 ? 0.5f : -0.5f));
+}
+
+static uint16_t comp_u16(float v, float escala) {
+    float s = v * escala;
+    if (!(s > 0)) return 0;               // negativo ou NaN
+    if (s >= UINT16_MAX) return UINT16_MAX;
+    return (uint16_t)(s + 0.5f);
+}
+
+void sensores_compactar(const sensor_data_t *dados, sensor_amostra_t *amostra) {
+    amostra->temp            = comp_i16(dados->temp, 100.0f);
+    amostra->umid            = comp_u16(dados->umid, 100.0f);
+    amostra->co2             = comp_u16(dados->co2, 1.0f);
+    amostra->flags           = (dados->luz > 0.5f ? 0x01 : 0) |
+                               (dados->agua_min ? 0x02 : 0) |
+                               (dados->agua_max ? 0x04 : 0);
+    amostra->temp_reserv_int = comp_i16(dados->temp_reserv_int, 100.0f);
+    amostra->ph              = comp_u16(dados->ph, 100.0f);
+    amostra->ec              = comp_u16(dados->ec, 100.0f);
+    amostra->temp_reserv_ext = comp_i16(dados->temp_reserv_ext, 100.0f);
+    amostra->temp_externa    = comp_i16(dados->temp_externa, 100.0f);
+    amostra->umid_externa    = comp_u16(dados->umid_externa, 100.0f);
+}
+
+void sensores_expandir(const sensor_amostra_t *amostra, sensor_data_t *dados) {
+    dados->temp            = amostra->temp / 100.0f;
+    dados->umid            = amostra->umid / 100.0f;
+    dados->co2             = amostra->co2;
+    dados->luz             = (amostra->flags & 0x01) ? 1 : 0;
+    dados->agua_min        = (amostra->flags & 0x02) ? 1 : 0;
+    dados->agua_max        = (amostra->flags & 0x04) ? 1 : 0;
+    dados->temp_reserv_int = amostra->temp_reserv_int / 100.0f;
+    dados->ph              = amostra->ph / 100.0f;
+    dados->ec              = amostra->ec / 100.0f;
+    dados->temp_reserv_ext = amostra->temp_reserv_ext / 100.0f;
+    dados->temp_externa    = amostra->temp_externa / 100.0f;
+    dados->umid_externa    = amostra->umid_externa / 100.0f;
+}
+
+// ======== CANAIS (BANDA MORTA) ========
+
+const sensores_canal_t sensores_canais[SENSORES_N_CANAIS] = {
+    { "temp",            100.0f, 0.2f  },
+    { "umid",            100.0f, 1.0f  },
+    { "co2",             1.0f,   25.0f },
+    { "flags",           1.0f,   0.0f  },   // luz e boias: qualquer mudança
+    { "temp_reserv_int", 100.0f, 0.2f  },
+    { "ph",              100.0f, 0.05f },
+    { "ec",              100.0f, 0.05f },
+    { "temp_reserv_ext", 100.0f, -1.0f },   // ainda simulado (aleatório)
+    { "temp_externa",    100.0f, 0.2f  },
+    { "umid_externa",    100.0f, 1.0f  },
+};
+
+void sensores_valores_canais(const sensor_amostra_t *a, int32_t *valores) {
+    valores[0] = a->temp;
+    valores[1] = a->umid;
+    valores[2] = a->co2;
+    valores[3] = a->flags;
+    valores[4] = a->temp_reserv_int;
+    valores[5] = a->ph;
+    valores[6] = a->ec;
+    valores[7] = a->temp_reserv_ext;
+    valores[8] = a->temp_externa;
+    valores[9] = a->umid_externa;
+}
+
+uint32_t sensores_canais_validos(void) {
+    return canais_validos;
+}
@@ -1,6 +1,8 @@
 #ifndef SENSORES_H
 #define SENSORES_H
 
+#include <stdint.h>
+
 typedef struct {
     float temp;
     float umid;
@@ -16,7 +18,40 @@ typedef struct {
     float umid_externa;
 } sensor_data_t;
 
+// Amostra compacta (ponto fixo) guardada na fila persistente
+typedef struct __attribute__((packed)) {
+    int16_t  temp;              // 0.01 °C
+    uint16_t umid;              // 0.01 %
+    uint16_t co2;               // ppm
+    uint8_t  flags;             // bit0 luz, bit1 agua_min, bit2 agua_max
+    int16_t  temp_reserv_int;   // 0.01 °C
+    uint16_t ph;                // 0.01
+    uint16_t ec;                // 0.01
+    int16_t  temp_reserv_ext;   // 0.01 °C
+    int16_t  temp_externa;      // 0.01 °C
+    uint16_t umid_externa;      // 0.01 %
+} sensor_amostra_t;
+
 void sensores_init(void);
 sensor_data_t sensores_ler_dados(void);
 
+void sensores_compactar(const sensor_data_t *dados, sensor_amostra_t *amostra);
+void sensores_expandir(const sensor_amostra_t *amostra, sensor_data_t *dados);
+
+// Canais da amostra para a banda morta: chave (mesma do JSON), escala do
+// ponto fixo e delta padrão em unidades de engenharia (< 0 = ignorado)
+typedef struct {
+    const char *nome;
+    float escala;
+    float delta;
+} sensores_canal_t;
+
+#define SENSORES_N_CANAIS 10
+extern const sensores_canal_t sensores_canais[SENSORES_N_CANAIS];
+void sensores_valores_canais(const sensor_amostra_t *amostra, int32_t *valores);
+
+// Canais com leitura real na última sensores_ler_dados (bit i = sensores_canais[i]);
+// sensor com falha ou simulado fica fora
+uint32_t sensores_canais_validos(void);
+
 #endif // SENSORES_H
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* Partição de host em RAM com a semântica da flash NOR:
+ * apagar leva setores de 4 KB a 0xFF e gravar só zera bits. */
+
+typedef enum {
+    ESP_PARTITION_TYPE_DATA = 1,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *p, size_t off, void *dst, size_t len);
+esp_err_t esp_partition_write(const esp_partition_t *p, size_t off, const void *src, size_t len);
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t off, size_t len);
+
+/* Cria (ou recria, toda em 0xFF) a partição com esse label e tamanho */
+void particao_falsa_criar(const char *label, uint32_t tamanho);
+
+/* A n-ésima gravação a partir de agora falha sem gravar nada (0 = nenhuma) */
+void particao_falsa_falhar_gravacao(uint32_t n);
+
+/* Gravações que tentaram levar um bit de 0 para 1 (erro de quem grava) */
+uint32_t particao_falsa_violacoes(void);
+
+/* Conteúdo bruto, para inspeção e para simular corrupção */
+uint8_t *particao_falsa_dados(void);
@@ -0,0 +1,85 @@
+#include "esp_partition.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SETOR_BYTES  4096
+
+static esp_partition_t particao;
+static uint8_t *dados;
+static uint32_t falhar_em;
+static uint32_t violacoes;
+
+void particao_falsa_criar(const char *label, uint32_t tamanho)
+{
+    free(dados);
+    dados = malloc(tamanho);
+    memset(dados, 0xFF, tamanho);
+    particao.type = ESP_PARTITION_TYPE_DATA;
+    particao.size = tamanho;
+    strncpy(particao.label, label, sizeof(particao.label) - 1);
+    falhar_em = 0;
+    violacoes = 0;
+}
+
+void particao_falsa_falhar_gravacao(uint32_t n)
+{
+    falhar_em = n;
+}
+
+uint32_t particao_falsa_violacoes(void)
+{
+    return violacoes;
+}
+
+uint8_t *particao_falsa_dados(void)
+{
+    return dados;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    (void)subtype;
+    if (dados == NULL || type != particao.type || strcmp(label, particao.label) != 0) {
+        return NULL;
+    }
+    return &particao;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *p, size_t off, void *dst, size_t len)
+{
+    if (p != &particao || off + len > particao.size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, dados + off, len);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *p, size_t off, const void *src, size_t len)
+{
+    if (p != &particao || off + len > particao.size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (falhar_em && --falhar_em == 0) {
+        return ESP_FAIL;
+    }
+    const uint8_t *b = src;
+    for (size_t i = 0; i < len; i++) {
+        if (b[i] & ~dados[off + i]) {
+            violacoes++;
+        }
+        dados[off + i] &= b[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t off, size_t len)
+{
+    if (p != &particao || off + len > particao.size ||
+        off % SETOR_BYTES != 0 || len % SETOR_BYTES != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(dados + off, 0xFF, len);
+    return ESP_OK;
+}
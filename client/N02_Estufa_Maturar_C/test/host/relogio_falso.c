@@ -0,0 +1,35 @@
+#include "relogio.h"
+
+/* relogio.c usa NVS e SNTP; nos testes cada boot é só a sequência inicial */
+
+static uint32_t boots;
+static uint32_t seq_inicio_atual;
+
+esp_err_t relogio_init(uint32_t seq_inicio)
+{
+    boots++;
+    seq_inicio_atual = seq_inicio;
+    return ESP_OK;
+}
+
+void relogio_sntp_iniciar(const char *servidor)
+{
+    (void)servidor;
+}
+
+bool relogio_sincronizado(void)
+{
+    return false;
+}
+
+uint32_t relogio_boot_atual(void)
+{
+    return boots;
+}
+
+void relogio_carimbar(uint32_t seq, int64_t t_ms, uint32_t *boot, int64_t *unix_ms)
+{
+    (void)t_ms;
+    *boot = seq >= seq_inicio_atual ? boots : 0;
+    *unix_ms = 0;
+}
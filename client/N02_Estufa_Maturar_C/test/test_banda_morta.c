@@ -0,0 +1,97 @@
+#include "teste.h"
+#include "banda_morta.h"
+
+#define CANAIS  3
+
+static banda_morta_config_t config(int32_t d0, int32_t d1, int32_t d2, uint32_t silencio_ms)
+{
+    banda_morta_config_t cfg = {
+        .delta = { d0, d1, d2 },
+        .silencio_max_ms = silencio_ms,
+    };
+    return cfg;
+}
+
+static banda_morta_decisao_t avaliar(banda_morta_t *b, int32_t v0, int32_t v1, int32_t v2, int64_t agora_ms)
+{
+    int32_t v[CANAIS] = { v0, v1, v2 };
+    return banda_morta_avaliar(b, v, agora_ms);
+}
+
+static void testar_supressao(void)
+{
+    banda_morta_t b;
+    banda_morta_config_t cfg = config(50, 0, BANDA_MORTA_IGNORAR, 60000);
+
+    banda_morta_init(&b, CANAIS, &cfg);
+    VERIFICAR(avaliar(&b, 2500, 7, 100, 0) == BANDA_MORTA_MUDOU);
+
+    // Ruído dentro do delta e canal ignorado: não sai
+    VERIFICAR(avaliar(&b, 2549, 7, 100, 1000) == BANDA_MORTA_SUPRIMIR);
+    VERIFICAR(avaliar(&b, 2451, 7, 9999, 2000) == BANDA_MORTA_SUPRIMIR);
+
+    // Deriva lenta acumula contra o último ENVIADO, não a última amostra
+    VERIFICAR(avaliar(&b, 2530, 7, 100, 3000) == BANDA_MORTA_SUPRIMIR);
+    VERIFICAR(avaliar(&b, 2549, 7, 100, 4000) == BANDA_MORTA_SUPRIMIR);
+    VERIFICAR(avaliar(&b, 2550, 7, 100, 5000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 2599, 7, 100, 6000) == BANDA_MORTA_SUPRIMIR);
+
+    // Delta 0: qualquer mudança
+    VERIFICAR(avaliar(&b, 2550, 8, 100, 7000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 2550, 8, 100, 8000) == BANDA_MORTA_SUPRIMIR);
+
+    VERIFICAR(b.stats.mudancas == 3 && b.stats.suprimidas == 6 && b.stats.silencios == 0);
+}
+
+static void testar_heartbeat(void)
+{
+    banda_morta_t b;
+    banda_morta_config_t cfg = config(10, 10, 10, 60000);
+
+    banda_morta_init(&b, CANAIS, &cfg);
+    VERIFICAR(avaliar(&b, 0, 0, 0, 1000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 1, 0, 0, 60999) == BANDA_MORTA_SUPRIMIR);
+    VERIFICAR(avaliar(&b, 1, 0, 0, 61000) == BANDA_MORTA_SILENCIO);
+    // O heartbeat também vira referência e reinicia o silêncio
+    VERIFICAR(avaliar(&b, 10, 0, 0, 62000) == BANDA_MORTA_SUPRIMIR);
+    VERIFICAR(avaliar(&b, 11, 0, 0, 63000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 11, 0, 0, 122999) == BANDA_MORTA_SUPRIMIR);
+    VERIFICAR(avaliar(&b, 11, 0, 0, 123000) == BANDA_MORTA_SILENCIO);
+}
+
+static void testar_configuracao(void)
+{
+    banda_morta_t b;
+    banda_morta_config_t cfg = config(100, 100, 100, 60000);
+
+    banda_morta_init(&b, CANAIS, &cfg);
+    VERIFICAR(avaliar(&b, 0, 0, 0, 0) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 0, 0, 0, 1000) == BANDA_MORTA_SUPRIMIR);
+
+    // Config nova: a próxima amostra sai mesmo igual à referência
+    cfg = config(5, 5, 5, 60000);
+    banda_morta_configurar(&b, &cfg);
+    VERIFICAR(avaliar(&b, 0, 0, 0, 2000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 0, 0, 5, 3000) == BANDA_MORTA_MUDOU);
+
+    // Silêncio 0: publica toda amostra
+    cfg = config(100, 100, 100, 0);
+    banda_morta_configurar(&b, &cfg);
+    VERIFICAR(avaliar(&b, 0, 0, 5, 4000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 0, 0, 5, 4001) == BANDA_MORTA_MUDOU);
+
+    // Extremos de int32 não estouram a diferença
+    cfg = config(INT32_MAX, 0, 0, 60000);
+    banda_morta_configurar(&b, &cfg);
+    VERIFICAR(avaliar(&b, INT32_MIN, 0, 0, 5000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, INT32_MAX, 0, 0, 6000) == BANDA_MORTA_MUDOU);
+    VERIFICAR(avaliar(&b, 1, 0, 0, 7000) == BANDA_MORTA_SUPRIMIR);
+}
+
+int main(void)
+{
+    testar_supressao();
+    testar_heartbeat();
+    testar_configuracao();
+    return TESTE_FIM();
+}
@@ -0,0 +1,134 @@
+#include "teste.h"
+#include "controle.h"
+
+#define MIN_MS   60000
+#define VALIDOS  0x3u
+
+static controle_regra_t regra(uint8_t canal, uint8_t saida, uint8_t sentido, int32_t liga, int32_t desliga)
+{
+    controle_regra_t r = {
+        .canal = canal,
+        .saida = saida,
+        .sentido = sentido,
+        .liga = liga,
+        .desliga = desliga,
+        .min_ligado_ms = MIN_MS,
+        .min_desligado_ms = MIN_MS,
+    };
+    return r;
+}
+
+static uint32_t avaliar(controle_t *c, int32_t v0, int32_t v1, uint32_t validos, int64_t agora_ms)
+{
+    int32_t v[2] = { v0, v1 };
+    return controle_avaliar(c, v, validos, agora_ms);
+}
+
+static void testar_histerese(void)
+{
+    controle_t c;
+    controle_config_t cfg = { .n_regras = 1, .regras = { regra(0, 0, CONTROLE_ACIMA, 300, 280) } };
+
+    controle_init(&c, &cfg);
+    VERIFICAR(avaliar(&c, 290, 0, VALIDOS, 0) == 0);
+    // Primeiro acionamento não espera o mínimo desligado
+    VERIFICAR(avaliar(&c, 300, 0, VALIDOS, 1000) == 1);
+    // Dentro da histerese e antes do mínimo ligado: fica
+    VERIFICAR(avaliar(&c, 285, 0, VALIDOS, 2000) == 1);
+    VERIFICAR(avaliar(&c, 200, 0, VALIDOS, 1000 + MIN_MS - 1) == 1);
+    VERIFICAR(avaliar(&c, 200, 0, VALIDOS, 1000 + MIN_MS) == 0);
+    // Mínimo desligado segura o religamento
+    VERIFICAR(avaliar(&c, 400, 0, VALIDOS, 1000 + 2 * MIN_MS - 1) == 0);
+    VERIFICAR(avaliar(&c, 400, 0, VALIDOS, 1000 + 2 * MIN_MS) == 1);
+}
+
+static void testar_abaixo_e_ou(void)
+{
+    controle_t c;
+    controle_config_t cfg = {
+        .n_regras = 2,
+        .regras = {
+            regra(0, 2, CONTROLE_ACIMA, 300, 280),
+            regra(1, 2, CONTROLE_ABAIXO, 40, 60),
+        },
+    };
+
+    controle_init(&c, &cfg);
+    VERIFICAR(avaliar(&c, 250, 50, VALIDOS, 0) == 0);
+    VERIFICAR(avaliar(&c, 250, 40, VALIDOS, 1000) == 0x4);
+    // Saída fica ligada enquanto alguma regra a quer ligada
+    VERIFICAR(avaliar(&c, 310, 70, VALIDOS, 1000 + MIN_MS) == 0x4);
+    VERIFICAR(avaliar(&c, 270, 70, VALIDOS, 2000 + 2 * MIN_MS) == 0);
+
+    controle_regra_t ruim = regra(0, 0, CONTROLE_ACIMA, 280, 300);
+    VERIFICAR(!controle_regra_valida(&ruim, 2, 4));
+    ruim = regra(1, 0, CONTROLE_ABAIXO, 60, 40);
+    VERIFICAR(!controle_regra_valida(&ruim, 2, 4));
+    ruim = regra(2, 0, CONTROLE_ACIMA, 300, 280);
+    VERIFICAR(!controle_regra_valida(&ruim, 2, 4));
+    ruim = regra(0, 4, CONTROLE_ACIMA, 300, 280);
+    VERIFICAR(!controle_regra_valida(&ruim, 2, 4));
+    VERIFICAR(controle_regra_valida(&cfg.regras[0], 2, 4));
+}
+
+static void testar_canal_invalido(void)
+{
+    controle_t c;
+    controle_config_t cfg = { .n_regras = 1, .regras = { regra(1, 0, CONTROLE_ACIMA, 300, 280) } };
+
+    controle_init(&c, &cfg);
+    VERIFICAR(avaliar(&c, 0, 400, VALIDOS, 0) == 1);
+    // Valor sem leitura não desliga nem liga; passa de CONTROLE_FALHAS_MAX e desliga
+    for (int i = 1; i <= CONTROLE_FALHAS_MAX; i++) {
+        VERIFICAR(avaliar(&c, 0, -1, 0x1, i * 1000) == 1);
+    }
+    VERIFICAR(avaliar(&c, 0, -1, 0x1, 10000) == 0);
+    // Leitura de volta zera as falhas, com o mínimo desligado contando do desligamento
+    VERIFICAR(avaliar(&c, 0, 400, VALIDOS, 10000 + MIN_MS - 1) == 0);
+    VERIFICAR(avaliar(&c, 0, 400, VALIDOS, 10000 + MIN_MS) == 1);
+    VERIFICAR(avaliar(&c, 0, -1, 0x1, 80000) == 1);
+    VERIFICAR(avaliar(&c, 0, 400, VALIDOS, 81000) == 1);
+    for (int i = 1; i <= CONTROLE_FALHAS_MAX; i++) {
+        VERIFICAR(avaliar(&c, 0, -1, 0x1, 81000 + i) == 1);
+    }
+}
+
+static void testar_reconfiguracao(void)
+{
+    controle_t c;
+    controle_config_t cfg = { .n_regras = 1, .regras = { regra(0, 0, CONTROLE_ACIMA, 300, 280) } };
+    controle_config_t vazio = { 0 };
+
+    controle_init(&c, &cfg);
+    VERIFICAR(avaliar(&c, 320, 0, VALIDOS, 0) == 1);
+
+    // Mesma malha com limites novos: herda estado e tempo da regra anterior
+    cfg.regras[0].liga = 350;
+    cfg.regras[0].desliga = 330;
+    controle_configurar(&c, &cfg);
+    VERIFICAR(avaliar(&c, 200, 0, VALIDOS, 1000) == 1);
+    VERIFICAR(avaliar(&c, 200, 0, VALIDOS, MIN_MS) == 0);
+
+    // Regra nova numa saída que acabou de desligar respeita o mínimo desligado
+    controle_config_t outra = { .n_regras = 1, .regras = { regra(1, 0, CONTROLE_ACIMA, 50, 40) } };
+    controle_configurar(&c, &outra);
+    VERIFICAR(avaliar(&c, 0, 90, VALIDOS, 2 * MIN_MS - 1) == 0);
+    VERIFICAR(avaliar(&c, 0, 90, VALIDOS, 2 * MIN_MS) == 1);
+
+    // Saída de regra removida fica ligada até cumprir o mínimo ligado
+    controle_configurar(&c, &vazio);
+    VERIFICAR(avaliar(&c, 0, 0, VALIDOS, 2 * MIN_MS + 1000) == 1);
+    VERIFICAR(avaliar(&c, 0, 0, VALIDOS, 3 * MIN_MS - 1) == 1);
+    VERIFICAR(avaliar(&c, 0, 0, VALIDOS, 3 * MIN_MS) == 0);
+    // E não religa depois de desligada
+    VERIFICAR(avaliar(&c, 0, 0, VALIDOS, 3 * MIN_MS + 1) == 0);
+}
+
+int main(void)
+{
+    testar_histerese();
+    testar_abaixo_e_ou();
+    testar_canal_invalido();
+    testar_reconfiguracao();
+    return TESTE_FIM();
+}
@@ -0,0 +1,30 @@
+#ifndef TESTE_H
+#define TESTE_H
+
+#include <stdio.h>
+#include <math.h>
+
+/* Verificações dos testes de host: contam falhas em vez de abortar,
+ * então um caso quebrado não esconde os seguintes (e NDEBUG não muda nada). */
+
+static int teste_falhas;
+
+#define VERIFICAR(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #cond); \
+        teste_falhas++; \
+    } \
+} while (0)
+
+#define VERIFICAR_PERTO(a, b, tol) do { \
+    double a_ = (a), b_ = (b); \
+    if (!(fabs(a_ - b_) <= (tol))) { \
+        fprintf(stderr, "%s:%d: falhou: %s = %g, esperado %g (tol %g)\n", \
+                __FILE__, __LINE__, #a, a_, b_, (double)(tol)); \
+        teste_falhas++; \
+    } \
+} while (0)
+
+#define TESTE_FIM() (teste_falhas ? (fprintf(stderr, "%d falha(s)\n", teste_falhas), 1) : 0)
+
+#endif // TESTE_H
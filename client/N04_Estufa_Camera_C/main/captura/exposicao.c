@@ -0,0 +1,69 @@
+#include "exposicao.h"
+#include <stdlib.h>
+#include <string.h>
+
+void exposicao_init(exposicao_t *e, const exposicao_config_t *cfg)
+{
+    memset(e, 0, sizeof(*e));
+    e->cfg = *cfg;
+    e->media_ms = cfg->media_inicial_ms;
+}
+
+static uint32_t calcular_prazo(const exposicao_t *e)
+{
+    uint32_t prazo = e->cfg.folga * e->media_ms;
+    if (prazo < e->cfg.prazo_min_ms) {
+        prazo = e->cfg.prazo_min_ms;
+    }
+    if (prazo > e->cfg.prazo_max_ms) {
+        prazo = e->cfg.prazo_max_ms;
+    }
+    return prazo;
+}
+
+void exposicao_iniciar(exposicao_t *e, int64_t agora_us)
+{
+    e->inicio_us = agora_us;
+    e->prazo_ms = calcular_prazo(e);
+    e->tem_anterior = false;
+    e->estaveis = 0;
+    e->quadros = 0;
+}
+
+exposicao_estado_t exposicao_avaliar(exposicao_t *e, uint8_t brilho, int64_t agora_us)
+{
+    uint32_t decorrido_ms = (uint32_t)((agora_us - e->inicio_us) / 1000);
+
+    if (e->quadros < UINT8_MAX) {
+        e->quadros++;
+    }
+    if (e->tem_anterior && abs((int)brilho - (int)e->anterior) <= e->cfg.tolerancia) {
+        e->estaveis++;
+    } else {
+        e->estaveis = 0;
+    }
+    e->anterior = brilho;
+    e->tem_anterior = true;
+
+    exposicao_estado_t estado = EXPOSICAO_AJUSTANDO;
+    if (e->estaveis >= e->cfg.quadros_estaveis) {
+        estado = EXPOSICAO_ESTAVEL;
+    } else if (decorrido_ms >= e->prazo_ms) {
+        estado = EXPOSICAO_PRAZO;
+    }
+    if (estado != EXPOSICAO_AJUSTANDO) {
+        // Média móvel: um prazo esgotado entra como amostra e alonga o próximo
+        e->media_ms = (3 * e->media_ms + decorrido_ms) / 4;
+    }
+    return estado;
+}
+
+const char *exposicao_nome(exposicao_estado_t estado)
+{
+    switch (estado) {
+        case EXPOSICAO_AJUSTANDO: return "ajustando";
+        case EXPOSICAO_ESTAVEL:   return "estável";
+        case EXPOSICAO_PRAZO:     return "prazo";
+    }
+    return "?";
+}
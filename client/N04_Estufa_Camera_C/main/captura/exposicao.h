@@ -0,0 +1,71 @@
+#ifndef EXPOSICAO_H
+#define EXPOSICAO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================
+ * Convergência da exposição automática depois do flash
+ * ============================================================
+ * Com o flash aceso o AEC do sensor leva alguns quadros para se
+ * ajustar. Em vez de esperar um tempo fixo, o brilho médio de cada
+ * quadro novo é comparado com o do anterior: quadros_estaveis
+ * variações seguidas de até tolerancia níveis = exposição assentada.
+ *
+ * O prazo se adapta: folga vezes a média móvel do tempo que a
+ * exposição levou para assentar nas fotos anteriores, entre prazo_min_ms
+ * e prazo_max_ms. Um prazo esgotado entra na média como amostra, e o
+ * prazo seguinte cresce.
+ *
+ * Não depende do ESP-IDF: compila no host.
+ */
+
+#define EXPOSICAO_TOLERANCIA        3     // níveis de brilho (0-255)
+#define EXPOSICAO_QUADROS_ESTAVEIS  2
+#define EXPOSICAO_PRAZO_MIN_MS      300
+#define EXPOSICAO_PRAZO_MAX_MS      1500
+#define EXPOSICAO_FOLGA             2
+#define EXPOSICAO_MEDIA_INICIAL_MS  500   // a espera fixa antiga
+
+typedef struct {
+    uint8_t  tolerancia;
+    uint8_t  quadros_estaveis;
+    uint32_t prazo_min_ms;
+    uint32_t prazo_max_ms;
+    uint8_t  folga;
+    uint32_t media_inicial_ms;
+} exposicao_config_t;
+
+typedef enum {
+    EXPOSICAO_AJUSTANDO,          // descarta e pede outro quadro
+    EXPOSICAO_ESTAVEL,            // usa este quadro
+    EXPOSICAO_PRAZO,              // usa este quadro mesmo sem assentar
+} exposicao_estado_t;
+
+typedef struct {
+    exposicao_config_t cfg;
+    uint32_t media_ms;            // tempo médio até assentar
+    int64_t  inicio_us;           // flash aceso
+    uint32_t prazo_ms;            // da medição atual
+    bool     tem_anterior;
+    uint8_t  anterior;
+    uint8_t  estaveis;
+    uint8_t  quadros;             // avaliados na medição atual
+} exposicao_t;
+
+void exposicao_init(exposicao_t *e, const exposicao_config_t *cfg);
+
+/**
+ * @brief Começa uma medição (logo depois de acender o flash).
+ */
+void exposicao_iniciar(exposicao_t *e, int64_t agora_us);
+
+/**
+ * @brief Avalia o brilho médio de um quadro capturado depois do início.
+ * @param agora_us  mesmo relógio de exposicao_iniciar
+ */
+exposicao_estado_t exposicao_avaliar(exposicao_t *e, uint8_t brilho, int64_t agora_us);
+
+const char *exposicao_nome(exposicao_estado_t estado);
+
+#endif // EXPOSICAO_H
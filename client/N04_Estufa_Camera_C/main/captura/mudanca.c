@@ -0,0 +1,104 @@
+#include "mudanca.h"
+#include <stdlib.h>
+#include <string.h>
+
+void mudanca_init(mudanca_t *m, const mudanca_config_t *cfg)
+{
+    memset(m, 0, sizeof(*m));
+    m->cfg = *cfg;
+}
+
+// Uma linha de células por vez: a pilha da tarefa de captura é pequena
+void mudanca_reduzir_rgb565(const uint8_t *rgb565, int largura, int altura, uint8_t *miniatura)
+{
+    uint32_t soma[MUDANCA_LARGURA];
+    uint32_t n[MUDANCA_LARGURA];
+    int y = 0;
+
+    for (int cy = 0; cy < MUDANCA_ALTURA; cy++) {
+        memset(soma, 0, sizeof(soma));
+        memset(n, 0, sizeof(n));
+        for (; y < altura && y * MUDANCA_ALTURA / altura == cy; y++) {
+            const uint8_t *p = rgb565 + (size_t)y * largura * 2;
+            for (int x = 0; x < largura; x++, p += 2) {
+                uint16_t c = (p[0] << 8) | p[1];
+                uint32_t r = (c >> 11) << 3;
+                uint32_t g = ((c >> 5) & 0x3F) << 2;
+                uint32_t b = (c & 0x1F) << 3;
+                int cx = x * MUDANCA_LARGURA / largura;
+                soma[cx] += (77 * r + 150 * g + 29 * b) >> 8;   // BT.601
+                n[cx]++;
+            }
+        }
+        for (int cx = 0; cx < MUDANCA_LARGURA; cx++) {
+            miniatura[cy * MUDANCA_LARGURA + cx] = n[cx] ? soma[cx] / n[cx] : 0;
+        }
+    }
+}
+
+uint8_t mudanca_brilho(const uint8_t *miniatura)
+{
+    uint32_t soma = 0;
+    for (int i = 0; i < MUDANCA_PIXELS; i++) {
+        soma += miniatura[i];
+    }
+    return soma / MUDANCA_PIXELS;
+}
+
+mudanca_decisao_t mudanca_avaliar(mudanca_t *m, const uint8_t *miniatura, uint32_t agora_s,
+                                  mudanca_resultado_t *resultado)
+{
+    mudanca_resultado_t r = { .brilho = mudanca_brilho(miniatura) };
+
+    if (m->tem_referencia) {
+        // Igualar o brilho médio (ganho, não deslocamento): ajuste de
+        // exposição não é mudança
+        int atual = r.brilho ? r.brilho : 1;
+        int ref = mudanca_brilho(m->referencia);
+        uint32_t soma = 0, acima = 0;
+        for (int i = 0; i < MUDANCA_PIXELS; i++) {
+            int d = abs((int)miniatura[i] * ref / atual - (int)m->referencia[i]);
+            soma += d;
+            if (d > m->cfg.limiar_celula) {
+                acima++;
+            }
+        }
+        r.diferenca = soma / MUDANCA_PIXELS;
+        r.celulas_pct = acima * 100 / MUDANCA_PIXELS;
+    }
+
+    // Escura primeiro: à noite nem keyframe nem primeira foto são mantidos
+    if (r.brilho < m->cfg.limiar_escuro) {
+        r.decisao = MUDANCA_ESCURA;
+    } else if (!m->tem_referencia) {
+        r.decisao = MUDANCA_PRIMEIRA;
+    } else if (m->cfg.keyframe_s && agora_s - m->mantida_s >= m->cfg.keyframe_s) {
+        r.decisao = MUDANCA_KEYFRAME;
+    } else if (r.celulas_pct >= m->cfg.celulas_pct) {
+        r.decisao = MUDANCA_MUDOU;
+    } else {
+        r.decisao = MUDANCA_IGUAL;
+    }
+
+    if (mudanca_manter(r.decisao)) {
+        memcpy(m->referencia, miniatura, MUDANCA_PIXELS);
+        m->tem_referencia = true;
+        m->mantida_s = agora_s;
+    }
+    if (resultado) {
+        *resultado = r;
+    }
+    return r.decisao;
+}
+
+const char *mudanca_nome(mudanca_decisao_t d)
+{
+    switch (d) {
+        case MUDANCA_PRIMEIRA: return "primeira";
+        case MUDANCA_MUDOU:    return "mudou";
+        case MUDANCA_KEYFRAME: return "keyframe";
+        case MUDANCA_IGUAL:    return "igual";
+        case MUDANCA_ESCURA:   return "escura";
+    }
+    return "?";
+}
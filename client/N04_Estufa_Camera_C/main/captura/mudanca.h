@@ -0,0 +1,89 @@
+#ifndef MUDANCA_H
+#define MUDANCA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================
+ * Detector de mudança entre fotos
+ * ============================================================
+ * Compara uma miniatura de luminância (MUDANCA_LARGURA x
+ * MUDANCA_ALTURA) da foto nova com a da última foto mantida. Antes da
+ * comparação a foto nova é escalada para o brilho médio da referência,
+ * para uma variação de exposição não contar como mudança. A foto é
+ * mantida se pelo menos celulas_pct % das células mudaram mais que
+ * limiar_celula; foto com brilho médio abaixo de limiar_escuro é
+ * descartada (noite), antes de qualquer outro critério. A cada
+ * keyframe_s segundos sem foto mantida a próxima foto clara é mantida
+ * de qualquer jeito.
+ *
+ * Não depende do ESP-IDF: a miniatura vem de fora (no nó, do JPEG
+ * decodificado em escala 1/8) e o módulo compila no host.
+ */
+
+#define MUDANCA_LARGURA   32
+#define MUDANCA_ALTURA    24
+#define MUDANCA_PIXELS    (MUDANCA_LARGURA * MUDANCA_ALTURA)
+
+#define MUDANCA_LIMIAR_CELULA   12    // níveis de luminância (0-255)
+#define MUDANCA_CELULAS_PCT     2
+#define MUDANCA_LIMIAR_ESCURO   20    // brilho médio
+#define MUDANCA_KEYFRAME_S      1800
+
+typedef struct {
+    uint8_t  limiar_celula;
+    uint8_t  celulas_pct;
+    uint8_t  limiar_escuro;       // 0 = não descarta fotos escuras
+    uint32_t keyframe_s;          // 0 = sem keyframe forçado
+} mudanca_config_t;
+
+typedef enum {
+    MUDANCA_PRIMEIRA,             // sem referência ainda: mantida
+    MUDANCA_MUDOU,                // mantida
+    MUDANCA_KEYFRAME,             // mantida por tempo
+    MUDANCA_IGUAL,                // descartada
+    MUDANCA_ESCURA,               // descartada
+} mudanca_decisao_t;
+
+typedef struct {
+    mudanca_decisao_t decisao;
+    uint8_t  brilho;              // média da miniatura
+    uint8_t  diferenca;           // média das diferenças absolutas, brilho igualado
+    uint8_t  celulas_pct;         // células acima de limiar_celula
+} mudanca_resultado_t;
+
+typedef struct {
+    mudanca_config_t cfg;
+    uint8_t  referencia[MUDANCA_PIXELS];
+    bool     tem_referencia;
+    uint32_t mantida_s;           // instante da última foto mantida
+} mudanca_t;
+
+void mudanca_init(mudanca_t *m, const mudanca_config_t *cfg);
+
+/**
+ * @brief Reduz uma imagem RGB565 (big-endian, como sai do jpg2rgb565)
+ *        à miniatura de luminância, pela média de cada bloco.
+ */
+void mudanca_reduzir_rgb565(const uint8_t *rgb565, int largura, int altura, uint8_t *miniatura);
+
+/**
+ * @brief Brilho médio da miniatura (0-255).
+ */
+uint8_t mudanca_brilho(const uint8_t *miniatura);
+
+/**
+ * @brief Decide se a foto é mantida; se for, ela vira a referência.
+ * @param agora_s  relógio monotônico em segundos (keyframe)
+ */
+mudanca_decisao_t mudanca_avaliar(mudanca_t *m, const uint8_t *miniatura, uint32_t agora_s,
+                                  mudanca_resultado_t *resultado);
+
+static inline bool mudanca_manter(mudanca_decisao_t d)
+{
+    return d == MUDANCA_PRIMEIRA || d == MUDANCA_MUDOU || d == MUDANCA_KEYFRAME;
+}
+
+const char *mudanca_nome(mudanca_decisao_t d);
+
+#endif // MUDANCA_H
@@ -0,0 +1,73 @@
+#include "quadro.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "QUADRO";
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static quadro_fim_cb_t fim_cb = NULL;
+
+void quadro_set_fim_cb(quadro_fim_cb_t cb)
+{
+    fim_cb = cb;
+}
+
+quadro_t *quadro_novo(camera_fb_t *fb, uint32_t numero, const char *nome, int refs)
+{
+    quadro_t *q = calloc(1, sizeof(quadro_t));
+    if (q == NULL) {
+        ESP_LOGE(TAG, "Sem memória para o quadro %lu", (unsigned long)numero);
+        esp_camera_fb_return(fb);
+        return NULL;
+    }
+    q->fb = fb;
+    q->numero = numero;
+    strlcpy(q->nome, nome, sizeof(q->nome));
+    q->capturado_us = esp_timer_get_time();
+    q->refs = refs;
+    return q;
+}
+
+static void registrar_latencia(const quadro_t *q, quadro_consumidor_t quem, const char *nome, char *buf, size_t len)
+{
+    if (q->pronto_us[quem] == 0) {
+        snprintf(buf, len, "%s -", nome);
+    } else {
+        snprintf(buf, len, "%s %lld ms (%s)", nome,
+                 (long long)((q->pronto_us[quem] - q->capturado_us) / 1000), q->ok[quem] ? "ok" : "falhou");
+    }
+}
+
+void quadro_liberar(quadro_t *q)
+{
+    portENTER_CRITICAL(&lock);
+    int refs = --q->refs;
+    portEXIT_CRITICAL(&lock);
+    if (refs > 0) {
+        return;
+    }
+
+    char envio[40], sd[40];
+    registrar_latencia(q, QUADRO_ENVIO, "enviado", envio, sizeof(envio));
+    registrar_latencia(q, QUADRO_SD, "salvo", sd, sizeof(sd));
+    ESP_LOGI(TAG, "Quadro %lu (%u bytes): captura -> %s, %s",
+             (unsigned long)q->numero, (unsigned)q->fb->len, sd, envio);
+
+    if (fim_cb) {
+        fim_cb(q);
+    }
+    esp_camera_fb_return(q->fb);
+    free(q);
+}
+
+void quadro_concluir(quadro_t *q, quadro_consumidor_t quem, bool ok)
+{
+    // Cada consumidor escreve só o seu campo; o último a soltar lê todos
+    q->pronto_us[quem] = esp_timer_get_time();
+    q->ok[quem] = ok;
+    quadro_liberar(q);
+}
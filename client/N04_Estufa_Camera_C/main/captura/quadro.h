@@ -0,0 +1,56 @@
+#ifndef QUADRO_H
+#define QUADRO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_camera.h"
+
+/* ============================================================
+ * Quadro capturado compartilhado entre consumidores
+ * ============================================================
+ * A tarefa de captura embrulha o camera_fb_t num quadro com um
+ * contador de referências (uma por consumidor: envio, SD) e passa o
+ * ponteiro pelas filas. Cada consumidor registra o resultado e solta
+ * a sua referência; a última chama o callback de fim, devolve o
+ * buffer ao driver e loga as latências do quadro.
+ */
+
+#define QUADRO_NOME_MAX  32
+
+typedef enum {
+    QUADRO_ENVIO,
+    QUADRO_SD,
+    QUADRO_N_CONSUMIDORES,
+} quadro_consumidor_t;
+
+typedef struct {
+    camera_fb_t *fb;
+    uint32_t     numero;
+    char         nome[QUADRO_NOME_MAX];              // arquivo no SD
+    int64_t      capturado_us;
+    int64_t      pronto_us[QUADRO_N_CONSUMIDORES];   // 0 = consumidor não recebeu
+    bool         ok[QUADRO_N_CONSUMIDORES];
+    int          refs;
+} quadro_t;
+
+// Chamado uma vez por quadro, com os resultados de todos os consumidores
+typedef void (*quadro_fim_cb_t)(const quadro_t *q);
+void quadro_set_fim_cb(quadro_fim_cb_t cb);
+
+/**
+ * @brief Embrulha o buffer; refs = número de consumidores que vão recebê-lo.
+ * @return NULL sem memória (o buffer já foi devolvido ao driver)
+ */
+quadro_t *quadro_novo(camera_fb_t *fb, uint32_t numero, const char *nome, int refs);
+
+/**
+ * @brief Registra o fim de um consumidor e solta a referência dele.
+ */
+void quadro_concluir(quadro_t *q, quadro_consumidor_t quem, bool ok);
+
+/**
+ * @brief Solta uma referência sem resultado (consumidor não recebeu o quadro).
+ */
+void quadro_liberar(quadro_t *q);
+
+#endif // QUADRO_H
@@ -0,0 +1,69 @@
+#include "qualidade.h"
+#include <string.h>
+#include <math.h>
+
+void qualidade_init(qualidade_t *c, const qualidade_config_t *cfg, uint8_t q_inicial)
+{
+    memset(c, 0, sizeof(*c));
+    c->cfg = *cfg;
+    if (c->cfg.n_tamanhos == 0) {
+        c->cfg.n_tamanhos = 1;
+    }
+    c->q = q_inicial < cfg->q_min ? cfg->q_min : (q_inicial > cfg->q_max ? cfg->q_max : q_inicial);
+}
+
+static uint32_t calcular_alvo(const qualidade_t *c, uint32_t vazao_kbps)
+{
+    uint32_t alvo = c->cfg.alvo_bytes;
+    if (c->cfg.tempo_alvo_ms && vazao_kbps) {
+        uint64_t pelo_link = (uint64_t)vazao_kbps * 1024 * c->cfg.tempo_alvo_ms / 1000;
+        if (pelo_link < alvo) {
+            alvo = pelo_link;
+        }
+    }
+    return alvo < c->cfg.alvo_min_bytes ? c->cfg.alvo_min_bytes : alvo;
+}
+
+bool qualidade_atualizar(qualidade_t *c, uint32_t bytes, uint32_t vazao_kbps, qualidade_passo_t *passo)
+{
+    uint32_t alvo = calcular_alvo(c, vazao_kbps);
+    float razao = bytes > 0 ? (float)bytes / alvo : 1.0f;
+    float banda = c->cfg.banda_pct / 100.0f;
+    qualidade_passo_t p = {
+        .alvo = alvo,
+        .erro_pct = (int)lroundf((razao - 1.0f) * 100.0f),
+        .q_anterior = c->q,
+        .tamanho_anterior = c->tamanho,
+    };
+
+    if (razao > 1.0f + banda || razao < 1.0f - banda) {
+        // Meio passo em log: ruído de cena não vira oscilação
+        float q = c->q * powf(razao, 0.5f / QUALIDADE_ALFA);
+        int delta = (int)lroundf(q) - c->q;
+        if (delta == 0) {
+            delta = razao > 1.0f ? 1 : -1;
+        }
+        if (delta > c->cfg.passo_max) {
+            delta = c->cfg.passo_max;
+        } else if (delta < -(int)c->cfg.passo_max) {
+            delta = -(int)c->cfg.passo_max;
+        }
+        int novo = c->q + delta;
+        novo = novo < c->cfg.q_min ? c->cfg.q_min : (novo > c->cfg.q_max ? c->cfg.q_max : novo);
+
+        if (razao > 1.0f && c->q == c->cfg.q_max && c->tamanho + 1 < c->cfg.n_tamanhos) {
+            // Já no pior valor: só um quadro menor cabe no alvo
+            c->tamanho++;
+        } else if (razao * QUALIDADE_FATOR_TAMANHO < 1.0f - banda && c->q == c->cfg.q_min && c->tamanho > 0) {
+            c->tamanho--;
+        }
+        c->q = novo;
+    }
+
+    p.q = c->q;
+    p.tamanho = c->tamanho;
+    if (passo) {
+        *passo = p;
+    }
+    return p.q != p.q_anterior || p.tamanho != p.tamanho_anterior;
+}
@@ -0,0 +1,74 @@
+#ifndef QUALIDADE_H
+#define QUALIDADE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================
+ * Qualidade JPEG ajustada para um tamanho de foto
+ * ============================================================
+ * Com a qualidade fixa o tamanho do JPEG (e o tempo de envio) varia
+ * com a cena e a luz. Depois de cada foto o tamanho obtido é comparado
+ * com o alvo e a qualidade do sensor (0-63, menor = melhor) da próxima
+ * é corrigida. Modelo: tamanho ~ 1/q^QUALIDADE_ALFA, então
+ * q' = q * (tamanho/alvo)^(1/alfa), com metade do passo (amortecido),
+ * no máximo passo_max por foto e nada dentro de banda_pct do alvo.
+ *
+ * Alvo: alvo_bytes, ou menos se o link não envia isso em tempo_alvo_ms
+ * (vazão média dos envios), sem descer de alvo_min_bytes.
+ *
+ * Com n_tamanhos > 1 o tamanho do quadro também varia: índice 0 é o
+ * maior. Com a qualidade no pior valor e a foto ainda acima do alvo, o
+ * quadro diminui um passo; com a qualidade no melhor valor e folga
+ * maior que QUALIDADE_FATOR_TAMANHO, volta a crescer.
+ *
+ * Não depende do ESP-IDF: compila no host.
+ */
+
+#define QUALIDADE_ALVO_BYTES      (60 * 1024)
+#define QUALIDADE_ALVO_MIN_BYTES  (20 * 1024)
+#define QUALIDADE_TEMPO_ALVO_MS   4000
+#define QUALIDADE_Q_MIN           8       // melhor qualidade permitida
+#define QUALIDADE_Q_MAX           40
+#define QUALIDADE_PASSO_MAX       4
+#define QUALIDADE_BANDA_PCT       10
+#define QUALIDADE_ALFA            0.8f
+#define QUALIDADE_FATOR_TAMANHO   1.7f    // área XGA/SVGA ~ 1,64; SVGA/VGA ~ 1,56
+
+typedef struct {
+    uint32_t alvo_bytes;
+    uint32_t alvo_min_bytes;
+    uint32_t tempo_alvo_ms;       // 0 = alvo não depende da vazão
+    uint8_t  q_min;
+    uint8_t  q_max;
+    uint8_t  passo_max;
+    uint8_t  banda_pct;
+    uint8_t  n_tamanhos;          // 1 = só a qualidade varia
+} qualidade_config_t;
+
+typedef struct {
+    qualidade_config_t cfg;
+    uint8_t  q;
+    uint8_t  tamanho;             // índice, 0 = maior
+} qualidade_t;
+
+typedef struct {
+    uint32_t alvo;
+    int      erro_pct;            // tamanho obtido em relação ao alvo
+    uint8_t  q_anterior;
+    uint8_t  q;
+    uint8_t  tamanho_anterior;
+    uint8_t  tamanho;
+} qualidade_passo_t;
+
+void qualidade_init(qualidade_t *c, const qualidade_config_t *cfg, uint8_t q_inicial);
+
+/**
+ * @brief Calcula qualidade e tamanho da próxima foto a partir desta.
+ * @param bytes       tamanho do JPEG capturado com c->q e c->tamanho
+ * @param vazao_kbps  vazão média dos envios (0 = desconhecida)
+ * @return true se q ou tamanho mudaram (aplicar no sensor)
+ */
+bool qualidade_atualizar(qualidade_t *c, uint32_t bytes, uint32_t vazao_kbps, qualidade_passo_t *passo);
+
+#endif // QUALIDADE_H
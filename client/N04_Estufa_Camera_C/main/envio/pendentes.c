@@ -0,0 +1,423 @@
+#include "pendentes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "upload.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "PENDENTES";
+
+#define PENDENTES_CAMINHO_MAX  64
+#define PENDENTES_LINHA_MAX    (PENDENTES_NOME_MAX + 16)
+
+typedef struct {
+    char    nome[PENDENTES_NOME_MAX];
+    uint8_t tentativas;
+} pendente_t;
+
+// Uma rodada de reenvio: do primeiro envio até a lista esvaziar
+typedef struct {
+    bool     ativa;
+    int64_t  inicio_us;
+    int64_t  envio_us;        // só o tempo dentro de upload_enviar
+    uint32_t fotos;
+    uint32_t falhas;
+    uint64_t bytes;
+} escoamento_t;
+
+static pendentes_config_t cfg;
+static pendente_t *lista = NULL;     // da mais antiga para a mais nova
+static uint32_t n_lista = 0;
+static FILE *diario = NULL;
+static uint32_t linhas_diario = 0;
+static SemaphoreHandle_t mutex = NULL;
+static pendentes_stats_t stats;
+
+static void caminho(char *buf, size_t len, const char *arquivo)
+{
+    snprintf(buf, len, "%s%s", cfg.diretorio, arquivo);
+}
+
+// ======== Diário ========
+
+static void escrever(FILE *f, char op, const char *nome, int n)
+{
+    if (n > 0) {
+        fprintf(f, "%c %s %d\n", op, nome, n);
+    } else {
+        fprintf(f, "%c %s\n", op, nome);
+    }
+}
+
+// Chamado com o mutex; a linha só conta depois do fsync
+static void registrar(char op, const char *nome, int n)
+{
+    if (diario == NULL) {
+        return;
+    }
+    escrever(diario, op, nome, n);
+    if (fflush(diario) != 0 || fsync(fileno(diario)) != 0) {
+        ESP_LOGE(TAG, "Falha ao gravar o diário (%c %s)", op, nome);
+    }
+    linhas_diario++;
+}
+
+static int procurar(const char *nome)
+{
+    for (uint32_t i = 0; i < n_lista; i++) {
+        if (strcmp(lista[i].nome, nome) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void remover(int i)
+{
+    memmove(&lista[i], &lista[i + 1], (n_lista - i - 1) * sizeof(pendente_t));
+    n_lista--;
+}
+
+static bool acrescentar(const char *nome)
+{
+    if (procurar(nome) >= 0) {
+        return false;
+    }
+    if (n_lista == PENDENTES_MAX) {
+        // Cheia: a mais antiga sai para dar lugar
+        ESP_LOGW(TAG, "Lista cheia, desistindo de %s", lista[0].nome);
+        registrar('x', lista[0].nome, 0);
+        stats.desistencias++;
+        remover(0);
+    }
+    strlcpy(lista[n_lista].nome, nome, PENDENTES_NOME_MAX);
+    lista[n_lista].tentativas = 0;
+    n_lista++;
+    return true;
+}
+
+static void aplicar(char op, const char *nome, int n)
+{
+    int i = procurar(nome);
+    switch (op) {
+        case '+':
+            acrescentar(nome);
+            break;
+        case '!':
+            if (i >= 0) {
+                lista[i].tentativas = n;
+            }
+            break;
+        case '-':
+        case 'x':
+            if (i >= 0) {
+                remover(i);
+            }
+            break;
+    }
+}
+
+// Devolve o número de linhas incompletas
+static uint32_t reler(const char *arquivo)
+{
+    FILE *f = fopen(arquivo, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    char linha[PENDENTES_LINHA_MAX];
+    uint32_t cortadas = 0;
+    while (fgets(linha, sizeof(linha), f) != NULL) {
+        linhas_diario++;
+        size_t len = strlen(linha);
+        if (len == 0 || linha[len - 1] != '\n') {
+            cortadas++;     // gravação interrompida (ou linha inválida)
+            continue;
+        }
+        char op;
+        char nome[PENDENTES_NOME_MAX];
+        int n = 0;
+        if (sscanf(linha, "%c %31s %d", &op, nome, &n) >= 2) {
+            aplicar(op, nome, n);
+        }
+    }
+    fclose(f);
+    if (cortadas) {
+        ESP_LOGW(TAG, "%lu linha(s) incompleta(s) ignorada(s) no diário", (unsigned long)cortadas);
+    }
+    return cortadas;
+}
+
+// Reescreve só as pendentes: grava o temporário inteiro antes de trocar
+static void compactar(void)
+{
+    char tmp[PENDENTES_CAMINHO_MAX], final[PENDENTES_CAMINHO_MAX];
+    caminho(tmp, sizeof(tmp), PENDENTES_TMP);
+    caminho(final, sizeof(final), PENDENTES_DIARIO);
+
+    FILE *f = fopen(tmp, "w");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Não foi possível compactar o diário");
+        return;
+    }
+    for (uint32_t i = 0; i < n_lista; i++) {
+        escrever(f, '+', lista[i].nome, 0);
+        if (lista[i].tentativas) {
+            escrever(f, '!', lista[i].nome, lista[i].tentativas);
+        }
+    }
+    bool ok = (fflush(f) == 0 && fsync(fileno(f)) == 0);
+    fclose(f);
+    if (!ok) {
+        unlink(tmp);
+        return;
+    }
+
+    // FAT não troca arquivo existente no rename: queda entre unlink e
+    // rename deixa só o temporário, que o boot promove
+    if (diario) {
+        fclose(diario);
+    }
+    unlink(final);
+    rename(tmp, final);
+    diario = fopen(final, "a");
+    linhas_diario = n_lista;
+    ESP_LOGI(TAG, "Diário compactado: %lu pendentes", (unsigned long)n_lista);
+}
+
+static void compactar_se_preciso(void)
+{
+    if (linhas_diario > 2 * n_lista + 256) {
+        compactar();
+    }
+}
+
+// ======== Reenvio ========
+
+// Lê a foto inteira (PSRAM) e confere as marcas de início e fim do JPEG
+static uint8_t *ler_foto(const char *nome, size_t *len)
+{
+    char arquivo[PENDENTES_CAMINHO_MAX];
+    snprintf(arquivo, sizeof(arquivo), "%s/%s", cfg.diretorio, nome);
+
+    FILE *f = fopen(arquivo, "rb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "%s não existe mais", nome);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long tamanho = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t *buf = (tamanho > 4) ? malloc(tamanho) : NULL;
+    if (buf == NULL || fread(buf, 1, tamanho, f) != (size_t)tamanho ||
+        buf[0] != 0xFF || buf[1] != 0xD8 || buf[tamanho - 2] != 0xFF || buf[tamanho - 1] != 0xD9) {
+        ESP_LOGW(TAG, "%s ilegível ou incompleto (%ld bytes)", nome, tamanho);
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    *len = tamanho;
+    return buf;
+}
+
+static bool primeira(pendente_t *p)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool tem = (n_lista > 0);
+    if (tem) {
+        *p = lista[0];
+    }
+    xSemaphoreGive(mutex);
+    return tem;
+}
+
+// Tira da lista (a foto pode já ter saído se a lista encheu nesse meio tempo)
+static void concluir(const char *nome, char op)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int i = procurar(nome);
+    if (i >= 0) {
+        registrar(op, nome, 0);
+        remover(i);
+        if (op == 'x') {
+            stats.desistencias++;
+        } else {
+            stats.enviadas++;
+        }
+    }
+    compactar_se_preciso();
+    xSemaphoreGive(mutex);
+}
+
+bool pendentes_recusada(int status)
+{
+    return status >= 400 && status < 500 && status != 408 && status != 429;
+}
+
+// Só a recusa gasta tentativa: servidor fora não pode descartar foto boa
+static void falhar(const char *nome, bool recusada)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    stats.falhas++;
+    int i = procurar(nome);
+    if (i >= 0 && recusada) {
+        lista[i].tentativas++;
+        if (lista[i].tentativas >= PENDENTES_TENTATIVAS) {
+            ESP_LOGW(TAG, "Desistindo de %s depois de %d tentativas", nome, lista[i].tentativas);
+            registrar('x', nome, 0);
+            remover(i);
+            stats.desistencias++;
+        } else {
+            registrar('!', nome, lista[i].tentativas);
+        }
+    }
+    xSemaphoreGive(mutex);
+}
+
+static void relatar(const escoamento_t *e)
+{
+    double s = (esp_timer_get_time() - e->inicio_us) / 1e6;
+    double kb = e->bytes / 1024.0;
+    ESP_LOGI(TAG, "Pendentes escoadas: %lu fotos, %.1f KB em %.1f s (%.1f KB/s; %.1f KB/s durante o envio), "
+             "%lu falhas", (unsigned long)e->fotos, kb, s, s > 0 ? kb / s : 0.0,
+             e->envio_us > 0 ? kb / (e->envio_us / 1e6) : 0.0, (unsigned long)e->falhas);
+}
+
+static void task_pendentes(void *arg)
+{
+    uint32_t backoff_ms = PENDENTES_BACKOFF_MIN_MS;
+    escoamento_t escoamento = {0};
+    pendente_t p;
+
+    while (true) {
+        if (!cfg.online() || !primeira(&p)) {
+            if (escoamento.ativa && pendentes_quantidade() == 0) {
+                relatar(&escoamento);
+                escoamento.ativa = false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+        if (!escoamento.ativa) {
+            escoamento = (escoamento_t){ .ativa = true, .inicio_us = esp_timer_get_time() };
+            ESP_LOGI(TAG, "Reenviando %lu fotos pendentes", (unsigned long)pendentes_quantidade());
+        }
+
+        size_t len = 0;
+        uint8_t *buf = ler_foto(p.nome, &len);
+        if (buf == NULL) {
+            concluir(p.nome, 'x');
+            continue;
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        upload_tempos_t t = {0};
+        esp_err_t err = upload_enviar(buf, len, p.nome, &t);
+        int64_t dt = esp_timer_get_time() - t0;
+        free(buf);
+
+        if (err == ESP_OK) {
+            concluir(p.nome, '-');
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            stats.bytes += len;
+            xSemaphoreGive(mutex);
+            escoamento.fotos++;
+            escoamento.bytes += len;
+            escoamento.envio_us += dt;
+            backoff_ms = PENDENTES_BACKOFF_MIN_MS;
+            ESP_LOGI(TAG, "%s reenviada (%u bytes, %lld ms), faltam %lu", p.nome, (unsigned)len,
+                     (long long)(dt / 1000), (unsigned long)pendentes_quantidade());
+
+            // Vazão média limitada: o envio ao vivo continua com folga
+            int64_t alvo_us = (int64_t)len * 1000000 / (PENDENTES_TAXA_KBPS * 1024);
+            if (alvo_us > dt) {
+                vTaskDelay(pdMS_TO_TICKS((alvo_us - dt) / 1000));
+            }
+        } else {
+            bool recusada = pendentes_recusada(t.status);
+            falhar(p.nome, recusada);
+            escoamento.falhas++;
+            ESP_LOGW(TAG, "Reenvio de %s falhou (%s, HTTP %d%s), nova tentativa em %lu ms", p.nome,
+                     esp_err_to_name(err), t.status, recusada ? ", recusada" : "", (unsigned long)backoff_ms);
+            vTaskDelay(pdMS_TO_TICKS(backoff_ms));
+            backoff_ms = (backoff_ms * 2 > PENDENTES_BACKOFF_MAX_MS) ? PENDENTES_BACKOFF_MAX_MS : backoff_ms * 2;
+        }
+    }
+}
+
+// ======== API ========
+
+esp_err_t pendentes_init(const pendentes_config_t *config)
+{
+    cfg = *config;
+    lista = calloc(PENDENTES_MAX, sizeof(pendente_t));   // ~50 KB: vai para a PSRAM
+    mutex = xSemaphoreCreateMutex();
+    if (lista == NULL || mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    char final[PENDENTES_CAMINHO_MAX], tmp[PENDENTES_CAMINHO_MAX];
+    caminho(final, sizeof(final), PENDENTES_DIARIO);
+    caminho(tmp, sizeof(tmp), PENDENTES_TMP);
+
+    // Compactação interrompida: sem diário vale o temporário (já completo);
+    // com os dois, o temporário pode estar pela metade
+    if (access(final, F_OK) != 0 && access(tmp, F_OK) == 0) {
+        rename(tmp, final);
+    } else {
+        unlink(tmp);
+    }
+
+    if (reler(final) > 0) {
+        // A linha cortada não termina em '\n': o próximo acréscimo grudaria nela
+        compactar();
+    } else {
+        diario = fopen(final, "a");
+        compactar_se_preciso();
+    }
+    if (diario == NULL) {
+        ESP_LOGE(TAG, "Não foi possível abrir o diário %s", final);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "%lu fotos pendentes no diário", (unsigned long)n_lista);
+
+    // Envio TLS roda nesta tarefa: pilha do tamanho da de envio
+    xTaskCreate(task_pendentes, "pendentes_task", 8192, NULL, 3, NULL);
+    return ESP_OK;
+}
+
+esp_err_t pendentes_adicionar(const char *nome)
+{
+    if (mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (acrescentar(nome)) {
+        registrar('+', nome, 0);
+    }
+    xSemaphoreGive(mutex);
+    return ESP_OK;
+}
+
+uint32_t pendentes_quantidade(void)
+{
+    return n_lista;
+}
+
+void pendentes_get_stats(pendentes_stats_t *out)
+{
+    if (mutex == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    *out = stats;
+    out->pendentes = n_lista;
+    xSemaphoreGive(mutex);
+}
@@ -0,0 +1,67 @@
+#ifndef PENDENTES_H
+#define PENDENTES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Fotos do SD que ainda não chegaram ao servidor
+ * ============================================================
+ * Cada foto salva no SD e não enviada entra num diário (arquivo de
+ * texto só com acréscimos, uma linha por operação, fsync a cada
+ * uma): "+ nome" pendente, "! nome n" n-ésima falha, "- nome"
+ * enviada, "x nome" desistência. No boot o diário é relido; uma
+ * linha cortada por queda de energia é ignorada. Quando as linhas
+ * mortas dominam, o diário é reescrito em PENDENTES_TMP e renomeado.
+ *
+ * Uma tarefa reenvia as pendentes da mais antiga para a mais nova,
+ * com a vazão limitada a PENDENTES_TAXA_KBPS para não disputar o link
+ * com o envio ao vivo e backoff exponencial depois de falha. Só a
+ * recusa da foto em si (4xx exceto 408 e 429) gasta uma das
+ * PENDENTES_TENTATIVAS; sem rede, sem resposta, 5xx, 408 e 429 só
+ * esperam o backoff, e a foto não se perde com o servidor fora.
+ */
+
+#define PENDENTES_MAX             1440    // um dia de fotos com o Wi-Fi fora
+#define PENDENTES_NOME_MAX        32
+#define PENDENTES_TENTATIVAS      8
+#define PENDENTES_TAXA_KBPS       64
+#define PENDENTES_BACKOFF_MIN_MS  5000
+#define PENDENTES_BACKOFF_MAX_MS  300000
+#define PENDENTES_DIARIO          "/pendente.log"
+#define PENDENTES_TMP             "/pendente.tmp"
+
+typedef struct {
+    const char *diretorio;      // ponto de montagem do SD (fotos e diário)
+    bool (*online)(void);       // só tenta enviar com rede
+} pendentes_config_t;
+
+typedef struct {
+    uint32_t pendentes;
+    uint32_t enviadas;
+    uint32_t falhas;            // todas, inclusive as que não gastam tentativa
+    uint32_t desistencias;      // tentativas esgotadas, arquivo sumido ou corrompido
+    uint64_t bytes;
+} pendentes_stats_t;
+
+/**
+ * @brief Relê o diário e cria a tarefa de reenvio (SD já montado).
+ */
+esp_err_t pendentes_init(const pendentes_config_t *cfg);
+
+/**
+ * @brief Registra uma foto já gravada (e sincronizada) no SD.
+ */
+esp_err_t pendentes_adicionar(const char *nome);
+
+uint32_t pendentes_quantidade(void);
+
+/**
+ * @brief true se o status HTTP do reenvio conta como tentativa da foto.
+ */
+bool pendentes_recusada(int status);
+
+void pendentes_get_stats(pendentes_stats_t *stats);
+
+#endif // PENDENTES_H
@@ -0,0 +1,372 @@
+#include "upload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_http_client.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "UPLOAD";
+
+// Instantes de uma tentativa; conexão e cabeçalhos da resposta vêm dos eventos
+typedef struct {
+    int64_t inicio_us;
+    int64_t conectado_us;      // 0 = conexão reaproveitada
+    int64_t cabecalhos_us;     // open() voltou: pedido enviado
+    int64_t corpo_us;          // último bloco escrito
+    int64_t resposta_us;       // cabeçalhos da resposta lidos
+    int64_t fim_us;
+    size_t  enviados;          // bytes do corpo aceitos pelo socket
+    long    offset_servidor;   // X-Upload-Offset da resposta; -1 = ausente
+} medicao_t;
+
+static const char *url_envio = NULL;
+static const char *cert = NULL;
+static esp_http_client_handle_t cliente = NULL;
+static SemaphoreHandle_t mutex = NULL;
+static medicao_t medicao;
+static int falhas_seguidas = 0;
+static volatile bool ocupado = false;
+static uint32_t vazao_kbps = UPLOAD_VAZAO_INICIAL_KBPS;
+static int prazos_esgotados = 0;        // seguidos; dobram o próximo prazo
+static upload_progresso_cb_t progresso_cb = NULL;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static upload_stats_t stats;
+
+static esp_err_t on_http(esp_http_client_event_t *evt)
+{
+    medicao_t *m = evt->user_data;
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            m->conectado_us = esp_timer_get_time();
+            break;
+        case HTTP_EVENT_ON_HEADER:
+            if (strcasecmp(evt->header_key, "X-Upload-Offset") == 0) {
+                m->offset_servidor = strtol(evt->header_value, NULL, 10);
+            }
+            break;
+        default:
+            break;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t criar_cliente(void)
+{
+    esp_http_client_config_t config = {
+        .url = url_envio,
+        .method = HTTP_METHOD_POST,
+        .transport_type = HTTP_TRANSPORT_OVER_SSL,
+        .cert_pem = cert,
+        .timeout_ms = UPLOAD_TIMEOUT_MS,
+        .event_handler = on_http,
+        .user_data = &medicao,
+        .keep_alive_enable = true,
+        .keep_alive_idle = UPLOAD_TCP_KEEPALIVE_S,
+        .keep_alive_interval = 5,
+        .keep_alive_count = 3,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true,
+#endif
+    };
+
+    cliente = esp_http_client_init(&config);
+    if (cliente == NULL) {
+        ESP_LOGE(TAG, "Falha ao criar o cliente HTTP");
+        return ESP_ERR_NO_MEM;
+    }
+    esp_http_client_set_header(cliente, "Content-Type", "image/jpeg");
+    return ESP_OK;
+}
+
+esp_err_t upload_init(const char *url, const char *cert_pem)
+{
+    url_envio = url;
+    cert = cert_pem;
+    mutex = xSemaphoreCreateMutex();
+    return criar_cliente();
+}
+
+void upload_set_progresso_cb(upload_progresso_cb_t cb)
+{
+    progresso_cb = cb;
+}
+
+static int64_t intervalo(int64_t de, int64_t ate)
+{
+    return (de != 0 && ate >= de) ? ate - de : 0;
+}
+
+static void iniciar_medicao(void)
+{
+    memset(&medicao, 0, sizeof(medicao));
+    medicao.offset_servidor = -1;
+    medicao.inicio_us = esp_timer_get_time();
+}
+
+// Prazo do envio inteiro a partir da vazão média
+static int64_t calcular_prazo_us(size_t len)
+{
+    int64_t corpo_ms = (int64_t)len * 1000 / ((int64_t)vazao_kbps * 1024);
+    int64_t prazo_ms = (UPLOAD_TIMEOUT_MS + UPLOAD_FOLGA_VAZAO * corpo_ms) << prazos_esgotados;
+    if (prazo_ms > UPLOAD_PRAZO_MAX_MS) {
+        prazo_ms = UPLOAD_PRAZO_MAX_MS;
+    }
+    return prazo_ms * 1000;
+}
+
+static void atualizar_vazao(uint32_t kbps)
+{
+    vazao_kbps = (3 * vazao_kbps + kbps) / 4;
+    if (vazao_kbps == 0) {
+        vazao_kbps = 1;
+    }
+}
+
+// Um POST de dados[inicio..len); status 0 se não houve resposta
+static esp_err_t tentar(const uint8_t *dados, size_t len, size_t inicio, int64_t inicio_us,
+                        int64_t prazo_us, int *status)
+{
+    char valor[16];
+    if (inicio > 0) {
+        snprintf(valor, sizeof(valor), "%u", (unsigned)inicio);
+        esp_http_client_set_header(cliente, "X-Upload-Offset", valor);
+    } else {
+        esp_http_client_delete_header(cliente, "X-Upload-Offset");
+    }
+    esp_http_client_set_method(cliente, HTTP_METHOD_POST);
+
+    *status = 0;
+    iniciar_medicao();
+    esp_err_t err = esp_http_client_open(cliente, len - inicio);
+    if (err != ESP_OK) {
+        return err;
+    }
+    medicao.cabecalhos_us = esp_timer_get_time();
+
+    // Direto do buffer da câmera; o mbedTLS cifra bloco a bloco
+    size_t pos = inicio;
+    while (pos < len) {
+        size_t n = (len - pos < UPLOAD_BLOCO_BYTES) ? len - pos : UPLOAD_BLOCO_BYTES;
+        int w = esp_http_client_write(cliente, (const char *)dados + pos, n);
+        if (w <= 0) {
+            return ESP_FAIL;
+        }
+        pos += w;
+        medicao.enviados = pos - inicio;
+        int64_t decorrido = esp_timer_get_time() - inicio_us;
+        if (progresso_cb) {
+            progresso_cb(pos, len, decorrido);
+        }
+        if (pos < len && decorrido > prazo_us) {
+            ESP_LOGW(TAG, "Prazo de %lld ms esgotado com %u de %u bytes",
+                     (long long)(prazo_us / 1000), (unsigned)pos, (unsigned)len);
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    medicao.corpo_us = esp_timer_get_time();
+
+    if (esp_http_client_fetch_headers(cliente) < 0) {
+        return ESP_FAIL;
+    }
+    medicao.resposta_us = esp_timer_get_time();
+    *status = esp_http_client_get_status_code(cliente);
+    esp_http_client_flush_response(cliente, NULL);
+    medicao.fim_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+// HEAD com o id do envio: quantos bytes o servidor já guardou (0 se não sabe)
+static size_t consultar_offset(size_t len)
+{
+    esp_http_client_delete_header(cliente, "X-Upload-Offset");
+    esp_http_client_set_method(cliente, HTTP_METHOD_HEAD);
+    iniciar_medicao();
+
+    size_t offset = 0;
+    if (esp_http_client_open(cliente, 0) == ESP_OK && esp_http_client_fetch_headers(cliente) >= 0) {
+        esp_http_client_flush_response(cliente, NULL);
+        if (esp_http_client_get_status_code(cliente) == 200 &&
+            medicao.offset_servidor > 0 && (size_t)medicao.offset_servidor < len) {
+            offset = medicao.offset_servidor;
+        }
+    } else {
+        esp_http_client_close(cliente);
+    }
+    esp_http_client_set_method(cliente, HTTP_METHOD_POST);
+    return offset;
+}
+
+static void contar(bool ok, bool nova, bool refeita, bool retomada, size_t len)
+{
+    portENTER_CRITICAL(&stats_lock);
+    if (ok) {
+        stats.enviados++;
+        stats.bytes += len;
+    } else {
+        stats.falhas++;
+    }
+    if (nova) {
+        stats.conexoes_novas++;
+    } else {
+        stats.reaproveitadas++;
+    }
+    if (refeita) {
+        stats.reconexoes++;
+    }
+    if (retomada) {
+        stats.retomadas++;
+    }
+    stats.vazao_kbps = vazao_kbps;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+esp_err_t upload_enviar(const uint8_t *dados, size_t len, const char *nome, upload_tempos_t *tempos)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    if (cliente == NULL && criar_cliente() != ESP_OK) {
+        xSemaphoreGive(mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    ocupado = true;
+
+    if (nome) {
+        esp_http_client_set_header(cliente, "X-Foto", nome);
+    } else {
+        esp_http_client_delete_header(cliente, "X-Foto");
+    }
+#if UPLOAD_RETOMAR
+    char id[48];
+    snprintf(id, sizeof(id), "%s-%u", nome ? nome : "ao-vivo", (unsigned)len);
+    esp_http_client_set_header(cliente, "X-Upload-Id", id);
+#endif
+
+    int64_t inicio_us = esp_timer_get_time();
+    int64_t prazo_us = calcular_prazo_us(len);
+    esp_err_t err = ESP_FAIL;
+    int status = 0;
+    int tentativas = 0;
+    size_t offset = 0;
+    bool refeita = false;
+
+    while (tentativas < 2) {
+        tentativas++;
+        err = tentar(dados, len, offset, inicio_us, prazo_us, &status);
+        if (err == ESP_OK) {
+            break;
+        }
+
+        esp_http_client_close(cliente);
+        if (err == ESP_ERR_TIMEOUT) {
+            break;   // prazo é do envio inteiro
+        }
+        bool parcial = UPLOAD_RETOMAR && medicao.enviados > 0 && err != ESP_ERR_TIMEOUT;
+        if (medicao.conectado_us != 0 && !parcial) {
+            break;   // já era conexão nova: não adianta repetir agora
+        }
+        if (parcial) {
+            size_t enviados = offset + medicao.enviados;
+            offset = consultar_offset(len);
+            ESP_LOGW(TAG, "Envio interrompido (%s) com %u bytes enviados, continuando de %u",
+                     esp_err_to_name(err), (unsigned)enviados, (unsigned)offset);
+        } else {
+            // Conexão ociosa que o servidor já tinha fechado
+            ESP_LOGW(TAG, "Conexão reaproveitada falhou (%s), reconectando", esp_err_to_name(err));
+        }
+        refeita = true;
+    }
+    int64_t fim = esp_timer_get_time();
+
+    bool ok = (err == ESP_OK && status >= 200 && status < 300);
+    bool nova = (medicao.conectado_us != 0);
+    int64_t inicio_pedido = nova ? medicao.conectado_us : medicao.inicio_us;
+    size_t corpo = len - offset;
+    int64_t transferencia_us = intervalo(medicao.cabecalhos_us, medicao.resposta_us);
+
+    upload_tempos_t t = {
+        .status = status,
+        .nova_conexao = nova,
+        .tentativas = tentativas,
+        .conexao_us = intervalo(medicao.inicio_us, medicao.conectado_us),
+        .cabecalho_us = intervalo(inicio_pedido, medicao.cabecalhos_us),
+        .corpo_us = intervalo(medicao.cabecalhos_us, medicao.corpo_us),
+        .servidor_us = intervalo(medicao.corpo_us, medicao.resposta_us),
+        .resposta_us = intervalo(medicao.resposta_us, medicao.fim_us),
+        .total_us = fim - inicio_us,
+        .kbps = transferencia_us > 0 ? (uint32_t)((int64_t)corpo * 1000000 / 1024 / transferencia_us) : 0,
+        .retomado_de = offset,
+    };
+
+    if (ok && corpo >= UPLOAD_VAZAO_MIN_BYTES && t.kbps > 0) {
+        // Só corpos grandes medem o link (os pequenos cabem no buffer do socket)
+        atualizar_vazao(t.kbps);
+    } else if (!ok && medicao.cabecalhos_us != 0 &&
+               (err == ESP_ERR_TIMEOUT || medicao.enviados >= UPLOAD_VAZAO_MIN_BYTES)) {
+        // Envio incompleto: o que o socket aceitou no tempo gasto é o teto da
+        // vazão real. Sem isso a média só vê envios bons e não cai com o link
+        int64_t dt = fim - medicao.cabecalhos_us;
+        uint32_t teto = dt > 0 ? (uint32_t)((int64_t)medicao.enviados * 1000000 / 1024 / dt) : 0;
+        if (teto < vazao_kbps) {
+            atualizar_vazao(teto);
+        }
+    }
+    if (err == ESP_ERR_TIMEOUT) {
+        if (prazos_esgotados < UPLOAD_PRAZO_DOBRAS_MAX) {
+            prazos_esgotados++;
+        }
+    } else if (ok) {
+        prazos_esgotados = 0;
+    }
+
+    if (ok) {
+        falhas_seguidas = 0;
+    } else if (++falhas_seguidas >= UPLOAD_FALHAS_REINICIO) {
+        // Estado do cliente suspeito: começa do zero (sessão TLS incluída)
+        ESP_LOGW(TAG, "%d falhas seguidas, recriando o cliente", falhas_seguidas);
+        esp_http_client_cleanup(cliente);
+        cliente = NULL;
+        falhas_seguidas = 0;
+    }
+    ocupado = false;
+    xSemaphoreGive(mutex);
+
+    contar(ok, nova, refeita, ok && offset > 0, len);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erro ao enviar imagem: %s", esp_err_to_name(err));
+    }
+    ESP_LOGI(TAG, "Envio de %u bytes%s: status %d, %lu KB/s, conexão %s %lld ms, cabeçalho %lld ms, "
+             "corpo %lld ms, servidor %lld ms, resposta %lld ms, total %lld ms (prazo %lld ms)",
+             (unsigned)len, offset ? " (retomado)" : "", status, (unsigned long)t.kbps,
+             nova ? "nova" : "reaproveitada",
+             (long long)(t.conexao_us / 1000), (long long)(t.cabecalho_us / 1000),
+             (long long)(t.corpo_us / 1000), (long long)(t.servidor_us / 1000),
+             (long long)(t.resposta_us / 1000), (long long)(t.total_us / 1000),
+             (long long)(prazo_us / 1000));
+
+    if (tempos) {
+        *tempos = t;
+    }
+    if (ok) {
+        return ESP_OK;
+    }
+    return (err != ESP_OK) ? err : ESP_FAIL;
+}
+
+bool upload_ocupado(void)
+{
+    return ocupado;
+}
+
+void upload_get_stats(upload_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
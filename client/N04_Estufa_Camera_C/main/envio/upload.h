@@ -0,0 +1,101 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Envio HTTPS das fotos com conexão persistente
+ * ============================================================
+ * Um único esp_http_client vive entre os envios: com HTTP keep-alive
+ * a foto seguinte vai pela mesma conexão TLS, sem handshake. Quando o
+ * servidor fecha a conexão ociosa, a reconexão oferece a sessão TLS
+ * anterior (save_client_session) e o handshake é retomado.
+ *
+ * O corpo sai direto do buffer da câmera (PSRAM), em blocos de
+ * UPLOAD_BLOCO_BYTES com esp_http_client_write, sem cópia. O prazo do
+ * envio inteiro acompanha a vazão medida nos envios anteriores (média
+ * móvel): UPLOAD_TIMEOUT_MS + UPLOAD_FOLGA_VAZAO vezes o tempo esperado
+ * para o corpo, até UPLOAD_PRAZO_MAX_MS. UPLOAD_TIMEOUT_MS continua
+ * valendo para cada operação de socket (link parado). Um envio que não
+ * termina (prazo esgotado ou conexão caída) também entra na média, com
+ * os bytes aceitos pelo socket sobre o tempo gasto, se isso for menor
+ * que a média; e cada prazo esgotado seguido dobra o próximo (até
+ * 2^UPLOAD_PRAZO_DOBRAS_MAX vezes).
+ *
+ * Se o envio falha numa conexão reaproveitada (o servidor já a tinha
+ * fechado), tenta de novo uma vez numa conexão nova. Com
+ * UPLOAD_RETOMAR, uma falha no meio do corpo também é repetida: um HEAD
+ * com X-Upload-Id pergunta quantos bytes o servidor guardou
+ * (X-Upload-Offset na resposta) e o POST seguinte manda só o restante,
+ * com X-Upload-Offset; servidor que não responde o cabeçalho recebe a
+ * foto inteira de novo. Depois de UPLOAD_FALHAS_REINICIO falhas
+ * seguidas o cliente é recriado.
+ */
+
+#define UPLOAD_TIMEOUT_MS          10000
+#define UPLOAD_FALHAS_REINICIO     3
+#define UPLOAD_TCP_KEEPALIVE_S     30     // derruba a conexão meio-aberta entre fotos
+#define UPLOAD_BLOCO_BYTES         8192
+#define UPLOAD_VAZAO_INICIAL_KBPS  32     // até o primeiro envio medido
+#define UPLOAD_FOLGA_VAZAO         4      // prazo aguenta o link 4x mais lento que a média
+#define UPLOAD_PRAZO_MAX_MS        180000
+#define UPLOAD_PRAZO_DOBRAS_MAX    3
+#define UPLOAD_VAZAO_MIN_BYTES     (16 * 1024)   // corpo menor cabe no buffer do socket
+#define UPLOAD_RETOMAR             0      // só com servidor que implementa X-Upload-Offset
+
+// Fases de um envio (esp_http_client não separa TCP de TLS)
+typedef struct {
+    int      status;          // HTTP; 0 = sem resposta
+    bool     nova_conexao;
+    int      tentativas;
+    int64_t  conexao_us;      // DNS + TCP + handshake TLS (0 se reaproveitada)
+    int64_t  cabecalho_us;    // cabeçalhos do pedido
+    int64_t  corpo_us;        // escrita do corpo
+    int64_t  servidor_us;     // fim do corpo até o início da resposta
+    int64_t  resposta_us;     // restante da resposta
+    int64_t  total_us;
+    uint32_t kbps;            // corpo / (corpo + servidor) da última tentativa
+    size_t   retomado_de;     // offset da última tentativa (0 = foto inteira)
+} upload_tempos_t;
+
+typedef struct {
+    uint32_t enviados;
+    uint32_t falhas;
+    uint32_t conexoes_novas;
+    uint32_t reaproveitadas;
+    uint32_t reconexoes;      // reaproveitada falhou e foi refeita
+    uint32_t retomadas;       // continuaram de onde o servidor parou
+    uint32_t vazao_kbps;      // média móvel usada no prazo
+    uint64_t bytes;           // corpo dos envios com sucesso
+} upload_stats_t;
+
+// Progresso do corpo, chamado depois de cada bloco (tarefa que envia)
+typedef void (*upload_progresso_cb_t)(size_t enviados, size_t total, int64_t decorrido_us);
+void upload_set_progresso_cb(upload_progresso_cb_t cb);
+
+/**
+ * @brief Guarda URL e certificado (PEM com terminador) e cria o cliente.
+ */
+esp_err_t upload_init(const char *url, const char *cert_pem);
+
+/**
+ * @brief POST de image/jpeg; bloqueia até a resposta. Uma chamada por vez.
+ * @param nome    opcional: nome da foto no SD, vai no cabeçalho X-Foto
+ *                (reenvios chegam depois da hora da captura) e identifica
+ *                o envio na retomada
+ * @param tempos  opcional
+ * @return ESP_OK só com status 2xx
+ */
+esp_err_t upload_enviar(const uint8_t *dados, size_t len, const char *nome, upload_tempos_t *tempos);
+
+/**
+ * @brief true enquanto um envio está em andamento (o stream cede a banda).
+ */
+bool upload_ocupado(void);
+
+void upload_get_stats(upload_stats_t *stats);
+
+#endif // UPLOAD_H
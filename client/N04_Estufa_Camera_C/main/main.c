@@ -1,13 +1,16 @@
 #include <stdint.h>
 #include <sys/stat.h> // Necessário para mkpath
-#include <dirent.h>   // Necessário para opendir, readdir, closedir
+#include <unistd.h>   // fsync
 
 // Certificado embutido
 extern const uint8_t greense_cert_pem_start[] asm("_binary_greense_cert_pem_start");
 extern const uint8_t greense_cert_pem_end[]   asm("_binary_greense_cert_pem_end");
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "esp_camera.h"
+#include "img_converters.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
@@ -17,14 +20,23 @@ extern const uint8_t greense_cert_pem_end[]   asm("_binary_greense_cert_pem_end"
 #include "freertos/event_groups.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_http_client.h"
 #include "driver/gpio.h"
 #include "secrets.h"
 
-// --- Novas Inclusões para SD Card ---
-#include "esp_vfs_fat.h"
-#include "driver/sdmmc_host.h"
-#include "sdmmc_cmd.h"
+// --- SD Card ---
+#include "cartao.h"
+#include "timelapse.h"
+
+#include "quadro.h"
+#include "mudanca.h"
+#include "exposicao.h"
+#include "qualidade.h"
+#include "upload.h"
+#include "pendentes.h"
+#include "stream.h"
+#include "relogio.h"
 
 // === DEFINIÇÕES ===
 #define WIFI_CONNECTED_BIT BIT0
@@ -34,6 +46,8 @@ extern const uint8_t greense_cert_pem_end[]   asm("_binary_greense_cert_pem_end"
 #define TAG_WIFI "WIFI"
 #define TAG_SD "SD_CARD" // Novo TAG para logs do SD
 
+#define SNTP_SERVIDOR "pool.ntp.org"
+
 static EventGroupHandle_t s_wifi_event_group;
 
 // === Pinos da ESP32-CAM (AI Thinker) ===
@@ -54,6 +68,8 @@ static EventGroupHandle_t s_wifi_event_group;
 #define HREF_GPIO_NUM     23
 #define PCLK_GPIO_NUM     22
 #define FLASH_GPIO_NUM     4
+// No SD em 4 bits o GPIO 4 é DAT1: sem flash
+#define FLASH_HABILITADO  (SD_LARGURA_BARRAMENTO == 1)
 
 // === LED Wi-Fi ===
 #define LED_WIFI_GPIO_NUM 33  // LED no lado oposto da câmera
@@ -61,6 +77,70 @@ static EventGroupHandle_t s_wifi_event_group;
 // --- Definições para SD Card ---
 #define MOUNT_POINT "/sdcard"
 
+// --- Captura e consumidores ---
+// A captura entrega cada quadro às tarefas de envio e SD, que rodam em
+// paralelo. Cada consumidor segura no máximo um quadro em andamento e um
+// na fila: com 3 buffers sempre sobra um para o driver.
+#define FOTO_INTERVALO_MS   60000
+#define FOTO_FB_COUNT       3
+#define FOTO_FILA_TAMANHO   1
+
+// Com FOTO_TIMELAPSE as fotos do dia vão para um AVI (sd/timelapse.h) em
+// vez de um JPEG cada; só as que não chegaram ao servidor continuam como
+// JPEG avulso, que o reenvio de pendentes lê pelo nome.
+#define FOTO_TIMELAPSE      0
+
+// --- Detector de mudança (captura/mudanca.h) ---
+// Foto escura ou igual à última mantida não vai para o servidor nem para
+// o SD. A miniatura sai do JPEG decodificado em escala 1/8.
+#define FOTO_FILTRAR_MUDANCA  1
+#define RESUMO_DIA_US         (24LL * 3600 * 1000000)
+
+// --- Captura com flash (captura/exposicao.h) ---
+// Quadros começados antes do pedido (buffers que o driver já tinha) são
+// devolvidos; com flash, a foto sai assim que o brilho dos quadros para
+// de variar, em vez de uma espera fixa.
+#define FOTO_DESCARTE_MAX   (FOTO_FB_COUNT + 1)
+
+// --- Qualidade JPEG (captura/qualidade.h) ---
+// A qualidade da próxima foto é corrigida para o tamanho alvo; com
+// FOTO_VARIAR_TAMANHO a resolução também desce (e volta) pela lista.
+// Fotos escuras não entram no controle.
+#define FOTO_QUALIDADE_INICIAL     12
+#define FOTO_QUALIDADE_ADAPTATIVA  1
+#define FOTO_VARIAR_TAMANHO        0
+
+static const framesize_t foto_tamanhos[] = { FRAMESIZE_XGA, FRAMESIZE_SVGA, FRAMESIZE_VGA };
+static const char *const foto_tamanhos_nome[] = { "XGA", "SVGA", "VGA" };
+
+typedef struct {
+    int64_t  inicio_us;
+    uint32_t mantidas;
+    uint32_t iguais;
+    uint32_t escuras;
+    uint64_t bytes_mantidos;
+    uint64_t bytes_evitados;
+    uint32_t avaliadas;
+    int64_t  detector_us;
+    int64_t  detector_max_us;
+    uint32_t capturas;
+    int64_t  captura_us;       // pedido até o quadro escolhido
+    int64_t  flash_us;
+    upload_stats_t upload;     // contadores no início do dia
+} resumo_dia_t;
+
+static mudanca_t mudanca;
+static uint8_t *miniatura_rgb = NULL;
+static size_t miniatura_rgb_len = 0;
+static uint8_t miniatura[MUDANCA_PIXELS];   // do último quadro reduzido
+static exposicao_t exposicao;
+static qualidade_t qualidade;
+static resumo_dia_t resumo;
+
+static QueueHandle_t fila_envio = NULL;
+static QueueHandle_t fila_sd = NULL;
+static bool sd_montado = false;
+
 // === Handlers ===
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
@@ -121,133 +201,352 @@ bool conexao_wifi_is_connected(void) {
 }
 
 esp_err_t enviar_foto_para_raspberry(camera_fb_t *fb) {
-    esp_http_client_config_t config = {
-        .url = CAMERA_UPLOAD_URL,
-        .method = HTTP_METHOD_POST,
-        .transport_type = HTTP_TRANSPORT_OVER_SSL,
-        .cert_pem = (const char *)greense_cert_pem_start,
-        .timeout_ms = 10000
-    };
+    // Conexão persistente: ver envio/upload.h
+    return upload_enviar(fb->buf, fb->len, NULL, NULL);
+}
+
+// --- Nova Função: Inicializa o Cartão SD ---
+static esp_err_t init_sd_card(void) {
+    // Montagem, barramento e modo de gravação: ver sd/cartao.h
+    return cartao_montar(MOUNT_POINT);
+}
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_http_client_set_header(client, "Content-Type", "image/jpeg");
-    esp_http_client_set_post_field(client, (const char *)fb->buf, fb->len);
+// Nome do arquivo da foto (sem o ponto de montagem)
+static void nomear_foto(char *nome, size_t len) {
+    struct tm timeinfo;
+    time_t now;
 
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        ESP_LOGI(TAG, "Imagem enviada. Status = %d", esp_http_client_get_status_code(client));
+    if (!relogio_valido()) {
+        // Sem hora: boot + uptime não se repete depois de um reset
+        snprintf(nome, len, "img_b%lu_%llu.jpg", (unsigned long)relogio_boot_atual(),
+                 (unsigned long long)(esp_timer_get_time() / 1000));
     } else {
-        ESP_LOGE(TAG, "Erro ao enviar imagem: %s", esp_err_to_name(err));
+        time(&now);
+        localtime_r(&now, &timeinfo);
+        strftime(nome, len, "%Y%m%d_%H%M%S.jpg", &timeinfo);
     }
-
-    esp_http_client_cleanup(client);
-    return err;
 }
 
-// --- Nova Função: Inicializa o Cartão SD ---
-static esp_err_t init_sd_card(void) {
-    esp_err_t ret;
-    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
-    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
+// --- Nova Função: Salva a Imagem no Cartão SD ---
+static esp_err_t salvar_foto_no_sd(camera_fb_t *fb, const char *nome) {
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), MOUNT_POINT "/%s", nome);
 
-    slot_config.width = 1; // 1-bit mode for compatibility (you can try 4 if your board supports it)
-    slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP; // Habilita pull-ups internos
+    ESP_LOGI(TAG_SD, "Salvando imagem em: %s", file_name);
 
-    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .format_if_mount_failed = false, // Não formatar se falhar a montagem
-        .max_files = 5,                  // Número máximo de arquivos que podem ser abertos simultaneamente
-        .allocation_unit_size = 16 * 1024 // Tamanho da unidade de alocação
-    };
+    // A foto pode entrar no diário de pendentes: cartao_gravar só volta
+    // ESP_OK depois do fsync
+    cartao_tempos_t t;
+    if (cartao_gravar(file_name, fb->buf, fb->len, &t) != ESP_OK) {
+        ESP_LOGE(TAG_SD, "Erro ao gravar %s (%u bytes)", file_name, (unsigned)fb->len);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG_SD, "Imagem salva com sucesso! (%u bytes: abrir %lld ms, escrever %lld ms = %.0f KB/s, fechar %lld ms)",
+             (unsigned)fb->len, (long long)(t.abrir_us / 1000), (long long)(t.escrever_us / 1000),
+             t.escrever_us > 0 ? fb->len / 1024.0 / (t.escrever_us / 1e6) : 0.0,
+             (long long)(t.fechar_us / 1000));
+    return ESP_OK;
+}
 
-    ESP_LOGI(TAG_SD, "Montando cartão SD...");
-    ret = esp_vfs_fat_sdmmc_mount(MOUNT_POINT, &host, &slot_config, &mount_config, NULL);
+// Foto salva que não chegou ao servidor fica pendente para reenvio
+static void on_quadro_fim(const quadro_t *q) {
+    bool salvo = q->pronto_us[QUADRO_SD] != 0 && q->ok[QUADRO_SD];
+    bool enviado = q->pronto_us[QUADRO_ENVIO] != 0 && q->ok[QUADRO_ENVIO];
+#if FOTO_TIMELAPSE
+    // O quadro está no AVI; o reenvio precisa do arquivo avulso
+    salvo = sd_montado && !enviado && salvar_foto_no_sd(q->fb, q->nome) == ESP_OK;
+#endif
+    if (salvo && !enviado) {
+        pendentes_adicionar(q->nome);
+    }
+}
 
-    if (ret != ESP_OK) {
-        if (ret == ESP_FAIL) {
-            ESP_LOGE(TAG_SD, "Falha ao montar sistema de arquivos. Você pode precisar formatar o cartão.");
-        } else {
-            ESP_LOGE(TAG_SD, "Falha ao inicializar cartão SD (%s).", esp_err_to_name(ret));
-        }
-        return ret;
+static bool wifi_online(void) {
+    return conexao_wifi_is_connected();
+}
+
+// Envio lento: registra o andamento a cada quarto do corpo
+static void on_upload_progresso(size_t enviados, size_t total, int64_t decorrido_us) {
+    static int quarto_anterior = 0;
+    int quarto = (int)(enviados * 4 / total);
+    if (enviados == total || quarto < quarto_anterior) {
+        quarto_anterior = 0;
+        return;
+    }
+    if (quarto > quarto_anterior && decorrido_us >= 2000000) {
+        ESP_LOGI(TAG, "Envio em andamento: %u de %u bytes (%d%%) em %lld ms",
+                 (unsigned)enviados, (unsigned)total, quarto * 25, (long long)(decorrido_us / 1000));
     }
-    ESP_LOGI(TAG_SD, "Cartão SD montado com sucesso.");
+    quarto_anterior = quarto;
+}
 
-    // Opcional: Lista arquivos no diretório raiz para verificar
-    ESP_LOGI(TAG_SD, "Listando arquivos em %s:", MOUNT_POINT);
-    DIR *dir = opendir(MOUNT_POINT);
-    if (dir == NULL) {
-        ESP_LOGE(TAG_SD, "Falha ao abrir diretório");
-        return ESP_FAIL;
+static void task_envio(void *pvParameter) {
+    quadro_t *q;
+    while (true) {
+        xQueueReceive(fila_envio, &q, portMAX_DELAY);
+        bool ok = (enviar_foto_para_raspberry(q->fb) == ESP_OK);
+        quadro_concluir(q, QUADRO_ENVIO, ok);
+
+        upload_stats_t st;
+        upload_get_stats(&st);
+        ESP_LOGI(TAG, "Envios: %lu ok, %lu falhas, %lu retomados; conexões: %lu novas, %lu reaproveitadas, "
+                 "%lu refeitas; vazão média %lu KB/s",
+                 (unsigned long)st.enviados, (unsigned long)st.falhas, (unsigned long)st.retomadas,
+                 (unsigned long)st.conexoes_novas, (unsigned long)st.reaproveitadas,
+                 (unsigned long)st.reconexoes, (unsigned long)st.vazao_kbps);
     }
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        ESP_LOGI(TAG_SD, "%s", entry->d_name);
+}
+
+#if FOTO_TIMELAPSE
+static esp_err_t acrescentar_ao_timelapse(camera_fb_t *fb) {
+    int64_t dt;
+    esp_err_t err = timelapse_adicionar(fb->buf, fb->len, fb->width, fb->height, &dt);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG_SD, "Erro ao acrescentar ao timelapse (%s)", esp_err_to_name(err));
+        return err;
     }
-    closedir(dir);
+    timelapse_stats_t st;
+    timelapse_get_stats(&st);
+    ESP_LOGI(TAG_SD, "Timelapse: quadro %lu (%u bytes) em %lld ms, arquivo com %lu KB",
+             (unsigned long)st.quadros, (unsigned)fb->len, (long long)(dt / 1000),
+             (unsigned long)(st.bytes / 1024));
     return ESP_OK;
 }
+#endif
 
-// --- Nova Função: Salva a Imagem no Cartão SD ---
-static esp_err_t salvar_foto_no_sd(camera_fb_t *fb) {
-    char file_name[64];
-    struct tm timeinfo;
-    time_t now;
+static void task_sd(void *pvParameter) {
+    quadro_t *q;
+    while (true) {
+        xQueueReceive(fila_sd, &q, portMAX_DELAY);
+#if FOTO_TIMELAPSE
+        bool ok = (acrescentar_ao_timelapse(q->fb) == ESP_OK);
+#else
+        bool ok = (salvar_foto_no_sd(q->fb, q->nome) == ESP_OK);
+#endif
+        quadro_concluir(q, QUADRO_SD, ok);
+    }
+}
 
-    time(&now);
-    if (now < 1609459200) {  // antes de 2021-01-01
-    snprintf(file_name, sizeof(file_name), MOUNT_POINT "/img_%lu.jpg", esp_log_timestamp());
-    } else {
-    localtime_r(&now, &timeinfo);
-    strftime(file_name, sizeof(file_name), MOUNT_POINT "/%Y%m%d_%H%M%S.jpg", &timeinfo);
+// Decodifica em 1/8 e reduz à miniatura de luminância
+static bool reduzir_quadro(camera_fb_t *fb) {
+    int largura = fb->width / 8, altura = fb->height / 8;
+    size_t len = (size_t)largura * altura * 2;
+
+    if (len > miniatura_rgb_len) {
+        // O tamanho do quadro pode mudar entre fotos
+        free(miniatura_rgb);
+        miniatura_rgb = malloc(len);
+        miniatura_rgb_len = miniatura_rgb ? len : 0;
     }
+    if (miniatura_rgb == NULL || !jpg2rgb565(fb->buf, fb->len, miniatura_rgb, JPG_SCALE_8X)) {
+        return false;
+    }
+    mudanca_reduzir_rgb565(miniatura_rgb, largura, altura, miniatura);
+    return true;
+}
 
-    ESP_LOGI(TAG_SD, "Salvando imagem em: %s", file_name);
+// Compara com a última foto mantida; 'reduzida' = miniatura já é deste quadro
+static bool manter_foto(camera_fb_t *fb, bool reduzida, mudanca_decisao_t *decisao) {
+    int64_t t0 = esp_timer_get_time();
 
-    FILE *f = fopen(file_name, "wb");
-    if (f == NULL) {
-        ESP_LOGE(TAG_SD, "Falha ao abrir arquivo para escrita.");
-        return ESP_FAIL;
+    if (!reduzida && !reduzir_quadro(fb)) {
+        ESP_LOGW(TAG, "Miniatura indisponível, foto mantida sem comparar");
+        return true;
     }
-    size_t bytes_written = fwrite(fb->buf, 1, fb->len, f);
-    fclose(f);
 
-    if (bytes_written == fb->len) {
-        ESP_LOGI(TAG_SD, "Imagem salva com sucesso! (%d bytes)", bytes_written);
-        return ESP_OK;
-    } else {
-        ESP_LOGE(TAG_SD, "Erro ao escrever todos os bytes da imagem. Escritos: %d, Esperados: %d", bytes_written, fb->len);
-        return ESP_FAIL;
+    mudanca_resultado_t r;
+    *decisao = mudanca_avaliar(&mudanca, miniatura, (uint32_t)(esp_timer_get_time() / 1000000), &r);
+    int64_t dt = esp_timer_get_time() - t0;
+
+    resumo.avaliadas++;
+    resumo.detector_us += dt;
+    if (dt > resumo.detector_max_us) {
+        resumo.detector_max_us = dt;
+    }
+    ESP_LOGI(TAG, "Mudança: brilho %u, diferença %u, células %u%% -> %s (%lld ms)",
+             r.brilho, r.diferenca, r.celulas_pct, mudanca_nome(r.decisao), (long long)(dt / 1000));
+
+    if (r.decisao == MUDANCA_IGUAL) {
+        resumo.iguais++;
+    } else if (r.decisao == MUDANCA_ESCURA) {
+        resumo.escuras++;
+    }
+    return mudanca_manter(r.decisao);
+}
+
+static void relatar_dia(void) {
+    upload_stats_t st;
+    upload_get_stats(&st);
+    ESP_LOGI(TAG, "Últimas 24 h: %lu fotos mantidas, %lu iguais, %lu escuras; %.1f MB mantidos, "
+             "%.1f MB evitados; %.1f MB enviados em %lu envios; detector %lld ms/foto (máx %lld); "
+             "captura %lld ms/foto, flash %lld ms/foto",
+             (unsigned long)resumo.mantidas, (unsigned long)resumo.iguais, (unsigned long)resumo.escuras,
+             resumo.bytes_mantidos / 1e6, resumo.bytes_evitados / 1e6,
+             (st.bytes - resumo.upload.bytes) / 1e6, (unsigned long)(st.enviados - resumo.upload.enviados),
+             (long long)(resumo.avaliadas ? resumo.detector_us / resumo.avaliadas / 1000 : 0),
+             (long long)(resumo.detector_max_us / 1000),
+             (long long)(resumo.capturas ? resumo.captura_us / resumo.capturas / 1000 : 0),
+             (long long)(resumo.capturas ? resumo.flash_us / resumo.capturas / 1000 : 0));
+    resumo = (resumo_dia_t){ .inicio_us = esp_timer_get_time(), .upload = st };
+}
+
+// Tamanho desta foto -> qualidade (e resolução) da próxima
+static void ajustar_qualidade(const camera_fb_t *fb) {
+    upload_stats_t st;
+    upload_get_stats(&st);
+
+    qualidade_passo_t p;
+    if (qualidade_atualizar(&qualidade, fb->len, st.vazao_kbps, &p)) {
+        sensor_t *s = esp_camera_sensor_get();
+        if (s) {
+            s->set_quality(s, p.q);
+            if (p.tamanho != p.tamanho_anterior) {
+                s->set_framesize(s, foto_tamanhos[p.tamanho]);
+            }
+        }
+    }
+    ESP_LOGI(TAG, "Qualidade: %u bytes em %s q %u (alvo %lu, %+d%%) -> próxima %s q %u",
+             (unsigned)fb->len, foto_tamanhos_nome[p.tamanho_anterior], p.q_anterior,
+             (unsigned long)p.alvo, p.erro_pct, foto_tamanhos_nome[p.tamanho], p.q);
+}
+
+typedef struct {
+    int64_t  latencia_us;      // pedido até o quadro escolhido
+    int64_t  flash_us;         // flash aceso
+    int      antigos;          // quadros de antes do pedido
+    int      ajuste;           // quadros com a exposição ainda mudando
+    uint8_t  brilho;
+    bool     reduzida;         // miniatura[] é do quadro devolvido
+    exposicao_estado_t estado;
+} captura_info_t;
+
+static int64_t instante_quadro(const camera_fb_t *fb) {
+    // O driver marca o início do quadro com esp_timer_get_time()
+    return (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+}
+
+// Primeiro quadro começado depois de 'desde'
+static camera_fb_t *quadro_desde(int64_t desde, int *antigos) {
+    for (int i = 0; i <= FOTO_DESCARTE_MAX; i++) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (fb == NULL || instante_quadro(fb) >= desde || i == FOTO_DESCARTE_MAX) {
+            return fb;
+        }
+        esp_camera_fb_return(fb);
+        (*antigos)++;
+    }
+    return NULL;
+}
+
+static camera_fb_t *capturar_foto(captura_info_t *info) {
+    *info = (captura_info_t){ .estado = EXPOSICAO_ESTAVEL };
+    int64_t pedido = esp_timer_get_time();
+
+#if FLASH_HABILITADO
+    gpio_set_level(FLASH_GPIO_NUM, 1); // Acende o flash
+    exposicao_iniciar(&exposicao, pedido);
+    camera_fb_t *fb = quadro_desde(pedido, &info->antigos);
+    while (fb) {
+        info->reduzida = reduzir_quadro(fb);
+        if (!info->reduzida) {
+            info->estado = EXPOSICAO_PRAZO;  // sem brilho para medir: fica com este
+            break;
+        }
+        info->brilho = mudanca_brilho(miniatura);
+        info->estado = exposicao_avaliar(&exposicao, info->brilho, esp_timer_get_time());
+        if (info->estado != EXPOSICAO_AJUSTANDO) {
+            break;
+        }
+        int64_t anterior = instante_quadro(fb);
+        esp_camera_fb_return(fb);
+        info->ajuste++;
+        fb = quadro_desde(anterior + 1, &info->antigos);
+    }
+    gpio_set_level(FLASH_GPIO_NUM, 0); // Desliga o flash
+    info->flash_us = esp_timer_get_time() - pedido;
+#else
+    camera_fb_t *fb = quadro_desde(pedido, &info->antigos);
+#endif
+
+    info->latencia_us = esp_timer_get_time() - pedido;
+    return fb;
+}
+
+// Não espera o consumidor: atrasado, ele perde o quadro
+static void entregar(quadro_t *q, QueueHandle_t fila, const char *nome) {
+    if (xQueueSend(fila, &q, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Quadro %lu descartado: %s ainda ocupado", (unsigned long)q->numero, nome);
+        quadro_liberar(q);
     }
 }
 
-void task_envia_foto_periodicamente(void *pvParameter) {
+void task_captura(void *pvParameter) {
+    uint32_t numero = 0;
+    TickType_t proxima = xTaskGetTickCount();
+
     while (true) {
         // Verifica conexão Wi-Fi
-        if (conexao_wifi_is_connected()) {
+        bool online = conexao_wifi_is_connected();
+        if (online) {
             gpio_set_level(LED_WIFI_GPIO_NUM, 0);
         } else {
             gpio_set_level(LED_WIFI_GPIO_NUM, 1);
-            ESP_LOGW(TAG, "Sem conexão Wi-Fi. Aguardando reconexão...");
-            vTaskDelay(5000 / portTICK_PERIOD_MS);
-            continue;
+            ESP_LOGW(TAG, "Sem conexão Wi-Fi. Foto fica pendente no SD.");
         }
 
-        gpio_set_level(FLASH_GPIO_NUM, 1); // Acende o flash
-        vTaskDelay(500 / portTICK_PERIOD_MS);
+        captura_info_t info;
+        camera_fb_t *fb = capturar_foto(&info); // Captura a imagem
+        if (fb) {
+            resumo.capturas++;
+            resumo.captura_us += info.latencia_us;
+            resumo.flash_us += info.flash_us;
+            ESP_LOGI(TAG, "Captura em %lld ms (flash %lld ms): %d quadros antigos e %d de ajuste descartados, "
+                     "brilho %u, exposição %s (prazo %lu ms)",
+                     (long long)(info.latencia_us / 1000), (long long)(info.flash_us / 1000),
+                     info.antigos, info.ajuste, info.brilho, exposicao_nome(info.estado),
+                     (unsigned long)exposicao.prazo_ms);
+        }
 
-        camera_fb_t *fb = esp_camera_fb_get(); // Captura a imagem
-        vTaskDelay(200 / portTICK_PERIOD_MS);  // Atraso opcional
-        gpio_set_level(FLASH_GPIO_NUM, 0); // Desliga o flash
+        if (esp_timer_get_time() - resumo.inicio_us >= RESUMO_DIA_US) {
+            relatar_dia();
+        }
+        mudanca_decisao_t decisao = MUDANCA_MUDOU;
+        bool manter = !(fb && FOTO_FILTRAR_MUDANCA) || manter_foto(fb, info.reduzida, &decisao);
+        if (fb && FOTO_QUALIDADE_ADAPTATIVA && decisao != MUDANCA_ESCURA) {
+            ajustar_qualidade(fb);
+        }
+        if (!manter) {
+            resumo.bytes_evitados += fb->len;
+            esp_camera_fb_return(fb);
+            xTaskDelayUntil(&proxima, pdMS_TO_TICKS(FOTO_INTERVALO_MS));
+            continue;
+        }
 
-        if (fb) {
-            enviar_foto_para_raspberry(fb);   // Envia
-            salvar_foto_no_sd(fb);            // Salva local
-            esp_camera_fb_return(fb);         // Libera buffer
-        } else {
+        // Com pendentes no SD a foto nova entra atrás delas: chegam em ordem
+        bool enviar = online && !(sd_montado && pendentes_quantidade() > 0);
+        int consumidores = (enviar ? 1 : 0) + (sd_montado ? 1 : 0);
+        if (!fb) {
             ESP_LOGE(TAG, "Erro ao capturar imagem");
+        } else if (consumidores == 0) {
+            esp_camera_fb_return(fb);
+        } else {
+            char nome[QUADRO_NOME_MAX];
+            nomear_foto(nome, sizeof(nome));
+            resumo.mantidas++;
+            resumo.bytes_mantidos += fb->len;
+            quadro_t *q = quadro_novo(fb, ++numero, nome, consumidores);
+            if (q) {
+                if (sd_montado) {
+                    entregar(q, fila_sd, "SD");
+                }
+                if (enviar) {
+                    entregar(q, fila_envio, "envio");
+                }
+            }
         }
 
-        vTaskDelay(60000 / portTICK_PERIOD_MS);  // Espera 1 min para próxima verificação
+        // Período fixo, independente da duração do envio
+        xTaskDelayUntil(&proxima, pdMS_TO_TICKS(FOTO_INTERVALO_MS));
     }
 }
 
@@ -274,9 +573,11 @@ void start_camera() {
         .ledc_timer     = LEDC_TIMER_0,
         .ledc_channel   = LEDC_CHANNEL_0,
         .pixel_format   = PIXFORMAT_JPEG,
-        .frame_size     = FRAMESIZE_XGA,
-        .jpeg_quality   = 12,
-        .fb_count       = 1
+        .frame_size     = foto_tamanhos[0],
+        .jpeg_quality   = FOTO_QUALIDADE_INICIAL,
+        .fb_count       = FOTO_FB_COUNT,
+        .fb_location    = CAMERA_FB_IN_PSRAM,
+        .grab_mode      = CAMERA_GRAB_LATEST  // com vários buffers, o quadro mais recente
     };
 
     config.sccb_i2c_port = 0;
@@ -292,10 +593,14 @@ void start_camera() {
 
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init());
+    // Número do boot antes de qualquer foto: nomeia as fotos sem hora
+    relogio_init();
 
     // Inicializa GPIOs
+#if FLASH_HABILITADO
     gpio_set_direction(FLASH_GPIO_NUM, GPIO_MODE_OUTPUT);
     gpio_set_level(FLASH_GPIO_NUM, 0);
+#endif
 
     gpio_set_direction(LED_WIFI_GPIO_NUM, GPIO_MODE_OUTPUT);
     gpio_set_level(LED_WIFI_GPIO_NUM, 1);  // Começa apagado ou como desejar
@@ -305,6 +610,7 @@ void app_main(void) {
         ESP_LOGE(TAG, "Falha ao inicializar o cartão SD. As imagens não serão salvas localmente.");
         // Se desejar, pode retornar ou continuar sem salvar imagens
     } else {
+        sd_montado = true;
         // Teste simples de escrita
         FILE *f = fopen(MOUNT_POINT "/teste.txt", "w");
         if (f) {
@@ -314,11 +620,73 @@ void app_main(void) {
         } else {
             ESP_LOGE(TAG_SD, "Teste de escrita: FALHOU (verifique proteção ou sistema de arquivos)");
         }
+#if SD_BENCHMARK
+        cartao_benchmark(MOUNT_POINT);
+        timelapse_benchmark(MOUNT_POINT);
+#endif
+#if FOTO_TIMELAPSE
+        timelapse_init(MOUNT_POINT);
+#endif
     }
 
 
     start_camera();
     conexao_wifi_init();
+    relogio_sntp_iniciar(SNTP_SERVIDOR);
+
+    upload_init(CAMERA_UPLOAD_URL, (const char *)greense_cert_pem_start);
+    upload_set_progresso_cb(on_upload_progresso);
+    quadro_set_fim_cb(on_quadro_fim);
+    if (sd_montado) {
+        const pendentes_config_t pendentes_cfg = {
+            .diretorio = MOUNT_POINT,
+            .online = wifi_online,
+        };
+        if (pendentes_init(&pendentes_cfg) != ESP_OK) {
+            ESP_LOGE(TAG, "Sem diário de pendentes: fotos não enviadas ficam só no SD");
+        }
+    }
 
-    xTaskCreate(&task_envia_foto_periodicamente, "envia_foto_task", 8192, NULL, 5, NULL);
+    const stream_config_t stream_cfg = {
+        .ocupado = upload_ocupado,
+    };
+    if (stream_init(&stream_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "Stream local indisponível");
+    }
+
+    const mudanca_config_t mudanca_cfg = {
+        .limiar_celula = MUDANCA_LIMIAR_CELULA,
+        .celulas_pct = MUDANCA_CELULAS_PCT,
+        .limiar_escuro = MUDANCA_LIMIAR_ESCURO,
+        .keyframe_s = MUDANCA_KEYFRAME_S,
+    };
+    mudanca_init(&mudanca, &mudanca_cfg);
+    const exposicao_config_t exposicao_cfg = {
+        .tolerancia = EXPOSICAO_TOLERANCIA,
+        .quadros_estaveis = EXPOSICAO_QUADROS_ESTAVEIS,
+        .prazo_min_ms = EXPOSICAO_PRAZO_MIN_MS,
+        .prazo_max_ms = EXPOSICAO_PRAZO_MAX_MS,
+        .folga = EXPOSICAO_FOLGA,
+        .media_inicial_ms = EXPOSICAO_MEDIA_INICIAL_MS,
+    };
+    exposicao_init(&exposicao, &exposicao_cfg);
+    const qualidade_config_t qualidade_cfg = {
+        .alvo_bytes = QUALIDADE_ALVO_BYTES,
+        .alvo_min_bytes = QUALIDADE_ALVO_MIN_BYTES,
+        .tempo_alvo_ms = QUALIDADE_TEMPO_ALVO_MS,
+        .q_min = QUALIDADE_Q_MIN,
+        .q_max = QUALIDADE_Q_MAX,
+        .passo_max = QUALIDADE_PASSO_MAX,
+        .banda_pct = QUALIDADE_BANDA_PCT,
+        .n_tamanhos = FOTO_VARIAR_TAMANHO ? sizeof(foto_tamanhos) / sizeof(foto_tamanhos[0]) : 1,
+    };
+    qualidade_init(&qualidade, &qualidade_cfg, FOTO_QUALIDADE_INICIAL);
+    resumo.inicio_us = esp_timer_get_time();
+
+    fila_envio = xQueueCreate(FOTO_FILA_TAMANHO, sizeof(quadro_t *));
+    fila_sd = xQueueCreate(FOTO_FILA_TAMANHO, sizeof(quadro_t *));
+    xTaskCreate(&task_envio, "envio_task", 8192, NULL, 4, NULL);
+    xTaskCreate(&task_sd, "sd_task", 4096, NULL, 4, NULL);
+    // Decodificador JPEG da miniatura usa a pilha da captura
+    xTaskCreate(&task_captura, "captura_task", 8192, NULL, 5, NULL);
 }
\ No newline at end of file
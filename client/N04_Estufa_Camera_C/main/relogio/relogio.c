@@ -0,0 +1,67 @@
+#include "relogio.h"
+#include <time.h>
+#include <sys/time.h>
+#include "esp_timer.h"
+#include "esp_sntp.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "RELOGIO";
+
+#define RELOGIO_HORA_MIN  1609459200    // 2021-01-01: antes disso o relógio não foi ajustado
+
+static uint32_t boot_atual = 0;
+
+esp_err_t relogio_init(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(RELOGIO_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        uint32_t ultimo = 0;
+        nvs_get_u32(handle, RELOGIO_NVS_CHAVE, &ultimo);   // ausente no primeiro boot
+        err = nvs_set_u32(handle, RELOGIO_NVS_CHAVE, ultimo + 1);
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+        if (err == ESP_OK) {
+            boot_atual = ultimo + 1;
+        }
+    }
+    if (err != ESP_OK) {
+        // Boot 0 repete a cada reset: os nomes sem hora podem colidir
+        ESP_LOGE(TAG, "Falha ao contar o boot no NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Boot %lu", (unsigned long)boot_atual);
+    return ESP_OK;
+}
+
+// Chamado na tarefa do lwip a cada sincronização
+static void on_sntp(struct timeval *tv)
+{
+    static bool primeira = true;
+    if (primeira) {
+        primeira = false;
+        ESP_LOGI(TAG, "Relógio sincronizado via SNTP (%lld s desde o boot)",
+                 (long long)(esp_timer_get_time() / 1000000));
+    }
+}
+
+void relogio_sntp_iniciar(const char *servidor)
+{
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, servidor);
+    sntp_set_time_sync_notification_cb(on_sntp);
+    esp_sntp_init();
+}
+
+bool relogio_valido(void)
+{
+    return time(NULL) >= RELOGIO_HORA_MIN;
+}
+
+uint32_t relogio_boot_atual(void)
+{
+    return boot_atual;
+}
@@ -0,0 +1,40 @@
+#ifndef RELOGIO_H
+#define RELOGIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Horário das fotos e número do boot
+ * ============================================================
+ * O SNTP ajusta o relógio depois que o Wi-Fi conecta. Até lá (ou sem
+ * rede nenhuma) os nomes no SD não podem vir da hora: cada boot recebe
+ * um número (contador no NVS) e os nomes usam boot + uptime, que não
+ * se repetem depois de um reset.
+ */
+
+#define RELOGIO_NVS_NAMESPACE  "relogio"
+#define RELOGIO_NVS_CHAVE      "boot"
+
+/**
+ * @brief Conta o boot no NVS (nvs_flash_init já chamado).
+ */
+esp_err_t relogio_init(void);
+
+/**
+ * @brief Inicia o SNTP (não bloqueia; precisa do esp_netif pronto).
+ */
+void relogio_sntp_iniciar(const char *servidor);
+
+/**
+ * @brief true com o relógio ajustado (SNTP agora ou antes de um reset suave).
+ */
+bool relogio_valido(void);
+
+/**
+ * @brief Número deste boot (0 se o NVS falhou).
+ */
+uint32_t relogio_boot_atual(void);
+
+#endif // RELOGIO_H
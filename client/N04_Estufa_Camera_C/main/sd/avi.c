@@ -0,0 +1,272 @@
+#include "avi.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define AVIF_HASINDEX     0x10
+#define AVIIF_KEYFRAME    0x10
+#define INDICE_BLOCO      256       // entradas a mais por realloc
+
+static void escrever_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void escrever_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t ler_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void escrever_chunk(uint8_t *p, const char *fourcc, uint32_t tamanho)
+{
+    memcpy(p, fourcc, 4);
+    escrever_u32(p + 4, tamanho);
+}
+
+uint32_t avi_tamanho(const avi_t *avi)
+{
+    return avi->fim + 8 + 16 * avi->quadros;
+}
+
+// RIFF/hdrl/movi com os tamanhos atuais; com_indice = idx1 logo depois da movi
+static void montar_cabecalho(const avi_t *avi, uint8_t *h, bool com_indice)
+{
+    memset(h, 0, AVI_CABECALHO);
+    uint32_t riff = (com_indice ? avi_tamanho(avi) : avi->fim) - 8;
+
+    escrever_chunk(h, "RIFF", riff);
+    memcpy(h + 8, "AVI ", 4);
+    escrever_chunk(h + 12, "LIST", 192);
+    memcpy(h + 20, "hdrl", 4);
+
+    escrever_chunk(h + 24, "avih", 56);
+    escrever_u32(h + 32, 1000000 / avi->fps);          // dwMicroSecPerFrame
+    escrever_u32(h + 36, avi->maior * avi->fps);       // dwMaxBytesPerSec
+    escrever_u32(h + 44, com_indice ? AVIF_HASINDEX : 0);
+    escrever_u32(h + 48, avi->quadros);                // dwTotalFrames
+    escrever_u32(h + 56, 1);                           // dwStreams
+    escrever_u32(h + 60, avi->maior);
+    escrever_u32(h + 64, avi->largura);
+    escrever_u32(h + 68, avi->altura);
+
+    escrever_chunk(h + 88, "LIST", 116);
+    memcpy(h + 96, "strl", 4);
+    escrever_chunk(h + 100, "strh", 56);
+    memcpy(h + 108, "vids", 4);
+    memcpy(h + 112, "MJPG", 4);
+    escrever_u32(h + 128, 1);                          // dwScale
+    escrever_u32(h + 132, avi->fps);                   // dwRate
+    escrever_u32(h + 140, avi->quadros);               // dwLength
+    escrever_u32(h + 144, avi->maior);
+    escrever_u32(h + 148, 0xFFFFFFFF);                 // dwQuality padrão
+    escrever_u16(h + 160, avi->largura);               // rcFrame
+    escrever_u16(h + 162, avi->altura);
+
+    escrever_chunk(h + 164, "strf", 40);
+    escrever_u32(h + 172, 40);                         // BITMAPINFOHEADER
+    escrever_u32(h + 176, avi->largura);
+    escrever_u32(h + 180, avi->altura);
+    escrever_u16(h + 184, 1);                          // biPlanes
+    escrever_u16(h + 186, 24);                         // biBitCount
+    memcpy(h + 188, "MJPG", 4);
+    escrever_u32(h + 192, (uint32_t)avi->largura * avi->altura * 3);
+
+    escrever_chunk(h + 212, "LIST", 4 + avi->fim - AVI_CABECALHO);
+    memcpy(h + 220, "movi", 4);
+}
+
+static bool gravar_cabecalho(avi_t *avi, bool com_indice)
+{
+    uint8_t h[AVI_CABECALHO];
+    montar_cabecalho(avi, h, com_indice);
+    bool ok = fseek(avi->f, 0, SEEK_SET) == 0 && fwrite(h, 1, sizeof(h), avi->f) == sizeof(h);
+    return fseek(avi->f, avi->fim, SEEK_SET) == 0 && ok;
+}
+
+static bool sincronizar(avi_t *avi)
+{
+    return fflush(avi->f) == 0 && fsync(fileno(avi->f)) == 0;
+}
+
+static bool indexar(avi_t *avi, uint32_t offset, uint32_t tamanho)
+{
+    if (avi->quadros == avi->capacidade) {
+        avi_entrada_t *novo = realloc(avi->indice, (avi->capacidade + INDICE_BLOCO) * sizeof(avi_entrada_t));
+        if (novo == NULL) {
+            return false;
+        }
+        avi->indice = novo;
+        avi->capacidade += INDICE_BLOCO;
+    }
+    avi->indice[avi->quadros++] = (avi_entrada_t){ .offset = offset, .tamanho = tamanho };
+    if (tamanho > avi->maior) {
+        avi->maior = tamanho;
+    }
+    return true;
+}
+
+// Refaz o índice a partir da lista 'movi'; para no idx1 ou no primeiro chunk inválido
+static esp_err_t recuperar(avi_t *avi, avi_recuperacao_t *rec)
+{
+    uint8_t h[AVI_CABECALHO];
+    if (fread(h, 1, sizeof(h), avi->f) != sizeof(h) || memcmp(h, "RIFF", 4) != 0 ||
+        memcmp(h + 8, "AVI ", 4) != 0 || memcmp(h + 112, "MJPG", 4) != 0 ||
+        memcmp(h + 220, "movi", 4) != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    avi->largura = ler_u32(h + 64);
+    avi->altura = ler_u32(h + 68);
+    avi->fps = ler_u32(h + 132) ? ler_u32(h + 132) : 1;
+
+    fseek(avi->f, 0, SEEK_END);
+    long tamanho = ftell(avi->f);
+    uint32_t pos = AVI_CABECALHO;
+
+    while (pos + 8 <= (uint32_t)tamanho) {
+        uint8_t c[10];
+        if (fseek(avi->f, pos, SEEK_SET) != 0 || fread(c, 1, sizeof(c), avi->f) < 8) {
+            break;
+        }
+        if (memcmp(c, "idx1", 4) == 0) {
+            rec->fechado = true;
+            break;
+        }
+        uint32_t len = ler_u32(c + 4);
+        uint64_t proximo = (uint64_t)pos + 8 + len + (len & 1);
+        // Com a queda antes do fsync, o tamanho do arquivo pode ter andado e os dados não:
+        // o quadro só vale com SOI no começo e EOI no fim
+        if (memcmp(c, "00dc", 4) != 0 || len < 4 || proximo > (uint64_t)tamanho ||
+            c[8] != 0xFF || c[9] != 0xD8) {
+            break;
+        }
+        uint8_t eoi[2];
+        if (fseek(avi->f, pos + 8 + len - 2, SEEK_SET) != 0 || fread(eoi, 1, 2, avi->f) != 2 ||
+            eoi[0] != 0xFF || eoi[1] != 0xD9) {
+            break;
+        }
+        if (!indexar(avi, pos - (AVI_CABECALHO - 4), len)) {
+            return ESP_ERR_NO_MEM;
+        }
+        pos = proximo;
+    }
+
+    avi->fim = pos;
+    rec->quadros = avi->quadros;
+    rec->descartados = rec->fechado ? 0 : (uint32_t)tamanho - pos;
+    if (pos != (uint32_t)tamanho) {
+        // Tira o idx1 antigo ou o chunk cortado: os quadros novos entram aqui
+        fflush(avi->f);
+        if (ftruncate(fileno(avi->f), pos) != 0) {
+            return ESP_FAIL;
+        }
+    }
+    return fseek(avi->f, pos, SEEK_SET) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t avi_abrir(avi_t *avi, const char *caminho, uint16_t largura, uint16_t altura, uint32_t fps,
+                    avi_recuperacao_t *rec)
+{
+    avi_recuperacao_t r = {0};
+    memset(avi, 0, sizeof(*avi));
+
+    avi->f = fopen(caminho, "r+b");
+    if (avi->f) {
+        r.existia = true;
+        esp_err_t err = recuperar(avi, &r);
+        if (rec) {
+            *rec = r;
+        }
+        if (err != ESP_OK) {
+            fclose(avi->f);
+            free(avi->indice);
+            memset(avi, 0, sizeof(*avi));
+        }
+        return err;
+    }
+
+    avi->f = fopen(caminho, "w+b");
+    if (avi->f == NULL) {
+        return ESP_FAIL;
+    }
+    avi->largura = largura;
+    avi->altura = altura;
+    avi->fps = fps ? fps : 1;
+    avi->fim = AVI_CABECALHO;
+    if (rec) {
+        *rec = r;
+    }
+    if (!gravar_cabecalho(avi, false) || !sincronizar(avi)) {
+        fclose(avi->f);
+        avi->f = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t avi_adicionar(avi_t *avi, const uint8_t *jpeg, size_t len)
+{
+    if (avi->f == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t chunk = 8 + len + (len & 1);
+    if ((uint64_t)avi_tamanho(avi) + chunk + 16 > AVI_TAMANHO_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t h[8];
+    static const uint8_t pad = 0;
+    escrever_chunk(h, "00dc", len);
+    bool ok = fwrite(h, 1, sizeof(h), avi->f) == sizeof(h) &&
+              fwrite(jpeg, 1, len, avi->f) == len &&
+              ((len & 1) == 0 || fwrite(&pad, 1, 1, avi->f) == 1);
+    ok = ok && indexar(avi, avi->fim - (AVI_CABECALHO - 4), len);
+    if (!ok) {
+        // Desfaz o chunk pela metade: o próximo quadro entra no mesmo lugar
+        fflush(avi->f);
+        ftruncate(fileno(avi->f), avi->fim);
+        fseek(avi->f, avi->fim, SEEK_SET);
+        return ESP_FAIL;
+    }
+    avi->fim += chunk;
+
+    if (avi->quadros % AVI_ATUALIZAR_QUADROS == 0) {
+        gravar_cabecalho(avi, false);
+    }
+    return sincronizar(avi) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t avi_fechar(avi_t *avi)
+{
+    if (avi->f == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t bloco[16 * 32];
+    escrever_chunk(bloco, "idx1", 16 * avi->quadros);
+    bool ok = fwrite(bloco, 1, 8, avi->f) == 8;
+    for (uint32_t i = 0; ok && i < avi->quadros; ) {
+        size_t n = 0;
+        for (; i < avi->quadros && n < sizeof(bloco); i++, n += 16) {
+            memcpy(bloco + n, "00dc", 4);
+            escrever_u32(bloco + n + 4, AVIIF_KEYFRAME);
+            escrever_u32(bloco + n + 8, avi->indice[i].offset);
+            escrever_u32(bloco + n + 12, avi->indice[i].tamanho);
+        }
+        ok = fwrite(bloco, 1, n, avi->f) == n;
+    }
+    ok = ok && gravar_cabecalho(avi, true) && sincronizar(avi);
+    ok = (fclose(avi->f) == 0) && ok;
+
+    free(avi->indice);
+    memset(avi, 0, sizeof(*avi));
+    return ok ? ESP_OK : ESP_FAIL;
+}
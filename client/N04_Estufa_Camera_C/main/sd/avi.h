@@ -0,0 +1,84 @@
+#ifndef AVI_H
+#define AVI_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Arquivo AVI (MJPEG) montado quadro a quadro
+ * ============================================================
+ * Cabeçalho fixo de AVI_CABECALHO bytes (hdrl com um stream 'MJPG' e a
+ * abertura da lista 'movi'); cada JPEG vira um chunk '00dc' acrescentado
+ * no fim, com fflush e fsync. O índice (idx1) fica em RAM e só vai para
+ * o arquivo no avi_fechar; a cada AVI_ATUALIZAR_QUADROS quadros os
+ * tamanhos do cabeçalho são regravados, para o arquivo abrir num player
+ * mesmo sem índice.
+ *
+ * Ao abrir um arquivo que já existe, a lista 'movi' é percorrida chunk a
+ * chunk: o índice é refeito, um idx1 de um fechamento anterior é
+ * retirado (os quadros novos entram depois) e um chunk cortado por queda
+ * de energia é truncado: vale o quadro com SOI (FF D8) no começo e EOI
+ * (FF D9) no fim dos len bytes; o primeiro que falha e o resto do arquivo
+ * saem. Perde-se no máximo o quadro que estava sendo gravado.
+ *
+ * Só usa stdio: compila no host.
+ */
+
+#define AVI_CABECALHO           224
+#define AVI_ATUALIZAR_QUADROS   10
+#define AVI_TAMANHO_MAX         (1024UL * 1024 * 1024)   // AVI 1.0: offsets de 32 bits
+
+typedef struct {
+    uint32_t offset;            // do chunk, a partir do fourcc 'movi'
+    uint32_t tamanho;           // do JPEG
+} avi_entrada_t;
+
+typedef struct {
+    FILE          *f;
+    uint16_t       largura;
+    uint16_t       altura;
+    uint32_t       fps;
+    uint32_t       quadros;
+    uint32_t       fim;         // onde entra o próximo chunk
+    uint32_t       maior;       // maior quadro (dwSuggestedBufferSize)
+    avi_entrada_t *indice;
+    uint32_t       capacidade;
+} avi_t;
+
+typedef struct {
+    bool     existia;
+    bool     fechado;           // tinha idx1: último fechamento foi normal
+    uint32_t quadros;           // recuperados
+    uint32_t descartados;       // bytes truncados no fim (chunk cortado)
+} avi_recuperacao_t;
+
+/**
+ * @brief Abre (ou cria) o arquivo para acrescentar quadros.
+ * @param largura, altura, fps  usados só se o arquivo for novo
+ * @param rec     opcional: o que foi encontrado num arquivo existente
+ * @return ESP_ERR_INVALID_STATE se o arquivo existe e não é um AVI deste módulo
+ */
+esp_err_t avi_abrir(avi_t *avi, const char *caminho, uint16_t largura, uint16_t altura, uint32_t fps,
+                    avi_recuperacao_t *rec);
+
+/**
+ * @brief Acrescenta um JPEG e sincroniza.
+ * @return ESP_ERR_INVALID_SIZE se o arquivo passaria de AVI_TAMANHO_MAX
+ *         (o chamador abre outro)
+ */
+esp_err_t avi_adicionar(avi_t *avi, const uint8_t *jpeg, size_t len);
+
+/**
+ * @brief Grava o idx1 e os tamanhos do cabeçalho e fecha.
+ */
+esp_err_t avi_fechar(avi_t *avi);
+
+/**
+ * @brief Bytes que o arquivo terá depois de fechado.
+ */
+uint32_t avi_tamanho(const avi_t *avi);
+
+#endif // AVI_H
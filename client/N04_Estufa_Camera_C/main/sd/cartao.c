@@ -0,0 +1,254 @@
+#include "cartao.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "esp_vfs_fat.h"
+#include "driver/sdmmc_host.h"
+#include "sdmmc_cmd.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "SD_CARD";
+
+// Como gravar: o modo configurado e as alternativas comparadas no benchmark
+typedef struct {
+    const char *nome;
+    size_t      buffer;         // setvbuf; 0 = padrão do newlib
+    bool        bloco;          // passa pelo bloco DMA
+    bool        prealocar;
+} modo_t;
+
+static const modo_t modo_config = {
+    .nome = "configurado",
+    .buffer = SD_BUFFER_BYTES,
+    .bloco = true,
+    .prealocar = SD_PREALOCAR,
+};
+
+static uint8_t *bloco = NULL;       // RAM interna, DMA
+static SemaphoreHandle_t mutex = NULL;
+
+esp_err_t cartao_montar(const char *ponto_montagem)
+{
+    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
+    host.max_freq_khz = SD_FREQ_KHZ;
+    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
+
+    slot_config.width = SD_LARGURA_BARRAMENTO;
+    slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP; // Habilita pull-ups internos
+
+    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
+        .format_if_mount_failed = false, // Não formatar se falhar a montagem
+        .max_files = 5,                  // Número máximo de arquivos que podem ser abertos simultaneamente
+        .allocation_unit_size = SD_UNIDADE_ALOCACAO
+    };
+
+    ESP_LOGI(TAG, "Montando cartão SD (%d bit, %d kHz)...", SD_LARGURA_BARRAMENTO, SD_FREQ_KHZ);
+    sdmmc_card_t *card = NULL;
+    esp_err_t ret = esp_vfs_fat_sdmmc_mount(ponto_montagem, &host, &slot_config, &mount_config, &card);
+
+    if (ret != ESP_OK) {
+        if (ret == ESP_FAIL) {
+            ESP_LOGE(TAG, "Falha ao montar sistema de arquivos. Você pode precisar formatar o cartão.");
+        } else {
+            ESP_LOGE(TAG, "Falha ao inicializar cartão SD (%s).", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+    ESP_LOGI(TAG, "Cartão SD montado com sucesso.");
+    sdmmc_card_print_info(stdout, card);
+
+    bloco = heap_caps_malloc(SD_BLOCO_BYTES, MALLOC_CAP_DMA);
+    mutex = xSemaphoreCreateMutex();
+    if (bloco == NULL) {
+        ESP_LOGW(TAG, "Sem RAM interna para o bloco de %d bytes: gravação direta da PSRAM", SD_BLOCO_BYTES);
+    }
+
+    // Opcional: Lista arquivos no diretório raiz para verificar
+    ESP_LOGI(TAG, "Listando arquivos em %s:", ponto_montagem);
+    DIR *dir = opendir(ponto_montagem);
+    if (dir == NULL) {
+        ESP_LOGE(TAG, "Falha ao abrir diretório");
+        return ESP_FAIL;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        ESP_LOGI(TAG, "%s", entry->d_name);
+    }
+    closedir(dir);
+    return ESP_OK;
+}
+
+static esp_err_t gravar(const char *caminho, const uint8_t *dados, size_t len, const modo_t *modo,
+                        cartao_tempos_t *tempos)
+{
+    int64_t t0 = esp_timer_get_time();
+    FILE *f = fopen(caminho, "wb");
+    if (f == NULL) {
+        return ESP_FAIL;
+    }
+    int64_t t1 = esp_timer_get_time();
+
+    if (modo->buffer) {
+        setvbuf(f, NULL, _IOFBF, modo->buffer);
+    }
+    if (modo->prealocar && len > 0) {
+        // f_lseek além do fim aloca os clusters; a escrita volta ao início
+        fseek(f, len, SEEK_SET);
+        fseek(f, 0, SEEK_SET);
+    }
+
+    size_t escritos = 0;
+    if (modo->bloco && bloco) {
+        while (escritos < len) {
+            size_t n = (len - escritos < SD_BLOCO_BYTES) ? len - escritos : SD_BLOCO_BYTES;
+            memcpy(bloco, dados + escritos, n);
+            if (fwrite(bloco, 1, n, f) != n) {
+                break;
+            }
+            escritos += n;
+        }
+    } else {
+        escritos = fwrite(dados, 1, len, f);
+    }
+    bool ok = (escritos == len && fflush(f) == 0 && fsync(fileno(f)) == 0);
+    int64_t t2 = esp_timer_get_time();
+
+    ok = (fclose(f) == 0) && ok;
+    int64_t t3 = esp_timer_get_time();
+
+    if (tempos) {
+        tempos->abrir_us = t1 - t0;
+        tempos->escrever_us = t2 - t1;
+        tempos->fechar_us = t3 - t2;
+    }
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t cartao_gravar(const char *caminho, const uint8_t *dados, size_t len, cartao_tempos_t *tempos)
+{
+    if (mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    esp_err_t err = gravar(caminho, dados, len, &modo_config, tempos);
+    xSemaphoreGive(mutex);
+    return err;
+}
+
+// ======== Benchmark ========
+
+#define BENCH_FOTOS          10
+#define BENCH_SEQUENCIAL     (4 * 1024 * 1024)
+
+static double kb_por_s(size_t bytes, int64_t us)
+{
+    return us > 0 ? bytes / 1024.0 / (us / 1e6) : 0.0;
+}
+
+// Arquivo grande em blocos, como uma gravação contínua
+static void bench_sequencial(const char *diretorio, const uint8_t *dados, size_t len_dados)
+{
+    char caminho[64];
+    snprintf(caminho, sizeof(caminho), "%s/bench_seq.bin", diretorio);
+    FILE *f = fopen(caminho, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Benchmark: não foi possível criar %s", caminho);
+        return;
+    }
+    setvbuf(f, NULL, _IOFBF, SD_BUFFER_BYTES ? SD_BUFFER_BYTES : BUFSIZ);
+
+    int64_t pior = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (size_t feito = 0; feito < BENCH_SEQUENCIAL; feito += SD_BLOCO_BYTES) {
+        int64_t t = esp_timer_get_time();
+        memcpy(bloco, dados + (feito % (len_dados - SD_BLOCO_BYTES)), SD_BLOCO_BYTES);
+        fwrite(bloco, 1, SD_BLOCO_BYTES, f);
+        int64_t dt = esp_timer_get_time() - t;
+        if (dt > pior) {
+            pior = dt;
+        }
+    }
+    fflush(f);
+    fsync(fileno(f));
+    int64_t total = esp_timer_get_time() - t0;
+    fclose(f);
+    unlink(caminho);
+
+    ESP_LOGI(TAG, "Benchmark sequencial: %d KB em %lld ms = %.0f KB/s (pior bloco de %d KB: %lld ms)",
+             BENCH_SEQUENCIAL / 1024, (long long)(total / 1000), kb_por_s(BENCH_SEQUENCIAL, total),
+             SD_BLOCO_BYTES / 1024, (long long)(pior / 1000));
+}
+
+static void bench_fotos(const char *diretorio, const uint8_t *dados, size_t len, const modo_t *modo)
+{
+    int64_t abrir = 0, escrever = 0, fechar = 0, pior = 0;
+    int falhas = 0;
+
+    for (int i = 0; i < BENCH_FOTOS; i++) {
+        char caminho[64];
+        snprintf(caminho, sizeof(caminho), "%s/bench_%02d.jpg", diretorio, i);
+        cartao_tempos_t t = {0};
+        if (gravar(caminho, dados, len, modo, &t) != ESP_OK) {
+            falhas++;
+        }
+        abrir += t.abrir_us;
+        escrever += t.escrever_us;
+        fechar += t.fechar_us;
+        int64_t total = t.abrir_us + t.escrever_us + t.fechar_us;
+        if (total > pior) {
+            pior = total;
+        }
+    }
+    for (int i = 0; i < BENCH_FOTOS; i++) {
+        char caminho[64];
+        snprintf(caminho, sizeof(caminho), "%s/bench_%02d.jpg", diretorio, i);
+        unlink(caminho);
+    }
+
+    ESP_LOGI(TAG, "Benchmark %3u KB %-18s: escrita %4.0f KB/s, abrir+fechar %.1f ms, pior foto %.1f ms%s",
+             (unsigned)(len / 1024), modo->nome, kb_por_s(len * BENCH_FOTOS, escrever),
+             (abrir + fechar) / (double)BENCH_FOTOS / 1000, pior / 1000.0,
+             falhas ? " (com falhas)" : "");
+}
+
+void cartao_benchmark(const char *diretorio)
+{
+    static const size_t tamanhos[] = { 40 * 1024, 90 * 1024, 180 * 1024 };   // XGA de noite, típica, detalhada
+    const modo_t modos[] = {
+        { .nome = "stdio padrão" },
+        { .nome = "setvbuf", .buffer = SD_BUFFER_BYTES },
+        { .nome = "setvbuf+prealoc", .buffer = SD_BUFFER_BYTES, .prealocar = true },
+        { .nome = "bloco DMA+prealoc", .buffer = SD_BUFFER_BYTES, .bloco = true, .prealocar = true },
+    };
+
+    // Os dados vêm da PSRAM, como o buffer da câmera
+    size_t len_dados = 256 * 1024;
+    uint8_t *dados = heap_caps_malloc(len_dados, MALLOC_CAP_SPIRAM);
+    if (dados == NULL || bloco == NULL) {
+        ESP_LOGE(TAG, "Benchmark: sem memória");
+        free(dados);
+        return;
+    }
+    for (size_t i = 0; i < len_dados; i++) {
+        dados[i] = (uint8_t)(i * 31 + (i >> 8));
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    ESP_LOGI(TAG, "Benchmark do cartão: %d bit, %d kHz, setvbuf %d, bloco %d, %d fotos por medida",
+             SD_LARGURA_BARRAMENTO, SD_FREQ_KHZ, SD_BUFFER_BYTES, SD_BLOCO_BYTES, BENCH_FOTOS);
+    bench_sequencial(diretorio, dados, len_dados);
+    for (size_t t = 0; t < sizeof(tamanhos) / sizeof(tamanhos[0]); t++) {
+        for (size_t m = 0; m < sizeof(modos) / sizeof(modos[0]); m++) {
+            bench_fotos(diretorio, dados, tamanhos[t], &modos[m]);
+        }
+    }
+    xSemaphoreGive(mutex);
+    free(dados);
+}
@@ -0,0 +1,56 @@
+#ifndef CARTAO_H
+#define CARTAO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Cartão SD: montagem e gravação das fotos
+ * ============================================================
+ * SD_LARGURA_BARRAMENTO 4 usa DAT1..DAT3 (GPIO 4, 12, 13): na
+ * ESP32-CAM o GPIO 4 é o flash LED, que fica desativado nesse modo.
+ *
+ * Gravação de uma foto: f_lseek além do fim reserva a cadeia de
+ * clusters de uma vez (SD_PREALOCAR); o JPEG, que está na PSRAM, passa
+ * por um bloco em RAM interna com DMA (SD_BLOCO_BYTES, múltiplo de 512)
+ * para o driver gravar setores inteiros direto do bloco; o FILE usa
+ * buffer de SD_BUFFER_BYTES (setvbuf; 0 = padrão do newlib). Termina
+ * com fsync.
+ *
+ * SD_BENCHMARK 1 roda cartao_benchmark() no boot: escrita sequencial e
+ * fotos de tamanhos típicos em cada modo de gravação.
+ */
+
+#define SD_LARGURA_BARRAMENTO   1       // 1 ou 4
+#define SD_FREQ_KHZ             20000   // SDMMC_FREQ_DEFAULT; 40000 = high speed
+#define SD_UNIDADE_ALOCACAO     (16 * 1024)
+#define SD_BUFFER_BYTES         4096
+#define SD_BLOCO_BYTES          (16 * 1024)
+#define SD_PREALOCAR            1
+#define SD_BENCHMARK            0
+
+typedef struct {
+    int64_t abrir_us;
+    int64_t escrever_us;        // escrita + fsync
+    int64_t fechar_us;
+} cartao_tempos_t;
+
+/**
+ * @brief Monta o cartão (FAT) em ponto_montagem e lista a raiz.
+ */
+esp_err_t cartao_montar(const char *ponto_montagem);
+
+/**
+ * @brief Grava o arquivo inteiro e sincroniza; só volta ESP_OK se tudo
+ *        chegou ao cartão.
+ * @param tempos  opcional
+ */
+esp_err_t cartao_gravar(const char *caminho, const uint8_t *dados, size_t len, cartao_tempos_t *tempos);
+
+/**
+ * @brief Mede a escrita no cartão (alguns MB em arquivos temporários, apagados no fim).
+ */
+void cartao_benchmark(const char *diretorio);
+
+#endif // CARTAO_H
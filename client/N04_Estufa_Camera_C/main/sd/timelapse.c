@@ -0,0 +1,334 @@
+#include "timelapse.h"
+#include "avi.h"
+#include "cartao.h"
+#include "relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "esp_vfs_fat.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "TIMELAPSE";
+
+static const char *diretorio = NULL;
+static SemaphoreHandle_t mutex = NULL;
+static avi_t avi;
+static bool aberto = false;
+static char dia[24];            // do arquivo aberto
+static int parte = 0;
+static char caminho[64];
+static timelapse_stats_t stats;
+
+esp_err_t timelapse_init(const char *dir)
+{
+    diretorio = dir;
+    mutex = xSemaphoreCreateMutex();
+    return mutex ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static void dia_atual(char *s, size_t len)
+{
+    time_t agora;
+    struct tm tm;
+
+    if (!relogio_valido()) {
+        // Sem hora: o "dia" conta desde o boot, e o boot separa os resets
+        snprintf(s, len, "b%lu_d%lu", (unsigned long)relogio_boot_atual(),
+                 (unsigned long)(esp_timer_get_time() / (86400LL * 1000000)));
+    } else {
+        time(&agora);
+        localtime_r(&agora, &tm);
+        strftime(s, len, "%Y%m%d", &tm);
+    }
+}
+
+static void fechar_arquivo(void)
+{
+    uint32_t quadros = avi.quadros, bytes = avi_tamanho(&avi);
+    if (avi_fechar(&avi) != ESP_OK) {
+        ESP_LOGE(TAG, "Erro ao fechar %s (o índice é refeito na próxima abertura)", caminho);
+    } else {
+        ESP_LOGI(TAG, "%s fechado: %lu quadros, %lu KB", caminho, (unsigned long)quadros,
+                 (unsigned long)(bytes / 1024));
+    }
+    aberto = false;
+}
+
+// Primeira parte de hoje a partir de 'desde' que abre (nova ou recuperada)
+static esp_err_t abrir_arquivo(const char *hoje, int desde, uint16_t largura, uint16_t altura)
+{
+    for (int p = desde; p <= TIMELAPSE_PARTES_MAX; p++) {
+        if (p == 1) {
+            snprintf(caminho, sizeof(caminho), "%s/" TIMELAPSE_PREFIXO "%s.avi", diretorio, hoje);
+        } else {
+            snprintf(caminho, sizeof(caminho), "%s/" TIMELAPSE_PREFIXO "%s_%d.avi", diretorio, hoje, p);
+        }
+
+        avi_recuperacao_t rec;
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t err = avi_abrir(&avi, caminho, largura, altura, TIMELAPSE_FPS, &rec);
+        if (err == ESP_ERR_INVALID_STATE) {
+            ESP_LOGW(TAG, "%s não é um AVI do timelapse, usando a parte seguinte", caminho);
+            continue;
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Erro ao abrir %s (%s)", caminho, esp_err_to_name(err));
+            return err;
+        }
+
+        if (!rec.existia) {
+            ESP_LOGI(TAG, "Novo arquivo %s (%ux%u, %d fps)", caminho, largura, altura, TIMELAPSE_FPS);
+        } else if (rec.fechado) {
+            ESP_LOGI(TAG, "Continuando %s: %lu quadros (%lld ms)", caminho, (unsigned long)rec.quadros,
+                     (long long)((esp_timer_get_time() - t0) / 1000));
+        } else {
+            ESP_LOGW(TAG, "Recuperado %s sem índice: %lu quadros, %lu bytes cortados descartados (%lld ms)",
+                     caminho, (unsigned long)rec.quadros, (unsigned long)rec.descartados,
+                     (long long)((esp_timer_get_time() - t0) / 1000));
+        }
+        strlcpy(dia, hoje, sizeof(dia));
+        parte = p;
+        aberto = true;
+        stats.arquivos++;
+        return ESP_OK;
+    }
+    ESP_LOGE(TAG, "Sem parte disponível para %s", hoje);
+    return ESP_FAIL;
+}
+
+esp_err_t timelapse_adicionar(const uint8_t *jpeg, size_t len, uint16_t largura, uint16_t altura,
+                              int64_t *escrever_us)
+{
+    if (mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    char hoje[sizeof(dia)];
+    dia_atual(hoje, sizeof(hoje));
+    if (aberto && strcmp(hoje, dia) != 0) {
+        fechar_arquivo();
+    }
+
+    esp_err_t err = aberto ? ESP_OK : abrir_arquivo(hoje, 1, largura, altura);
+    int64_t t0 = esp_timer_get_time();
+    if (err == ESP_OK) {
+        err = avi_adicionar(&avi, jpeg, len);
+        if (err == ESP_ERR_INVALID_SIZE) {
+            fechar_arquivo();
+            err = abrir_arquivo(hoje, parte + 1, largura, altura);
+            if (err == ESP_OK) {
+                err = avi_adicionar(&avi, jpeg, len);
+            }
+        }
+    }
+    if (escrever_us) {
+        *escrever_us = esp_timer_get_time() - t0;
+    }
+
+    if (err != ESP_OK) {
+        stats.falhas++;
+    }
+    stats.quadros = aberto ? avi.quadros : 0;
+    stats.bytes = aberto ? avi_tamanho(&avi) : 0;
+    xSemaphoreGive(mutex);
+    return err;
+}
+
+void timelapse_fechar(void)
+{
+    if (mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (aberto) {
+        fechar_arquivo();
+    }
+    xSemaphoreGive(mutex);
+}
+
+void timelapse_get_stats(timelapse_stats_t *out)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(mutex);
+}
+
+// ======== Benchmark ========
+
+#define BENCH_QUADROS       200
+#define BENCH_TAMANHO       (90 * 1024)     // foto XGA típica
+#define BENCH_LEITURA       (16 * 1024)
+
+typedef struct {
+    int64_t  gravar_us;
+    int64_t  listar_us;
+    int64_t  copiar_us;
+    int64_t  apagar_us;
+    uint64_t espaco;
+} bench_t;
+
+static uint64_t livre(const char *dir)
+{
+    uint64_t total = 0, livres = 0;
+    esp_vfs_fat_info(dir, &total, &livres);
+    return livres;
+}
+
+// Como um gerenciador de arquivos: nomes e tamanhos
+static int64_t listar(const char *pasta, uint32_t *arquivos)
+{
+    int64_t t0 = esp_timer_get_time();
+    DIR *d = opendir(pasta);
+    *arquivos = 0;
+    if (d == NULL) {
+        return 0;
+    }
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        char c[300];
+        struct stat st;
+        snprintf(c, sizeof(c), "%s/%s", pasta, e->d_name);
+        if (stat(c, &st) == 0) {
+            (*arquivos)++;
+        }
+    }
+    closedir(d);
+    return esp_timer_get_time() - t0;
+}
+
+static size_t ler_arquivo(const char *c, uint8_t *buf)
+{
+    size_t total = 0, n;
+    FILE *f = fopen(c, "rb");
+    if (f == NULL) {
+        return 0;
+    }
+    while ((n = fread(buf, 1, BENCH_LEITURA, f)) > 0) {
+        total += n;
+    }
+    fclose(f);
+    return total;
+}
+
+static void nome_jpeg(char *c, size_t len, const char *pasta, int i)
+{
+    // Mesmo formato (nome longo) das fotos do nó
+    snprintf(c, len, "%s/20250101_%02d%02d%02d.jpg", pasta, i / 3600, i / 60 % 60, i % 60);
+}
+
+static double mb(uint64_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+static void relatar(const char *nome, const bench_t *b, uint64_t dados)
+{
+    ESP_LOGI(TAG, "Benchmark %-14s: gravar %5lld ms, listar %4lld ms, copiar %5lld ms (%4.0f KB/s), "
+             "apagar %4lld ms, espaço %.2f MB (+%.1f%%)",
+             nome, (long long)(b->gravar_us / 1000), (long long)(b->listar_us / 1000),
+             (long long)(b->copiar_us / 1000), b->copiar_us > 0 ? dados / 1024.0 / (b->copiar_us / 1e6) : 0.0,
+             (long long)(b->apagar_us / 1000), mb(b->espaco),
+             dados ? (b->espaco > dados ? (b->espaco - dados) * 100.0 / dados : 0.0) : 0.0);
+}
+
+void timelapse_benchmark(const char *dir)
+{
+    uint8_t *dados = heap_caps_malloc(BENCH_TAMANHO, MALLOC_CAP_SPIRAM);
+    uint8_t *buf = malloc(BENCH_LEITURA);
+    char pasta[48], c[80];
+    bench_t jpg = {0}, mov = {0};
+    uint64_t total = (uint64_t)BENCH_QUADROS * BENCH_TAMANHO;
+    uint32_t arquivos = 0;
+
+    if (dados == NULL || buf == NULL) {
+        ESP_LOGE(TAG, "Benchmark: sem memória");
+        free(dados);
+        free(buf);
+        return;
+    }
+    for (size_t i = 0; i < BENCH_TAMANHO; i++) {
+        dados[i] = (uint8_t)(i * 31 + (i >> 8));
+    }
+    dados[0] = 0xFF;
+    dados[1] = 0xD8;
+    dados[BENCH_TAMANHO - 2] = 0xFF;
+    dados[BENCH_TAMANHO - 1] = 0xD9;
+
+    snprintf(pasta, sizeof(pasta), "%s/bench_tl", dir);
+    mkdir(pasta, 0775);
+    ESP_LOGI(TAG, "Benchmark: %d fotos de %d KB (%.1f MB), JPEGs avulsos x um AVI",
+             BENCH_QUADROS, BENCH_TAMANHO / 1024, mb(total));
+
+    // JPEGs avulsos, gravados como as fotos do nó
+    uint64_t antes = livre(dir);
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_QUADROS; i++) {
+        nome_jpeg(c, sizeof(c), pasta, i);
+        cartao_gravar(c, dados, BENCH_TAMANHO, NULL);
+    }
+    jpg.gravar_us = esp_timer_get_time() - t0;
+    jpg.espaco = antes - livre(dir);
+    jpg.listar_us = listar(pasta, &arquivos);
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_QUADROS; i++) {
+        nome_jpeg(c, sizeof(c), pasta, i);
+        ler_arquivo(c, buf);
+    }
+    jpg.copiar_us = esp_timer_get_time() - t0;
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_QUADROS; i++) {
+        nome_jpeg(c, sizeof(c), pasta, i);
+        unlink(c);
+    }
+    jpg.apagar_us = esp_timer_get_time() - t0;
+    ESP_LOGI(TAG, "Benchmark: %lu entradas listadas", (unsigned long)arquivos);
+
+    // Um AVI com as mesmas fotos
+    snprintf(c, sizeof(c), "%s/bench.avi", pasta);
+    unlink(c);
+    antes = livre(dir);
+    t0 = esp_timer_get_time();
+    avi_t b;
+    if (avi_abrir(&b, c, 1024, 768, TIMELAPSE_FPS, NULL) == ESP_OK) {
+        for (int i = 0; i < BENCH_QUADROS; i++) {
+            avi_adicionar(&b, dados, BENCH_TAMANHO);
+        }
+        avi_fechar(&b);
+    }
+    mov.gravar_us = esp_timer_get_time() - t0;
+    mov.espaco = antes - livre(dir);
+    mov.listar_us = listar(pasta, &arquivos);
+    t0 = esp_timer_get_time();
+    ler_arquivo(c, buf);
+    mov.copiar_us = esp_timer_get_time() - t0;
+
+    // Custo de retomar o arquivo depois de um reset: percorre os chunks
+    avi_recuperacao_t rec = {0};
+    t0 = esp_timer_get_time();
+    if (avi_abrir(&b, c, 0, 0, 0, &rec) == ESP_OK) {
+        avi_fechar(&b);
+    }
+    int64_t retomar_us = esp_timer_get_time() - t0;
+
+    t0 = esp_timer_get_time();
+    unlink(c);
+    mov.apagar_us = esp_timer_get_time() - t0;
+    rmdir(pasta);
+
+    relatar("JPEGs avulsos", &jpg, total);
+    relatar("AVI", &mov, total);
+    ESP_LOGI(TAG, "Benchmark: retomar o AVI (%lu quadros, índice refeito e regravado) %lld ms",
+             (unsigned long)rec.quadros, (long long)(retomar_us / 1000));
+    free(dados);
+    free(buf);
+}
@@ -0,0 +1,61 @@
+#ifndef TIMELAPSE_H
+#define TIMELAPSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Timelapse diário no cartão SD
+ * ============================================================
+ * Em vez de um JPEG por foto, as fotos do dia entram num único AVI
+ * MJPEG (sd/avi.h): TIMELAPSE_PREFIXO + AAAAMMDD.avi, com _2, _3...
+ * quando um arquivo chega a AVI_TAMANHO_MAX ou não pode ser retomado.
+ * Na virada do dia o arquivo é fechado (idx1) e o do dia novo é
+ * aberto; depois de um reset, o arquivo do dia é recuperado e continua.
+ * Sem relógio ajustado o dia é contado desde o boot: TIMELAPSE_PREFIXO
+ * + b<boot>_d<dia>.avi (relogio.h), um arquivo novo a cada 24 h de
+ * uptime e a cada reset.
+ *
+ * timelapse_benchmark() compara, para as mesmas fotos, JPEGs avulsos e
+ * um AVI: tempo de gravação, de listar o diretório, de copiar (ler
+ * tudo), de apagar, e o espaço ocupado no cartão.
+ */
+
+#define TIMELAPSE_PREFIXO       "tl_"
+#define TIMELAPSE_FPS           10      // 10 fotos por segundo de vídeo: 1 dia em 2,4 min
+#define TIMELAPSE_PARTES_MAX    9
+
+typedef struct {
+    uint32_t quadros;           // no arquivo aberto
+    uint32_t bytes;             // tamanho do arquivo aberto
+    uint32_t arquivos;          // abertos desde o boot
+    uint32_t falhas;
+} timelapse_stats_t;
+
+/**
+ * @brief Guarda o diretório (SD já montado); o arquivo abre no primeiro quadro.
+ */
+esp_err_t timelapse_init(const char *diretorio);
+
+/**
+ * @brief Acrescenta o JPEG ao arquivo do dia (abrindo/trocando se preciso).
+ * @param largura, altura  do quadro, usados no cabeçalho de arquivo novo
+ * @param escrever_us      opcional: gravação + fsync
+ */
+esp_err_t timelapse_adicionar(const uint8_t *jpeg, size_t len, uint16_t largura, uint16_t altura,
+                              int64_t *escrever_us);
+
+/**
+ * @brief Fecha o arquivo aberto (grava o índice).
+ */
+void timelapse_fechar(void);
+
+void timelapse_get_stats(timelapse_stats_t *stats);
+
+/**
+ * @brief Grava as mesmas fotos como JPEGs avulsos e como AVI e compara (apaga tudo no fim).
+ */
+void timelapse_benchmark(const char *diretorio);
+
+#endif // TIMELAPSE_H
@@ -0,0 +1,389 @@
+#include "stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_camera.h"
+#include "esp_http_server.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "STREAM";
+
+#define STREAM_FRONTEIRA  "greensequadro"
+#define STREAM_PARTE      "\r\n--" STREAM_FRONTEIRA "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n"
+
+// Cópia de um quadro do sensor, compartilhada pelos clientes
+typedef struct {
+    uint8_t *buf;
+    size_t   len;
+    uint32_t numero;
+    int      refs;
+} stream_quadro_t;
+
+typedef struct {
+    bool         ativo;
+    uint32_t     id;
+    httpd_req_t *req;
+    TaskHandle_t tarefa;
+    int64_t      inicio_us;
+    int64_t      ultimo_us;
+    int64_t      intervalo_us;      // média móvel entre quadros enviados
+    uint32_t     enviados;
+    uint32_t     pulados;
+    uint64_t     bytes;
+} cliente_t;
+
+static stream_config_t cfg;
+static httpd_handle_t servidor = NULL;
+static TaskHandle_t tarefa_captura = NULL;
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static stream_quadro_t *atual = NULL;        // segura uma referência
+static cliente_t clientes[STREAM_CLIENTES_MAX];
+static uint32_t proximo_id = 1;
+static uint32_t capturados = 0;
+static uint32_t falhas_captura = 0;
+static int64_t captura_us = 0;
+static int64_t intervalo_captura_us = 0;
+
+static int64_t media_movel(int64_t media, int64_t amostra)
+{
+    return media ? media + (amostra - media) / 8 : amostra;
+}
+
+static float fps(int64_t intervalo_us, int64_t ultimo_us, int64_t agora)
+{
+    // Parado há mais tempo que o intervalo médio: usa o tempo parado
+    int64_t parado = ultimo_us ? agora - ultimo_us : 0;
+    int64_t t = (parado > intervalo_us) ? parado : intervalo_us;
+    return t > 0 ? 1e6f / t : 0.0f;
+}
+
+// ======== Quadros ========
+
+static stream_quadro_t *pegar_atual(void)
+{
+    portENTER_CRITICAL(&lock);
+    stream_quadro_t *q = atual;
+    if (q) {
+        q->refs++;
+    }
+    portEXIT_CRITICAL(&lock);
+    return q;
+}
+
+static void soltar(stream_quadro_t *q)
+{
+    if (q == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    bool ultima = (--q->refs == 0);
+    portEXIT_CRITICAL(&lock);
+    if (ultima) {
+        free(q);
+    }
+}
+
+static stream_quadro_t *copiar(const camera_fb_t *fb, uint32_t numero)
+{
+    // Cabeçalho e JPEG numa alocação só, na PSRAM
+    stream_quadro_t *q = heap_caps_malloc(sizeof(stream_quadro_t) + fb->len, MALLOC_CAP_SPIRAM);
+    if (q == NULL) {
+        return NULL;
+    }
+    q->buf = (uint8_t *)(q + 1);
+    memcpy(q->buf, fb->buf, fb->len);
+    q->len = fb->len;
+    q->numero = numero;
+    q->refs = 1;
+    return q;
+}
+
+// Troca o quadro atual e acorda os clientes; q == NULL só solta o atual
+static void publicar(stream_quadro_t *q)
+{
+    int64_t agora = esp_timer_get_time();
+    TaskHandle_t acordar[STREAM_CLIENTES_MAX];
+    int n = 0;
+
+    portENTER_CRITICAL(&lock);
+    stream_quadro_t *velho = atual;
+    atual = q;
+    if (q) {
+        capturados++;
+        if (captura_us) {
+            intervalo_captura_us = media_movel(intervalo_captura_us, agora - captura_us);
+        }
+        captura_us = agora;
+        for (int i = 0; i < STREAM_CLIENTES_MAX; i++) {
+            if (clientes[i].ativo && clientes[i].tarefa) {
+                acordar[n++] = clientes[i].tarefa;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    soltar(velho);
+    for (int i = 0; i < n; i++) {
+        xTaskNotifyGive(acordar[i]);
+    }
+}
+
+static int clientes_conectados(void)
+{
+    int n = 0;
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < STREAM_CLIENTES_MAX; i++) {
+        n += clientes[i].ativo;
+    }
+    portEXIT_CRITICAL(&lock);
+    return n;
+}
+
+// ======== Relatório ========
+
+void stream_get_stats(stream_stats_t *out)
+{
+    int64_t agora = esp_timer_get_time();
+    memset(out, 0, sizeof(*out));
+
+    portENTER_CRITICAL(&lock);
+    out->capturados = capturados;
+    out->falhas_captura = falhas_captura;
+    out->fps_captura = atual ? fps(intervalo_captura_us, captura_us, agora) : 0.0f;
+    for (int i = 0; i < STREAM_CLIENTES_MAX; i++) {
+        const cliente_t *c = &clientes[i];
+        if (!c->ativo) {
+            continue;
+        }
+        stream_cliente_stats_t *s = &out->clientes[out->n_clientes++];
+        s->id = c->id;
+        s->fps = fps(c->intervalo_us, c->ultimo_us, agora);
+        s->enviados = c->enviados;
+        s->pulados = c->pulados;
+        s->bytes = c->bytes;
+        s->conectado_s = (agora - c->inicio_us) / 1000000;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+static void relatar(void)
+{
+    stream_stats_t st;
+    stream_get_stats(&st);
+    char linha[64 * STREAM_CLIENTES_MAX] = "";
+    size_t usado = 0;
+    for (int i = 0; i < st.n_clientes && usado < sizeof(linha); i++) {
+        const stream_cliente_stats_t *c = &st.clientes[i];
+        usado += snprintf(linha + usado, sizeof(linha) - usado, "; cliente %lu %.1f fps (%lu pulados)",
+                          (unsigned long)c->id, c->fps, (unsigned long)c->pulados);
+    }
+    ESP_LOGI(TAG, "Captura %.1f fps (%lu quadros, %lu falhas)%s", st.fps_captura,
+             (unsigned long)st.capturados, (unsigned long)st.falhas_captura, linha);
+}
+
+// ======== Captura ========
+
+static void task_stream_captura(void *arg)
+{
+    TickType_t proxima = xTaskGetTickCount();
+    int64_t relatorio_us = 0;
+    uint32_t numero = 0;
+
+    while (true) {
+        if (clientes_conectados() == 0) {
+            // Sem cliente o sensor fica só com as fotos periódicas
+            publicar(NULL);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            proxima = xTaskGetTickCount();
+            continue;
+        }
+
+        camera_fb_t *fb = esp_camera_fb_get();
+        stream_quadro_t *q = fb ? copiar(fb, ++numero) : NULL;
+        if (fb) {
+            esp_camera_fb_return(fb);
+        }
+        if (q) {
+            publicar(q);
+        } else {
+            portENTER_CRITICAL(&lock);
+            falhas_captura++;
+            portEXIT_CRITICAL(&lock);
+        }
+
+        int64_t agora = esp_timer_get_time();
+        if (agora - relatorio_us >= STREAM_RELATORIO_S * 1000000LL) {
+            relatorio_us = agora;
+            relatar();
+        }
+
+        bool ocupado = cfg.ocupado && cfg.ocupado();
+        xTaskDelayUntil(&proxima, pdMS_TO_TICKS(1000 / (ocupado ? STREAM_FPS_OCUPADO : STREAM_FPS_MAX)));
+    }
+}
+
+// ======== Clientes ========
+
+static esp_err_t enviar_quadro(httpd_req_t *req, const stream_quadro_t *q)
+{
+    char parte[128];
+    int len = snprintf(parte, sizeof(parte), STREAM_PARTE, (unsigned)q->len);
+    esp_err_t err = httpd_resp_send_chunk(req, parte, len);
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(req, (const char *)q->buf, q->len);
+    }
+    return err;
+}
+
+static void task_stream_cliente(void *arg)
+{
+    cliente_t *c = arg;
+    httpd_req_t *req = c->req;
+    uint32_t ultimo = 0;
+
+    portENTER_CRITICAL(&lock);
+    c->tarefa = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&lock);
+    xTaskNotifyGive(tarefa_captura);
+
+    httpd_resp_set_type(req, "multipart/x-mixed-replace;boundary=" STREAM_FRONTEIRA);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        stream_quadro_t *q = pegar_atual();
+        if (q == NULL || q->numero == ultimo) {
+            soltar(q);
+            continue;
+        }
+        esp_err_t err = enviar_quadro(req, q);
+        int64_t agora = esp_timer_get_time();
+
+        portENTER_CRITICAL(&lock);
+        if (err == ESP_OK) {
+            if (ultimo && q->numero > ultimo + 1) {
+                c->pulados += q->numero - ultimo - 1;
+            }
+            if (c->ultimo_us) {
+                c->intervalo_us = media_movel(c->intervalo_us, agora - c->ultimo_us);
+            }
+            c->ultimo_us = agora;
+            c->enviados++;
+            c->bytes += q->len;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        ultimo = q->numero;
+        soltar(q);
+        if (err != ESP_OK) {
+            break;      // cliente fechou ou não recebe há send_wait_timeout
+        }
+    }
+
+    ESP_LOGI(TAG, "Cliente %lu desconectado: %lu quadros, %lu pulados, %llu KB",
+             (unsigned long)c->id, (unsigned long)c->enviados, (unsigned long)c->pulados,
+             (unsigned long long)(c->bytes / 1024));
+    httpd_req_async_handler_complete(req);
+
+    portENTER_CRITICAL(&lock);
+    c->tarefa = NULL;
+    c->ativo = false;
+    portEXIT_CRITICAL(&lock);
+    vTaskDelete(NULL);
+}
+
+static void liberar_vaga(cliente_t *c)
+{
+    portENTER_CRITICAL(&lock);
+    c->ativo = false;
+    portEXIT_CRITICAL(&lock);
+}
+
+static esp_err_t handle_stream(httpd_req_t *req)
+{
+    cliente_t *c = NULL;
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < STREAM_CLIENTES_MAX; i++) {
+        if (!clientes[i].ativo) {
+            c = &clientes[i];
+            *c = (cliente_t){ .ativo = true, .id = proximo_id++, .inicio_us = esp_timer_get_time() };
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (c == NULL) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_sendstr(req, "Limite de clientes do stream atingido");
+    }
+
+    // A tarefa do httpd fica livre para os outros clientes
+    if (httpd_req_async_handler_begin(req, &c->req) != ESP_OK) {
+        liberar_vaga(c);
+        return ESP_FAIL;
+    }
+    if (xTaskCreate(task_stream_cliente, "stream_cliente", 4096, c, 2, NULL) != pdPASS) {
+        httpd_req_async_handler_complete(c->req);
+        liberar_vaga(c);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Cliente %lu conectado (%d de %d)", (unsigned long)c->id,
+             clientes_conectados(), STREAM_CLIENTES_MAX);
+    return ESP_OK;
+}
+
+static esp_err_t handle_stats(httpd_req_t *req)
+{
+    stream_stats_t st;
+    stream_get_stats(&st);
+
+    char json[160 + 128 * STREAM_CLIENTES_MAX];
+    size_t n = snprintf(json, sizeof(json), "{\"fps_captura\":%.2f,\"capturados\":%lu,\"falhas_captura\":%lu,\"clientes\":[",
+                        st.fps_captura, (unsigned long)st.capturados, (unsigned long)st.falhas_captura);
+    for (int i = 0; i < st.n_clientes && n < sizeof(json); i++) {
+        const stream_cliente_stats_t *c = &st.clientes[i];
+        n += snprintf(json + n, sizeof(json) - n,
+                      "%s{\"id\":%lu,\"fps\":%.2f,\"enviados\":%lu,\"pulados\":%lu,\"bytes\":%llu,\"conectado_s\":%lu}",
+                      i ? "," : "", (unsigned long)c->id, c->fps, (unsigned long)c->enviados,
+                      (unsigned long)c->pulados, (unsigned long long)c->bytes, (unsigned long)c->conectado_s);
+    }
+    if (n < sizeof(json)) {
+        snprintf(json + n, sizeof(json) - n, "]}");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, json);
+}
+
+esp_err_t stream_init(const stream_config_t *config)
+{
+    if (config) {
+        cfg = *config;
+    }
+
+    httpd_config_t http_cfg = HTTPD_DEFAULT_CONFIG();
+    http_cfg.server_port = STREAM_PORTA;
+    http_cfg.max_open_sockets = STREAM_CLIENTES_MAX + 2;   // + /stream/stats e folga
+    http_cfg.lru_purge_enable = true;
+
+    esp_err_t err = httpd_start(&servidor, &http_cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao iniciar o servidor HTTP: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    const httpd_uri_t uri_stream = { .uri = "/stream", .method = HTTP_GET, .handler = handle_stream };
+    const httpd_uri_t uri_stats = { .uri = "/stream/stats", .method = HTTP_GET, .handler = handle_stats };
+    httpd_register_uri_handler(servidor, &uri_stream);
+    httpd_register_uri_handler(servidor, &uri_stats);
+
+    // Abaixo do envio de fotos (4): o stream não rouba CPU do upload
+    xTaskCreate(task_stream_captura, "stream_captura", 4096, NULL, 3, &tarefa_captura);
+    ESP_LOGI(TAG, "Stream em http://<ip>:%d/stream (até %d clientes)", STREAM_PORTA, STREAM_CLIENTES_MAX);
+    return ESP_OK;
+}
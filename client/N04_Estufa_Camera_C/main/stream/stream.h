@@ -0,0 +1,58 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * Stream MJPEG local (GET /stream)
+ * ============================================================
+ * Uma tarefa de captura lê o sensor só enquanto há cliente conectado e
+ * publica cada quadro uma vez, copiado para a PSRAM com contador de
+ * referências: todos os clientes mandam a mesma cópia e o buffer do
+ * driver volta na hora (as fotos periódicas não ficam sem buffer).
+ *
+ * Cada cliente tem a sua tarefa (handler assíncrono do httpd) e manda
+ * sempre o quadro mais recente; cliente lento pula quadros, a captura
+ * nunca espera por ele. Enquanto cfg.ocupado() indicar envio de foto em
+ * andamento, a captura cai para STREAM_FPS_OCUPADO.
+ *
+ * GET /stream/stats devolve em JSON o fps da captura e de cada cliente.
+ */
+
+#define STREAM_PORTA            80
+#define STREAM_CLIENTES_MAX     3
+#define STREAM_FPS_MAX          5
+#define STREAM_FPS_OCUPADO      1
+#define STREAM_RELATORIO_S      30
+
+typedef struct {
+    bool (*ocupado)(void);      // opcional: envio que não pode ser disputado
+} stream_config_t;
+
+typedef struct {
+    uint32_t id;
+    float    fps;               // média móvel do intervalo entre quadros enviados
+    uint32_t enviados;
+    uint32_t pulados;           // publicados enquanto o cliente ainda mandava o anterior
+    uint64_t bytes;
+    uint32_t conectado_s;
+} stream_cliente_stats_t;
+
+typedef struct {
+    float    fps_captura;
+    uint32_t capturados;
+    uint32_t falhas_captura;
+    int      n_clientes;
+    stream_cliente_stats_t clientes[STREAM_CLIENTES_MAX];
+} stream_stats_t;
+
+/**
+ * @brief Sobe o servidor HTTP e a tarefa de captura do stream (câmera e Wi-Fi prontos).
+ */
+esp_err_t stream_init(const stream_config_t *cfg);
+
+void stream_get_stats(stream_stats_t *stats);
+
+#endif // STREAM_H
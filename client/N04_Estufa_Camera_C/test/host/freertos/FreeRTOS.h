@@ -0,0 +1,16 @@
+#pragma once
+
+/* Substituto de host: os testes rodam numa thread só */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFU)
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+/* Mutex de host sem efeito: um único handle não nulo basta */
+
+typedef void *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static int mutex;
+    return &mutex;
+}
+
+static inline int xSemaphoreTake(SemaphoreHandle_t m, TickType_t espera)
+{
+    (void)m;
+    (void)espera;
+    return pdTRUE;
+}
+
+static inline int xSemaphoreGive(SemaphoreHandle_t m)
+{
+    (void)m;
+    return pdTRUE;
+}
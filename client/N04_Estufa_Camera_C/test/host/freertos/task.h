@@ -0,0 +1,28 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+/* Tarefas não rodam no host: os testes exercitam o que a API faz
+ * de forma síncrona, e a tarefa criada nunca começa */
+
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+
+static inline BaseType_t xTaskCreate(TaskFunction_t funcao, const char *nome, uint32_t pilha,
+                                     void *arg, UBaseType_t prioridade, TaskHandle_t *tarefa)
+{
+    (void)funcao;
+    (void)nome;
+    (void)pilha;
+    (void)arg;
+    (void)prioridade;
+    if (tarefa) {
+        *tarefa = NULL;
+    }
+    return pdPASS;
+}
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
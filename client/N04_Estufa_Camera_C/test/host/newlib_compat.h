@@ -0,0 +1,18 @@
+#pragma once
+
+/* Funções da newlib (ESP-IDF) que a glibc só tem a partir da 2.38 */
+
+#include <string.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+static inline size_t strlcpy(char *dst, const char *src, size_t tam)
+{
+    size_t len = strlen(src);
+    if (tam > 0) {
+        size_t n = (len < tam - 1) ? len : tam - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
@@ -0,0 +1,156 @@
+#include "teste.h"
+#include "avi.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char dir[64];
+static char caminho[96];
+
+static uint32_t ler_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint8_t *jpeg(size_t len, int semente)
+{
+    uint8_t *d = malloc(len);
+    for (size_t i = 0; i < len; i++) {
+        d[i] = (uint8_t)(i * 7 + semente);
+    }
+    d[0] = 0xFF;
+    d[1] = 0xD8;
+    d[len - 2] = 0xFF;
+    d[len - 1] = 0xD9;
+    return d;
+}
+
+static void adicionar(avi_t *a, size_t len, int semente)
+{
+    uint8_t *d = jpeg(len, semente);
+    VERIFICAR(avi_adicionar(a, d, len) == ESP_OK);
+    free(d);
+}
+
+// Queda de energia: nada de idx1 nem cabeçalho final, índice em RAM perdido
+static void derrubar(avi_t *a)
+{
+    fclose(a->f);
+    free(a->indice);
+    memset(a, 0, sizeof(*a));
+}
+
+static void acrescentar_bruto(const void *dados, size_t len, int preencher, size_t n)
+{
+    FILE *f = fopen(caminho, "ab");
+    fwrite(dados, 1, len, f);
+    for (size_t i = 0; i < n; i++) {
+        fputc(preencher, f);
+    }
+    fclose(f);
+}
+
+// Confere um arquivo fechado: tamanhos RIFF/movi, contagem e cada entrada do idx1
+static void validar_fechado(uint32_t quadros)
+{
+    FILE *f = fopen(caminho, "rb");
+    fseek(f, 0, SEEK_END);
+    long tamanho = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *b = malloc(tamanho);
+    VERIFICAR(fread(b, 1, tamanho, f) == (size_t)tamanho);
+    fclose(f);
+
+    VERIFICAR(memcmp(b, "RIFF", 4) == 0 && ler_u32(b + 4) == (uint32_t)tamanho - 8);
+    VERIFICAR(ler_u32(b + 48) == quadros && ler_u32(b + 140) == quadros);
+    VERIFICAR(memcmp(b + 212, "LIST", 4) == 0 && memcmp(b + 220, "movi", 4) == 0);
+
+    uint32_t idx = 216 + 4 + ler_u32(b + 216);
+    VERIFICAR(idx + 8 <= (uint32_t)tamanho && memcmp(b + idx, "idx1", 4) == 0);
+    VERIFICAR(ler_u32(b + idx + 4) == 16 * quadros);
+    VERIFICAR(idx + 8 + 16 * quadros == (uint32_t)tamanho);
+
+    for (uint32_t i = 0; i < quadros && idx + 8 + 16 * (i + 1) <= (uint32_t)tamanho; i++) {
+        const uint8_t *e = b + idx + 8 + 16 * i;
+        uint32_t chunk = AVI_CABECALHO - 4 + ler_u32(e + 8);
+        uint32_t len = ler_u32(e + 12);
+        VERIFICAR(memcmp(e, "00dc", 4) == 0);
+        VERIFICAR(chunk + 8 + len <= idx && memcmp(b + chunk, "00dc", 4) == 0);
+        VERIFICAR(ler_u32(b + chunk + 4) == len);
+        VERIFICAR(b[chunk + 8] == 0xFF && b[chunk + 9] == 0xD8);
+        VERIFICAR(b[chunk + 8 + len - 2] == 0xFF && b[chunk + 8 + len - 1] == 0xD9);
+    }
+    free(b);
+}
+
+static void testar_recuperacao(void)
+{
+    avi_t a;
+    avi_recuperacao_t r;
+
+    VERIFICAR(avi_abrir(&a, caminho, 1024, 768, 10, &r) == ESP_OK && !r.existia);
+    for (int i = 0; i < 25; i++) {
+        adicionar(&a, 40000 + i * 13, i);   // tamanhos ímpares: chunk com byte de alinhamento
+    }
+    derrubar(&a);
+
+    // Chunk cortado no fim: cabeçalho do chunk promete mais do que há
+    acrescentar_bruto("00dc\x88\x13\0\0\xff\xd8", 10, 1, 98);
+    VERIFICAR(avi_abrir(&a, caminho, 0, 0, 0, &r) == ESP_OK);
+    VERIFICAR(r.existia && !r.fechado && r.quadros == 25 && r.descartados == 108);
+    VERIFICAR(a.largura == 1024 && a.altura == 768 && a.fps == 10);
+    for (int i = 0; i < 5; i++) {
+        adicionar(&a, 30001, i);
+    }
+    derrubar(&a);
+
+    // Tamanho do arquivo andou mas os dados não (zeros)
+    acrescentar_bruto("00dc\x64\0\0\0", 8, 0, 100);
+    VERIFICAR(avi_abrir(&a, caminho, 0, 0, 0, &r) == ESP_OK);
+    VERIFICAR(r.quadros == 30 && r.descartados == 108);
+    derrubar(&a);
+
+    // Chunk inteiro com SOI, mas sem EOI: JPEG parcial
+    acrescentar_bruto("00dc\x64\0\0\0\xff\xd8", 10, 1, 98);
+    VERIFICAR(avi_abrir(&a, caminho, 0, 0, 0, &r) == ESP_OK);
+    VERIFICAR(r.quadros == 30 && r.descartados == 108);
+    VERIFICAR(avi_tamanho(&a) == a.fim + 8 + 16 * 30);
+    VERIFICAR(avi_fechar(&a) == ESP_OK);
+    validar_fechado(30);
+
+    // Fechado normalmente: idx1 retirado na abertura, quadros novos depois
+    VERIFICAR(avi_abrir(&a, caminho, 0, 0, 0, &r) == ESP_OK);
+    VERIFICAR(r.fechado && r.quadros == 30 && r.descartados == 0);
+    adicionar(&a, 20000, 1);
+    adicionar(&a, 20001, 2);
+    VERIFICAR(avi_fechar(&a) == ESP_OK);
+    validar_fechado(32);
+}
+
+static void testar_arquivo_estranho(void)
+{
+    avi_t a;
+    avi_recuperacao_t r;
+
+    FILE *f = fopen(caminho, "wb");
+    fputs("nada", f);
+    fclose(f);
+    VERIFICAR(avi_abrir(&a, caminho, 0, 0, 0, &r) == ESP_ERR_INVALID_STATE);
+    unlink(caminho);
+}
+
+int main(void)
+{
+    strcpy(dir, "/tmp/avi_XXXXXX");
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 2;
+    }
+    snprintf(caminho, sizeof(caminho), "%s/lapso.avi", dir);
+
+    testar_recuperacao();
+    unlink(caminho);
+    testar_arquivo_estranho();
+    rmdir(dir);
+    return TESTE_FIM();
+}
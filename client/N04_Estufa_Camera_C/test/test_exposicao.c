@@ -0,0 +1,100 @@
+#include "teste.h"
+#include "exposicao.h"
+
+#define QUADRO_US  66000    // ~15 fps
+
+static const exposicao_config_t CFG = {
+    .tolerancia = EXPOSICAO_TOLERANCIA,
+    .quadros_estaveis = EXPOSICAO_QUADROS_ESTAVEIS,
+    .prazo_min_ms = EXPOSICAO_PRAZO_MIN_MS,
+    .prazo_max_ms = EXPOSICAO_PRAZO_MAX_MS,
+    .folga = EXPOSICAO_FOLGA,
+    .media_inicial_ms = EXPOSICAO_MEDIA_INICIAL_MS,
+};
+
+// Avalia a sequência de brilhos, um quadro a cada QUADRO_US; devolve o
+// estado do último e em n o índice (1..) do quadro que encerrou a medição
+static exposicao_estado_t rodar(exposicao_t *e, int64_t inicio_us, const uint8_t *brilhos, int total, int *n)
+{
+    exposicao_estado_t estado = EXPOSICAO_AJUSTANDO;
+    exposicao_iniciar(e, inicio_us);
+    for (*n = 1; *n <= total; (*n)++) {
+        estado = exposicao_avaliar(e, brilhos[*n - 1], inicio_us + (int64_t)*n * QUADRO_US);
+        if (estado != EXPOSICAO_AJUSTANDO) {
+            break;
+        }
+    }
+    return estado;
+}
+
+static void testar_assentar(void)
+{
+    exposicao_t e;
+    int n;
+    const uint8_t subindo[] = { 40, 80, 120, 130, 131, 132, 132 };
+    const uint8_t salto[] = { 100, 101, 120, 121, 122 };
+
+    exposicao_init(&e, &CFG);
+    VERIFICAR(rodar(&e, 0, subindo, 7, &n) == EXPOSICAO_ESTAVEL);
+    // Duas variações seguidas dentro da tolerância: 130 -> 131 -> 132
+    VERIFICAR(n == 6 && e.quadros == 6);
+    VERIFICAR(e.prazo_ms == EXPOSICAO_FOLGA * EXPOSICAO_MEDIA_INICIAL_MS);
+    // Média móvel 3/4 antiga + 1/4 medida
+    VERIFICAR(e.media_ms == (3 * EXPOSICAO_MEDIA_INICIAL_MS + 6 * QUADRO_US / 1000) / 4);
+
+    // Variação fora da tolerância recomeça a contagem
+    VERIFICAR(rodar(&e, 10000000, salto, 5, &n) == EXPOSICAO_ESTAVEL);
+    VERIFICAR(n == 5);
+}
+
+static void testar_prazo(void)
+{
+    exposicao_t e;
+    int n;
+    uint8_t oscilando[64];
+
+    for (int i = 0; i < 64; i++) {
+        oscilando[i] = (i & 1) ? 60 : 200;
+    }
+
+    exposicao_init(&e, &CFG);
+    VERIFICAR(rodar(&e, 0, oscilando, 64, &n) == EXPOSICAO_PRAZO);
+    // Prazo inicial 2 x 500 ms: encerra no primeiro quadro depois dele
+    VERIFICAR((int64_t)n * QUADRO_US >= 1000000 && (int64_t)(n - 1) * QUADRO_US < 1000000);
+    uint32_t media = e.media_ms;
+    VERIFICAR(media > EXPOSICAO_MEDIA_INICIAL_MS);
+
+    // O prazo esgotado alonga os seguintes, até prazo_max_ms
+    uint32_t prazo = e.prazo_ms;
+    for (int i = 0; i < 20; i++) {
+        VERIFICAR(rodar(&e, (int64_t)(i + 1) * 10000000, oscilando, 64, &n) == EXPOSICAO_PRAZO);
+        VERIFICAR(e.prazo_ms >= prazo);
+        prazo = e.prazo_ms;
+    }
+    VERIFICAR(prazo == EXPOSICAO_PRAZO_MAX_MS);
+}
+
+static void testar_prazo_minimo(void)
+{
+    exposicao_t e;
+    int n;
+    const uint8_t estavel[] = { 90, 90, 90, 90 };
+    exposicao_config_t cfg = CFG;
+    cfg.media_inicial_ms = 50;
+
+    exposicao_init(&e, &cfg);
+    exposicao_iniciar(&e, 0);
+    VERIFICAR(e.prazo_ms == EXPOSICAO_PRAZO_MIN_MS);
+
+    // Cena parada assenta no terceiro quadro (duas comparações)
+    VERIFICAR(rodar(&e, 0, estavel, 4, &n) == EXPOSICAO_ESTAVEL);
+    VERIFICAR(n == 1 + EXPOSICAO_QUADROS_ESTAVEIS);
+}
+
+int main(void)
+{
+    testar_assentar();
+    testar_prazo();
+    testar_prazo_minimo();
+    return TESTE_FIM();
+}
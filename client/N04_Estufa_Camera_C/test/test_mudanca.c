@@ -0,0 +1,152 @@
+#include "teste.h"
+#include "mudanca.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const mudanca_config_t CFG = {
+    .limiar_celula = MUDANCA_LIMIAR_CELULA,
+    .celulas_pct = MUDANCA_CELULAS_PCT,
+    .limiar_escuro = MUDANCA_LIMIAR_ESCURO,
+    .keyframe_s = MUDANCA_KEYFRAME_S,
+};
+
+// Cena com gradiente e textura, escalada por ganho (exposição) e com ruído
+static void cena(uint8_t *mini, float ganho, int ruido, unsigned semente)
+{
+    srand(semente);
+    for (int y = 0; y < MUDANCA_ALTURA; y++) {
+        for (int x = 0; x < MUDANCA_LARGURA; x++) {
+            int v = 60 + 3 * x + 2 * y + ((x ^ y) & 7) * 4;
+            v = (int)(v * ganho) + (ruido ? rand() % (2 * ruido + 1) - ruido : 0);
+            mini[y * MUDANCA_LARGURA + x] = v < 0 ? 0 : (v > 255 ? 255 : v);
+        }
+    }
+}
+
+// Objeto claro cobrindo l x a células
+static void objeto(uint8_t *mini, int x0, int y0, int l, int a)
+{
+    for (int y = y0; y < y0 + a; y++) {
+        for (int x = x0; x < x0 + l; x++) {
+            mini[y * MUDANCA_LARGURA + x] = 250;
+        }
+    }
+}
+
+static void testar_decisoes(void)
+{
+    static uint8_t mini[MUDANCA_PIXELS];
+    mudanca_t m;
+    mudanca_resultado_t r;
+    uint32_t t = 1000;
+
+    mudanca_init(&m, &CFG);
+    cena(mini, 1.0f, 0, 1);
+    VERIFICAR(mudanca_avaliar(&m, mini, t, &r) == MUDANCA_PRIMEIRA);
+
+    // Ruído de sensor e ajuste de exposição não são mudança
+    cena(mini, 1.0f, 3, 2);
+    VERIFICAR(mudanca_avaliar(&m, mini, t += 60, &r) == MUDANCA_IGUAL);
+    VERIFICAR(r.celulas_pct == 0);
+    cena(mini, 0.7f, 2, 3);
+    VERIFICAR(mudanca_avaliar(&m, mini, t += 60, &r) == MUDANCA_IGUAL);
+    VERIFICAR(r.celulas_pct < CFG.celulas_pct);
+
+    // Objeto em ~3% das células muda
+    cena(mini, 1.0f, 2, 4);
+    objeto(mini, 10, 10, 5, 5);
+    VERIFICAR(mudanca_avaliar(&m, mini, t += 60, &r) == MUDANCA_MUDOU);
+    VERIFICAR(r.celulas_pct >= CFG.celulas_pct && r.diferenca > 0);
+
+    // A foto mantida virou a referência: o objeto parado não muda mais
+    VERIFICAR(mudanca_avaliar(&m, mini, t += 60, &r) == MUDANCA_IGUAL);
+
+    // Sem foto mantida por keyframe_s: a próxima sai de qualquer jeito
+    uint32_t mantida = t - 60;
+    VERIFICAR(mudanca_avaliar(&m, mini, mantida + CFG.keyframe_s - 1, &r) == MUDANCA_IGUAL);
+    VERIFICAR(mudanca_avaliar(&m, mini, mantida + CFG.keyframe_s, &r) == MUDANCA_KEYFRAME);
+    VERIFICAR(mudanca_avaliar(&m, mini, mantida + CFG.keyframe_s + 1, &r) == MUDANCA_IGUAL);
+}
+
+static void testar_escura(void)
+{
+    static uint8_t mini[MUDANCA_PIXELS];
+    mudanca_t m;
+    mudanca_resultado_t r;
+
+    // Escura nem como primeira foto
+    mudanca_init(&m, &CFG);
+    memset(mini, CFG.limiar_escuro - 1, sizeof(mini));
+    VERIFICAR(mudanca_avaliar(&m, mini, 0, &r) == MUDANCA_ESCURA);
+    VERIFICAR(r.brilho == CFG.limiar_escuro - 1);
+    VERIFICAR(!m.tem_referencia);
+
+    cena(mini, 1.0f, 0, 1);
+    VERIFICAR(mudanca_avaliar(&m, mini, 10, &r) == MUDANCA_PRIMEIRA);
+
+    // Nem quando o keyframe venceu: a noite não gera fotos
+    memset(mini, 5, sizeof(mini));
+    VERIFICAR(mudanca_avaliar(&m, mini, 10 + CFG.keyframe_s * 2, &r) == MUDANCA_ESCURA);
+    // E não vira referência: a manhã é comparada com a última foto clara
+    cena(mini, 1.0f, 2, 5);
+    VERIFICAR(mudanca_avaliar(&m, mini, 10 + CFG.keyframe_s * 2 + 1, &r) == MUDANCA_KEYFRAME);
+
+    // limiar_escuro 0 desliga o descarte
+    mudanca_config_t sem_escuro = CFG;
+    sem_escuro.limiar_escuro = 0;
+    mudanca_init(&m, &sem_escuro);
+    memset(mini, 0, sizeof(mini));
+    VERIFICAR(mudanca_avaliar(&m, mini, 0, &r) == MUDANCA_PRIMEIRA);
+}
+
+static void pixel(uint8_t *rgb, int largura, int x, int y, uint16_t c)
+{
+    uint8_t *p = rgb + ((size_t)y * largura + x) * 2;
+    p[0] = c >> 8;
+    p[1] = c & 0xFF;
+}
+
+static void testar_reducao(void)
+{
+    static uint8_t rgb[128 * 96 * 2];
+    static uint8_t mini[MUDANCA_PIXELS];
+
+    // Tamanho que não divide a miniatura: toda célula recebe pixels
+    for (int y = 0; y < 75; y++) {
+        for (int x = 0; x < 100; x++) {
+            pixel(rgb, 100, x, y, 0xFFFF);
+        }
+    }
+    mudanca_reduzir_rgb565(rgb, 100, 75, mini);
+    int min = 255, max = 0;
+    for (int i = 0; i < MUDANCA_PIXELS; i++) {
+        min = mini[i] < min ? mini[i] : min;
+        max = mini[i] > max ? mini[i] : max;
+    }
+    VERIFICAR(min == max && min >= 245);
+    VERIFICAR(mudanca_brilho(mini) == min);
+
+    // Metade esquerda preta, direita branca; verde puro pesa mais que azul
+    for (int y = 0; y < 96; y++) {
+        for (int x = 0; x < 128; x++) {
+            uint16_t c = x < 64 ? 0x0000 : 0xFFFF;
+            if (y >= 48) {
+                c = x < 64 ? 0x07E0 : 0x001F;
+            }
+            pixel(rgb, 128, x, y, c);
+        }
+    }
+    mudanca_reduzir_rgb565(rgb, 128, 96, mini);
+    VERIFICAR(mini[0] == 0 && mini[MUDANCA_LARGURA - 1] >= 245);
+    uint8_t verde = mini[(MUDANCA_ALTURA - 1) * MUDANCA_LARGURA];
+    uint8_t azul = mini[MUDANCA_PIXELS - 1];
+    VERIFICAR(verde > 140 && azul < 40);
+}
+
+int main(void)
+{
+    testar_decisoes();
+    testar_escura();
+    testar_reducao();
+    return TESTE_FIM();
+}
@@ -0,0 +1,199 @@
+#include "teste.h"
+#include "pendentes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* pendentes.c guarda o estado em estáticos e pendentes_init roda uma vez
+ * por boot: cada cenário é um processo (argumento do ctest). */
+
+static char dir[64];
+static char diario[96];
+static char tmp[96];
+
+static bool sempre_online(void)
+{
+    return true;
+}
+
+static void preparar(void)
+{
+    strcpy(dir, "/tmp/pendentes_XXXXXX");
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        exit(2);
+    }
+    snprintf(diario, sizeof(diario), "%s%s", dir, PENDENTES_DIARIO);
+    snprintf(tmp, sizeof(tmp), "%s%s", dir, PENDENTES_TMP);
+}
+
+static void gravar(const char *arquivo, const char *conteudo)
+{
+    FILE *f = fopen(arquivo, "w");
+    fputs(conteudo, f);
+    fclose(f);
+}
+
+static bool conteudo_igual(const char *arquivo, const char *esperado)
+{
+    static char buf[65536];
+    FILE *f = fopen(arquivo, "r");
+    if (f == NULL) {
+        return false;
+    }
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    return strcmp(buf, esperado) == 0;
+}
+
+static void iniciar(void)
+{
+    pendentes_config_t cfg = { .diretorio = dir, .online = sempre_online };
+    VERIFICAR(pendentes_init(&cfg) == ESP_OK);
+}
+
+static void limpar(void)
+{
+    unlink(diario);
+    unlink(tmp);
+    rmdir(dir);
+}
+
+static void cenario_novo(void)
+{
+    iniciar();
+    VERIFICAR(pendentes_quantidade() == 0);
+    VERIFICAR(pendentes_adicionar("a.jpg") == ESP_OK);
+    VERIFICAR(pendentes_adicionar("b.jpg") == ESP_OK);
+    VERIFICAR(pendentes_adicionar("a.jpg") == ESP_OK);   // repetida: nada muda
+    VERIFICAR(pendentes_quantidade() == 2);
+    VERIFICAR(conteudo_igual(diario, "+ a.jpg\n+ b.jpg\n"));
+
+    pendentes_stats_t st;
+    pendentes_get_stats(&st);
+    VERIFICAR(st.pendentes == 2 && st.enviadas == 0 && st.desistencias == 0);
+}
+
+static void cenario_diario(void)
+{
+    // Última linha cortada por queda de energia
+    gravar(diario, "+ a.jpg\n+ b.jpg\n! a.jpg 3\n- b.jpg\n+ c.jpg\nx c.jpg\n+ d.jpg\n+ e.j");
+    iniciar();
+    VERIFICAR(pendentes_quantidade() == 2);
+    // Reescrito sem a linha cortada, mantendo ordem e tentativas
+    VERIFICAR(conteudo_igual(diario, "+ a.jpg\n! a.jpg 3\n+ d.jpg\n"));
+    VERIFICAR(pendentes_adicionar("f.jpg") == ESP_OK);
+    VERIFICAR(conteudo_igual(diario, "+ a.jpg\n! a.jpg 3\n+ d.jpg\n+ f.jpg\n"));
+}
+
+static void cenario_temporario(void)
+{
+    // Queda entre o unlink do diário e o rename: vale o temporário
+    gravar(tmp, "+ a.jpg\n+ b.jpg\n");
+    iniciar();
+    VERIFICAR(pendentes_quantidade() == 2);
+    VERIFICAR(access(tmp, F_OK) != 0);
+    VERIFICAR(conteudo_igual(diario, "+ a.jpg\n+ b.jpg\n"));
+}
+
+static void cenario_temporario_parcial(void)
+{
+    // Queda durante a escrita do temporário: o diário ainda é o completo
+    gravar(diario, "+ a.jpg\n+ b.jpg\n+ c.jpg\n");
+    gravar(tmp, "+ a.jpg\n");
+    iniciar();
+    VERIFICAR(pendentes_quantidade() == 3);
+    VERIFICAR(access(tmp, F_OK) != 0);
+}
+
+static void cenario_compactar(void)
+{
+    // Linhas mortas dominam o diário: reescrito só com as pendentes
+    FILE *f = fopen(diario, "w");
+    for (int i = 0; i < 300; i++) {
+        fprintf(f, "+ %d.jpg\n- %d.jpg\n", i, i);
+    }
+    fputs("+ viva.jpg\n", f);
+    fclose(f);
+    iniciar();
+    VERIFICAR(pendentes_quantidade() == 1);
+    VERIFICAR(conteudo_igual(diario, "+ viva.jpg\n"));
+}
+
+static void cenario_cheia(void)
+{
+    char nome[PENDENTES_NOME_MAX];
+
+    iniciar();
+    for (int i = 0; i <= PENDENTES_MAX; i++) {
+        snprintf(nome, sizeof(nome), "%05d.jpg", i);
+        pendentes_adicionar(nome);
+    }
+    VERIFICAR(pendentes_quantidade() == PENDENTES_MAX);
+
+    pendentes_stats_t st;
+    pendentes_get_stats(&st);
+    VERIFICAR(st.desistencias == 1);
+
+    // A mais antiga saiu, e o diário registra
+    FILE *f = fopen(diario, "r");
+    char linha[64];
+    bool desistiu = false;
+    while (f && fgets(linha, sizeof(linha), f)) {
+        desistiu |= strcmp(linha, "x 00000.jpg\n") == 0;
+    }
+    if (f) {
+        fclose(f);
+    }
+    VERIFICAR(desistiu);
+}
+
+static void cenario_recusa(void)
+{
+    // Só a recusa da foto gasta tentativa
+    VERIFICAR(pendentes_recusada(400));
+    VERIFICAR(pendentes_recusada(404));
+    VERIFICAR(pendentes_recusada(413));
+    VERIFICAR(pendentes_recusada(499));
+
+    // Sem resposta, servidor fora ou sobrecarregado: espera sem contar
+    VERIFICAR(!pendentes_recusada(0));
+    VERIFICAR(!pendentes_recusada(408));
+    VERIFICAR(!pendentes_recusada(429));
+    VERIFICAR(!pendentes_recusada(500));
+    VERIFICAR(!pendentes_recusada(502));
+    VERIFICAR(!pendentes_recusada(503));
+    VERIFICAR(!pendentes_recusada(302));
+}
+
+int main(int argc, char **argv)
+{
+    static const struct {
+        const char *nome;
+        void (*rodar)(void);
+    } cenarios[] = {
+        { "novo", cenario_novo },
+        { "recusa", cenario_recusa },
+        { "diario", cenario_diario },
+        { "temporario", cenario_temporario },
+        { "temporario_parcial", cenario_temporario_parcial },
+        { "compactar", cenario_compactar },
+        { "cheia", cenario_cheia },
+    };
+
+    if (argc != 2) {
+        fprintf(stderr, "uso: %s <cenário>\n", argv[0]);
+        return 2;
+    }
+    for (size_t i = 0; i < sizeof(cenarios) / sizeof(cenarios[0]); i++) {
+        if (strcmp(argv[1], cenarios[i].nome) == 0) {
+            preparar();
+            cenarios[i].rodar();
+            limpar();
+            return TESTE_FIM();
+        }
+    }
+    fprintf(stderr, "cenário desconhecido: %s\n", argv[1]);
+    return 2;
+}
@@ -0,0 +1,139 @@
+#include "teste.h"
+#include "qualidade.h"
+#include <math.h>
+#include <stdlib.h>
+
+static qualidade_config_t config(uint8_t n_tamanhos)
+{
+    qualidade_config_t cfg = {
+        .alvo_bytes = QUALIDADE_ALVO_BYTES,
+        .alvo_min_bytes = QUALIDADE_ALVO_MIN_BYTES,
+        .tempo_alvo_ms = QUALIDADE_TEMPO_ALVO_MS,
+        .q_min = QUALIDADE_Q_MIN,
+        .q_max = QUALIDADE_Q_MAX,
+        .passo_max = QUALIDADE_PASSO_MAX,
+        .banda_pct = QUALIDADE_BANDA_PCT,
+        .n_tamanhos = n_tamanhos,
+    };
+    return cfg;
+}
+
+// Cena sintética no modelo do controlador: tamanho = k / q^alfa, e cada
+// passo de tamanho de quadro divide por ~1,6
+static uint32_t foto(const qualidade_t *c, double k)
+{
+    return (uint32_t)(k / pow(c->q, QUALIDADE_ALFA) / pow(1.6, c->tamanho));
+}
+
+static void testar_passo(void)
+{
+    qualidade_t c;
+    qualidade_passo_t p;
+    qualidade_config_t cfg = config(1);
+
+    qualidade_init(&c, &cfg, 12);
+
+    // Dentro da banda: nada muda
+    VERIFICAR(!qualidade_atualizar(&c, QUALIDADE_ALVO_BYTES * 105 / 100, 0, &p));
+    VERIFICAR(p.q == 12 && p.alvo == QUALIDADE_ALVO_BYTES && p.erro_pct == 5);
+
+    // Foto com o dobro do alvo: piora a qualidade, no máximo passo_max
+    VERIFICAR(qualidade_atualizar(&c, 2 * QUALIDADE_ALVO_BYTES, 0, &p));
+    VERIFICAR(p.q_anterior == 12 && p.q == 12 + QUALIDADE_PASSO_MAX && p.erro_pct == 100);
+
+    // Pouco acima da banda: ao menos um nível
+    VERIFICAR(qualidade_atualizar(&c, QUALIDADE_ALVO_BYTES * 112 / 100, 0, &p));
+    VERIFICAR(p.q == 17);
+
+    // Metade do alvo: melhora
+    VERIFICAR(qualidade_atualizar(&c, QUALIDADE_ALVO_BYTES / 2, 0, &p));
+    VERIFICAR(p.q == 17 - QUALIDADE_PASSO_MAX);
+
+    // Limites de q
+    qualidade_init(&c, &cfg, 2);
+    VERIFICAR(c.q == QUALIDADE_Q_MIN);
+    VERIFICAR(!qualidade_atualizar(&c, QUALIDADE_ALVO_BYTES / 4, 0, &p));
+    qualidade_init(&c, &cfg, 60);
+    VERIFICAR(c.q == QUALIDADE_Q_MAX);
+    VERIFICAR(!qualidade_atualizar(&c, QUALIDADE_ALVO_BYTES * 4, 0, &p));
+}
+
+static void testar_alvo_pela_vazao(void)
+{
+    qualidade_t c;
+    qualidade_passo_t p;
+    qualidade_config_t cfg = config(1);
+
+    qualidade_init(&c, &cfg, 20);
+    // 10 KB/s x 4 s = 40 KB: abaixo de alvo_bytes, vale o link
+    qualidade_atualizar(&c, 40960, 10, &p);
+    VERIFICAR(p.alvo == 40960 && p.erro_pct == 0);
+    // Link lento: não desce de alvo_min_bytes
+    qualidade_atualizar(&c, 20480, 1, &p);
+    VERIFICAR(p.alvo == QUALIDADE_ALVO_MIN_BYTES);
+    // Link rápido ou desconhecido: alvo_bytes
+    qualidade_atualizar(&c, 60000, 1000, &p);
+    VERIFICAR(p.alvo == QUALIDADE_ALVO_BYTES);
+    qualidade_atualizar(&c, 60000, 0, &p);
+    VERIFICAR(p.alvo == QUALIDADE_ALVO_BYTES);
+}
+
+static void testar_convergencia(void)
+{
+    qualidade_t c;
+    qualidade_passo_t p;
+    qualidade_config_t cfg = config(1);
+    // Cena em que o alvo cai perto de q = 20
+    double k = QUALIDADE_ALVO_BYTES * pow(20, QUALIDADE_ALFA);
+
+    qualidade_init(&c, &cfg, QUALIDADE_Q_MIN);
+    int mudancas = 0;
+    for (int i = 0; i < 20; i++) {
+        mudancas += qualidade_atualizar(&c, foto(&c, k), 0, &p);
+    }
+    VERIFICAR(abs(c.q - 20) <= 2);
+    VERIFICAR(abs(p.erro_pct) <= QUALIDADE_BANDA_PCT);
+    // Chega sem oscilar: poucos passos e depois para
+    VERIFICAR(mudancas <= 6);
+    VERIFICAR(!qualidade_atualizar(&c, foto(&c, k), 0, &p));
+}
+
+static void testar_tamanho_do_quadro(void)
+{
+    qualidade_t c;
+    qualidade_passo_t p;
+    qualidade_config_t cfg = config(3);
+    // Nem q_max cabe no alvo no maior quadro
+    double k = 1.3 * QUALIDADE_ALVO_BYTES * pow(QUALIDADE_Q_MAX, QUALIDADE_ALFA);
+
+    qualidade_init(&c, &cfg, QUALIDADE_Q_MAX);
+    VERIFICAR(qualidade_atualizar(&c, foto(&c, k), 0, &p));
+    VERIFICAR(p.tamanho_anterior == 0 && p.tamanho == 1);
+    for (int i = 0; i < 20; i++) {
+        qualidade_atualizar(&c, foto(&c, k), 0, &p);
+    }
+    VERIFICAR(c.tamanho == 1 && abs(p.erro_pct) <= QUALIDADE_BANDA_PCT);
+
+    // Cena bem mais leve: q vai ao mínimo e o quadro volta a crescer
+    k /= 20;
+    for (int i = 0; i < 30; i++) {
+        qualidade_atualizar(&c, foto(&c, k), 0, &p);
+    }
+    VERIFICAR(c.tamanho == 0);
+
+    // Sem mais quadros menores: fica no último
+    qualidade_init(&c, &cfg, QUALIDADE_Q_MAX);
+    for (int i = 0; i < 5; i++) {
+        qualidade_atualizar(&c, QUALIDADE_ALVO_BYTES * 10, 0, &p);
+    }
+    VERIFICAR(c.tamanho == 2 && c.q == QUALIDADE_Q_MAX);
+}
+
+int main(void)
+{
+    testar_passo();
+    testar_alvo_pela_vazao();
+    testar_convergencia();
+    testar_tamanho_do_quadro();
+    return TESTE_FIM();
+}
@@ -5,23 +5,32 @@
 #include <math.h>
 #include <errno.h>
 #include <float.h>
+#include <unistd.h>
 
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_spiffs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "app_data_logger.h"
+#include "app_log_record.h"
+#include "app_log_block.h"
 #include "../bsp/board.h"
 #include "gui_services.h"
 #include "cJSON.h"
 
 static const char *TAG = "APP_DATA_LOGGER";
 
-#define LOG_FILE_PATH  BSP_SPIFFS_MOUNT "/log_temp.csv"
+#define LOG_FILE_PATH  BSP_SPIFFS_MOUNT "/log_data.bin"
+#define TAIL_FILE_PATH BSP_SPIFFS_MOUNT "/log_tail.bin"
+#define LOG_V1_PATH    BSP_SPIFFS_MOUNT "/log_v1.bin"
+#define LOG_NEW_PATH   BSP_SPIFFS_MOUNT "/log_new.bin"
+#define LEGACY_CSV_PATH BSP_SPIFFS_MOUNT "/log_temp.csv"
 #define CALIB_FILE     BSP_SPIFFS_MOUNT "/soil_calib.json"
 #define RECENT_STATS_MAX_WINDOW 64
+#define HISTORY_MAX_SAMPLES     20
 
 /* calibração persistida */
 static float calib_seco    = 4000.0f;
@@ -30,9 +39,27 @@ static float calib_molhado = 400.0f;
 /* índice incremental da linha */
 static int linha_idx = 1;
 
-/* Mutex para proteger acesso ao arquivo CSV */
+/* Mutex para proteger acesso aos arquivos de log e ao estado abaixo */
 static SemaphoreHandle_t file_mutex = NULL;
 
+/* Bloco aberto: registros ainda não comprimidos, espelhados em log_tail.bin */
+static log_record_t tail_recs[LOG_BLOCK_MAX_SAMPLES];
+static int tail_count = 0;
+
+/* Primeiro e último N presentes no log (0 = vazio) */
+static uint32_t first_n = 0;
+static uint32_t last_n  = 0;
+
+/* Durante a migração os blocos vão para log_new.bin e o bloco aberto fica só em RAM */
+static bool migrando = false;
+
+/* Maior N lido das fontes antigas: a numeração nova continua depois dele */
+static uint32_t legado_max_n = 0;
+
+/* Rascunhos de (de)compressão */
+static uint8_t      block_buf[LOG_BLOCK_MAX_BYTES];
+static log_record_t block_recs[LOG_BLOCK_MAX_SAMPLES];
+
 /* ---------- calibração solo ---------- */
 
 static esp_err_t carregar_calibracao(void)
@@ -102,6 +129,452 @@ static esp_err_t salvar_calibracao(void)
     return ESP_OK;
 }
 
+/* ---------- arquivo de blocos comprimidos ---------- */
+
+static bool write_file_header(FILE *f)
+{
+    log_file_header_t hdr = {
+        .magic       = LOG_RECORD_MAGIC,
+        .version     = LOG_RECORD_VERSION,
+        .record_size = sizeof(log_record_t),
+        .reserved    = 0,
+    };
+    return fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+}
+
+/* Retorna a versão do arquivo, ou -1 se o cabeçalho for inválido */
+static int header_version(FILE *f)
+{
+    log_file_header_t hdr;
+    if (fseek(f, 0, SEEK_SET) != 0 || fread(&hdr, sizeof(hdr), 1, f) != 1) {
+        return -1;
+    }
+    if (hdr.magic != LOG_RECORD_MAGIC || hdr.record_size != sizeof(log_record_t)) {
+        return -1;
+    }
+    return hdr.version;
+}
+
+static esp_err_t create_log_file(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Nao consegui criar %s", path);
+        return ESP_FAIL;
+    }
+    bool ok = write_file_header(f);
+    fclose(f);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+static long file_size(FILE *f)
+{
+    if (fseek(f, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    return ftell(f);
+}
+
+/* Lê e decodifica o bloco que termina em end; usa block_buf/block_recs */
+static int read_block_before(FILE *f, long end, long *start_out)
+{
+    uint8_t trailer[LOG_BLOCK_TRAILER_BYTES];
+    if (end < (long)(sizeof(log_file_header_t) + sizeof(log_block_header_t) + sizeof(trailer)) ||
+        fseek(f, end - (long)sizeof(trailer), SEEK_SET) != 0 ||
+        fread(trailer, sizeof(trailer), 1, f) != 1) {
+        return -1;
+    }
+
+    long len = trailer[0] | (trailer[1] << 8);
+    long start = end - len;
+    if (len > (long)sizeof(block_buf) || start < (long)sizeof(log_file_header_t) ||
+        fseek(f, start, SEEK_SET) != 0 ||
+        fread(block_buf, 1, (size_t)len, f) != (size_t)len) {
+        return -1;
+    }
+
+    if (start_out) *start_out = start;
+    return log_block_decode(block_buf, (size_t)len, block_recs);
+}
+
+/* Lê e decodifica o bloco que começa em start; usa block_buf/block_recs */
+static int read_block_at(FILE *f, long start, long *end_out)
+{
+    log_block_header_t hdr;
+    if (fseek(f, start, SEEK_SET) != 0 || fread(&hdr, sizeof(hdr), 1, f) != 1) {
+        return -1;
+    }
+
+    size_t len = log_block_size(&hdr);
+    if (len == 0 || len > sizeof(block_buf) ||
+        fseek(f, start, SEEK_SET) != 0 ||
+        fread(block_buf, 1, len, f) != len) {
+        return -1;
+    }
+
+    if (end_out) *end_out = start + (long)len;
+    return log_block_decode(block_buf, len, block_recs);
+}
+
+/* Comprime o bloco aberto e o anexa ao log; só então esvazia log_tail.bin */
+static esp_err_t flush_tail_block(void)
+{
+    if (tail_count == 0) {
+        return ESP_OK;
+    }
+
+    size_t len = log_block_encode(tail_recs, tail_count, block_buf, sizeof(block_buf));
+    if (len == 0) {
+        ESP_LOGE(TAG, "Falha ao comprimir bloco de %d amostras", tail_count);
+        return ESP_FAIL;
+    }
+
+    const char *path = migrando ? LOG_NEW_PATH : LOG_FILE_PATH;
+    FILE *f = fopen(path, "ab");
+    if (!f) {
+        ESP_LOGE(TAG, "Falha ao abrir %s para append", path);
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(block_buf, 1, len, f) == len;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) {
+        ESP_LOGE(TAG, "Falha ao gravar bloco");
+        return ESP_FAIL;
+    }
+
+    /* O tail em flash ainda é do log atual, que a migração vai reler */
+    if (!migrando) {
+        FILE *t = fopen(TAIL_FILE_PATH, "wb");
+        if (t) fclose(t);
+    }
+
+    ESP_LOGD(TAG, "Bloco gravado: %d amostras em %u bytes", tail_count, (unsigned)len);
+    tail_count = 0;
+    return ESP_OK;
+}
+
+/* Acrescenta um registro ao bloco aberto; persist grava também em log_tail.bin.
+ * Retorna false só se o registro não pôde ser aceito. */
+static bool push_record(const log_record_t *rec, bool persist)
+{
+    /* Bloco cheio de uma tentativa anterior que falhou */
+    if (tail_count >= LOG_BLOCK_MAX_SAMPLES && flush_tail_block() != ESP_OK) {
+        return false;
+    }
+
+    tail_recs[tail_count++] = *rec;
+    if (first_n == 0) first_n = rec->n;
+    last_n = rec->n;
+
+    if (tail_count == LOG_BLOCK_MAX_SAMPLES && flush_tail_block() == ESP_OK) {
+        return true;
+    }
+    if (!persist) {
+        return true;
+    }
+
+    /* Mesmo sem o espelho em flash, o registro segue no bloco em RAM */
+    FILE *t = fopen(TAIL_FILE_PATH, "ab");
+    if (!t || fwrite(rec, sizeof(*rec), 1, t) != 1) {
+        ESP_LOGW(TAG, "Falha ao espelhar registro %lu em %s",
+                 (unsigned long)rec->n, TAIL_FILE_PATH);
+    }
+    if (t) fclose(t);
+    return true;
+}
+
+/* Regrava log_tail.bin com o bloco aberto em RAM */
+static bool save_tail(void)
+{
+    FILE *t = fopen(TAIL_FILE_PATH, "wb");
+    if (!t) {
+        ESP_LOGE(TAG, "Falha ao abrir %s", TAIL_FILE_PATH);
+        return false;
+    }
+    bool ok = tail_count == 0 ||
+              fwrite(tail_recs, sizeof(log_record_t), (size_t)tail_count, t) == (size_t)tail_count;
+    ok = (fclose(t) == 0) && ok;
+    if (!ok) {
+        ESP_LOGE(TAG, "Falha ao gravar %s", TAIL_FILE_PATH);
+    }
+    return ok;
+}
+
+/* Últimos max registros (blocos + bloco aberto), em ordem cronológica.
+ * Percorre os blocos de trás para frente pelo trailer: só decodifica
+ * os blocos necessários. Chamar com file_mutex. */
+static int read_last_records(log_record_t *out, int max)
+{
+    int from_tail = (tail_count < max) ? tail_count : max;
+    int need = max - from_tail;
+    int got = 0;
+
+    FILE *f = (need > 0) ? fopen(LOG_FILE_PATH, "rb") : NULL;
+    if (f) {
+        long pos = file_size(f);
+        while (need > 0 && pos > (long)sizeof(log_file_header_t)) {
+            long start;
+            int k = read_block_before(f, pos, &start);
+            if (k <= 0) {
+                break;
+            }
+            int take = (k < need) ? k : need;
+            memmove(out + take, out, (size_t)got * sizeof(log_record_t));
+            memcpy(out, block_recs + (k - take), (size_t)take * sizeof(log_record_t));
+            got  += take;
+            need -= take;
+            pos   = start;
+        }
+        fclose(f);
+    }
+
+    memcpy(out + got, tail_recs + (tail_count - from_tail), (size_t)from_tail * sizeof(log_record_t));
+    return got + from_tail;
+}
+
+static int total_records(void)
+{
+    return (last_n >= first_n && first_n != 0) ? (int)(last_n - first_n + 1) : 0;
+}
+
+/* Cede CPU em conversões longas para não disparar o watchdog */
+static void migration_yield(int migrados)
+{
+    if ((migrados % 256) == 0) {
+        vTaskDelay(1);
+    }
+}
+
+static bool existe(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+/* Acrescenta ao log em construção um registro lido de uma fonte antiga.
+ * N que não avança já foi migrado (migração repetida após falha ou queda):
+ * é ignorado, então refazer a migração não duplica amostras. */
+static void migrar_registro(const log_record_t *rec, bool *ok, int *migrados)
+{
+    if (last_n != 0 && rec->n <= last_n) {
+        return;
+    }
+    if (!push_record(rec, false)) {
+        *ok = false;
+    }
+    migration_yield(++(*migrados));
+}
+
+/* Converte log_temp.csv de versões anteriores para blocos.
+ * *ok vira false se algum registro não foi aceito: o CSV não é apagado. */
+static int migrar_csv_legado(bool *ok)
+{
+    FILE *in = fopen(LEGACY_CSV_PATH, "r");
+    if (!in) {
+        return 0;
+    }
+
+    ESP_LOGI(TAG, "Migrando %s para blocos comprimidos...", LEGACY_CSV_PATH);
+
+    char line[160];
+    int migrados = 0;
+    fgets(line, sizeof(line), in); // header
+    while (fgets(line, sizeof(line), in)) {
+        int n_local;
+        log_entry_t e = { .luminosidade = NAN, .dpv = NAN, .ponto_orvalho = NAN };
+        int fields = sscanf(line, "%d,%f,%f,%f,%f,%f,%f,%f",
+                            &n_local, &e.temp_ar, &e.umid_ar, &e.temp_solo, &e.umid_solo,
+                            &e.luminosidade, &e.dpv, &e.ponto_orvalho);
+        if (fields < 5 || n_local <= 0) {
+            continue;
+        }
+        if (fields < 6) e.luminosidade = NAN;
+        if (fields < 7) e.dpv = NAN;
+        if (fields < 8) e.ponto_orvalho = NAN;
+
+        log_record_t rec;
+        log_record_encode((uint32_t)n_local, &e, &rec);
+        if (rec.n > legado_max_n) legado_max_n = rec.n;
+        migrar_registro(&rec, ok, &migrados);
+    }
+    if (ferror(in)) {
+        *ok = false;
+    }
+    fclose(in);
+    return migrados;
+}
+
+/* Converte o log de registros não comprimidos (versão 1) para blocos */
+static int migrar_v1(bool *ok)
+{
+    FILE *in = fopen(LOG_V1_PATH, "rb");
+    if (!in) {
+        return 0;
+    }
+
+    ESP_LOGI(TAG, "Migrando registros v1 para blocos comprimidos...");
+
+    int migrados = 0;
+    log_record_t rec;
+    fseek(in, sizeof(log_file_header_t), SEEK_SET);
+    while (fread(&rec, sizeof(rec), 1, in) == 1) {
+        if (rec.n > legado_max_n) legado_max_n = rec.n;
+        migrar_registro(&rec, ok, &migrados);
+    }
+    if (ferror(in)) {
+        *ok = false;
+    }
+    fclose(in);
+    return migrados;
+}
+
+/* Descarta um bloco final incompleto (queda de energia durante a gravação) */
+static void reparar_final(FILE *f)
+{
+    long size = file_size(f);
+    if (size <= (long)sizeof(log_file_header_t) || read_block_before(f, size, NULL) > 0) {
+        return;
+    }
+
+    long pos = sizeof(log_file_header_t);
+    long end;
+    while (pos < size && read_block_at(f, pos, &end) > 0 && end <= size) {
+        pos = end;
+    }
+
+    ESP_LOGW(TAG, "Bloco final incompleto: truncando %s de %ld para %ld bytes",
+             LOG_FILE_PATH, size, pos);
+    if (truncate(LOG_FILE_PATH, pos) != 0) {
+        ESP_LOGE(TAG, "Falha ao truncar %s (%d)", LOG_FILE_PATH, errno);
+    }
+}
+
+/* Registros que já estão em log_data.bin/log_tail.bin: gravados depois de
+ * uma migração que falhou, ou a migração inteira se a troca de arquivos
+ * caiu antes de apagar as fontes antigas */
+static int migrar_log_atual(bool *ok)
+{
+    int migrados = 0;
+    log_record_t rec;
+
+    FILE *f = fopen(LOG_FILE_PATH, "rb");
+    if (f) {
+        if (header_version(f) == LOG_RECORD_VERSION) {
+            reparar_final(f);
+            long pos = sizeof(log_file_header_t);
+            long end;
+            int k;
+            while ((k = read_block_at(f, pos, &end)) > 0) {
+                for (int i = 0; i < k; i++) {
+                    migrar_registro(&block_recs[i], ok, &migrados);
+                }
+                pos = end;
+            }
+        }
+        fclose(f);
+    }
+
+    FILE *t = fopen(TAIL_FILE_PATH, "rb");
+    if (t) {
+        while (fread(&rec, sizeof(rec), 1, t) == 1) {
+            migrar_registro(&rec, ok, &migrados);
+        }
+        if (ferror(t)) {
+            *ok = false;
+        }
+        fclose(t);
+    }
+    return migrados;
+}
+
+/* Reconstrói o log em log_new.bin a partir das fontes antigas e do log
+ * atual, e só troca os arquivos depois que tudo foi gravado. Se falhar,
+ * log_data.bin e as fontes antigas ficam como estavam e a migração é
+ * refeita no próximo boot. */
+static void migrar_legado(void)
+{
+    tail_count = 0;
+    first_n = 0;
+    last_n = 0;
+    legado_max_n = 0;
+
+    /* Fontes lidas mesmo se log_new.bin não pôde ser criado: legado_max_n
+     * ainda define a numeração das amostras novas */
+    bool ok = create_log_file(LOG_NEW_PATH) == ESP_OK;
+    migrando = true;
+    int migrados = migrar_v1(&ok);
+    migrados += migrar_csv_legado(&ok);
+    migrados += migrar_log_atual(&ok);
+    /* Falta o bloco aberto, que vai para log_tail.bin depois da troca */
+    migrando = false;
+
+    /* Troca: uma queda entre remove e rename é resolvida no próximo boot */
+    if (ok && (remove(LOG_FILE_PATH) != 0 || rename(LOG_NEW_PATH, LOG_FILE_PATH) != 0)) {
+        ESP_LOGE(TAG, "Falha ao substituir %s (%d)", LOG_FILE_PATH, errno);
+        ok = false;
+    }
+    if (ok && !save_tail()) {
+        ok = false;
+    }
+
+    if (ok) {
+        remove(LOG_V1_PATH);
+        remove(LEGACY_CSV_PATH);
+        ESP_LOGI(TAG, "Migracao concluida: %d amostras", migrados);
+    } else {
+        /* Se log_data.bin já foi apagado, o log novo serve mesmo incompleto */
+        if (existe(LOG_FILE_PATH) || rename(LOG_NEW_PATH, LOG_FILE_PATH) != 0) {
+            remove(LOG_NEW_PATH);
+        }
+        if (!existe(LOG_FILE_PATH)) {
+            create_log_file(LOG_FILE_PATH);
+        }
+        ESP_LOGE(TAG, "Migracao incompleta (%d amostras lidas): mantendo %s e %s, "
+                 "nova tentativa no proximo boot", migrados, LOG_V1_PATH, LEGACY_CSV_PATH);
+    }
+}
+
+/* Recupera first_n/last_n dos blocos e recarrega o bloco aberto */
+static void carregar_estado(void)
+{
+    tail_count = 0;
+    first_n = 0;
+    last_n = 0;
+
+    FILE *f = fopen(LOG_FILE_PATH, "rb");
+    if (f) {
+        reparar_final(f);
+        long size = file_size(f);
+        if (read_block_at(f, sizeof(log_file_header_t), NULL) > 0) {
+            first_n = block_recs[0].n;
+        }
+        int k = read_block_before(f, size, NULL);
+        if (k > 0) {
+            last_n = block_recs[k - 1].n;
+        }
+        fclose(f);
+    }
+
+    FILE *t = fopen(TAIL_FILE_PATH, "rb");
+    if (t) {
+        log_record_t rec;
+        while (tail_count < LOG_BLOCK_MAX_SAMPLES && fread(&rec, sizeof(rec), 1, t) == 1) {
+            /* Já comprimido (queda entre gravar o bloco e esvaziar o tail) */
+            if (last_n != 0 && rec.n <= last_n) {
+                continue;
+            }
+            tail_recs[tail_count++] = rec;
+            if (first_n == 0) first_n = rec.n;
+            last_n = rec.n;
+        }
+        fclose(t);
+    }
+
+    if (tail_count == LOG_BLOCK_MAX_SAMPLES) {
+        flush_tail_block();
+    }
+}
+
 /* ---------- API pública ---------- */
 
 esp_err_t data_logger_init(void)
@@ -130,39 +603,45 @@ esp_err_t data_logger_init(void)
     ESP_LOGI(TAG, "SPIFFS montado em %s", BSP_SPIFFS_MOUNT);
     ESP_LOGI(TAG, "Total=%d bytes, Usado=%d bytes", (int)total, (int)used);
 
-    /* criar ou recuperar log_temp.csv */
-    FILE *f = fopen(LOG_FILE_PATH, "r");
-    if (!f) {
+    /* Queda entre apagar log_data.bin e renomear log_new.bin: o novo tem tudo
+     * o que já foi migrado; o resto volta com a migração abaixo */
+    if (!existe(LOG_FILE_PATH) && existe(LOG_NEW_PATH)) {
+        rename(LOG_NEW_PATH, LOG_FILE_PATH);
+    }
+
+    /* criar, recuperar ou migrar log_data.bin */
+    FILE *f = fopen(LOG_FILE_PATH, "rb");
+    int version = f ? header_version(f) : 0;
+    if (f) fclose(f);
+
+    if (version == 1) {
+        rename(LOG_FILE_PATH, LOG_V1_PATH);
+    } else if (version != LOG_RECORD_VERSION && version != 0) {
+        ESP_LOGW(TAG, "Cabecalho invalido em %s, recriando", LOG_FILE_PATH);
+    }
+
+    if (version != LOG_RECORD_VERSION) {
         ESP_LOGI(TAG, "Criando novo %s", LOG_FILE_PATH);
-        f = fopen(LOG_FILE_PATH, "w");
-        if (!f) {
-            ESP_LOGE(TAG, "Nao consegui criar %s", LOG_FILE_PATH);
+        if (create_log_file(LOG_FILE_PATH) != ESP_OK) {
             return ESP_FAIL;
         }
-        fprintf(f,
-                "N,temp_ar_C,umid_ar_pct,temp_solo_C,umid_solo_pct,luminosidade_lux,dpv_kPa\n");
-        fclose(f);
-        linha_idx = 1;
-    } else {
-        char line[160];
-        fgets(line, sizeof(line), f); // header
-        int last_idx = 0;
-        while (fgets(line, sizeof(line), f)) {
-            int n_local;
-            float ta, ua, ts, us, lum, dpv;
-            // Tenta ler formato antigo (4 variáveis) ou novo (6 variáveis)
-            if (sscanf(line,
-                       "%d,%f,%f,%f,%f,%f,%f",
-                       &n_local, &ta, &ua, &ts, &us, &lum, &dpv) >= 5)
-            {
-                last_idx = n_local;
-            }
-        }
-        fclose(f);
-        linha_idx = last_idx + 1;
-        ESP_LOGI(TAG, "Proximo indice de log sera: %d", linha_idx);
+        FILE *t = fopen(TAIL_FILE_PATH, "wb");
+        if (t) fclose(t);
+    }
+
+    /* Fontes antigas ainda presentes: primeira migração ou uma anterior que
+     * falhou. Elas só são apagadas depois que log_data.bin tem tudo. */
+    legado_max_n = 0;
+    if (existe(LOG_V1_PATH) || existe(LEGACY_CSV_PATH)) {
+        migrar_legado();
     }
 
+    carregar_estado();
+    /* Após falha, amostras novas não reusam N que ainda está nas fontes antigas */
+    linha_idx = (int)((last_n > legado_max_n) ? last_n : legado_max_n) + 1;
+    ESP_LOGI(TAG, "%d registros (%d no bloco aberto), proximo indice de log sera: %d",
+             total_records(), tail_count, linha_idx);
+
     carregar_calibracao();
     // data_logger_dump_to_logcat(); // Removido: causa watchdog timer ao imprimir arquivos grandes
     ESP_LOGI(TAG, "Data logger inicializado. Proximo indice: %d", linha_idx);
@@ -214,49 +693,35 @@ bool data_logger_append(const log_entry_t *entry)
         return false;
     }
 
-    FILE *f = fopen(LOG_FILE_PATH, "a");
-    if (!f) {
-        ESP_LOGE(TAG, "Falha ao abrir %s para append", LOG_FILE_PATH);
-        xSemaphoreGive(file_mutex);
-        return false;
-    }
+    log_record_t rec;
+    log_record_encode((uint32_t)linha_idx, entry, &rec);
+    bool ok = push_record(&rec, true);
 
-    fprintf(f,
-            "%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f\n",
-            linha_idx,
-            entry->temp_ar,
-            entry->umid_ar,
-            entry->temp_solo,
-            entry->umid_solo,
-            entry->luminosidade,
-            entry->dpv);
-    fclose(f);
-
-    linha_idx++;
+    if (ok) {
+        linha_idx++;
+    } else {
+        ESP_LOGE(TAG, "Falha ao gravar registro %d", linha_idx);
+    }
     xSemaphoreGive(file_mutex);
-    return true;
+    return ok;
+}
+
+static esp_err_t dump_chunk_cb(const char *chunk, size_t len, void *ctx)
+{
+    (void)ctx;
+    ESP_LOGI(TAG, "%.*s", (int)len, chunk);
+    return ESP_OK;
 }
 
 void data_logger_dump_to_logcat(void)
 {
     ESP_LOGI(TAG, "--- Lendo %s ---", LOG_FILE_PATH);
-    FILE *f = fopen(LOG_FILE_PATH, "r");
-    if (!f) {
-        ESP_LOGW(TAG, "Nao consegui abrir %s", LOG_FILE_PATH);
-        return;
-    }
-
-    char line[160];
-    while (fgets(line, sizeof(line), f)) {
-        ESP_LOGI(TAG, "%s", line);
-    }
-
-    fclose(f);
+    data_logger_export_csv(dump_chunk_cb, NULL);
     ESP_LOGI(TAG, "--- Fim do arquivo ---");
 }
 
 /*
-   Retorna 6 séries independentes:
+   Retorna 7 séries independentes:
 
    {
      "temp_ar_points":   [ [idx, temp_ar_C], ... ],
@@ -264,7 +729,8 @@ void data_logger_dump_to_logcat(void)
      "temp_solo_points": [ [idx, temp_solo_C], ... ],
      "umid_solo_points": [ [idx, umid_solo_pct], ... ],
      "luminosidade_points": [ [idx, luminosidade_lux], ... ],
-     "dpv_points":       [ [idx, dpv_kPa], ... ]
+     "dpv_points":       [ [idx, dpv_kPa], ... ],
+     "orvalho_points":   [ [idx, ponto_orvalho_C], ... ]
    }
 
    Pegamos só os últimos max_samples pontos para não encher RAM.
@@ -279,8 +745,8 @@ char *data_logger_build_history_json(int max_samples)
     /* Valida e limita max_samples */
     if (max_samples <= 0) {
         max_samples = 10; // padrão
-    } else if (max_samples > 20) {
-        max_samples = 20; // máximo
+    } else if (max_samples > HISTORY_MAX_SAMPLES) {
+        max_samples = HISTORY_MAX_SAMPLES; // máximo
     }
 
     /* Protege acesso ao arquivo */
@@ -289,14 +755,9 @@ char *data_logger_build_history_json(int max_samples)
         return NULL;
     }
 
-    FILE *f = fopen(LOG_FILE_PATH, "r");
-    if (!f) {
-        xSemaphoreGive(file_mutex);
-        return NULL;
-    }
-
-    char line[160];
-    fgets(line, sizeof(line), f); // descarta header
+    log_record_t recs[HISTORY_MAX_SAMPLES];
+    int num = read_last_records(recs, max_samples);
+    xSemaphoreGive(file_mutex); /* Libera mutex após ler arquivo */
 
     /* Aloca arrays dinamicamente baseado em max_samples */
     int   *idx_arr = malloc(max_samples * sizeof(int));
@@ -306,9 +767,10 @@ char *data_logger_build_history_json(int max_samples)
     float *umid_solo_arr = malloc(max_samples * sizeof(float));
     float *luminosidade_arr = malloc(max_samples * sizeof(float));
     float *dpv_arr = malloc(max_samples * sizeof(float));
+    float *orvalho_arr = malloc(max_samples * sizeof(float));
     
     if (!idx_arr || !temp_ar_arr || !umid_ar_arr || !temp_solo_arr || 
-        !umid_solo_arr || !luminosidade_arr || !dpv_arr) {
+        !umid_solo_arr || !luminosidade_arr || !dpv_arr || !orvalho_arr) {
         ESP_LOGE(TAG, "Falha ao alocar memória para histórico");
         if (idx_arr) free(idx_arr);
         if (temp_ar_arr) free(temp_ar_arr);
@@ -317,41 +779,22 @@ char *data_logger_build_history_json(int max_samples)
         if (umid_solo_arr) free(umid_solo_arr);
         if (luminosidade_arr) free(luminosidade_arr);
         if (dpv_arr) free(dpv_arr);
-        fclose(f);
-        xSemaphoreGive(file_mutex);
+        if (orvalho_arr) free(orvalho_arr);
         return NULL;
     }
 
-    int count = 0;
-
-    while (fgets(line, sizeof(line), f)) {
-        int   n_local;
-        float ta, ua, ts, us, lum = NAN, dpv = NAN;
-        // Tenta ler formato novo (6 variáveis) ou antigo (4 variáveis)
-        int fields = sscanf(line,
-                           "%d,%f,%f,%f,%f,%f,%f",
-                           &n_local, &ta, &ua, &ts, &us, &lum, &dpv);
-        if (fields >= 5)  // Aceita formato antigo (4 variáveis) ou novo (6 variáveis)
-        {
-            int pos = count % max_samples;
-            idx_arr[pos]        = n_local;
-            temp_ar_arr[pos]    = ta;
-            umid_ar_arr[pos]    = ua;
-            temp_solo_arr[pos]  = ts;
-            umid_solo_arr[pos]  = us;
-            luminosidade_arr[pos] = (fields >= 6) ? lum : NAN;
-            dpv_arr[pos]        = (fields >= 7) ? dpv : NAN;
-            count++;
-        }
-    }
-    fclose(f);
-    xSemaphoreGive(file_mutex); /* Libera mutex após ler arquivo */
-
-    int start = 0;
-    int num   = count;
-    if (num > max_samples) {
-        start = count - max_samples;
-        num   = max_samples;
+    /* Conversão para float só na apresentação */
+    for (int k = 0; k < num; k++) {
+        log_entry_t e;
+        log_record_decode(&recs[k], &e);
+        idx_arr[k]          = (int)recs[k].n;
+        temp_ar_arr[k]      = e.temp_ar;
+        umid_ar_arr[k]      = e.umid_ar;
+        temp_solo_arr[k]    = e.temp_solo;
+        umid_solo_arr[k]    = e.umid_solo;
+        luminosidade_arr[k] = e.luminosidade;
+        dpv_arr[k]          = e.dpv;
+        orvalho_arr[k]      = e.ponto_orvalho;
     }
 
     cJSON *root              = cJSON_CreateObject();
@@ -361,9 +804,10 @@ char *data_logger_build_history_json(int max_samples)
     cJSON *umid_solo_points  = cJSON_CreateArray();
     cJSON *luminosidade_points = cJSON_CreateArray();
     cJSON *dpv_points       = cJSON_CreateArray();
+    cJSON *orvalho_points   = cJSON_CreateArray();
 
     for (int k = 0; k < num; k++) {
-        int pos = (start + k) % max_samples;
+        int pos = k;
 
         /* temp_ar_points: [idx, temp_ar] */
         if (isfinite(temp_ar_arr[pos])) {
@@ -412,6 +856,14 @@ char *data_logger_build_history_json(int max_samples)
             cJSON_AddItemToArray(p, cJSON_CreateNumber(dpv_arr[pos]));
             cJSON_AddItemToArray(dpv_points, p);
         }
+
+        /* orvalho_points: [idx, ponto_orvalho] */
+        if (isfinite(orvalho_arr[pos])) {
+            cJSON *p = cJSON_CreateArray();
+            cJSON_AddItemToArray(p, cJSON_CreateNumber(idx_arr[pos]));
+            cJSON_AddItemToArray(p, cJSON_CreateNumber(orvalho_arr[pos]));
+            cJSON_AddItemToArray(orvalho_points, p);
+        }
     }
 
     cJSON_AddItemToObject(root, "temp_ar_points",   temp_ar_points);
@@ -420,6 +872,7 @@ char *data_logger_build_history_json(int max_samples)
     cJSON_AddItemToObject(root, "umid_solo_points", umid_solo_points);
     cJSON_AddItemToObject(root, "luminosidade_points", luminosidade_points);
     cJSON_AddItemToObject(root, "dpv_points",       dpv_points);
+    cJSON_AddItemToObject(root, "orvalho_points",   orvalho_points);
 
     char *json_txt = cJSON_PrintUnformatted(root);
     
@@ -431,6 +884,7 @@ char *data_logger_build_history_json(int max_samples)
     free(umid_solo_arr);
     free(luminosidade_arr);
     free(dpv_arr);
+    free(orvalho_arr);
     
     if (json_txt == NULL) {
         ESP_LOGE(TAG, "Falha ao gerar JSON");
@@ -454,14 +908,13 @@ static void gui_stats_reset(gui_sensor_stats_t *stat)
     stat->has_data = false;
 }
 
+/* buffer em ordem cronológica (mais antiga primeiro) */
 static void gui_stats_compute(gui_sensor_stats_t *dest,
                               const float *buffer,
-                              int total_samples,
-                              int max_window,
                               int window_samples)
 {
     gui_stats_reset(dest);
-    if (!dest || !buffer || window_samples <= 0 || total_samples <= 0) {
+    if (!dest || !buffer || window_samples <= 0) {
         return;
     }
 
@@ -472,11 +925,8 @@ static void gui_stats_compute(gui_sensor_stats_t *dest,
     float  latest_value  = 0.0f;
     bool   latest_valid  = false;
 
-    int start_idx = (total_samples <= max_window) ? 0 : (total_samples % max_window);
-
     for (int i = 0; i < window_samples; ++i) {
-        int idx = (total_samples <= max_window) ? i : ((start_idx + i) % max_window);
-        float value = buffer[idx];
+        float value = buffer[i];
         if (!isfinite(value)) {
             continue;
         }
@@ -518,6 +968,7 @@ bool data_logger_get_recent_stats(int max_samples, gui_recent_stats_t *out)
     gui_stats_reset(&out->umid_solo);
     gui_stats_reset(&out->luminosidade);
     gui_stats_reset(&out->dpv);
+    gui_stats_reset(&out->ponto_orvalho);
 
     if (file_mutex == NULL) {
         ESP_LOGE(TAG, "Mutex nao inicializado para estatisticas");
@@ -530,6 +981,7 @@ bool data_logger_get_recent_stats(int max_samples, gui_recent_stats_t *out)
     float umid_solo_buf[RECENT_STATS_MAX_WINDOW] = {0};
     float luminosidade_buf[RECENT_STATS_MAX_WINDOW] = {0};
     float dpv_buf[RECENT_STATS_MAX_WINDOW] = {0};
+    float orvalho_buf[RECENT_STATS_MAX_WINDOW] = {0};
     int   total_samples = 0;
 
     if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
@@ -537,47 +989,37 @@ bool data_logger_get_recent_stats(int max_samples, gui_recent_stats_t *out)
         return false;
     }
 
-    FILE *f = fopen(LOG_FILE_PATH, "r");
-    if (f) {
-        char line[160];
-        /* descarta header se existir */
-        fgets(line, sizeof(line), f);
-
-        while (fgets(line, sizeof(line), f)) {
-            int   idx_local;
-            float ta, ua, ts, us, lum = NAN, dpv = NAN;
-            // Tenta ler formato novo (6 variáveis) ou antigo (4 variáveis)
-            int fields = sscanf(line, "%d,%f,%f,%f,%f,%f,%f",
-                       &idx_local, &ta, &ua, &ts, &us, &lum, &dpv);
-            if (fields >= 5) {  // Aceita formato antigo ou novo
-                int pos             = total_samples % max_samples;
-                temp_ar_buf[pos]    = ta;
-                umid_ar_buf[pos]    = ua;
-                temp_solo_buf[pos]  = ts;
-                umid_solo_buf[pos]  = us;
-                luminosidade_buf[pos] = (fields >= 6) ? lum : NAN;
-                dpv_buf[pos]        = (fields >= 7) ? dpv : NAN;
-                total_samples++;
-            }
-        }
-        fclose(f);
-    } else {
-        ESP_LOGW(TAG, "Nao consegui abrir %s para estatisticas", LOG_FILE_PATH);
-    }
+    log_record_t recs[RECENT_STATS_MAX_WINDOW];
+    int window_samples = 0;
+
+    window_samples = read_last_records(recs, max_samples);
+    total_samples  = total_records();
 
     xSemaphoreGive(file_mutex);
 
-    int window_samples = (total_samples < max_samples) ? total_samples : max_samples;
+    for (int i = 0; i < window_samples; i++) {
+        log_entry_t e;
+        log_record_decode(&recs[i], &e);
+        temp_ar_buf[i]      = e.temp_ar;
+        umid_ar_buf[i]      = e.umid_ar;
+        temp_solo_buf[i]    = e.temp_solo;
+        umid_solo_buf[i]    = e.umid_solo;
+        luminosidade_buf[i] = e.luminosidade;
+        dpv_buf[i]          = e.dpv;
+        orvalho_buf[i]      = e.ponto_orvalho;
+    }
+
     out->window_samples = window_samples;
     out->total_samples  = total_samples;
 
     if (window_samples > 0) {
-        gui_stats_compute(&out->temp_ar,   temp_ar_buf,   total_samples, max_samples, window_samples);
-        gui_stats_compute(&out->umid_ar,   umid_ar_buf,   total_samples, max_samples, window_samples);
-        gui_stats_compute(&out->temp_solo, temp_solo_buf, total_samples, max_samples, window_samples);
-        gui_stats_compute(&out->umid_solo, umid_solo_buf, total_samples, max_samples, window_samples);
-        gui_stats_compute(&out->luminosidade, luminosidade_buf, total_samples, max_samples, window_samples);
-        gui_stats_compute(&out->dpv,       dpv_buf,       total_samples, max_samples, window_samples);
+        gui_stats_compute(&out->temp_ar,   temp_ar_buf, window_samples);
+        gui_stats_compute(&out->umid_ar,   umid_ar_buf, window_samples);
+        gui_stats_compute(&out->temp_solo, temp_solo_buf, window_samples);
+        gui_stats_compute(&out->umid_solo, umid_solo_buf, window_samples);
+        gui_stats_compute(&out->luminosidade, luminosidade_buf, window_samples);
+        gui_stats_compute(&out->dpv,       dpv_buf, window_samples);
+        gui_stats_compute(&out->ponto_orvalho, orvalho_buf, window_samples);
     }
 
     size_t total_bytes = 0;
@@ -597,6 +1039,9 @@ bool data_logger_get_recent_stats(int max_samples, gui_recent_stats_t *out)
 esp_err_t data_logger_clear_all(void)
 {
     ESP_LOGI(TAG, "Limpando todos os dados armazenados...");
+
+    bool locked = (file_mutex != NULL) &&
+                  (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(2000)) == pdTRUE);
     
     /* Remove arquivo de log */
     if (remove(LOG_FILE_PATH) == 0) {
@@ -605,10 +1050,15 @@ esp_err_t data_logger_clear_all(void)
         ESP_LOGW(TAG, "Nao foi possivel remover %s (pode nao existir)", LOG_FILE_PATH);
     }
     /* Recria arquivo com header padrão para manter histórico funcionando */
-    FILE *f = fopen(LOG_FILE_PATH, "w");
-    if (f) {
-        fprintf(f, "N,temp_ar_C,umid_ar_pct,temp_solo_C,umid_solo_pct,luminosidade_lux,dpv_kPa\n");
-        fclose(f);
+    remove(LEGACY_CSV_PATH);
+    remove(LOG_V1_PATH);
+    remove(LOG_NEW_PATH);
+    FILE *t = fopen(TAIL_FILE_PATH, "wb");
+    if (t) fclose(t);
+    tail_count = 0;
+    first_n = 0;
+    last_n = 0;
+    if (create_log_file(LOG_FILE_PATH) == ESP_OK) {
         ESP_LOGI(TAG, "Arquivo %s recriado com header", LOG_FILE_PATH);
     } else {
         ESP_LOGE(TAG, "Falha ao recriar %s apos limpeza", LOG_FILE_PATH);
@@ -625,8 +1075,82 @@ esp_err_t data_logger_clear_all(void)
     linha_idx = 1;
     calib_seco = 4000.0f;
     calib_molhado = 400.0f;
+
+    if (locked) {
+        xSemaphoreGive(file_mutex);
+    }
     
     ESP_LOGI(TAG, "Dados limpos. Sistema reiniciado do zero.");
     return ESP_OK;
 }
 
+esp_err_t data_logger_export_csv(data_logger_chunk_cb_t cb, void *ctx)
+{
+    if (cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (file_mutex == NULL) {
+        ESP_LOGE(TAG, "Mutex nao inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = cb(LOG_RECORD_CSV_HEADER, strlen(LOG_RECORD_CSV_HEADER), ctx);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    char *buf = malloc(LOG_BLOCK_MAX_SAMPLES * LOG_RECORD_CSV_MAX);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    log_record_t *recs = malloc(LOG_BLOCK_MAX_SAMPLES * sizeof(log_record_t));
+    if (recs == NULL) {
+        free(buf);
+        return ESP_ERR_NO_MEM;
+    }
+
+    long offset = sizeof(log_file_header_t);
+    bool fim = false;
+
+    while (err == ESP_OK && !fim) {
+        /* Mutex só durante a leitura do bloco: cliente lento não trava o append */
+        if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
+            ESP_LOGE(TAG, "Timeout ao obter mutex para exportacao");
+            err = ESP_ERR_TIMEOUT;
+            break;
+        }
+        int n = -1;
+        FILE *f = fopen(LOG_FILE_PATH, "rb");
+        if (f) {
+            long end;
+            n = read_block_at(f, offset, &end);
+            if (n > 0) {
+                memcpy(recs, block_recs, (size_t)n * sizeof(log_record_t));
+                offset = end;
+            }
+            fclose(f);
+        }
+        if (n <= 0) {
+            /* Depois do último bloco vem o bloco aberto */
+            n = tail_count;
+            memcpy(recs, tail_recs, (size_t)n * sizeof(log_record_t));
+            fim = true;
+        }
+        xSemaphoreGive(file_mutex);
+
+        if (n == 0) {
+            break;
+        }
+
+        size_t len = 0;
+        for (int i = 0; i < n; i++) {
+            len += log_record_format_csv(&recs[i], buf + len, LOG_RECORD_CSV_MAX);
+        }
+        err = cb(buf, len, ctx);
+    }
+
+    free(recs);
+    free(buf);
+    return err;
+}
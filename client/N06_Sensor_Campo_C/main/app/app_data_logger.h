@@ -1,11 +1,13 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
 
 typedef struct gui_recent_stats gui_recent_stats_t;
 
-/* Estrutura de uma amostra registrada no CSV */
+/* Amostra em unidades de engenharia; no arquivo vira log_record_t
+ * (ponto fixo, ver app_log_record.h) */
 typedef struct {
     float temp_ar;     /* °C ar */
     float umid_ar;     /* % ar */
@@ -13,28 +15,31 @@ typedef struct {
     float umid_solo;   /* % solo convertida via calibração */
     float luminosidade; /* lux (intensidade de luminosidade) */
     float dpv;         /* kPa (Déficit de Pressão de Vapor) */
+    float ponto_orvalho; /* °C (Ponto de orvalho) */
 } log_entry_t;
 
-/* Inicializa SPIFFS, carrega/calibra solo, prepara/analisa log_temp.csv.
+/* Inicializa SPIFFS, carrega/calibra solo, prepara/analisa log_data.bin.
  * - Monta /spiffs com label "spiffs".
- * - Cria cabeçalho CSV se não existir.
- * - Lê último índice N.
+ * - Migra log_temp.csv / log_data.bin v1 de versões anteriores, se existirem;
+ *   se a migração falhar, as fontes ficam e ela é refeita no próximo boot.
+ * - Cria cabeçalho binário se não existir.
+ * - Lê último índice N (último registro).
  * Retorna ESP_OK em caso de sucesso.
  */
 esp_err_t data_logger_init(void);
 
-/* Acrescenta uma linha (N, temp_ar, umid_ar, temp_solo, umid_solo) no CSV
+/* Acrescenta um registro de ponto fixo (18 bytes) em log_data.bin
  * e autoincrementa N interno.
  * Retorna true em caso de sucesso.
  */
 bool data_logger_append(const log_entry_t *entry);
 
-/* Imprime no log (ESP_LOGI) todo o conteúdo atual de /spiffs/log_temp.csv.
+/* Imprime no log (ESP_LOGI) todo o log, formatado como CSV.
  * Usado apenas para debug no boot.
  */
 void data_logger_dump_to_logcat(void);
 
-/* Lê /spiffs/log_temp.csv e constrói um JSON compacto com os últimos pontos.
+/* Lê os últimos registros de log_data.bin e constrói um JSON compacto com os últimos pontos.
  * Formato:
  * {
  *   "temp_ar_points":   [ [idx, temp_ar_C], ... ],
@@ -42,7 +47,8 @@ void data_logger_dump_to_logcat(void);
  *   "temp_solo_points": [ [idx, temp_solo_C], ... ],
  *   "umid_solo_points": [ [idx, umid_solo_pct], ... ],
  *   "luminosidade_points": [ [idx, luminosidade_lux], ... ],
- *   "dpv_points":       [ [idx, dpv_kPa], ... ]
+ *   "dpv_points":       [ [idx, dpv_kPa], ... ],
+ *   "orvalho_points":   [ [idx, ponto_orvalho_C], ... ]
  * }
  *
  * @param max_samples Número máximo de amostras a retornar (5, 10, 15 ou 20)
@@ -74,7 +80,7 @@ void data_logger_get_calibracao(float *seco, float *molhado);
 esp_err_t data_logger_set_calibracao(float seco, float molhado);
 
 /* Apaga todos os dados armazenados (log CSV e calibração) e reinicia do zero.
- * - Remove /spiffs/log_temp.csv
+ * - Recria /spiffs/log_data.bin vazio
  * - Remove /spiffs/soil_calib.json
  * - Reseta índice de linha para 1
  * - Reseta calibração para valores padrão
@@ -82,3 +88,11 @@ esp_err_t data_logger_set_calibracao(float seco, float molhado);
  */
 esp_err_t data_logger_clear_all(void);
 
+/* Callback que recebe pedaços do CSV exportado */
+typedef esp_err_t (*data_logger_chunk_cb_t)(const char *chunk, size_t len, void *ctx);
+
+/* Exporta o log completo como CSV (mesmo formato do antigo log_temp.csv),
+ * em blocos, convertendo os registros só na saída.
+ * Retorna o primeiro erro devolvido por cb, ou ESP_OK.
+ */
+esp_err_t data_logger_export_csv(data_logger_chunk_cb_t cb, void *ctx);
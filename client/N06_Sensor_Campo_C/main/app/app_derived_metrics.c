@@ -0,0 +1,264 @@
+#include "app_derived_metrics.h"
+
+#include <string.h>
+#include <math.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "APP_DERIVED";
+
+#define MS_PER_DAY       (24U * 60U * 60U * 1000U)
+
+/* Constantes de Magnus (mesmas do cálculo original de DPV) */
+#define MAGNUS_A         17.27f
+#define MAGNUS_B         237.3f
+#define MAGNUS_ES0_KPA   0.6108f
+
+/* Formato persistido no NVS (namespace "appcfg", chave "derived") */
+typedef struct {
+    derived_metrics_t metrics;
+    uint32_t day_elapsed_ms;
+} derived_persist_t;
+
+static derived_persist_t state;
+static uint32_t ms_since_save = 0;
+static SemaphoreHandle_t state_mutex = NULL;
+
+/* ---------- aproximações rápidas ---------- */
+
+typedef union {
+    float    f;
+    int32_t  i;
+} float_bits_t;
+
+float derived_fast_expf(float x)
+{
+    if (x > 88.0f)  return INFINITY;
+    if (x < -87.0f) return 0.0f;
+
+    /* e^x = 2^n * 2^f, com n inteiro mais próximo e f em [-0.5, 0.5] */
+    float y = x * 1.44269504f;
+    int32_t n = (int32_t)(y + (y >= 0.0f ? 0.5f : -0.5f));
+    float f = y - (float)n;
+
+    /* 2^f por polinômio de grau 6 (Horner) */
+    float p = 1.0f + f * (0.693147181f
+                + f * (0.240226507f
+                + f * (0.0555041087f
+                + f * (0.00961812911f
+                + f * (0.00133335581f
+                + f * 0.000154035304f)))));
+
+    float_bits_t scale;
+    scale.i = (n + 127) << 23;
+    return p * scale.f;
+}
+
+float derived_fast_logf(float x)
+{
+    if (!(x > 0.0f)) return NAN;
+
+    float_bits_t bits = { .f = x };
+    int32_t e = ((bits.i >> 23) & 0xFF) - 127;
+    bits.i = (bits.i & 0x007FFFFF) | 0x3F800000;
+    float m = bits.f;  /* [1, 2) */
+    if (m > 1.41421356f) {
+        m *= 0.5f;
+        e++;
+    }
+
+    /* ln(m) = 2*atanh(s), s = (m-1)/(m+1), |s| <= 0.172 */
+    float s  = (m - 1.0f) / (m + 1.0f);
+    float s2 = s * s;
+    float ln_m = 2.0f * s * (1.0f + s2 * (0.333333333f
+                          + s2 * (0.2f
+                          + s2 * (0.142857143f
+                          + s2 * 0.111111111f))));
+
+    return (float)e * 0.693147181f + ln_m;
+}
+
+/* ---------- métricas instantâneas ---------- */
+
+static bool air_valid(float temp_c, float humid_pct)
+{
+    return !(isnan(temp_c) || isnan(humid_pct) ||
+             temp_c < -50.0f || temp_c > 60.0f ||
+             humid_pct < 0.0f || humid_pct > 100.0f);
+}
+
+/**
+ * DPV = es - ea, com es = 0.6108 * exp(17.27 * T / (T + 237.3)) e
+ * ea = es * (UR / 100).
+ */
+float derived_metrics_vpd(float temp_c, float humid_pct)
+{
+    if (!air_valid(temp_c, humid_pct)) {
+        return NAN;
+    }
+
+    float es = MAGNUS_ES0_KPA * derived_fast_expf(MAGNUS_A * temp_c / (temp_c + MAGNUS_B));
+    return es * (1.0f - humid_pct / 100.0f);
+}
+
+/**
+ * Td = B * g / (A - g), com g = ln(UR / 100) + A * T / (B + T).
+ */
+float derived_metrics_dew_point(float temp_c, float humid_pct)
+{
+    if (!air_valid(temp_c, humid_pct) || humid_pct <= 0.0f) {
+        return NAN;
+    }
+
+    float g = derived_fast_logf(humid_pct / 100.0f) + MAGNUS_A * temp_c / (MAGNUS_B + temp_c);
+    return MAGNUS_B * g / (MAGNUS_A - g);
+}
+
+/* ---------- acumuladores diários ---------- */
+
+static esp_err_t save_state(const derived_persist_t *snapshot)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("appcfg", NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erro abrindo NVS para salvar acumuladores (%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(handle, "derived", snapshot, sizeof(*snapshot));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erro salvando acumuladores (%s)", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t derived_metrics_init(void)
+{
+    if (state_mutex == NULL) {
+        state_mutex = xSemaphoreCreateMutex();
+        if (state_mutex == NULL) {
+            ESP_LOGE(TAG, "Falha ao criar mutex");
+            return ESP_FAIL;
+        }
+    }
+
+    memset(&state, 0, sizeof(state));
+    ms_since_save = 0;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("appcfg", NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS open falhou (%s), acumuladores zerados", esp_err_to_name(err));
+        return err;
+    }
+
+    size_t required_size = sizeof(state);
+    err = nvs_get_blob(handle, "derived", &state, &required_size);
+    if (err == ESP_OK && required_size == sizeof(state)) {
+        ESP_LOGI(TAG, "Acumuladores restaurados: GDD hoje=%.2f, DLI hoje=%.2f, dias=%lu",
+                 state.metrics.gdd_hoje, state.metrics.dli_hoje,
+                 (unsigned long)state.metrics.dias);
+    } else {
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "Valor inválido ou erro lendo derived (%s)", esp_err_to_name(err));
+        } else {
+            ESP_LOGI(TAG, "Nenhum acumulador salvo. Iniciando do zero");
+        }
+        memset(&state, 0, sizeof(state));
+    }
+    nvs_close(handle);
+    return ESP_OK;
+}
+
+void derived_metrics_update(float temp_c, float lux, uint32_t dt_ms)
+{
+    if (state_mutex == NULL || dt_ms == 0) {
+        return;
+    }
+
+    derived_persist_t snapshot;
+    bool save_now = false;
+
+    xSemaphoreTake(state_mutex, portMAX_DELAY);
+
+    /* GDD por integração: (T - Tbase) ponderado pela fração de dia */
+    if (isfinite(temp_c) && temp_c > DERIVED_GDD_BASE_C) {
+        float inc = (temp_c - DERIVED_GDD_BASE_C) * ((float)dt_ms / (float)MS_PER_DAY);
+        state.metrics.gdd_hoje  += inc;
+        state.metrics.gdd_total += inc;
+    }
+
+    /* DLI: PPFD (µmol/m²/s) * tempo (s) / 1e6 */
+    if (isfinite(lux) && lux > 0.0f) {
+        state.metrics.dli_hoje += lux * DERIVED_LUX_TO_PPFD * (float)dt_ms * 1e-9f;
+    }
+
+    /* Sem RTC no modo AP: o dia é contado em tempo de amostragem acumulado */
+    state.day_elapsed_ms += dt_ms;
+    ms_since_save += dt_ms;
+    if (state.day_elapsed_ms >= MS_PER_DAY) {
+        state.day_elapsed_ms %= MS_PER_DAY;
+        state.metrics.gdd_ontem = state.metrics.gdd_hoje;
+        state.metrics.dli_ontem = state.metrics.dli_hoje;
+        state.metrics.gdd_hoje = 0.0f;
+        state.metrics.dli_hoje = 0.0f;
+        state.metrics.dias++;
+        save_now = true;
+        ESP_LOGI(TAG, "Dia fechado: GDD=%.2f DLI=%.2f mol/m2",
+                 state.metrics.gdd_ontem, state.metrics.dli_ontem);
+    }
+
+    if (ms_since_save >= DERIVED_SAVE_INTERVAL_MS) {
+        save_now = true;
+    }
+    if (save_now) {
+        ms_since_save = 0;
+        snapshot = state;
+    }
+
+    xSemaphoreGive(state_mutex);
+
+    if (save_now) {
+        save_state(&snapshot);
+    }
+}
+
+void derived_metrics_get(derived_metrics_t *out)
+{
+    if (out == NULL) return;
+
+    if (state_mutex == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+
+    xSemaphoreTake(state_mutex, portMAX_DELAY);
+    *out = state.metrics;
+    xSemaphoreGive(state_mutex);
+}
+
+esp_err_t derived_metrics_reset(void)
+{
+    derived_persist_t snapshot;
+
+    if (state_mutex != NULL) {
+        xSemaphoreTake(state_mutex, portMAX_DELAY);
+    }
+    memset(&state, 0, sizeof(state));
+    ms_since_save = 0;
+    snapshot = state;
+    if (state_mutex != NULL) {
+        xSemaphoreGive(state_mutex);
+    }
+
+    ESP_LOGI(TAG, "Acumuladores zerados");
+    return save_state(&snapshot);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Temperatura base para graus-dia de crescimento (°C) */
+#define DERIVED_GDD_BASE_C         10.0f
+/* Conversão lux -> PPFD (µmol/m²/s) para luz solar */
+#define DERIVED_LUX_TO_PPFD        0.0185f
+/* Intervalo mínimo entre gravações dos acumuladores no NVS */
+#define DERIVED_SAVE_INTERVAL_MS   (30U * 60U * 1000U)
+
+/* Acumuladores diários e do ciclo */
+typedef struct {
+    float gdd_hoje;        /* °C·dia acumulados no dia corrente */
+    float dli_hoje;        /* mol/m²/dia acumulados no dia corrente */
+    float gdd_ontem;       /* GDD do último dia completo */
+    float dli_ontem;       /* DLI do último dia completo */
+    float gdd_total;       /* GDD acumulado desde a última limpeza */
+    uint32_t dias;         /* dias completos desde a última limpeza */
+} derived_metrics_t;
+
+/**
+ * @brief Inicializa o módulo e restaura acumuladores do NVS.
+ *
+ * Deve ser chamado após nvs_flash_init().
+ */
+esp_err_t derived_metrics_init(void);
+
+/**
+ * @brief Déficit de Pressão de Vapor (kPa) via Magnus com exp rápida.
+ * @return DPV em kPa, ou NAN se dados inválidos
+ */
+float derived_metrics_vpd(float temp_c, float humid_pct);
+
+/**
+ * @brief Ponto de orvalho (°C) via Magnus com exp/log rápidas.
+ * @return Ponto de orvalho em °C, ou NAN se dados inválidos
+ */
+float derived_metrics_dew_point(float temp_c, float humid_pct);
+
+/**
+ * @brief Integra GDD e DLI com uma nova amostra em tempo constante.
+ *
+ * Fecha o dia a cada 24 h de amostragem acumulada e persiste
+ * os acumuladores no NVS no máximo a cada DERIVED_SAVE_INTERVAL_MS.
+ *
+ * @param temp_c   Temperatura do ar (°C), NAN ignora GDD
+ * @param lux      Luminosidade (lux), NAN ignora DLI
+ * @param dt_ms    Tempo representado pela amostra (ms)
+ */
+void derived_metrics_update(float temp_c, float lux, uint32_t dt_ms);
+
+/**
+ * @brief Copia os acumuladores atuais.
+ */
+void derived_metrics_get(derived_metrics_t *out);
+
+/**
+ * @brief Zera acumuladores em RAM e no NVS.
+ */
+esp_err_t derived_metrics_reset(void);
+
+/**
+ * @brief exp(x) rápida; erro relativo < 5e-6 para |x| < 80.
+ */
+float derived_fast_expf(float x);
+
+/**
+ * @brief ln(x) rápida; erro absoluto < 2e-6 para x normal positivo.
+ */
+float derived_fast_logf(float x);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,323 @@
+#include "app_host_profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <math.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "app_data_logger.h"
+#include "app_log_record.h"
+#include "app_log_block.h"
+#include "app_stats_window.h"
+#include "app_derived_metrics.h"
+#include "gui_services.h"
+#include "../bsp/board.h"
+
+static const char *TAG = "APP_HOST_PROFILE";
+
+#define MS_PER_DAY   (24.0 * 60.0 * 60.0 * 1000.0)
+
+static SemaphoreHandle_t prof_mutex = NULL;
+static uint32_t samples = 0;
+static uint64_t simulated_ms = 0;
+static int64_t  append_total_us = 0;
+static int64_t  append_max_us = 0;
+
+esp_err_t host_profile_init(void)
+{
+    if (prof_mutex == NULL) {
+        prof_mutex = xSemaphoreCreateMutex();
+        if (prof_mutex == NULL) {
+            ESP_LOGE(TAG, "Falha ao criar mutex");
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+void host_profile_note_append(int64_t append_us, uint32_t dt_ms)
+{
+    if (prof_mutex == NULL) return;
+
+    xSemaphoreTake(prof_mutex, portMAX_DELAY);
+    samples++;
+    simulated_ms += dt_ms;
+    append_total_us += append_us;
+    if (append_us > append_max_us) {
+        append_max_us = append_us;
+    }
+    xSemaphoreGive(prof_mutex);
+}
+
+static size_t heap_in_use(void)
+{
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks;
+}
+
+static uint32_t replay_sample_limit(void)
+{
+    const char *env = getenv("N06_REPLAY_SAMPLES");
+    if (env == NULL || *env == '\0') {
+        return BSP_REPLAY_SAMPLES_DEFAULT;
+    }
+    return (uint32_t)strtoul(env, NULL, 10);
+}
+
+/* Compara o formato texto anterior (printf/sscanf de float) com o registro
+ * de ponto fixo: custo por amostra para gravar/ler e bytes por amostra. */
+#define BENCH_RECORDS  20000
+
+static void bench_record_format(void)
+{
+    log_entry_t *entries = malloc(BENCH_RECORDS * sizeof(log_entry_t));
+    log_record_t *recs = malloc(BENCH_RECORDS * sizeof(log_record_t));
+    char *text = malloc((size_t)BENCH_RECORDS * LOG_RECORD_CSV_MAX);
+    if (entries == NULL || recs == NULL || text == NULL) {
+        free(entries);
+        free(recs);
+        free(text);
+        return;
+    }
+
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        float ph = (float)i * 0.01f;
+        entries[i].temp_ar       = 22.0f + 6.0f * sinf(ph);
+        entries[i].umid_ar       = 65.0f - 15.0f * sinf(ph);
+        entries[i].temp_solo     = 20.0f + 2.0f * sinf(ph * 0.5f);
+        entries[i].umid_solo     = 40.0f + (float)(i % 7);
+        entries[i].luminosidade  = 20000.0f * fmaxf(0.0f, sinf(ph * 0.3f));
+        entries[i].dpv           = 1.1f + 0.5f * sinf(ph);
+        entries[i].ponto_orvalho = 14.0f + sinf(ph);
+    }
+
+    char line[LOG_RECORD_CSV_MAX];
+    size_t text_bytes = 0;
+    volatile float sink = 0.0f;
+
+    /* Cada linha vai para o buffer como iria para o arquivo; a leitura
+     * percorre as linhas em ordem, uma por registro */
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        const log_entry_t *e = &entries[i];
+        text_bytes += snprintf(text + text_bytes, LOG_RECORD_CSV_MAX, "%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f,%.2f\n",
+                               i + 1, e->temp_ar, e->umid_ar, e->temp_solo, e->umid_solo,
+                               e->luminosidade, e->dpv, e->ponto_orvalho);
+    }
+    int64_t text_enc_us = esp_timer_get_time() - t0;
+
+    int text_ok = 0;
+    const char *p = text;
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_RECORDS && p != NULL; i++) {
+        int n;
+        float ta = 0.0f, ua, ts, us, lum, dpv, orv;
+        if (sscanf(p, "%d,%f,%f,%f,%f,%f,%f,%f", &n, &ta, &ua, &ts, &us, &lum, &dpv, &orv) == 8 && n == i + 1) {
+            text_ok++;
+        }
+        sink += ta;
+        p = strchr(p, '\n');
+        p = p ? p + 1 : NULL;
+    }
+    int64_t text_dec_us = esp_timer_get_time() - t0;
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        log_record_encode((uint32_t)i + 1, &entries[i], &recs[i]);
+    }
+    int64_t rec_enc_us = esp_timer_get_time() - t0;
+
+    float err_temp = 0.0f, err_lux_rel = 0.0f;
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        log_entry_t e;
+        log_record_decode(&recs[i], &e);
+        sink += e.temp_ar;
+    }
+    int64_t rec_dec_us = esp_timer_get_time() - t0;
+
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        log_entry_t e;
+        log_record_decode(&recs[i], &e);
+        err_temp = fmaxf(err_temp, fabsf(e.temp_ar - entries[i].temp_ar));
+        if (entries[i].luminosidade > 1.0f) {
+            err_lux_rel = fmaxf(err_lux_rel,
+                                fabsf(e.luminosidade - entries[i].luminosidade) / entries[i].luminosidade);
+        }
+    }
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        log_record_format_csv(&recs[i], line, sizeof(line));
+    }
+    int64_t rec_csv_us = esp_timer_get_time() - t0;
+    (void)sink;
+
+    ESP_LOGI(TAG, "Bench %d amostras | texto: %.1f B, grava %.3f us, le %.3f us (%d linhas lidas)",
+             BENCH_RECORDS, (double)text_bytes / BENCH_RECORDS,
+             (double)text_enc_us / BENCH_RECORDS, (double)text_dec_us / BENCH_RECORDS, text_ok);
+    ESP_LOGI(TAG, "Bench registro: %u B, grava %.3f us, le %.3f us, CSV %.3f us | "
+             "erro max temp %.4f C, lux %.3f %%",
+             (unsigned)sizeof(log_record_t),
+             (double)rec_enc_us / BENCH_RECORDS, (double)rec_dec_us / BENCH_RECORDS,
+             (double)rec_csv_us / BENCH_RECORDS, err_temp, err_lux_rel * 100.0f);
+
+    free(entries);
+    free(recs);
+    free(text);
+}
+
+/* Compressão em blocos sobre o trace real do replay: bytes por amostra
+ * (CSV, registro, bloco) e vazão de decodificação. */
+#define BENCH_BLOCK_MAX_ROWS  50000
+
+static void bench_block_compression(void)
+{
+    const char *path = getenv("N06_REPLAY_CSV");
+    if (path == NULL || path[0] == '\0') {
+        path = BSP_REPLAY_CSV_DEFAULT;
+    }
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return;
+    }
+
+    log_record_t *recs = malloc(BENCH_BLOCK_MAX_ROWS * sizeof(log_record_t));
+    uint8_t *blocks = malloc((BENCH_BLOCK_MAX_ROWS / LOG_BLOCK_MAX_SAMPLES + 1) * LOG_BLOCK_MAX_BYTES);
+    if (recs == NULL || blocks == NULL) {
+        free(recs);
+        free(blocks);
+        fclose(f);
+        return;
+    }
+
+    char line[192];
+    size_t csv_bytes = 0;
+    int rows = 0;
+    while (rows < BENCH_BLOCK_MAX_ROWS && fgets(line, sizeof(line), f)) {
+        int n;
+        log_entry_t e = { .luminosidade = NAN, .dpv = NAN, .ponto_orvalho = NAN };
+        if (sscanf(line, "%d,%f,%f,%f,%f,%f,%f,%f", &n, &e.temp_ar, &e.umid_ar, &e.temp_solo,
+                   &e.umid_solo, &e.luminosidade, &e.dpv, &e.ponto_orvalho) < 5) {
+            continue;
+        }
+        csv_bytes += strlen(line);
+        log_record_encode((uint32_t)n, &e, &recs[rows++]);
+    }
+    fclose(f);
+
+    size_t blk_bytes = 0;
+    int nblocks = 0;
+    for (int i = 0; i < rows; i += LOG_BLOCK_MAX_SAMPLES) {
+        int count = (rows - i < LOG_BLOCK_MAX_SAMPLES) ? rows - i : LOG_BLOCK_MAX_SAMPLES;
+        blk_bytes += log_block_encode(&recs[i], count, blocks + blk_bytes, LOG_BLOCK_MAX_BYTES);
+        nblocks++;
+    }
+
+    log_record_t out[LOG_BLOCK_MAX_SAMPLES];
+    int decoded = 0;
+    bool iguais = true;
+    int64_t t0 = esp_timer_get_time();
+    for (size_t pos = 0; pos < blk_bytes; ) {
+        const log_block_header_t *hdr = (const log_block_header_t *)(blocks + pos);
+        size_t len = log_block_size(hdr);
+        int k = log_block_decode(blocks + pos, len, out);
+        if (k <= 0) {
+            iguais = false;
+            break;
+        }
+        iguais = iguais && memcmp(out, &recs[decoded], (size_t)k * sizeof(log_record_t)) == 0;
+        decoded += k;
+        pos += len;
+    }
+    int64_t dec_us = esp_timer_get_time() - t0;
+
+    if (rows > 0) {
+        ESP_LOGI(TAG, "Bench blocos (%s, %d amostras, %d blocos): CSV %.1f B, registro %u B, "
+                 "bloco %.2f B/amostra (%.1fx CSV) | decodifica %.1f Mamostras/s | %s",
+                 path, rows, nblocks, (double)csv_bytes / rows, (unsigned)sizeof(log_record_t),
+                 (double)blk_bytes / rows, (double)csv_bytes / (double)blk_bytes,
+                 dec_us > 0 ? (double)decoded / (double)dec_us : 0.0,
+                 (iguais && decoded == rows) ? "sem perdas" : "DIVERGENTE");
+    }
+
+    free(recs);
+    free(blocks);
+}
+
+void host_profile_task(void *pvParameter)
+{
+    (void)pvParameter;
+
+    uint32_t limite = replay_sample_limit();
+    size_t heap_inicial = heap_in_use();
+    size_t heap_pico = heap_inicial;
+    int64_t json_max_us = 0;
+    int64_t stats_max_us = 0;
+
+    bench_record_format();
+    bench_block_compression();
+
+    ESP_LOGI(TAG, "Replay x%u, limite de %lu amostras (0 = sem limite)",
+             (unsigned)BSP_TIME_SCALE, (unsigned long)limite);
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(HOST_PROFILE_REPORT_MS));
+
+        /* Mesmo trabalho feito pelas páginas / e /history */
+        int janela = stats_window_get_count();
+        int64_t t0 = esp_timer_get_time();
+        char *json = data_logger_build_history_json(janela);
+        int64_t json_us = esp_timer_get_time() - t0;
+        size_t json_len = json ? strlen(json) : 0;
+        size_t heap_agora = heap_in_use();
+        free(json);
+
+        gui_recent_stats_t stats;
+        t0 = esp_timer_get_time();
+        data_logger_get_recent_stats(janela, &stats);
+        int64_t stats_us = esp_timer_get_time() - t0;
+
+        if (json_us > json_max_us)   json_max_us = json_us;
+        if (stats_us > stats_max_us) stats_max_us = stats_us;
+        if (heap_agora > heap_pico)  heap_pico = heap_agora;
+
+        uint32_t n;
+        uint64_t sim_ms;
+        int64_t total_us, max_us;
+        xSemaphoreTake(prof_mutex, portMAX_DELAY);
+        n = samples;
+        sim_ms = simulated_ms;
+        total_us = append_total_us;
+        max_us = append_max_us;
+        xSemaphoreGive(prof_mutex);
+
+        derived_metrics_t dm;
+        derived_metrics_get(&dm);
+
+        ESP_LOGI(TAG,
+                 "amostras=%lu dias=%.2f | append med=%lld us max=%lld us | "
+                 "historico(%d)=%lld us (max %lld) %u B | stats=%lld us (max %lld) | "
+                 "heap=%u B (pico %u) | GDD=%.1f",
+                 (unsigned long)n, (double)sim_ms / MS_PER_DAY,
+                 (long long)(n ? total_us / n : 0), (long long)max_us,
+                 janela, (long long)json_us, (long long)json_max_us, (unsigned)json_len,
+                 (long long)stats_us, (long long)stats_max_us,
+                 (unsigned)heap_agora, (unsigned)heap_pico, dm.gdd_total);
+
+        if (limite > 0 && n >= limite) {
+            ESP_LOGI(TAG, "Replay concluído: %lu amostras, %.2f dias simulados, heap pico %+ld B",
+                     (unsigned long)n, (double)sim_ms / MS_PER_DAY,
+                     (long)heap_pico - (long)heap_inicial);
+            fflush(stdout);
+            exit(0);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Intervalo (tempo real) entre relatórios de perfil no host */
+#define HOST_PROFILE_REPORT_MS   1000U
+
+/**
+ * @brief Cria o mutex dos contadores; chamar antes de criar as tarefas.
+ */
+esp_err_t host_profile_init(void);
+
+/**
+ * @brief Contabiliza uma gravação simulada e o tempo gasto em data_logger_append.
+ * @param append_us Duração do append (µs)
+ * @param dt_ms     Tempo de amostragem representado pela linha (ms)
+ */
+void host_profile_note_append(int64_t append_us, uint32_t dt_ms);
+
+/**
+ * @brief Tarefa de perfil (target linux).
+ *
+ * A cada HOST_PROFILE_REPORT_MS mede a geração do histórico JSON e das
+ * estatísticas recentes (dados das páginas web), reporta heap e dias
+ * simulados, e encerra o processo após N06_REPLAY_SAMPLES gravações
+ * (0 = sem limite).
+ */
+void host_profile_task(void *pvParameter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,234 @@
+#include "app_log_block.h"
+
+#include <string.h>
+
+/* ---------- acesso aos canais como inteiros ---------- */
+
+static int32_t field_get(const log_record_t *r, int ch)
+{
+    switch (ch) {
+        case 1:  return r->temp_ar;
+        case 2:  return r->umid_ar;
+        case 3:  return r->temp_solo;
+        case 4:  return r->umid_solo;
+        case 5:  return r->luminosidade;
+        case 6:  return r->dpv;
+        default: return r->ponto_orvalho;
+    }
+}
+
+static void field_set(log_record_t *r, int ch, int32_t v)
+{
+    switch (ch) {
+        case 1:  r->temp_ar       = (int16_t)v;  break;
+        case 2:  r->umid_ar       = (uint16_t)v; break;
+        case 3:  r->temp_solo     = (int16_t)v;  break;
+        case 4:  r->umid_solo     = (uint16_t)v; break;
+        case 5:  r->luminosidade  = (uint16_t)v; break;
+        case 6:  r->dpv           = (uint16_t)v; break;
+        default: r->ponto_orvalho = (int16_t)v;  break;
+    }
+}
+
+static uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static uint8_t bit_width(uint64_t v)
+{
+    uint8_t w = 0;
+    while (v) {
+        w++;
+        v >>= 1;
+    }
+    return w;
+}
+
+/* Delta do canal ch da amostra i (i >= 1); canal 0 usa delta-de-delta de N */
+static uint64_t channel_delta(const log_record_t *recs, int i, int ch)
+{
+    if (ch == 0) {
+        int64_t d      = (int64_t)recs[i].n - (int64_t)recs[i - 1].n;
+        int64_t d_prev = (i >= 2) ? (int64_t)recs[i - 1].n - (int64_t)recs[i - 2].n : 1;
+        return zigzag(d - d_prev);
+    }
+    return zigzag((int64_t)field_get(&recs[i], ch) - (int64_t)field_get(&recs[i - 1], ch));
+}
+
+/* ---------- fluxo de bits (LSB primeiro) ---------- */
+
+typedef struct {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   pos;
+    uint64_t acc;
+    int      nbits;
+} bit_writer_t;
+
+static void bw_put(bit_writer_t *w, uint64_t v, int width)
+{
+    if (width > 32) {
+        bw_put(w, v & 0xFFFFFFFFULL, 32);
+        bw_put(w, v >> 32, width - 32);
+        return;
+    }
+    if (width == 0) {
+        return;
+    }
+    w->acc |= (v & ((1ULL << width) - 1)) << w->nbits;
+    w->nbits += width;
+    while (w->nbits >= 8) {
+        if (w->pos < w->cap) {
+            w->buf[w->pos] = (uint8_t)w->acc;
+        }
+        w->pos++;
+        w->acc >>= 8;
+        w->nbits -= 8;
+    }
+}
+
+static void bw_flush(bit_writer_t *w)
+{
+    if (w->nbits > 0) {
+        bw_put(w, 0, 8 - w->nbits);
+    }
+}
+
+typedef struct {
+    const uint8_t *buf;
+    size_t   len;
+    size_t   pos;
+    uint64_t acc;
+    int      nbits;
+} bit_reader_t;
+
+static uint64_t br_get(bit_reader_t *r, int width)
+{
+    if (width > 32) {
+        uint64_t lo = br_get(r, 32);
+        return lo | (br_get(r, width - 32) << 32);
+    }
+    if (width == 0) {
+        return 0;
+    }
+    while (r->nbits < width) {
+        uint64_t byte = (r->pos < r->len) ? r->buf[r->pos] : 0;
+        r->pos++;
+        r->acc |= byte << r->nbits;
+        r->nbits += 8;
+    }
+    uint64_t v = r->acc & ((1ULL << width) - 1);
+    r->acc >>= width;
+    r->nbits -= width;
+    return v;
+}
+
+/* ---------- blocos ---------- */
+
+size_t log_block_size(const log_block_header_t *hdr)
+{
+    if (hdr->sync != LOG_BLOCK_SYNC ||
+        hdr->count == 0 || hdr->count > LOG_BLOCK_MAX_SAMPLES) {
+        return 0;
+    }
+
+    uint32_t bits_per_sample = 0;
+    for (int ch = 0; ch < LOG_BLOCK_CHANNELS; ch++) {
+        if (hdr->width[ch] > 64) {
+            return 0;
+        }
+        bits_per_sample += hdr->width[ch];
+    }
+
+    size_t payload = ((size_t)(hdr->count - 1) * bits_per_sample + 7) / 8;
+    return sizeof(log_block_header_t) + payload + LOG_BLOCK_TRAILER_BYTES;
+}
+
+size_t log_block_encode(const log_record_t *recs, int count, uint8_t *out, size_t cap)
+{
+    if (recs == NULL || out == NULL || count <= 0 || count > LOG_BLOCK_MAX_SAMPLES) {
+        return 0;
+    }
+
+    log_block_header_t hdr = {
+        .sync  = LOG_BLOCK_SYNC,
+        .count = (uint8_t)count,
+        .first = recs[0],
+    };
+
+    /* Largura de cada canal = maior zigzag(delta) do bloco */
+    for (int ch = 0; ch < LOG_BLOCK_CHANNELS; ch++) {
+        uint64_t max_zz = 0;
+        for (int i = 1; i < count; i++) {
+            uint64_t zz = channel_delta(recs, i, ch);
+            if (zz > max_zz) max_zz = zz;
+        }
+        hdr.width[ch] = bit_width(max_zz);
+    }
+
+    size_t total = log_block_size(&hdr);
+    if (total == 0 || total > cap || total > UINT16_MAX) {
+        return 0;
+    }
+
+    memcpy(out, &hdr, sizeof(hdr));
+
+    bit_writer_t w = {
+        .buf = out + sizeof(hdr),
+        .cap = total - sizeof(hdr) - LOG_BLOCK_TRAILER_BYTES,
+    };
+    for (int i = 1; i < count; i++) {
+        for (int ch = 0; ch < LOG_BLOCK_CHANNELS; ch++) {
+            bw_put(&w, channel_delta(recs, i, ch), hdr.width[ch]);
+        }
+    }
+    bw_flush(&w);
+
+    out[total - 2] = (uint8_t)(total & 0xFF);
+    out[total - 1] = (uint8_t)(total >> 8);
+    return total;
+}
+
+int log_block_decode(const uint8_t *blk, size_t len, log_record_t *out)
+{
+    if (blk == NULL || out == NULL || len < sizeof(log_block_header_t)) {
+        return -1;
+    }
+
+    log_block_header_t hdr;
+    memcpy(&hdr, blk, sizeof(hdr));
+
+    size_t total = log_block_size(&hdr);
+    if (total == 0 || total > len ||
+        (size_t)(blk[total - 2] | (blk[total - 1] << 8)) != total) {
+        return -1;
+    }
+
+    out[0] = hdr.first;
+
+    bit_reader_t r = {
+        .buf = blk + sizeof(hdr),
+        .len = total - sizeof(hdr) - LOG_BLOCK_TRAILER_BYTES,
+    };
+    int64_t d_prev = 1;
+    for (int i = 1; i < hdr.count; i++) {
+        out[i] = out[i - 1];
+
+        int64_t d = d_prev + unzigzag(br_get(&r, hdr.width[0]));
+        out[i].n = (uint32_t)((int64_t)out[i - 1].n + d);
+        d_prev = d;
+
+        for (int ch = 1; ch < LOG_BLOCK_CHANNELS; ch++) {
+            int64_t delta = unzigzag(br_get(&r, hdr.width[ch]));
+            field_set(&out[i], ch, (int32_t)(field_get(&out[i - 1], ch) + delta));
+        }
+    }
+
+    return hdr.count;
+}
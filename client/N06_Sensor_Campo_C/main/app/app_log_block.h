@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "app_log_record.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Bloco comprimido de registros do log
+ * ============================================================
+ * Cada bloco é decodificável sozinho:
+ *
+ *   [cabeçalho 28 B]  sync, count, largura em bits de cada canal,
+ *                     primeiro registro completo (log_record_t)
+ *   [bits]            para cada amostra seguinte e cada canal:
+ *                     zigzag(delta) com a largura do canal
+ *                     (canal 0 = índice N em delta-de-delta)
+ *   [trailer 2 B]     tamanho total do bloco (uint16 LE), permite
+ *                     percorrer o arquivo de trás para frente
+ *
+ * Canais lentos variam poucos centésimos entre amostras, então a
+ * maioria cabe em 2..5 bits por amostra.
+ */
+
+#define LOG_BLOCK_SYNC          0xB7
+#define LOG_BLOCK_MAX_SAMPLES   64
+#define LOG_BLOCK_CHANNELS      8     /* N + 7 sensores */
+
+typedef struct __attribute__((packed)) {
+    uint8_t      sync;
+    uint8_t      count;
+    uint8_t      width[LOG_BLOCK_CHANNELS];
+    log_record_t first;
+} log_block_header_t;
+
+#define LOG_BLOCK_TRAILER_BYTES 2
+
+/* Pior caso: N com 64 bits e canais de 16 bits com delta de 17 bits */
+#define LOG_BLOCK_MAX_BYTES \
+    (sizeof(log_block_header_t) + \
+     ((LOG_BLOCK_MAX_SAMPLES - 1) * (64 + (LOG_BLOCK_CHANNELS - 1) * 17) + 7) / 8 + \
+     LOG_BLOCK_TRAILER_BYTES)
+
+/**
+ * @brief Comprime count (1..LOG_BLOCK_MAX_SAMPLES) registros consecutivos.
+ * @return Bytes escritos em out (incluindo trailer), ou 0 se cap insuficiente
+ */
+size_t log_block_encode(const log_record_t *recs, int count, uint8_t *out, size_t cap);
+
+/**
+ * @brief Tamanho total do bloco a partir do cabeçalho.
+ * @return Bytes do bloco, ou 0 se o cabeçalho for inválido
+ */
+size_t log_block_size(const log_block_header_t *hdr);
+
+/**
+ * @brief Descomprime um bloco completo.
+ * @param out Espaço para LOG_BLOCK_MAX_SAMPLES registros
+ * @return Número de registros, ou -1 se o bloco for inválido
+ */
+int log_block_decode(const uint8_t *blk, size_t len, log_record_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+#include "app_log_record.h"
+
+#include <math.h>
+#include <string.h>
+
+const char LOG_RECORD_CSV_HEADER[] =
+    "N,temp_ar_C,umid_ar_pct,temp_solo_C,umid_solo_pct,luminosidade_lux,dpv_kPa,orvalho_C\n";
+
+/* ---------- codificação ---------- */
+
+static int16_t encode_i16(float v, float scale)
+{
+    if (!isfinite(v)) return LOG_REC_NAN_I16;
+    float s = v * scale;
+    if (s >= (float)INT16_MAX)  return INT16_MAX;
+    if (s <= (float)-INT16_MAX) return -INT16_MAX;
+    return (int16_t)(s + (s >= 0.0f ? 0.5f : -0.5f));
+}
+
+static uint16_t encode_u16(float v, float scale)
+{
+    if (!isfinite(v)) return LOG_REC_NAN_U16;
+    float s = v * scale;
+    if (s <= 0.0f) return 0;
+    if (s >= (float)(UINT16_MAX - 1)) return UINT16_MAX - 1;
+    return (uint16_t)(s + 0.5f);
+}
+
+static float decode_i16(int16_t v, float scale)
+{
+    return (v == LOG_REC_NAN_I16) ? NAN : (float)v / scale;
+}
+
+static float decode_u16(uint16_t v, float scale)
+{
+    return (v == LOG_REC_NAN_U16) ? NAN : (float)v / scale;
+}
+
+void log_record_encode(uint32_t n, const log_entry_t *entry, log_record_t *rec)
+{
+    rec->n             = n;
+    rec->temp_ar       = encode_i16(entry->temp_ar,       LOG_REC_TEMP_SCALE);
+    rec->umid_ar       = encode_u16(entry->umid_ar,       LOG_REC_UMID_SCALE);
+    rec->temp_solo     = encode_i16(entry->temp_solo,     LOG_REC_TEMP_SCALE);
+    rec->umid_solo     = encode_u16(entry->umid_solo,     LOG_REC_UMID_SCALE);
+    rec->dpv           = encode_u16(entry->dpv,           LOG_REC_DPV_SCALE);
+    rec->ponto_orvalho = encode_i16(entry->ponto_orvalho, LOG_REC_TEMP_SCALE);
+
+    /* Luz cobre 5 décadas: codificação logarítmica com erro relativo constante */
+    float lux = entry->luminosidade;
+    if (!isfinite(lux)) {
+        rec->luminosidade = LOG_REC_NAN_U16;
+    } else {
+        rec->luminosidade = encode_u16(log2f(1.0f + (lux > 0.0f ? lux : 0.0f)),
+                                       LOG_REC_LUX_LOG2_SCALE);
+    }
+}
+
+void log_record_decode(const log_record_t *rec, log_entry_t *entry)
+{
+    entry->temp_ar       = decode_i16(rec->temp_ar,       LOG_REC_TEMP_SCALE);
+    entry->umid_ar       = decode_u16(rec->umid_ar,       LOG_REC_UMID_SCALE);
+    entry->temp_solo     = decode_i16(rec->temp_solo,     LOG_REC_TEMP_SCALE);
+    entry->umid_solo     = decode_u16(rec->umid_solo,     LOG_REC_UMID_SCALE);
+    entry->dpv           = decode_u16(rec->dpv,           LOG_REC_DPV_SCALE);
+    entry->ponto_orvalho = decode_i16(rec->ponto_orvalho, LOG_REC_TEMP_SCALE);
+
+    if (rec->luminosidade == LOG_REC_NAN_U16) {
+        entry->luminosidade = NAN;
+    } else {
+        entry->luminosidade = exp2f((float)rec->luminosidade / LOG_REC_LUX_LOG2_SCALE) - 1.0f;
+    }
+}
+
+/* ---------- CSV sem printf de float ---------- */
+
+/* Escreve v / 10^decimals em p; retorna o novo fim */
+static char *put_fixed(char *p, int64_t v, int decimals)
+{
+    char tmp[24];
+    int len = 0;
+    bool neg = v < 0;
+    uint64_t u = neg ? (uint64_t)(-v) : (uint64_t)v;
+
+    do {
+        tmp[len++] = (char)('0' + (u % 10));
+        u /= 10;
+        if (len == decimals) {
+            tmp[len++] = '.';
+        }
+    } while (u != 0 || len <= decimals + (decimals > 0 ? 1 : 0));
+
+    if (neg) *p++ = '-';
+    while (len > 0) {
+        *p++ = tmp[--len];
+    }
+    return p;
+}
+
+static char *put_nan(char *p)
+{
+    memcpy(p, "nan", 3);
+    return p + 3;
+}
+
+int log_record_format_csv(const log_record_t *rec, char *buf, size_t len)
+{
+    if (len < LOG_RECORD_CSV_MAX) {
+        if (len > 0) buf[0] = '\0';
+        return 0;
+    }
+
+    char *p = buf;
+    p = put_fixed(p, rec->n, 0);
+    *p++ = ',';
+    p = (rec->temp_ar == LOG_REC_NAN_I16) ? put_nan(p) : put_fixed(p, rec->temp_ar, 2);
+    *p++ = ',';
+    p = (rec->umid_ar == LOG_REC_NAN_U16) ? put_nan(p) : put_fixed(p, rec->umid_ar, 1);
+    *p++ = ',';
+    p = (rec->temp_solo == LOG_REC_NAN_I16) ? put_nan(p) : put_fixed(p, rec->temp_solo, 2);
+    *p++ = ',';
+    p = (rec->umid_solo == LOG_REC_NAN_U16) ? put_nan(p) : put_fixed(p, rec->umid_solo, 1);
+    *p++ = ',';
+    if (rec->luminosidade == LOG_REC_NAN_U16) {
+        p = put_nan(p);
+    } else {
+        /* Único canal não linear: decodifica e arredonda para 0.01 lux */
+        float lux = exp2f((float)rec->luminosidade / LOG_REC_LUX_LOG2_SCALE) - 1.0f;
+        p = put_fixed(p, (int64_t)(lux * 100.0f + 0.5f), 2);
+    }
+    *p++ = ',';
+    p = (rec->dpv == LOG_REC_NAN_U16) ? put_nan(p) : put_fixed(p, rec->dpv, 3);
+    *p++ = ',';
+    p = (rec->ponto_orvalho == LOG_REC_NAN_I16) ? put_nan(p) : put_fixed(p, rec->ponto_orvalho, 2);
+    *p++ = '\n';
+    *p = '\0';
+
+    return (int)(p - buf);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "app_data_logger.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Registro compacto de ponto fixo do log (18 bytes)
+ * ============================================================
+ * Cada canal tem precisão declarada; float só aparece na
+ * apresentação (JSON, estatísticas, CSV de download).
+ *
+ *   canal          tipo      unidade            faixa
+ *   temp_ar        int16     0.01 °C            -327.67 .. 327.67
+ *   umid_ar        uint16    0.1 %              0 .. 6553.4
+ *   temp_solo      int16     0.01 °C            -327.67 .. 327.67
+ *   umid_solo      uint16    0.1 %              0 .. 6553.4
+ *   luminosidade   uint16    2048*log2(1+lux)   0 .. ~4e9 lux (passo 0.034 %)
+ *   dpv            uint16    0.001 kPa          0 .. 65.534
+ *   ponto_orvalho  int16     0.01 °C            -327.67 .. 327.67
+ *
+ * Valores ausentes (NAN) usam o sentinela do tipo (INT16_MIN / UINT16_MAX).
+ */
+
+#define LOG_RECORD_MAGIC          0x4C36304EUL   /* "N06L" */
+#define LOG_RECORD_VERSION        2   /* 1 = registros soltos, 2 = blocos */
+
+#define LOG_REC_TEMP_SCALE        100.0f    /* 0.01 °C */
+#define LOG_REC_UMID_SCALE        10.0f     /* 0.1 % */
+#define LOG_REC_DPV_SCALE         1000.0f   /* 0.001 kPa */
+#define LOG_REC_LUX_LOG2_SCALE    2048.0f   /* passos por oitava */
+
+#define LOG_REC_NAN_I16           INT16_MIN
+#define LOG_REC_NAN_U16           UINT16_MAX
+
+typedef struct __attribute__((packed)) {
+    uint32_t n;              /* índice da amostra (1..) */
+    int16_t  temp_ar;
+    uint16_t umid_ar;
+    int16_t  temp_solo;
+    uint16_t umid_solo;
+    uint16_t luminosidade;
+    uint16_t dpv;
+    int16_t  ponto_orvalho;
+} log_record_t;
+
+/* Cabeçalho do arquivo binário (8 bytes), seguido dos blocos (app_log_block.h) */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  record_size;
+    uint16_t reserved;
+} log_file_header_t;
+
+/* Tamanho máximo de uma linha CSV gerada por log_record_format_csv */
+#define LOG_RECORD_CSV_MAX        96
+
+/**
+ * @brief Converte uma amostra em float para o registro de ponto fixo.
+ */
+void log_record_encode(uint32_t n, const log_entry_t *entry, log_record_t *rec);
+
+/**
+ * @brief Converte o registro para float (apresentação).
+ */
+void log_record_decode(const log_record_t *rec, log_entry_t *entry);
+
+/**
+ * @brief Formata o registro como linha CSV (com '\n') usando só aritmética inteira
+ *        nos canais lineares.
+ * @return Número de caracteres escritos (sem o terminador)
+ */
+int log_record_format_csv(const log_record_t *rec, char *buf, size_t len);
+
+/**
+ * @brief Cabeçalho CSV correspondente a log_record_format_csv.
+ */
+extern const char LOG_RECORD_CSV_HEADER[];
+
+#ifdef __cplusplus
+}
+#endif
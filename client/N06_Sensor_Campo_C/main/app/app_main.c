@@ -21,10 +21,15 @@
 #include "app_sampling_period.h"
 #include "app_stats_window.h"
 #include "app_cultivation_tolerance.h"
+#include "app_derived_metrics.h"
 #include "gui_services.h"
 
 // GUI
+#if CONFIG_IDF_TARGET_LINUX
+#include "app_host_profile.h"
+#else
 #include "gui/web/gui_http_server.h"
+#endif
 
 static const char *TAG = "APP_MAIN";
 
@@ -86,6 +91,28 @@ static esp_err_t set_cultivation_tolerance_wrapper(float temp_ar_min, float temp
     return cultivation_tolerance_set(&tol);
 }
 
+/* Wrapper para métricas agronômicas acumuladas */
+static void get_derived_metrics_wrapper(gui_derived_metrics_t *out)
+{
+    if (out == NULL) return;
+    derived_metrics_t m;
+    derived_metrics_get(&m);
+    out->gdd_hoje  = m.gdd_hoje;
+    out->gdd_ontem = m.gdd_ontem;
+    out->gdd_total = m.gdd_total;
+    out->dli_hoje  = m.dli_hoje;
+    out->dli_ontem = m.dli_ontem;
+    out->dias      = m.dias;
+}
+
+/* Limpeza de dados também zera os acumuladores diários */
+static esp_err_t clear_logged_data_wrapper(void)
+{
+    esp_err_t err = data_logger_clear_all();
+    derived_metrics_reset();
+    return err;
+}
+
 static const uint32_t SENSOR_JANELA_MS = 5000;
 static const uint32_t SENSOR_RETRY_MS  = 2000;
 
@@ -130,6 +157,7 @@ static void tarefa_log(void *pvParameter)
             entry.umid_solo = reading.humid_soil;
             entry.luminosidade = reading.luminosity;
             entry.dpv = reading.dpv;
+            entry.ponto_orvalho = reading.dew_point;
 
             ultimo_entry       = entry;
             ultimo_entry_valido = true;
@@ -152,7 +180,17 @@ static void tarefa_log(void *pvParameter)
 
         if (deve_registrar)
         {
-            if (data_logger_append(&entry))
+            // Cada linha registrada representa um período de amostragem
+            derived_metrics_update(entry.temp_ar, entry.luminosidade, intervalo_ms);
+
+#if CONFIG_IDF_TARGET_LINUX
+            int64_t append_inicio = esp_timer_get_time();
+            bool gravado = data_logger_append(&entry);
+            host_profile_note_append(esp_timer_get_time() - append_inicio, intervalo_ms);
+#else
+            bool gravado = data_logger_append(&entry);
+#endif
+            if (gravado)
             {
                 // Formatação direta no log para evitar corrupção de buffer
                 if (isfinite(entry.temp_ar) && isfinite(entry.umid_ar)) {
@@ -178,9 +216,11 @@ static void tarefa_log(void *pvParameter)
             }
         }
 
+        // No replay em host o período é comprimido por BSP_TIME_SCALE
+        uint32_t periodo_real_ms = intervalo_ms / BSP_TIME_SCALE;
         int64_t elapsed_ms = (esp_timer_get_time() - janela_inicio) / 1000;
-        if (elapsed_ms < (int64_t)intervalo_ms) {
-            uint32_t sleep_ms = (uint32_t)(intervalo_ms - elapsed_ms);
+        if (elapsed_ms < (int64_t)periodo_real_ms) {
+            uint32_t sleep_ms = (uint32_t)(periodo_real_ms - elapsed_ms);
             if (sleep_ms > 0) {
                 vTaskDelay(pdMS_TO_TICKS(sleep_ms));
             } else {
@@ -222,6 +262,9 @@ void app_main(void)
     // Carrega tolerâncias de cultivo (NVS)
     ESP_ERROR_CHECK(cultivation_tolerance_init());
 
+    // Restaura acumuladores de GDD/DLI (NVS)
+    ESP_ERROR_CHECK(derived_metrics_init());
+
     // ============================================================
     // CONECTA CAMADAS (remove dependência circular)
     // ============================================================
@@ -246,11 +289,25 @@ void app_main(void)
     gui_services_impl.set_stats_window_count = stats_window_set_count;
     gui_services_impl.build_history_json = build_history_json_wrapper;
     gui_services_impl.get_recent_stats  = data_logger_get_recent_stats;
+    gui_services_impl.get_derived_metrics = get_derived_metrics_wrapper;
+    gui_services_impl.export_csv         = data_logger_export_csv;
     gui_services_impl.get_cultivation_tolerance = get_cultivation_tolerance_wrapper;
     gui_services_impl.set_cultivation_tolerance = set_cultivation_tolerance_wrapper;
-    gui_services_impl.clear_logged_data  = data_logger_clear_all;
+    gui_services_impl.clear_logged_data  = clear_logged_data_wrapper;
     gui_services_register(&gui_services_impl);
 
+#if CONFIG_IDF_TARGET_LINUX
+    // Host: sem rádio nem servidor HTTP; mede o custo das páginas no lugar
+    ESP_ERROR_CHECK(host_profile_init());
+    xTaskCreate(
+        host_profile_task,
+        "host_profile",
+        8192,
+        NULL,
+        3,
+        NULL
+    );
+#else
     // Sobe servidor HTTP + SoftAP
     // http_server_start() deve:
     //   - montar AP
@@ -259,6 +316,7 @@ void app_main(void)
     // Após sucesso consideramos AP ativo
     ESP_ERROR_CHECK(http_server_start());
     atuadores_set_ap_status(true);
+#endif
 
     // Cria tarefa que controla LED de status (pisca, apaga etc)
     xTaskCreate(
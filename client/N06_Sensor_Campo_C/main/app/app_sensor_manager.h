@@ -14,6 +14,7 @@ typedef struct {
     float humid_soil;  // Já convertido para %
     float luminosity;  // lux (intensidade de luminosidade)
     float dpv;         // kPa (Déficit de Pressão de Vapor)
+    float dew_point;   // °C (Ponto de orvalho)
 } sensor_reading_t;
 
 esp_err_t sensor_manager_init(void);
@@ -35,8 +35,22 @@ typedef struct gui_recent_stats {
     gui_sensor_stats_t umid_solo;
     gui_sensor_stats_t luminosidade;
     gui_sensor_stats_t dpv;
+    gui_sensor_stats_t ponto_orvalho;
 } gui_recent_stats_t;
 
+/* Métricas agronômicas acumuladas (graus-dia e integral de luz diária) */
+typedef struct {
+    float gdd_hoje;
+    float gdd_ontem;
+    float gdd_total;
+    float dli_hoje;
+    float dli_ontem;
+    uint32_t dias;
+} gui_derived_metrics_t;
+
+/* Recebe pedaços de uma resposta gerada em blocos (ex.: CSV) */
+typedef esp_err_t (*gui_chunk_cb_t)(const char *chunk, size_t len, void *ctx);
+
 typedef struct {
     /* Sensores */
     float (*get_temp_air)(void);
@@ -60,6 +74,8 @@ typedef struct {
     /* Histórico */
     char* (*build_history_json)(void);
     bool  (*get_recent_stats)(int max_samples, gui_recent_stats_t *stats_out);
+    void  (*get_derived_metrics)(gui_derived_metrics_t *out);
+    esp_err_t (*export_csv)(gui_chunk_cb_t cb, void *ctx);
     
     /* Tolerâncias de cultivo */
     void (*get_cultivation_tolerance)(float *temp_ar_min, float *temp_ar_max,
@@ -1,5 +1,29 @@
 #pragma once
 
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+
+/* ============================================================
+ * CONFIGURAÇÃO DE HOST - ESP-IDF target linux (replay)
+ * ============================================================
+ * Sensores vêm de um CSV gravado (bsp/host/bsp_sensors_replay.c),
+ * SPIFFS é um diretório local e NVS é o arquivo de partição emulado
+ * pelo próprio ESP-IDF.
+ */
+
+#define BOARD_NAME "LINUX_REPLAY"
+
+/* Trace de entrada (sobrescrito pela variável de ambiente N06_REPLAY_CSV) */
+#define BSP_REPLAY_CSV_DEFAULT      "replay.csv"
+/* Amostras simuladas antes de encerrar (N06_REPLAY_SAMPLES; 0 = infinito) */
+#define BSP_REPLAY_SAMPLES_DEFAULT  0
+
+/* Divisor do tempo de espera entre amostras: roda semanas em segundos */
+#define BSP_TIME_SCALE              100000
+
+#else
+
 #include "driver/gpio.h"
 #include "esp_adc/adc_oneshot.h"
 
@@ -11,6 +35,9 @@
 
 #define BOARD_NAME "ESP32_WROOM"
 
+/* Tempo real: sem aceleração entre amostras */
+#define BSP_TIME_SCALE          1
+
 /* GPIOs */
 #define BSP_GPIO_DS18B20        GPIO_NUM_4
 #define BSP_GPIO_LED_STATUS     GPIO_NUM_2
@@ -28,22 +55,27 @@
 #define BSP_ADC_SOIL_BITWIDTH   ADC_BITWIDTH_12
 #define BSP_ADC_SOIL_ATTEN      ADC_ATTEN_DB_12  // ADC_ATTEN_DB_11 deprecated, usa DB_12
 
+/* Validação de configuração */
+#if !defined(BSP_GPIO_DS18B20) || !defined(BSP_GPIO_LED_STATUS)
+    #error "BSP: GPIOs não definidos"
+#endif
+
+#endif /* CONFIG_IDF_TARGET_LINUX */
+
 /* Wi-Fi AP */
 #define BSP_WIFI_AP_SSID        "greenSe_Campo"
 #define BSP_WIFI_AP_PASSWORD    "12345678"
 #define BSP_WIFI_AP_CHANNEL     1
 #define BSP_WIFI_AP_MAX_CONN    4
 
-/* SPIFFS */
+/* SPIFFS (no host, diretório relativo ao diretório de execução) */
 #define BSP_SPIFFS_LABEL        "spiffs"
+#if CONFIG_IDF_TARGET_LINUX
+#define BSP_SPIFFS_MOUNT        "spiffs_host"
+#else
 #define BSP_SPIFFS_MOUNT        "/spiffs"
+#endif
 #define BSP_SPIFFS_MAX_FILES    5
 
 /* Intervalo de amostragem dos sensores (em milissegundos) */
 #define BSP_SENSOR_SAMPLE_INTERVAL_MS    10000  // 10 segundos (valor padrão)
-
-/* Validação de configuração */
-#if !defined(BSP_GPIO_DS18B20) || !defined(BSP_GPIO_LED_STATUS)
-    #error "BSP: GPIOs não definidos"
-#endif
-
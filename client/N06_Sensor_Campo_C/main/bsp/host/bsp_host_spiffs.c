@@ -0,0 +1,58 @@
+#include "esp_spiffs.h"
+#include "../board.h"
+#include "esp_log.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char *TAG = "BSP_HOST_SPIFFS";
+
+/* Mesmo tamanho da partição spiffs em partitions.csv (3008K) */
+#define HOST_SPIFFS_TOTAL_BYTES  (3008U * 1024U)
+
+static char mounted_path[64] = BSP_SPIFFS_MOUNT;
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf)
+{
+    if (conf == NULL || conf->base_path == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (mkdir(conf->base_path, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "Falha ao criar %s (%d)", conf->base_path, errno);
+        return ESP_FAIL;
+    }
+
+    snprintf(mounted_path, sizeof(mounted_path), "%s", conf->base_path);
+    ESP_LOGI(TAG, "SPIFFS simulado no diretorio %s", mounted_path);
+    return ESP_OK;
+}
+
+esp_err_t esp_spiffs_info(const char *partition_label, size_t *total_bytes, size_t *used_bytes)
+{
+    (void)partition_label;
+
+    DIR *dir = opendir(mounted_path);
+    if (dir == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t used = 0;
+    struct dirent *ent;
+    char path[320];
+    while ((ent = readdir(dir)) != NULL) {
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", mounted_path, ent->d_name);
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+            used += (size_t)st.st_size;
+        }
+    }
+    closedir(dir);
+
+    if (total_bytes) *total_bytes = HOST_SPIFFS_TOTAL_BYTES;
+    if (used_bytes)  *used_bytes  = used;
+    return ESP_OK;
+}
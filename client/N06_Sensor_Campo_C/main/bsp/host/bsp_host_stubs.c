@@ -0,0 +1,40 @@
+#include "bsp_led.h"
+#include "bsp_wifi_ap.h"
+#include "esp_log.h"
+
+/* ============================================================
+ * Stubs de host (target linux) para LED e Wi-Fi AP
+ * ============================================================
+ * Não há GPIO nem rádio no host; as funções apenas mantêm a
+ * mesma interface para que a camada APP rode sem alterações.
+ */
+
+static const char *TAG = "BSP_HOST";
+
+esp_err_t led_bsp_init(void)
+{
+    ESP_LOGI(TAG, "LED simulado (sem GPIO no host)");
+    return ESP_OK;
+}
+
+void led_bsp_on(void) {}
+void led_bsp_off(void) {}
+void led_bsp_toggle(void) {}
+
+esp_err_t wifi_ap_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t wifi_ap_register_callbacks(wifi_ap_client_connected_cb_t on_client_connected,
+                                     wifi_ap_client_disconnected_cb_t on_client_disconnected)
+{
+    (void)on_client_connected;
+    (void)on_client_disconnected;
+    return ESP_OK;
+}
+
+esp_err_t wifi_ap_stop(void)
+{
+    return ESP_OK;
+}
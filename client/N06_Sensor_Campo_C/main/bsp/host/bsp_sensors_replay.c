@@ -0,0 +1,105 @@
+#include "bsp_sensors.h"
+#include "../board.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ============================================================
+ * Implementação de replay da interface de sensores (host linux)
+ * ============================================================
+ * Lê amostras de um CSV gravado. Aceita o próprio log do
+ * dispositivo (/download):
+ *   N,temp_ar_C,umid_ar_pct,temp_solo_C,umid_solo_pct,luminosidade_lux,...
+ * A umidade do solo em % é convertida de volta para leitura ADC
+ * bruta com a calibração padrão (seco=4000, molhado=400).
+ * Ao chegar ao fim do arquivo, volta ao início.
+ */
+
+static const char *TAG = "BSP_REPLAY";
+
+#define REPLAY_CALIB_SECO     4000.0f
+#define REPLAY_CALIB_MOLHADO  400.0f
+
+static FILE *trace = NULL;
+
+static bool replay_next_row(bsp_sensor_data_t *data)
+{
+    char line[192];
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        while (fgets(line, sizeof(line), trace)) {
+            int n;
+            float ta = NAN, ua = NAN, ts = NAN, us = NAN, lum = NAN;
+            int fields = sscanf(line, "%d,%f,%f,%f,%f,%f", &n, &ta, &ua, &ts, &us, &lum);
+            if (fields < 5) {
+                continue;  /* cabeçalho ou linha inválida */
+            }
+
+            data->temp_air   = ta;
+            data->humid_air  = ua;
+            data->temp_soil  = ts;
+            data->luminosity = (fields >= 6) ? lum : NAN;
+            data->soil_raw   = isfinite(us)
+                ? (int)(REPLAY_CALIB_SECO - (us / 100.0f) * (REPLAY_CALIB_SECO - REPLAY_CALIB_MOLHADO))
+                : -1;
+            return true;
+        }
+        /* Fim do trace: recomeça */
+        rewind(trace);
+    }
+    return false;
+}
+
+static esp_err_t bsp_replay_init_impl(void)
+{
+    if (trace != NULL) {
+        return ESP_OK;
+    }
+
+    const char *path = getenv("N06_REPLAY_CSV");
+    if (path == NULL || path[0] == '\0') {
+        path = BSP_REPLAY_CSV_DEFAULT;
+    }
+
+    trace = fopen(path, "r");
+    if (trace == NULL) {
+        ESP_LOGE(TAG, "Nao consegui abrir trace %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ESP_LOGI(TAG, "Replay de sensores a partir de %s", path);
+    return ESP_OK;
+}
+
+static esp_err_t bsp_replay_read_all_impl(bsp_sensor_data_t *data)
+{
+    if (data == NULL) return ESP_ERR_INVALID_ARG;
+    if (trace == NULL) return ESP_ERR_INVALID_STATE;
+
+    if (!replay_next_row(data)) {
+        ESP_LOGE(TAG, "Trace sem linhas validas");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
+static bool bsp_replay_is_ready_impl(void)
+{
+    return trace != NULL;
+}
+
+/* Leituras individuais não são usadas pelo sensor manager quando read_all existe */
+static const bsp_sensors_ops_t replay_ops = {
+    .init = bsp_replay_init_impl,
+    .read_all = bsp_replay_read_all_impl,
+    .is_ready = bsp_replay_is_ready_impl,
+};
+
+const bsp_sensors_ops_t* bsp_sensors_get_ops(void)
+{
+    return &replay_ops;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/* ============================================================
+ * Shim de SPIFFS para o host (target linux)
+ * ============================================================
+ * Mesma interface usada por app_data_logger; o "sistema de
+ * arquivos" é um diretório local (BSP_SPIFFS_MOUNT).
+ */
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *base_path;
+    const char *partition_label;
+    size_t max_files;
+    bool format_if_mount_failed;
+} esp_vfs_spiffs_conf_t;
+
+/**
+ * @brief Cria o diretório base_path se não existir
+ */
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf);
+
+/**
+ * @brief Reporta o tamanho da partição spiffs e os bytes usados no diretório
+ */
+esp_err_t esp_spiffs_info(const char *partition_label, size_t *total_bytes, size_t *used_bytes);
+
+#ifdef __cplusplus
+}
+#endif
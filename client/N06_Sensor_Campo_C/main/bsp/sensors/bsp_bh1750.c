@@ -4,6 +4,7 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <string.h>
 
 static const char *TAG = "BSP_BH1750";
@@ -17,12 +18,88 @@ static const char *TAG = "BSP_BH1750";
 #define BH1750_CMD_RESET       0x07
 #define BH1750_CMD_CONT_H_MODE 0x10  // Modo contínuo alta resolução (1 lux, ~120ms)
 #define BH1750_CMD_CONT_H_MODE2 0x11 // Modo contínuo alta resolução 2 (0.5 lux, ~120ms)
-#define BH1750_CMD_CONT_L_MODE 0x13  // Modo contínuo baixa resolução (4 lux, ~16ms)
+#define BH1750_CMD_MTREG_HIGH  0x40  // 01000_MT[7,5]
+#define BH1750_CMD_MTREG_LOW   0x60  // 011_MT[4,0]
+
+/* Faixa do registrador de tempo de medição (MTreg) */
+#define BH1750_MTREG_MIN       31    // ~121 klux de fundo de escala (sol pleno)
+#define BH1750_MTREG_DEFAULT   69
+#define BH1750_MTREG_MAX       254   // ~0.28 lux/contagem (crepúsculo)
+
+/* Janela de auto-range sobre a contagem bruta (0..65535) */
+#define BH1750_RAW_HIGH        50000 // acima disso, próximo de saturar
+#define BH1750_RAW_LOW         2000  // abaixo disso, resolução desperdiçada
+#define BH1750_RAW_TARGET      20000 // ponto de operação após reajuste
+
+/* Tempo de integração nominal com MTreg padrão (ms) */
+#define BH1750_H_MODE_MS       120
 
 static i2c_master_dev_handle_t bh1750_handle = NULL;
 static i2c_master_bus_handle_t i2c_bus_handle_shared = NULL;
 static bool initialized = false;
 
+/* Estado do modo contínuo */
+static uint8_t mtreg = BH1750_MTREG_DEFAULT;
+/* MTreg válido para o valor atualmente no registrador de dados:
+ * após trocar MTreg/modo, a medição anterior continua sendo entregue
+ * até que uma nova integração termine. */
+static uint8_t data_mtreg = BH1750_MTREG_DEFAULT;
+static int64_t settle_until_us = 0;
+
+static uint32_t integration_ms(uint8_t mt)
+{
+    /* Tempo escala linearmente com MTreg; +50% de margem (máx. do datasheet) */
+    return (BH1750_H_MODE_MS * mt * 3U) / (BH1750_MTREG_DEFAULT * 2U) + 1U;
+}
+
+static float raw_to_lux(uint16_t raw, uint8_t mt)
+{
+    /* lux = raw / 1.2 * (69 / MTreg) */
+    return ((float)raw / 1.2f) * ((float)BH1750_MTREG_DEFAULT / (float)mt);
+}
+
+/* Escreve MTreg e reinicia a medição contínua em alta resolução */
+static esp_err_t apply_config(uint8_t new_mt)
+{
+    uint8_t cmds[3] = {
+        (uint8_t)(BH1750_CMD_MTREG_HIGH | (new_mt >> 5)),
+        (uint8_t)(BH1750_CMD_MTREG_LOW | (new_mt & 0x1F)),
+        BH1750_CMD_CONT_H_MODE,
+    };
+
+    for (size_t i = 0; i < sizeof(cmds); i++) {
+        esp_err_t ret = i2c_master_transmit(bh1750_handle, &cmds[i], 1, pdMS_TO_TICKS(100));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    /* Leituras anteriores ao fim da nova integração usam os parâmetros antigos */
+    data_mtreg = mtreg;
+    mtreg = new_mt;
+    settle_until_us = esp_timer_get_time() + (int64_t)integration_ms(new_mt) * 1000;
+    return ESP_OK;
+}
+
+/* Escolhe novo MTreg para levar a contagem bruta ao ponto de operação */
+static uint8_t autorange_mtreg(uint16_t raw, uint8_t mt)
+{
+    if (raw >= BH1750_RAW_LOW && raw <= BH1750_RAW_HIGH) {
+        return mt;
+    }
+
+    uint32_t target;
+    if (raw == 0) {
+        target = BH1750_MTREG_MAX;
+    } else {
+        target = ((uint32_t)mt * BH1750_RAW_TARGET) / raw;
+    }
+
+    if (target < BH1750_MTREG_MIN) target = BH1750_MTREG_MIN;
+    if (target > BH1750_MTREG_MAX) target = BH1750_MTREG_MAX;
+    return (uint8_t)target;
+}
+
 esp_err_t bh1750_bsp_init(void)
 {
     if (initialized) {
@@ -86,16 +163,18 @@ esp_err_t bh1750_bsp_init(void)
     }
     vTaskDelay(pdMS_TO_TICKS(10));
 
-    /* Configura modo contínuo alta resolução */
-    cmd = BH1750_CMD_CONT_H_MODE;
-    ret = i2c_master_transmit(bh1750_handle, &cmd, 1, pdMS_TO_TICKS(100));
+    /* Configura modo contínuo alta resolução com MTreg padrão */
+    mtreg = BH1750_MTREG_DEFAULT;
+    ret = apply_config(BH1750_MTREG_DEFAULT);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Falha ao configurar modo contínuo: %s", esp_err_to_name(ret));
         i2c_master_bus_rm_device(bh1750_handle);
         bh1750_handle = NULL;
         return ret;
     }
-    vTaskDelay(pdMS_TO_TICKS(120));  // Aguarda primeira medição
+    /* Aguarda primeira medição (única espera bloqueante; leituras não bloqueiam) */
+    vTaskDelay(pdMS_TO_TICKS(integration_ms(mtreg)));
+    settle_until_us = 0;
 
     initialized = true;
     ESP_LOGI(TAG, "BH1750 inicializado com sucesso (I2C addr: 0x%02X)", BH1750_I2C_ADDR);
@@ -115,7 +194,8 @@ esp_err_t bh1750_bsp_read(float *lux)
 
     esp_err_t ret;
 
-    /* Lê 2 bytes de dados */
+    /* Modo contínuo: o sensor mede em segundo plano, a leitura é
+     * uma única transação I2C de 2 bytes (sem espera de conversão) */
     uint8_t data[2] = {0};
     ret = i2c_master_receive(bh1750_handle, data, 2, pdMS_TO_TICKS(100));
     if (ret != ESP_OK) {
@@ -123,9 +203,26 @@ esp_err_t bh1750_bsp_read(float *lux)
         return ret;
     }
 
-    /* Converte para lux */
     uint16_t raw = ((uint16_t)data[0] << 8) | (uint16_t)data[1];
-    *lux = (float)raw / 1.2f;  // Divisão por 1.2 para modo de alta resolução
+
+    /* Valor ainda pertence à integração anterior a uma troca de faixa */
+    if (settle_until_us != 0 && esp_timer_get_time() < settle_until_us) {
+        *lux = raw_to_lux(raw, data_mtreg);
+        return ESP_OK;
+    }
+    settle_until_us = 0;
+
+    *lux = raw_to_lux(raw, mtreg);
+
+    /* Auto-range: ajusta MTreg para a próxima leitura (sol pleno ↔ crepúsculo) */
+    uint8_t new_mt = autorange_mtreg(raw, mtreg);
+    if (new_mt != mtreg) {
+        ESP_LOGD(TAG, "Auto-range: raw=%u MTreg %u -> %u", raw, mtreg, new_mt);
+        ret = apply_config(new_mt);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Falha ao ajustar MTreg: %s", esp_err_to_name(ret));
+        }
+    }
 
     return ESP_OK;
 }
@@ -16,6 +16,11 @@ esp_err_t bh1750_bsp_init(void);
 
 /**
  * @brief Lê a luminosidade do sensor BH1750
+ *
+ * O sensor opera em modo contínuo: a leitura é uma única transação I2C,
+ * sem espera de conversão. O MTreg (tempo de integração) é reajustado
+ * automaticamente para manter a contagem dentro da faixa útil.
+ *
  * @param lux Ponteiro para armazenar luminosidade em lux
  * @return ESP_OK em caso de sucesso
  */
@@ -343,6 +343,7 @@ static esp_err_t handle_dashboard(httpd_req_t *req)
     char umid_solo_avg_text[32], umid_solo_min_text[32], umid_solo_max_text[32], umid_solo_last_text[32];
     char luminosidade_avg_text[32], luminosidade_min_text[32], luminosidade_max_text[32], luminosidade_last_text[32];
     char dpv_avg_text[32], dpv_min_text[32], dpv_max_text[32], dpv_last_text[32];
+    char orvalho_avg_text[32], orvalho_min_text[32], orvalho_max_text[32], orvalho_last_text[32];
 
     if (stats_available && recent_stats.temp_ar.has_data) {
         snprintf(temp_ar_avg_text, sizeof(temp_ar_avg_text), "%.1f&nbsp;&deg;C", recent_stats.temp_ar.avg);
@@ -416,12 +417,33 @@ static esp_err_t handle_dashboard(httpd_req_t *req)
         snprintf(dpv_last_text, sizeof(dpv_last_text), "--");
     }
 
+    if (stats_available && recent_stats.ponto_orvalho.has_data) {
+        snprintf(orvalho_avg_text, sizeof(orvalho_avg_text), "%.1f&nbsp;&deg;C", recent_stats.ponto_orvalho.avg);
+        snprintf(orvalho_min_text, sizeof(orvalho_min_text), "%.1f&nbsp;&deg;C", recent_stats.ponto_orvalho.min);
+        snprintf(orvalho_max_text, sizeof(orvalho_max_text), "%.1f&nbsp;&deg;C", recent_stats.ponto_orvalho.max);
+        snprintf(orvalho_last_text, sizeof(orvalho_last_text), "%.1f&nbsp;&deg;C", recent_stats.ponto_orvalho.latest);
+    } else {
+        snprintf(orvalho_avg_text, sizeof(orvalho_avg_text), "--");
+        snprintf(orvalho_min_text, sizeof(orvalho_min_text), "--");
+        snprintf(orvalho_max_text, sizeof(orvalho_max_text), "--");
+        snprintf(orvalho_last_text, sizeof(orvalho_last_text), "--");
+    }
+
+    /* Métricas agronômicas acumuladas (GDD/DLI) */
+    gui_derived_metrics_t derived;
+    memset(&derived, 0, sizeof(derived));
+    if (svc->get_derived_metrics) {
+        svc->get_derived_metrics(&derived);
+    }
+
     char card_temp_ar[512];
     char card_umid_ar[512];
     char card_temp_solo[512];
     char card_umid_solo[512];
     char card_luminosidade[512];
     char card_dpv[512];
+    char card_orvalho[512];
+    char card_derivadas[640];
 
     snprintf(card_temp_ar, sizeof(card_temp_ar),
              "<div class='stats-card'>"
@@ -513,16 +535,51 @@ static esp_err_t handle_dashboard(httpd_req_t *req)
              dpv_max_text,
              dpv_last_text);
 
-    char stats_grid_html[3500];
+    snprintf(card_orvalho, sizeof(card_orvalho),
+             "<div class='stats-card'>"
+             "<h3>Ponto de orvalho</h3>"
+             "<ul>"
+             "<li><span>M&eacute;dia</span><strong>%s</strong></li>"
+             "<li><span>M&iacute;nimo</span><strong>%s</strong></li>"
+             "<li><span>M&aacute;ximo</span><strong>%s</strong></li>"
+             "<li><span>&Uacute;ltima</span><strong>%s</strong></li>"
+             "</ul>"
+             "</div>",
+             orvalho_avg_text,
+             orvalho_min_text,
+             orvalho_max_text,
+             orvalho_last_text);
+
+    snprintf(card_derivadas, sizeof(card_derivadas),
+             "<div class='stats-card'>"
+             "<h3>Graus-dia e luz (dia %lu)</h3>"
+             "<ul>"
+             "<li><span>GDD hoje</span><strong>%.2f&nbsp;&deg;C&middot;d</strong></li>"
+             "<li><span>GDD ontem</span><strong>%.2f&nbsp;&deg;C&middot;d</strong></li>"
+             "<li><span>GDD acumulado</span><strong>%.1f&nbsp;&deg;C&middot;d</strong></li>"
+             "<li><span>DLI hoje</span><strong>%.2f&nbsp;mol/m&sup2;</strong></li>"
+             "<li><span>DLI ontem</span><strong>%.2f&nbsp;mol/m&sup2;</strong></li>"
+             "</ul>"
+             "</div>",
+             (unsigned long)derived.dias + 1,
+             derived.gdd_hoje,
+             derived.gdd_ontem,
+             derived.gdd_total,
+             derived.dli_hoje,
+             derived.dli_ontem);
+
+    char stats_grid_html[4800];
     snprintf(stats_grid_html,
              sizeof(stats_grid_html),
-             "<div class='stats-grid'>%s%s%s%s%s%s</div>",
+             "<div class='stats-grid'>%s%s%s%s%s%s%s%s</div>",
              card_temp_ar,
              card_umid_ar,
              card_temp_solo,
              card_umid_solo,
              card_luminosidade,
-             card_dpv);
+             card_dpv,
+             card_orvalho,
+             card_derivadas);
 
     char stats_meta_html[640];
     snprintf(stats_meta_html,
@@ -537,14 +594,14 @@ static esp_err_t handle_dashboard(httpd_req_t *req)
              memory_text);
 
     /* Buffer alocado no heap para evitar stack overflow */
-    char *page = (char *)malloc(16000);
+    char *page = (char *)malloc(18000);
     if (!page) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Erro de memória");
         return ESP_FAIL;
     }
     
     int len = snprintf(
-        page, 16000,
+        page, 18000,
         "<!DOCTYPE html>"
         "<html>"
         "<head>"
@@ -631,6 +688,7 @@ static esp_err_t handle_dashboard(httpd_req_t *req)
         "<div><canvas id='chart_umid_solo' width='320' height='180'></canvas></div>"
         "<div><canvas id='chart_luminosidade' width='320' height='180'></canvas></div>"
         "<div><canvas id='chart_dpv' width='320' height='180'></canvas></div>"
+        "<div><canvas id='chart_orvalho' width='320' height='180'></canvas></div>"
         "</div>"
         "<p class='caption'>Gr&aacute;ficos exibindo at&eacute; %d amostras mais recentes conforme a janela de an&aacute;lise configurada.</p>"
         "</div>"
@@ -738,6 +796,7 @@ static esp_err_t handle_dashboard(httpd_req_t *req)
         "  const uSolo = extrairXY(j.umid_solo_points||[]);"
         "  const lum   = extrairXY(j.luminosidade_points||[]);"
         "  const dpv   = extrairXY(j.dpv_points||[]);"
+        "  const orv   = extrairXY(j.orvalho_points||[]);"
 
         "  const tol={temp_ar_min:%.1f,temp_ar_max:%.1f,umid_ar_min:%.1f,umid_ar_max:%.1f,"
         "temp_solo_min:%.1f,temp_solo_max:%.1f,umid_solo_min:%.1f,umid_solo_max:%.1f,"
@@ -748,6 +807,7 @@ static esp_err_t handle_dashboard(httpd_req_t *req)
         "  desenha('chart_umid_solo','Umid Solo (%%)',uSolo.xs,uSolo.ys,0,100,tol.umid_solo_min,tol.umid_solo_max);"
         "  desenha('chart_luminosidade','Luminosidade (lux)',lum.xs,lum.ys,0,2500,tol.luminosidade_min,tol.luminosidade_max);"
         "  desenha('chart_dpv','DPV (kPa)',dpv.xs,dpv.ys,0,3,tol.dpv_min,tol.dpv_max);"
+        "  desenha('chart_orvalho','Orvalho (C)',orv.xs,orv.ys,0,30,NaN,NaN);"
         " }catch(e){console.log('erro /history',e);}"
         "}"
 
@@ -1230,14 +1290,16 @@ static esp_err_t handle_set_sampling(httpd_req_t *req)
     return resp;
 }
 
-/* /download -> CSV inteiro */
+/* /download -> CSV inteiro, gerado a partir dos registros binários */
+static esp_err_t download_chunk_cb(const char *chunk, size_t len, void *ctx)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, chunk, len);
+}
+
 static esp_err_t handle_download(httpd_req_t *req)
 {
-    char filepath[64];
-    snprintf(filepath, sizeof(filepath), "%s/log_temp.csv", BSP_SPIFFS_MOUNT);
-    
-    FILE *f = fopen(filepath, "r");
-    if (!f)
+    const gui_services_t *svc = gui_services_get();
+    if (svc == NULL || svc->export_csv == NULL)
     {
         httpd_resp_send_err(req,
                             HTTPD_500_INTERNAL_SERVER_ERROR,
@@ -1249,15 +1311,9 @@ static esp_err_t handle_download(httpd_req_t *req)
     httpd_resp_set_hdr(req, "Content-Disposition",
                        "attachment; filename=\"log_temp.csv\"");
  
-    char buf[256];
-    while (fgets(buf, sizeof(buf), f) != NULL)
-    {
-        if (httpd_resp_sendstr_chunk(req, buf) != ESP_OK) {
-            fclose(f);
-            return ESP_FAIL;
-        }
+    if (svc->export_csv(download_chunk_cb, req) != ESP_OK) {
+        return ESP_FAIL;
     }
-    fclose(f);
     httpd_resp_sendstr_chunk(req, NULL); /* fim chunked */
     return ESP_OK;
 }
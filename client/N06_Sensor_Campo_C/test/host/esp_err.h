@@ -0,0 +1,33 @@
+#pragma once
+
+/* Substituto de host do esp_err.h: só o que os módulos testados usam */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_NO_MEM              0x101
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_STATE       0x103
+#define ESP_ERR_INVALID_SIZE        0x104
+#define ESP_ERR_NOT_FOUND           0x105
+#define ESP_ERR_TIMEOUT             0x107
+#define ESP_ERR_NVS_NOT_FOUND       0x1102
+#define ESP_ERR_NVS_INVALID_LENGTH  0x110c
+
+static inline const char *esp_err_to_name(esp_err_t err)
+{
+    return err == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+/* Como no IDF: erro em ESP_ERROR_CHECK encerra (aqui, o teste) */
+#define ESP_ERROR_CHECK(x) do { \
+    esp_err_t err_ = (x); \
+    if (err_ != ESP_OK) { \
+        fprintf(stderr, "%s:%d: ESP_ERROR_CHECK(%s) = %d\n", __FILE__, __LINE__, #x, err_); \
+        abort(); \
+    } \
+} while (0)
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+/* Sem escalonador no host: ceder CPU não faz nada */
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
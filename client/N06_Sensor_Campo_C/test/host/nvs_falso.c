@@ -0,0 +1,110 @@
+#include "nvs.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define NVS_FALSO_ENTRADAS  16
+#define NVS_FALSO_NOME      16
+#define NVS_FALSO_BLOB      256
+
+typedef struct {
+    bool usada;
+    nvs_handle_t ns;
+    char chave[NVS_FALSO_NOME];
+    size_t tamanho;
+    uint8_t dados[NVS_FALSO_BLOB];
+} entrada_t;
+
+static char namespaces[NVS_FALSO_ENTRADAS][NVS_FALSO_NOME];
+static entrada_t entradas[NVS_FALSO_ENTRADAS];
+
+static entrada_t *procurar(nvs_handle_t ns, const char *chave)
+{
+    for (int i = 0; i < NVS_FALSO_ENTRADAS; i++) {
+        if (entradas[i].usada && entradas[i].ns == ns && strcmp(entradas[i].chave, chave) == 0) {
+            return &entradas[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out_handle)
+{
+    (void)mode;
+    for (int i = 0; i < NVS_FALSO_ENTRADAS; i++) {
+        if (namespaces[i][0] == '\0') {
+            strncpy(namespaces[i], name, NVS_FALSO_NOME - 1);
+        }
+        if (strcmp(namespaces[i], name) == 0) {
+            *out_handle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (length > NVS_FALSO_BLOB || strlen(key) >= NVS_FALSO_NOME) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    entrada_t *e = procurar(handle, key);
+    for (int i = 0; e == NULL && i < NVS_FALSO_ENTRADAS; i++) {
+        if (!entradas[i].usada) {
+            e = &entradas[i];
+        }
+    }
+    if (e == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    e->usada = true;
+    e->ns = handle;
+    strcpy(e->chave, key);
+    e->tamanho = length;
+    memcpy(e->dados, value, length);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    entrada_t *e = procurar(handle, key);
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value == NULL) {
+        *length = e->tamanho;
+        return ESP_OK;
+    }
+    if (*length < e->tamanho) {
+        *length = e->tamanho;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, e->dados, e->tamanho);
+    *length = e->tamanho;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    entrada_t *e = procurar(handle, key);
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    e->usada = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+void nvs_falso_limpar(void)
+{
+    memset(entradas, 0, sizeof(entradas));
+}
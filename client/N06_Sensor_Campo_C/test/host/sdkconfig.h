@@ -0,0 +1,5 @@
+#pragma once
+
+/* Substituto de host: board.h segue o ramo do target linux (SPIFFS em diretório local) */
+
+#define CONFIG_IDF_TARGET_LINUX 1
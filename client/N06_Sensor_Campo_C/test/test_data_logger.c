@@ -0,0 +1,332 @@
+#include "teste.h"
+#include "app_data_logger.h"
+#include "app_log_record.h"
+#include "app_log_block.h"
+#include "board.h"
+#include "gui_services.h"
+#include "cJSON.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Roda no diretório de build: o SPIFFS de host é BSP_SPIFFS_MOUNT ali dentro */
+
+#define ARQ(nome)      BSP_SPIFFS_MOUNT "/" nome
+#define MAX_LINHAS     1024
+
+static const char *const ARQUIVOS[] = {
+    ARQ("log_data.bin"), ARQ("log_tail.bin"), ARQ("log_v1.bin"),
+    ARQ("log_temp.csv"), ARQ("log_new.bin"), ARQ("soil_calib.json"),
+};
+
+static void limpar(void)
+{
+    mkdir(BSP_SPIFFS_MOUNT, 0755);
+    rmdir(ARQ("log_new.bin"));
+    for (size_t i = 0; i < sizeof(ARQUIVOS) / sizeof(ARQUIVOS[0]); i++) {
+        remove(ARQUIVOS[i]);
+    }
+}
+
+static bool existe(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+/* ---------- CSV exportado ---------- */
+
+static char exportado[MAX_LINHAS * LOG_RECORD_CSV_MAX];
+static size_t exportado_len;
+
+static esp_err_t juntar(const char *chunk, size_t len, void *ctx)
+{
+    (void)ctx;
+    if (exportado_len + len >= sizeof(exportado)) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(exportado + exportado_len, chunk, len);
+    exportado_len += len;
+    exportado[exportado_len] = '\0';
+    return ESP_OK;
+}
+
+/* Exporta o log e devolve os N de cada linha; retorna quantas linhas */
+static int exportar_n(uint32_t *ns)
+{
+    exportado_len = 0;
+    exportado[0] = '\0';
+    VERIFICAR(data_logger_export_csv(juntar, NULL) == ESP_OK);
+
+    int linhas = 0;
+    const char *p = strchr(exportado, '\n');   // cabeçalho
+    while (p && p[1] != '\0' && linhas < MAX_LINHAS) {
+        ns[linhas++] = (uint32_t)strtoul(p + 1, NULL, 10);
+        p = strchr(p + 1, '\n');
+    }
+    return linhas;
+}
+
+/* Todos os N de primeiro até primeiro+total-1, em ordem e sem repetição */
+static bool sequencia(const uint32_t *ns, int linhas, uint32_t primeiro, int total)
+{
+    if (linhas != total) {
+        fprintf(stderr, "  %d linhas, esperado %d\n", linhas, total);
+        return false;
+    }
+    for (int i = 0; i < linhas; i++) {
+        if (ns[i] != primeiro + (uint32_t)i) {
+            fprintf(stderr, "  linha %d: N=%u, esperado %u\n", i, ns[i], primeiro + (uint32_t)i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ---------- fontes de versões anteriores ---------- */
+
+static void escrever_csv_legado(int linhas)
+{
+    FILE *f = fopen(ARQ("log_temp.csv"), "w");
+    fputs("N,temp_ar_C,umid_ar_pct,temp_solo_C,umid_solo_pct,luminosidade_lux,dpv_kPa\n", f);
+    for (int i = 1; i <= linhas; i++) {
+        // As primeiras linhas são do formato ainda mais antigo, sem luz nem DPV
+        if (i <= 10) {
+            fprintf(f, "%d,%.2f,%.1f,%.2f,%.1f\n", i, 20.0 + i * 0.01, 60.0, 18.0, 40.0);
+        } else {
+            fprintf(f, "%d,%.2f,%.1f,%.2f,%.1f,%.2f,%.3f\n",
+                    i, 20.0 + i * 0.01, 60.0, 18.0, 40.0, 100.0 * i, 0.9);
+        }
+    }
+    fclose(f);
+}
+
+static void escrever_v1(int registros)
+{
+    FILE *f = fopen(ARQ("log_data.bin"), "wb");
+    log_file_header_t hdr = {
+        .magic = LOG_RECORD_MAGIC, .version = 1, .record_size = sizeof(log_record_t),
+    };
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    for (int i = 1; i <= registros; i++) {
+        log_entry_t e = { 21.0f, 55.0f, 19.0f, 35.0f, 500.0f, 1.1f, 11.0f };
+        log_record_t rec;
+        log_record_encode((uint32_t)i, &e, &rec);
+        fwrite(&rec, sizeof(rec), 1, f);
+    }
+    fclose(f);
+}
+
+static bool anexar(float temp)
+{
+    log_entry_t e = { temp, 50.0f, 18.0f, 40.0f, 1000.0f, 1.0f, 10.0f };
+    return data_logger_append(&e);
+}
+
+/* ---------- cenários ---------- */
+
+static uint32_t ns[MAX_LINHAS];
+
+static void testar_migracao_csv(void)
+{
+    limpar();
+    escrever_csv_legado(150);
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(!existe(ARQ("log_temp.csv")));
+    VERIFICAR(!existe(ARQ("log_new.bin")));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 150));
+
+    // Linha antiga sem luz/DPV volta com nan; o resto com os valores do CSV
+    VERIFICAR(strstr(exportado, "\n1,20.01,60.0,18.00,40.0,nan,nan,nan\n") != NULL);
+    VERIFICAR(strstr(exportado, "\n11,20.11,60.0,18.00,40.0,") != NULL);
+
+    // Numeração continua e o estado sobrevive a um reboot
+    VERIFICAR(anexar(25.0f));
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 151));
+}
+
+static void testar_migracao_v1(void)
+{
+    limpar();
+    escrever_v1(70);
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(!existe(ARQ("log_v1.bin")));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 70));
+    VERIFICAR(strstr(exportado, "\n70,21.00,55.0,19.00,35.0,") != NULL);
+}
+
+static void testar_migracao_refeita(void)
+{
+    // Log v2 já existe e o CSV reaparece (ex.: cópia de outro nó)
+    limpar();
+    VERIFICAR(data_logger_init() == ESP_OK);
+    escrever_csv_legado(100);
+
+    // log_new.bin como diretório: a migração não consegue gravar e falha
+    VERIFICAR(mkdir(ARQ("log_new.bin"), 0755) == 0);
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(existe(ARQ("log_temp.csv")));
+    VERIFICAR(existe(ARQ("log_data.bin")));
+
+    // O nó segue registrando, depois dos N que ainda estão no CSV
+    VERIFICAR(anexar(30.0f));
+    VERIFICAR(anexar(30.5f));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 101, 2));
+
+    // Próximo boot: log_data.bin já é v2, mas o CSV ainda existe e é migrado
+    rmdir(ARQ("log_new.bin"));
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(!existe(ARQ("log_temp.csv")));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 102));
+    VERIFICAR(strstr(exportado, "\n102,30.50,") != NULL);
+    VERIFICAR(anexar(31.0f));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 103));
+}
+
+static void testar_queda_na_troca(void)
+{
+    // Queda depois de renomear log_new.bin, antes de apagar o CSV:
+    // refazer a migração não pode duplicar amostras
+    limpar();
+    escrever_csv_legado(80);
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(anexar(26.0f));
+    escrever_csv_legado(80);
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(!existe(ARQ("log_temp.csv")));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 81));
+
+    // Queda entre apagar log_data.bin e renomear log_new.bin
+    VERIFICAR(rename(ARQ("log_data.bin"), ARQ("log_new.bin")) == 0);
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(!existe(ARQ("log_new.bin")));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 81));
+}
+
+static long tamanho(const char *path)
+{
+    struct stat st;
+    return (stat(path, &st) == 0) ? (long)st.st_size : -1;
+}
+
+static void copiar(const char *de, const char *para)
+{
+    char buf[4096];
+    FILE *in = fopen(de, "rb");
+    FILE *out = fopen(para, "wb");
+    size_t n;
+    while (in && out && (n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        fwrite(buf, 1, n, out);
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+}
+
+static void testar_bloco_final_rasgado(void)
+{
+    limpar();
+    VERIFICAR(data_logger_init() == ESP_OK);
+    for (int i = 0; i < 2 * LOG_BLOCK_MAX_SAMPLES - 1; i++) {
+        VERIFICAR(anexar(20.0f + (float)i * 0.01f));
+    }
+    long fim_bloco1 = tamanho(ARQ("log_data.bin"));
+    copiar(ARQ("log_tail.bin"), BSP_SPIFFS_MOUNT "/tail_antes.bin");
+
+    // 128ª amostra fecha o bloco 2; a queda corta a gravação no meio, com o
+    // tail ainda cheio (ele só é esvaziado depois do bloco gravado)
+    VERIFICAR(anexar(30.0f));
+    long fim_bloco2 = tamanho(ARQ("log_data.bin"));
+    VERIFICAR(fim_bloco2 > fim_bloco1);
+    VERIFICAR(truncate(ARQ("log_data.bin"), fim_bloco2 - 3) == 0);
+    VERIFICAR(rename(BSP_SPIFFS_MOUNT "/tail_antes.bin", ARQ("log_tail.bin")) == 0);
+
+    // Boot: o bloco incompleto é descartado e o tail volta a ser o bloco aberto;
+    // só a amostra que nunca chegou ao tail se perde
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(tamanho(ARQ("log_data.bin")) == fim_bloco1);
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 2 * LOG_BLOCK_MAX_SAMPLES - 1));
+    VERIFICAR(anexar(31.0f));
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 2 * LOG_BLOCK_MAX_SAMPLES));
+    VERIFICAR(tamanho(ARQ("log_data.bin")) > fim_bloco1);
+
+    // Lixo depois do último bloco completo também é cortado
+    long fim = tamanho(ARQ("log_data.bin"));
+    FILE *f = fopen(ARQ("log_data.bin"), "ab");
+    fputs("lixo de gravacao interrompida", f);
+    fclose(f);
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(tamanho(ARQ("log_data.bin")) == fim);
+    VERIFICAR(sequencia(ns, exportar_n(ns), 1, 2 * LOG_BLOCK_MAX_SAMPLES));
+}
+
+/* N dos pontos de temperatura do ar em /history */
+static int historico_n(int max, uint32_t *out)
+{
+    char *txt = data_logger_build_history_json(max);
+    cJSON *root = txt ? cJSON_Parse(txt) : NULL;
+    cJSON *pontos = cJSON_GetObjectItem(root, "temp_ar_points");
+    int k = 0;
+    cJSON *p;
+    cJSON_ArrayForEach(p, pontos) {
+        out[k++] = (uint32_t)cJSON_GetArrayItem(p, 0)->valueint;
+    }
+    cJSON_Delete(root);
+    free(txt);
+    return k;
+}
+
+static void testar_ultimos_registros(void)
+{
+    gui_recent_stats_t st;
+
+    limpar();
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(historico_n(20, ns) == 0);
+    VERIFICAR(data_logger_get_recent_stats(64, &st) && st.window_samples == 0);
+
+    // Só bloco aberto
+    for (int i = 1; i <= 10; i++) {
+        VERIFICAR(anexar(20.0f + (float)i * 0.01f));
+    }
+    VERIFICAR(sequencia(ns, historico_n(20, ns), 1, 10));
+
+    // Exatamente um bloco, bloco aberto vazio
+    for (int i = 11; i <= LOG_BLOCK_MAX_SAMPLES; i++) {
+        VERIFICAR(anexar(20.0f + (float)i * 0.01f));
+    }
+    VERIFICAR(sequencia(ns, historico_n(20, ns), LOG_BLOCK_MAX_SAMPLES - 19, 20));
+
+    // Dois blocos e 5 no aberto: janela atravessa a fronteira bloco/aberto
+    for (int i = LOG_BLOCK_MAX_SAMPLES + 1; i <= 2 * LOG_BLOCK_MAX_SAMPLES + 5; i++) {
+        VERIFICAR(anexar(20.0f + (float)i * 0.01f));
+    }
+    int total = 2 * LOG_BLOCK_MAX_SAMPLES + 5;
+    VERIFICAR(sequencia(ns, historico_n(20, ns), (uint32_t)total - 19, 20));
+
+    VERIFICAR(data_logger_get_recent_stats(64, &st));
+    VERIFICAR(st.window_samples == 64 && st.total_samples == total);
+    VERIFICAR_PERTO(st.temp_ar.min, 20.0 + (total - 63) * 0.01, 1e-3);
+    VERIFICAR_PERTO(st.temp_ar.max, 20.0 + total * 0.01, 1e-3);
+    VERIFICAR_PERTO(st.temp_ar.latest, 20.0 + total * 0.01, 1e-3);
+    VERIFICAR_PERTO(st.temp_ar.avg, 20.0 + (total - 31.5) * 0.01, 1e-3);
+
+    // Mesmo resultado depois de reiniciar (bloco aberto recarregado do tail)
+    VERIFICAR(data_logger_init() == ESP_OK);
+    VERIFICAR(sequencia(ns, historico_n(20, ns), (uint32_t)total - 19, 20));
+    VERIFICAR(data_logger_get_recent_stats(5, &st) && st.window_samples == 5);
+    VERIFICAR_PERTO(st.temp_ar.min, 20.0 + (total - 4) * 0.01, 1e-3);
+}
+
+int main(void)
+{
+    testar_migracao_csv();
+    testar_migracao_v1();
+    testar_migracao_refeita();
+    testar_queda_na_troca();
+    testar_bloco_final_rasgado();
+    testar_ultimos_registros();
+    limpar();
+    return TESTE_FIM();
+}
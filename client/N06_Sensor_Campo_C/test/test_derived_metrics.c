@@ -0,0 +1,176 @@
+#include "teste.h"
+#include "app_derived_metrics.h"
+#include "nvs.h"
+#include <math.h>
+#include <time.h>
+
+#define HORA_MS  (60U * 60U * 1000U)
+
+/* Teto do custo por amostra no host (VPD + orvalho + acumuladores). Folgado:
+ * pega regressão de ordem de grandeza (ex.: volta a libm em double ou a um
+ * laço por amostra), não variação de máquina. */
+#define CUSTO_MAX_NS  2000.0
+
+static double vpd_ref(double t, double ur)
+{
+    double es = 0.6108 * exp(17.27 * t / (t + 237.3));
+    return es * (1.0 - ur / 100.0);
+}
+
+static double orvalho_ref(double t, double ur)
+{
+    double g = log(ur / 100.0) + 17.27 * t / (237.3 + t);
+    return 237.3 * g / (17.27 - g);
+}
+
+static void testar_aproximacoes(void)
+{
+    double pior_exp = 0.0;
+    for (float x = -79.5f; x < 80.0f; x += 0.0137f) {
+        double ref = exp((double)x);
+        double erro = fabs(derived_fast_expf(x) - ref) / ref;
+        if (erro > pior_exp) {
+            pior_exp = erro;
+        }
+    }
+    VERIFICAR(pior_exp < 5e-6);
+
+    double pior_log = 0.0;
+    for (float x = 1e-4f; x < 1e4f; x *= 1.0071f) {
+        double erro = fabs(derived_fast_logf(x) - log((double)x));
+        if (erro > pior_log) {
+            pior_log = erro;
+        }
+    }
+    VERIFICAR(pior_log < 2e-6);
+
+    VERIFICAR(isnan(derived_fast_logf(0.0f)));
+    VERIFICAR(isnan(derived_fast_logf(-1.0f)));
+    VERIFICAR(derived_fast_expf(-100.0f) == 0.0f);
+}
+
+static void testar_magnus(void)
+{
+    for (float t = -10.0f; t <= 50.0f; t += 0.5f) {
+        for (float ur = 1.0f; ur <= 100.0f; ur += 1.5f) {
+            // Erro da exp rápida é relativo; acima de 40 °C o DPV passa de 7 kPa
+            VERIFICAR_PERTO(derived_metrics_vpd(t, ur), vpd_ref(t, ur), 1e-6 * vpd_ref(t, 0.0));
+            VERIFICAR_PERTO(derived_metrics_dew_point(t, ur), orvalho_ref(t, ur), 2e-5);
+        }
+    }
+    // Ar saturado: orvalho na própria temperatura, DPV nulo
+    VERIFICAR_PERTO(derived_metrics_dew_point(20.0f, 100.0f), 20.0, 1e-4);
+    VERIFICAR_PERTO(derived_metrics_vpd(20.0f, 100.0f), 0.0, 1e-7);
+
+    VERIFICAR(isnan(derived_metrics_vpd(NAN, 50.0f)));
+    VERIFICAR(isnan(derived_metrics_vpd(25.0f, 101.0f)));
+    VERIFICAR(isnan(derived_metrics_dew_point(25.0f, 0.0f)));
+    VERIFICAR(isnan(derived_metrics_dew_point(70.0f, 50.0f)));
+}
+
+static void testar_acumuladores(void)
+{
+    derived_metrics_t m;
+
+    nvs_falso_limpar();
+    VERIFICAR(derived_metrics_init() == ESP_OK);
+    derived_metrics_get(&m);
+    VERIFICAR(m.gdd_hoje == 0.0f && m.dli_hoje == 0.0f && m.dias == 0);
+
+    // 12 h a 25 °C e 10 klux em passos de 10 s: GDD 7,5; DLI 10000*0,0185*43200/1e6
+    for (int i = 0; i < 12 * 360; i++) {
+        derived_metrics_update(25.0f, 10000.0f, 10000);
+    }
+    derived_metrics_get(&m);
+    VERIFICAR_PERTO(m.gdd_hoje, 7.5, 1e-3);
+    VERIFICAR_PERTO(m.gdd_total, 7.5, 1e-3);
+    VERIFICAR_PERTO(m.dli_hoje, 7.992, 1e-3);
+
+    // Abaixo da base não soma GDD; NAN não soma nada
+    derived_metrics_update(5.0f, NAN, HORA_MS);
+    derived_metrics_update(NAN, NAN, HORA_MS);
+    derived_metrics_get(&m);
+    VERIFICAR_PERTO(m.gdd_hoje, 7.5, 1e-3);
+    VERIFICAR_PERTO(m.dli_hoje, 7.992, 1e-3);
+
+    // Reinício: o que foi gravado (a cada 30 min) volta do NVS
+    VERIFICAR(derived_metrics_init() == ESP_OK);
+    derived_metrics_get(&m);
+    VERIFICAR_PERTO(m.gdd_hoje, 7.5, 1e-3);
+    VERIFICAR(m.dias == 0);
+
+    // Fecha o dia ao completar 24 h de amostragem (14 h já contadas)
+    for (int i = 0; i < 10; i++) {
+        derived_metrics_update(20.0f, 0.0f, HORA_MS);
+    }
+    derived_metrics_get(&m);
+    VERIFICAR(m.dias == 1);
+    VERIFICAR_PERTO(m.gdd_ontem, 7.5 + 10.0 * 10.0 / 24.0, 1e-3);
+    VERIFICAR_PERTO(m.dli_ontem, 7.992, 1e-3);
+    VERIFICAR(m.gdd_hoje == 0.0f && m.dli_hoje == 0.0f);
+    VERIFICAR_PERTO(m.gdd_total, m.gdd_ontem, 1e-3);
+
+    // O fechamento do dia grava na hora
+    VERIFICAR(derived_metrics_init() == ESP_OK);
+    derived_metrics_get(&m);
+    VERIFICAR(m.dias == 1);
+
+    VERIFICAR(derived_metrics_reset() == ESP_OK);
+    VERIFICAR(derived_metrics_init() == ESP_OK);
+    derived_metrics_get(&m);
+    VERIFICAR(m.dias == 0 && m.gdd_total == 0.0f);
+}
+
+static void testar_blob_invalido(void)
+{
+    nvs_handle_t h;
+    uint8_t lixo[5] = {1, 2, 3, 4, 5};
+    derived_metrics_t m;
+
+    nvs_falso_limpar();
+    nvs_open("appcfg", NVS_READWRITE, &h);
+    nvs_set_blob(h, "derived", lixo, sizeof(lixo));
+    VERIFICAR(derived_metrics_init() == ESP_OK);
+    derived_metrics_get(&m);
+    VERIFICAR(m.gdd_total == 0.0f && m.dias == 0);
+}
+
+static double agora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void testar_custo(void)
+{
+    enum { N = 200000 };
+    volatile float sumidouro = 0.0f;
+
+    nvs_falso_limpar();
+    VERIFICAR(derived_metrics_init() == ESP_OK);
+
+    // dt de 1 ms: nem fecha o dia nem grava no NVS durante a medida
+    double inicio = agora_ns();
+    for (int i = 0; i < N; i++) {
+        float t = 5.0f + (float)(i % 400) * 0.1f;
+        float ur = 20.0f + (float)(i % 75);
+        sumidouro += derived_metrics_vpd(t, ur) + derived_metrics_dew_point(t, ur);
+        derived_metrics_update(t, (float)(i % 50000), 1);
+    }
+    double ns = (agora_ns() - inicio) / N;
+    (void)sumidouro;
+
+    printf("custo por amostra: %.1f ns\n", ns);
+    VERIFICAR(ns < CUSTO_MAX_NS);
+}
+
+int main(void)
+{
+    testar_aproximacoes();
+    testar_magnus();
+    testar_acumuladores();
+    testar_blob_invalido();
+    testar_custo();
+    return TESTE_FIM();
+}
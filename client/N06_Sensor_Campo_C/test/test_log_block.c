@@ -0,0 +1,143 @@
+#include "teste.h"
+#include "app_log_block.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t blk[LOG_BLOCK_MAX_BYTES];
+static log_record_t saida[LOG_BLOCK_MAX_SAMPLES];
+
+/* Passeio aleatório lento, como os sensores entre amostras de 1 min */
+static void gerar(log_record_t *recs, int count, uint32_t n0, unsigned semente)
+{
+    srand(semente);
+    log_record_t r = {
+        .n = n0, .temp_ar = 2530, .umid_ar = 652, .temp_solo = 2215, .umid_solo = 458,
+        .luminosidade = 20000, .dpv = 1127, .ponto_orvalho = 1829,
+    };
+    for (int i = 0; i < count; i++) {
+        recs[i] = r;
+        r.n += 1;
+        r.temp_ar += (int16_t)(rand() % 7 - 3);
+        r.umid_ar += (uint16_t)(rand() % 5 - 2);
+        r.temp_solo += (int16_t)(rand() % 3 - 1);
+        r.luminosidade += (uint16_t)(rand() % 41 - 20);
+        r.dpv += (uint16_t)(rand() % 9 - 4);
+        r.ponto_orvalho += (int16_t)(rand() % 5 - 2);
+    }
+}
+
+static bool ida_e_volta(const log_record_t *recs, int count, size_t *len_out)
+{
+    size_t len = log_block_encode(recs, count, blk, sizeof(blk));
+    if (len_out) *len_out = len;
+    if (len == 0) {
+        return false;
+    }
+    log_block_header_t hdr;
+    memcpy(&hdr, blk, sizeof(hdr));
+    return log_block_size(&hdr) == len &&
+           (size_t)(blk[len - 2] | (blk[len - 1] << 8)) == len &&
+           log_block_decode(blk, len, saida) == count &&
+           memcmp(saida, recs, (size_t)count * sizeof(log_record_t)) == 0;
+}
+
+static void testar_ida_e_volta(void)
+{
+    log_record_t recs[LOG_BLOCK_MAX_SAMPLES];
+    static const int contagens[] = { 1, 2, 3, 17, 63, 64 };
+    size_t len;
+
+    for (size_t k = 0; k < sizeof(contagens) / sizeof(contagens[0]); k++) {
+        gerar(recs, contagens[k], 1000, (unsigned)k + 1);
+        VERIFICAR(ida_e_volta(recs, contagens[k], &len));
+    }
+
+    // Bloco cheio de sensores lentos: poucos bytes por amostra
+    gerar(recs, LOG_BLOCK_MAX_SAMPLES, 1, 42);
+    VERIFICAR(ida_e_volta(recs, LOG_BLOCK_MAX_SAMPLES, &len));
+    VERIFICAR(len < LOG_BLOCK_MAX_SAMPLES * 5);
+
+    // Um registro só: cabeçalho e trailer, sem bits
+    VERIFICAR(ida_e_volta(recs, 1, &len));
+    VERIFICAR(len == sizeof(log_block_header_t) + LOG_BLOCK_TRAILER_BYTES);
+
+    // Canais constantes e N contínuo: largura zero em tudo
+    for (int i = 0; i < LOG_BLOCK_MAX_SAMPLES; i++) {
+        recs[i] = recs[0];
+        recs[i].n = 500 + (uint32_t)i;
+    }
+    VERIFICAR(ida_e_volta(recs, LOG_BLOCK_MAX_SAMPLES, &len));
+    VERIFICAR(len == sizeof(log_block_header_t) + LOG_BLOCK_TRAILER_BYTES);
+}
+
+static void testar_pior_caso(void)
+{
+    log_record_t recs[LOG_BLOCK_MAX_SAMPLES];
+    size_t len;
+
+    // Extremos alternados e sentinelas; N salta de ponta a ponta da faixa
+    for (int i = 0; i < LOG_BLOCK_MAX_SAMPLES; i++) {
+        bool par = (i % 2) == 0;
+        recs[i] = (log_record_t){
+            .n = par ? 1U : UINT32_MAX,
+            .temp_ar = par ? INT16_MIN : INT16_MAX,
+            .umid_ar = par ? 0 : UINT16_MAX,
+            .temp_solo = par ? INT16_MAX : INT16_MIN,
+            .umid_solo = par ? UINT16_MAX : 0,
+            .luminosidade = par ? 0 : UINT16_MAX,
+            .dpv = par ? UINT16_MAX : 0,
+            .ponto_orvalho = par ? INT16_MIN : INT16_MAX,
+        };
+    }
+    VERIFICAR(ida_e_volta(recs, LOG_BLOCK_MAX_SAMPLES, &len));
+    VERIFICAR(len <= LOG_BLOCK_MAX_BYTES);
+
+    // Buffer justo aceita; um byte a menos recusa
+    VERIFICAR(log_block_encode(recs, LOG_BLOCK_MAX_SAMPLES, blk, len) == len);
+    VERIFICAR(log_block_encode(recs, LOG_BLOCK_MAX_SAMPLES, blk, len - 1) == 0);
+}
+
+static void testar_invalidos(void)
+{
+    log_record_t recs[LOG_BLOCK_MAX_SAMPLES] = {0};
+    size_t len;
+
+    VERIFICAR(log_block_encode(recs, 0, blk, sizeof(blk)) == 0);
+    VERIFICAR(log_block_encode(recs, LOG_BLOCK_MAX_SAMPLES + 1, blk, sizeof(blk)) == 0);
+
+    gerar(recs, 40, 1, 7);
+    len = log_block_encode(recs, 40, blk, sizeof(blk));
+    VERIFICAR(len > 0);
+
+    // Bloco truncado (queda durante a gravação)
+    VERIFICAR(log_block_decode(blk, len - 1, saida) == -1);
+    VERIFICAR(log_block_decode(blk, sizeof(log_block_header_t) - 1, saida) == -1);
+
+    // Trailer que não confere
+    blk[len - 1] ^= 0x01;
+    VERIFICAR(log_block_decode(blk, len, saida) == -1);
+    blk[len - 1] ^= 0x01;
+    VERIFICAR(log_block_decode(blk, len, saida) == 40);
+
+    // Cabeçalho corrompido
+    log_block_header_t hdr;
+    memcpy(&hdr, blk, sizeof(hdr));
+    hdr.sync ^= 0xFF;
+    VERIFICAR(log_block_size(&hdr) == 0);
+    hdr.sync = LOG_BLOCK_SYNC;
+    hdr.count = 0;
+    VERIFICAR(log_block_size(&hdr) == 0);
+    hdr.count = LOG_BLOCK_MAX_SAMPLES + 1;
+    VERIFICAR(log_block_size(&hdr) == 0);
+    hdr.count = 40;
+    hdr.width[3] = 65;
+    VERIFICAR(log_block_size(&hdr) == 0);
+}
+
+int main(void)
+{
+    testar_ida_e_volta();
+    testar_pior_caso();
+    testar_invalidos();
+    return TESTE_FIM();
+}
@@ -0,0 +1,111 @@
+#include "teste.h"
+#include "app_log_record.h"
+#include <string.h>
+
+static log_entry_t amostra(float t, float ur, float ts, float us, float lux, float dpv, float po)
+{
+    log_entry_t e = {
+        .temp_ar = t, .umid_ar = ur, .temp_solo = ts, .umid_solo = us,
+        .luminosidade = lux, .dpv = dpv, .ponto_orvalho = po,
+    };
+    return e;
+}
+
+static void testar_ida_e_volta(void)
+{
+    log_record_t rec;
+    log_entry_t out;
+
+    VERIFICAR(sizeof(log_record_t) == 18);
+    VERIFICAR(sizeof(log_file_header_t) == 8);
+
+    // Canais lineares voltam com erro de no máximo meio passo
+    for (int i = 0; i < 2000; i++) {
+        float t = -40.0f + (float)i * 0.0437f;
+        float ur = (float)i * 0.05f;
+        log_entry_t e = amostra(t, ur, t * 0.5f, 100.0f - ur, 0.0f, (float)i * 0.0031f, t - 5.0f);
+        log_record_encode((uint32_t)i + 1, &e, &rec);
+        log_record_decode(&rec, &out);
+        VERIFICAR(rec.n == (uint32_t)i + 1);
+        VERIFICAR_PERTO(out.temp_ar, e.temp_ar, 0.005 + 1e-4);
+        VERIFICAR_PERTO(out.umid_ar, e.umid_ar, 0.05 + 1e-4);
+        VERIFICAR_PERTO(out.temp_solo, e.temp_solo, 0.005 + 1e-4);
+        VERIFICAR_PERTO(out.umid_solo, e.umid_solo, 0.05 + 1e-4);
+        VERIFICAR_PERTO(out.dpv, e.dpv, 0.0005 + 1e-5);
+        VERIFICAR_PERTO(out.ponto_orvalho, e.ponto_orvalho, 0.005 + 1e-4);
+    }
+
+    // Luz: erro relativo constante (meio passo de 2^(1/2048)) de 1 lux a 120 klux
+    for (float lux = 1.0f; lux < 120000.0f; lux *= 1.37f) {
+        log_entry_t e = amostra(20.0f, 50.0f, 20.0f, 50.0f, lux, 1.0f, 10.0f);
+        log_record_encode(1, &e, &rec);
+        log_record_decode(&rec, &out);
+        VERIFICAR_PERTO(out.luminosidade, lux, (1.0 + lux) * 2e-4);
+    }
+    log_entry_t escuro = amostra(20.0f, 50.0f, 20.0f, 50.0f, 0.0f, 1.0f, 10.0f);
+    log_record_encode(1, &escuro, &rec);
+    log_record_decode(&rec, &out);
+    VERIFICAR(out.luminosidade == 0.0f);
+}
+
+static void testar_ausentes_e_saturacao(void)
+{
+    log_record_t rec;
+    log_entry_t out;
+
+    log_entry_t vazia = amostra(NAN, NAN, NAN, NAN, NAN, NAN, NAN);
+    log_record_encode(7, &vazia, &rec);
+    VERIFICAR(rec.temp_ar == LOG_REC_NAN_I16 && rec.umid_ar == LOG_REC_NAN_U16);
+    VERIFICAR(rec.luminosidade == LOG_REC_NAN_U16 && rec.ponto_orvalho == LOG_REC_NAN_I16);
+    log_record_decode(&rec, &out);
+    VERIFICAR(isnan(out.temp_ar) && isnan(out.umid_ar) && isnan(out.temp_solo));
+    VERIFICAR(isnan(out.umid_solo) && isnan(out.luminosidade) && isnan(out.dpv));
+    VERIFICAR(isnan(out.ponto_orvalho));
+
+    // Fora da faixa satura sem virar sentinela (leitura absurda não some como NAN)
+    log_entry_t fora = amostra(1000.0f, 9000.0f, -1000.0f, -5.0f, -3.0f, 100.0f, INFINITY);
+    log_record_encode(8, &fora, &rec);
+    VERIFICAR(rec.temp_ar == INT16_MAX);
+    VERIFICAR(rec.umid_ar == UINT16_MAX - 1);
+    VERIFICAR(rec.temp_solo == -INT16_MAX);
+    VERIFICAR(rec.umid_solo == 0);
+    VERIFICAR(rec.luminosidade == 0);
+    VERIFICAR(rec.dpv == UINT16_MAX - 1);
+    VERIFICAR(rec.ponto_orvalho == LOG_REC_NAN_I16);
+}
+
+static void testar_csv(void)
+{
+    char buf[LOG_RECORD_CSV_MAX];
+    log_record_t rec;
+
+    log_entry_t e = amostra(25.3f, 65.2f, -0.05f, 45.8f, 850.0f, 1.127f, 18.29f);
+    log_record_encode(1, &e, &rec);
+    int len = log_record_format_csv(&rec, buf, sizeof(buf));
+    VERIFICAR(len == (int)strlen(buf));
+    // Luz volta pela codificação logarítmica: 850 lux -> 849.94
+    VERIFICAR(strcmp(buf, "1,25.30,65.2,-0.05,45.8,849.94,1.127,18.29\n") == 0);
+
+    log_entry_t vazia = amostra(NAN, NAN, NAN, NAN, NAN, NAN, NAN);
+    log_record_encode(4294967295U, &vazia, &rec);
+    log_record_format_csv(&rec, buf, sizeof(buf));
+    VERIFICAR(strcmp(buf, "4294967295,nan,nan,nan,nan,nan,nan,nan\n") == 0);
+
+    // Buffer menor que o máximo: nada é escrito
+    VERIFICAR(log_record_format_csv(&rec, buf, LOG_RECORD_CSV_MAX - 1) == 0 && buf[0] == '\0');
+
+    // Mesmas colunas do cabeçalho
+    int virgulas = 0;
+    for (const char *p = LOG_RECORD_CSV_HEADER; *p; p++) {
+        virgulas += (*p == ',');
+    }
+    VERIFICAR(virgulas == 7);
+}
+
+int main(void)
+{
+    testar_ida_e_volta();
+    testar_ausentes_e_saturacao();
+    testar_csv();
+    return TESTE_FIM();
+}
@@ -0,0 +1,216 @@
+"""
+Servidor HTTPS de teste para o envio de fotos do N04
+(client/N04_Estufa_Camera_C/main/envio/upload.h).
+
+Faz o papel do nginx + /upload de server01Full.py: aceita POST /upload
+com HTTP/1.1 keep-alive e mostra, para cada foto, se a conexão TLS é
+nova ou reaproveitada, se o handshake foi retomado e a vazão recebida.
+Também simula problemas para exercitar a reconexão do nó:
+
+    --fechar-apos N   responde "Connection: close" a cada N fotos
+    --ocioso S        fecha conexões paradas há S s (keepalive_timeout do nginx)
+    --falhar P        responde 500 com probabilidade P
+    --atraso-ms M     espera M ms antes de responder
+    --cortar P        derruba a conexão no meio do corpo com probabilidade P
+
+Retomada (UPLOAD_RETOMAR no nó): o corpo recebido de cada X-Upload-Id
+fica guardado até a foto completar; HEAD /upload responde quantos bytes
+já chegaram em X-Upload-Offset e um POST com X-Upload-Offset continua
+dali.
+
+Certificado de teste (CN/SAN = IP da máquina) no lugar de
+main/certs/greense_cert.pem e CAMERA_UPLOAD_URL "https://IP:8443/upload":
+
+    openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes \\
+        -keyout teste.key -out teste.pem -days 30 -subj "/CN=192.168.0.10" \\
+        -addext "subjectAltName=IP:192.168.0.10"
+    python3 camera_teste.py --cert teste.pem --key teste.key --port 8443
+"""
+
+import argparse
+import itertools
+import json
+import os
+import random
+import socket
+import ssl
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+_conexoes = itertools.count(1)
+_lock = threading.Lock()
+_parciais = {}      # X-Upload-Id -> bytes já recebidos
+
+
+def _agora():
+    return time.strftime("%H:%M:%S")
+
+
+class Servidor(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, endereco, ctx, args):
+        super().__init__(endereco, Handler)
+        self.ctx = ctx
+        self.args = args
+        self.total = {"fotos": 0, "bytes": 0, "conexoes": 0, "retomadas": 0, "continuadas": 0}
+
+    def get_request(self):
+        sock, endereco = self.socket.accept()
+        inicio = time.perf_counter()
+        try:
+            tls = self.ctx.wrap_socket(sock, server_side=True)
+        except (ssl.SSLError, OSError) as e:
+            sock.close()
+            print(f"{_agora()} {endereco[0]}: falha no handshake ({e})")
+            raise
+        tls.numero = next(_conexoes)
+        tls.fotos = 0
+        retomada = tls.session_reused
+        with _lock:
+            self.total["conexoes"] += 1
+            self.total["retomadas"] += retomada
+        print(f"{_agora()} {endereco[0]}: conexão {tls.numero}, {tls.version()} "
+              f"{'retomado' if retomada else 'completo'} em {(time.perf_counter() - inicio) * 1000:.0f} ms")
+        if self.args.ocioso:
+            tls.settimeout(self.args.ocioso)
+        return tls, endereco
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, formato, *args):
+        pass
+
+    def _responder(self, status, corpo, fechar=False, cabecalhos=None):
+        dados = json.dumps(corpo).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(dados)))
+        for chave, valor in (cabecalhos or {}).items():
+            self.send_header(chave, valor)
+        if fechar:
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        self.end_headers()
+        if self.command != "HEAD":
+            self.wfile.write(dados)
+
+    def do_HEAD(self):
+        if self.path != "/upload":
+            self._responder(404, {"erro": "rota"})
+            return
+        envio = self.headers.get("X-Upload-Id", "")
+        with _lock:
+            recebidos = len(_parciais.get(envio, b""))
+        print(f"{_agora()}   {envio or '?'}: servidor tem {recebidos} bytes")
+        self._responder(200, {"offset": recebidos}, cabecalhos={"X-Upload-Offset": str(recebidos)})
+
+    def _ler_corpo(self, tamanho, envio, anterior):
+        """Lê em blocos, guardando o parcial do envio; None se a conexão caiu."""
+        recebido = bytearray()
+        corte = tamanho // 2 if random.random() < self.server.args.cortar else None
+        while len(recebido) < tamanho:
+            if corte is not None and len(recebido) >= corte:
+                print(f"{_agora()}   derrubando a conexão com {len(recebido)} de {tamanho} bytes (simulado)")
+                self.close_connection = True
+                self.connection.shutdown(socket.SHUT_RDWR)
+                return None
+            bloco = self.rfile.read(min(8192, tamanho - len(recebido)))
+            if not bloco:
+                self.close_connection = True
+                return None
+            recebido += bloco
+            if envio:
+                with _lock:
+                    _parciais[envio] = anterior + bytes(recebido)
+        return anterior + bytes(recebido)
+
+    def do_POST(self):
+        if self.path != "/upload":
+            self._responder(404, {"erro": "rota"})
+            return
+        args = self.server.args
+        conexao = self.connection
+        conexao.fotos += 1
+
+        tamanho = int(self.headers.get("Content-Length", 0))
+        envio = self.headers.get("X-Upload-Id", "")
+        offset = int(self.headers.get("X-Upload-Offset", 0))
+        with _lock:
+            anterior = _parciais.get(envio, b"")[:offset] if envio else b""
+        if len(anterior) != offset:
+            self._responder(409, {"erro": "offset", "tem": len(anterior)}, fechar=True)
+            return
+
+        inicio = time.perf_counter()
+        conteudo = self._ler_corpo(tamanho, envio, anterior)
+        dt = time.perf_counter() - inicio
+        if conteudo is None:
+            return
+        if envio:
+            with _lock:
+                _parciais.pop(envio, None)
+
+        with _lock:
+            self.server.total["fotos"] += 1
+            self.server.total["bytes"] += tamanho
+            self.server.total["continuadas"] += offset > 0
+            n = self.server.total["fotos"]
+        kbps = tamanho / 1024 / dt if dt > 0 else 0
+        # Reenvio de pendentes (envio/pendentes.h) traz o nome do arquivo no SD
+        nome = os.path.basename(self.headers.get("X-Foto", ""))
+        print(f"{_agora()}   foto {n}: conexão {conexao.numero} (pedido {conexao.fotos}), "
+              f"{tamanho} bytes em {dt * 1000:.0f} ms ({kbps:.0f} KB/s)"
+              + (f", continuada de {offset}" if offset else "")
+              + (f", reenvio de {nome}" if nome else ""))
+        if args.salvar:
+            os.makedirs(args.salvar, exist_ok=True)
+            with open(os.path.join(args.salvar, nome or f"foto_{n:05d}.jpg"), "wb") as f:
+                f.write(conteudo)
+        if args.atraso_ms:
+            time.sleep(args.atraso_ms / 1000)
+        if random.random() < args.falhar:
+            print(f"{_agora()}   foto {n}: respondendo 500 (simulado)")
+            self._responder(500, {"erro": "simulado"})
+            return
+        fechar = bool(args.fechar_apos) and conexao.fotos % args.fechar_apos == 0
+        self._responder(200, {"status": "ok", "foto": n}, fechar=fechar)
+
+    def handle(self):
+        try:
+            super().handle()
+        except (socket.timeout, ConnectionError, ssl.SSLError):
+            pass
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Servidor HTTPS de teste para as fotos do N04")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", required=True)
+    parser.add_argument("--key", required=True)
+    parser.add_argument("--fechar-apos", type=int, default=0)
+    parser.add_argument("--ocioso", type=float, default=75, help="s; 0 = sem limite")
+    parser.add_argument("--falhar", type=float, default=0.0)
+    parser.add_argument("--atraso-ms", type=int, default=0)
+    parser.add_argument("--cortar", type=float, default=0.0)
+    parser.add_argument("--salvar", help="diretório para gravar as fotos recebidas")
+    parser.add_argument("--tls13", action="store_true", help="permite TLS 1.3")
+    args = parser.parse_args()
+
+    ctx = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+    ctx.load_cert_chain(args.cert, args.key)
+    if not args.tls13:
+        # O mbedTLS dos nós negocia TLS 1.2
+        ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    servidor = Servidor(("", args.port), ctx, args)
+    print(f"Aguardando fotos em https://0.0.0.0:{args.port}/upload")
+    try:
+        servidor.serve_forever()
+    except KeyboardInterrupt:
+        t = servidor.total
+        print(f"\n{t['fotos']} fotos, {t['bytes']} bytes, {t['conexoes']} conexões "
+              f"({t['retomadas']} com handshake retomado), {t['continuadas']} fotos continuadas")
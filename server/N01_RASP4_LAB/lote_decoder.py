@@ -0,0 +1,132 @@
+"""
+Decodificador de referência do lote binário publicado pelos nós N01/N02
+(client/N0x/main/fila/lote.h).
+
+Lote v2 (little-endian):
+    u8  versão do esquema
+    u8  layout da amostra (1 = N01 germinar, 2 = N02 maturar)
+    u8  tamanho S de cada amostra
+    u8  número n de amostras
+    u32 seq da primeira amostra
+    u16 amostras pendentes na fila do nó
+    u32 boot da primeira amostra (boot0)
+    u64 horário Unix (ms) da primeira amostra com horário (ts0), 0 se nenhuma
+    n × { u16 seq - seq0 ; u32 atraso_ms ; u8 info ; u32 t ; S bytes da amostra }
+
+info: bits 0-6 = boot - boot0; bit 7 = t é o horário relativo a ts0 (i32).
+Sem o bit 7, t é o instante da leitura em ms desde o boot (t_boot_ms).
+O v1 não tem boot0, ts0, info nem t.
+
+Cada amostra decodificada é um dict com as mesmas chaves do JSON por
+amostra (temp, umid, ..., seq, boot, t_boot_ms, ts, fila, atraso_ms),
+então pode ser passada direto para o mesmo processamento.
+"""
+
+import struct
+import sys
+
+VERSAO = 2
+ATRASO_DESCONHECIDO = 0xFFFFFFFF
+INFO_HORARIO = 0x80
+
+_CABECALHO = {1: struct.Struct("<BBBBIH"), 2: struct.Struct("<BBBBIHIQ")}
+_ITEM = {1: struct.Struct("<HI"), 2: struct.Struct("<HIBI")}
+
+# Campos comuns de sensor_amostra_t: (nome, escala). Escala int mantém o
+# valor inteiro; escala float gera float, como no JSON (evita conflito de
+# tipo de campo no InfluxDB).
+_COMUNS = [
+    ("temp", 100.0),
+    ("umid", 100.0),
+    ("co2", 1.0),
+    ("flags", None),
+    ("temp_reserv_int", 100.0),
+    ("ph", 100.0),
+    ("ec", 100.0),
+    ("temp_reserv_ext", 100.0),
+]
+
+LAYOUTS = {
+    1: (struct.Struct("<hHHBhHHhHH"),
+        _COMUNS + [("umid_solo_raw", 1), ("umid_solo_pct", 100.0)]),
+    2: (struct.Struct("<hHHBhHHhhH"),
+        _COMUNS + [("temp_externa", 100.0), ("umid_externa", 100.0)]),
+}
+
+
+class LoteInvalido(ValueError):
+    pass
+
+
+def _expandir(campos, valores):
+    amostra = {}
+    for (nome, escala), valor in zip(campos, valores):
+        if nome == "flags":
+            amostra["luz"] = 1.0 if valor & 0x01 else 0.0
+            amostra["agua_min"] = 1 if valor & 0x02 else 0
+            amostra["agua_max"] = 1 if valor & 0x04 else 0
+        elif isinstance(escala, int):
+            amostra[nome] = int(valor)
+        else:
+            amostra[nome] = round(valor / escala, 2)
+    return amostra
+
+
+def decodificar_lote(payload):
+    """Retorna (cabecalho, [amostras]) ou levanta LoteInvalido."""
+    if len(payload) < 1 or payload[0] not in _CABECALHO:
+        versao = payload[0] if payload else None
+        raise LoteInvalido(f"versão de esquema {versao} não suportada")
+    versao = payload[0]
+    cab_fmt, item_fmt = _CABECALHO[versao], _ITEM[versao]
+    if len(payload) < cab_fmt.size:
+        raise LoteInvalido("lote menor que o cabeçalho")
+
+    campos_cab = cab_fmt.unpack_from(payload, 0)
+    _, layout, tamanho, n, seq0, fila = campos_cab[:6]
+    boot0, ts0 = campos_cab[6:] if versao >= 2 else (None, 0)
+    if layout not in LAYOUTS:
+        raise LoteInvalido(f"layout {layout} desconhecido")
+
+    formato, campos = LAYOUTS[layout]
+    if tamanho != formato.size:
+        raise LoteInvalido(f"amostra de {tamanho} bytes, layout {layout} espera {formato.size}")
+
+    esperado = cab_fmt.size + n * (item_fmt.size + tamanho)
+    if len(payload) != esperado:
+        raise LoteInvalido(f"lote com {len(payload)} bytes, esperado {esperado}")
+
+    amostras = []
+    pos = cab_fmt.size
+    for _ in range(n):
+        item = item_fmt.unpack_from(payload, pos)
+        pos += item_fmt.size
+        amostra = _expandir(campos, formato.unpack_from(payload, pos))
+        pos += tamanho
+
+        dseq, atraso = item[:2]
+        amostra["seq"] = seq0 + dseq
+        if versao >= 2:
+            info, t = item[2:]
+            amostra["boot"] = boot0 + (info & ~INFO_HORARIO)
+            if info & INFO_HORARIO:
+                amostra["ts"] = ts0 + struct.unpack("<i", struct.pack("<I", t))[0]
+            else:
+                amostra["t_boot_ms"] = t
+        amostra["fila"] = fila
+        if atraso != ATRASO_DESCONHECIDO:
+            amostra["atraso_ms"] = atraso
+        amostras.append(amostra)
+
+    cabecalho = {"versao": versao, "layout": layout, "seq0": seq0, "fila": fila, "n": n}
+    if versao >= 2:
+        cabecalho.update({"boot0": boot0, "ts0": ts0})
+    return cabecalho, amostras
+
+
+if __name__ == "__main__":
+    # Uso: python3 lote_decoder.py <payload em hex>
+    cab, lista = decodificar_lote(bytes.fromhex(sys.argv[1]))
+    print(cab)
+    for a in lista:
+        print(a)
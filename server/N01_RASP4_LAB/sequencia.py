@@ -0,0 +1,212 @@
+"""
+Estatísticas do fluxo de amostras dos nós N01/N02 a partir de seq, boot
+e ts (client/N0x/main/fila/relogio.h).
+
+- seq é global no nó e continua entre boots (fila persistente), então
+  buracos são perdas e seq repetida é duplicata (reentrega QoS 1 ou
+  reenvio após queda); seq que volta muito com boot novo indica fila
+  apagada e reinicia o fluxo
+- amostras suprimidas pela banda morta não recebem seq, não contam
+- latência = chegada no servidor - ts (só amostras com horário SNTP)
+
+Uso no servidor: MonitorSequencia.duplicada() antes de gravar e
+registrar() só depois que a gravação deu certo (se ela falhar, a
+reentrega da mesma seq ainda é aceita). Uso avulso contra um broker
+(mosquitto local ou o de produção):
+
+    python3 sequencia.py --host localhost --port 1883 --intervalo 60
+"""
+
+import argparse
+import json
+import time
+from collections import deque
+
+# Seqs acompanhadas uma a uma; abaixo da janela a perda já foi contada e
+# uma chegada tardia é tratada como duplicata (memória limitada)
+JANELA = 8192
+# Volta de seq maior que isso com boot novo = fila do nó recomeçou
+VOLTA_REINICIO = 1000
+LATENCIAS_MAX = 2000
+
+
+def _percentil(ordenados, p):
+    if not ordenados:
+        return None
+    i = min(len(ordenados) - 1, int(round(p / 100.0 * (len(ordenados) - 1))))
+    return ordenados[i]
+
+
+class _Fluxo:
+    def __init__(self):
+        self.vistos = set()
+        self.base = None          # início da janela depois do primeiro corte
+        self.perdidas_antigas = 0
+        self.seq_min = None
+        self.seq_max = None
+        self.recebidas = 0
+        self.duplicadas = 0
+        self.fora_de_ordem = 0
+        self.sem_horario = 0
+        self.reinicios = 0
+        self.boot = None
+        self.latencias = deque(maxlen=LATENCIAS_MAX)
+
+    def _recomecou(self, seq, boot):
+        return (self.seq_max is not None and boot is not None and boot != self.boot
+                and seq + VOLTA_REINICIO < self.seq_max)
+
+    def duplicada(self, seq, boot):
+        if self._recomecou(seq, boot):
+            return False
+        return seq in self.vistos or (self.base is not None and seq < self.base)
+
+    def _reiniciar(self):
+        self.perdidas_antigas = self.perdidas()
+        self.vistos.clear()
+        self.base = self.seq_min = self.seq_max = None
+        self.reinicios += 1
+
+    def registrar(self, seq, boot, ts, recebido_ms):
+        if self._recomecou(seq, boot):
+            self._reiniciar()
+        if boot is not None:
+            self.boot = boot
+
+        if self.duplicada(seq, boot):
+            self.duplicadas += 1
+            return False
+
+        if self.seq_max is not None and seq < self.seq_max:
+            self.fora_de_ordem += 1
+        self.vistos.add(seq)
+        self.recebidas += 1
+        self.seq_min = seq if self.seq_min is None else min(self.seq_min, seq)
+        self.seq_max = seq if self.seq_max is None else max(self.seq_max, seq)
+        if self.seq_max - self._inicio() >= 2 * JANELA:
+            self._cortar(self.seq_max - JANELA)
+
+        if ts is None:
+            self.sem_horario += 1
+        else:
+            self.latencias.append(recebido_ms - ts)
+        return True
+
+    def _inicio(self):
+        return self.seq_min if self.base is None else self.base
+
+    def _cortar(self, limite):
+        # Buracos abaixo de limite viram perda definitiva
+        abaixo = sum(1 for s in self.vistos if s <= limite)
+        self.perdidas_antigas += (limite - self._inicio() + 1) - abaixo
+        self.vistos = {s for s in self.vistos if s > limite}
+        self.base = limite + 1
+
+    def perdidas(self):
+        if self.seq_max is None:
+            return self.perdidas_antigas
+        return self.perdidas_antigas + (self.seq_max - self._inicio() + 1) - len(self.vistos)
+
+    def resumo(self):
+        lat = sorted(self.latencias)
+        return {
+            "recebidas": self.recebidas,
+            "perdidas": self.perdidas(),
+            "duplicadas": self.duplicadas,
+            "fora_de_ordem": self.fora_de_ordem,
+            "sem_horario": self.sem_horario,
+            "reinicios": self.reinicios,
+            "boot": self.boot,
+            "seq_min": self.seq_min,
+            "seq_max": self.seq_max,
+            "latencia_ms": {
+                "n": len(lat),
+                "p50": _percentil(lat, 50),
+                "p90": _percentil(lat, 90),
+                "p99": _percentil(lat, 99),
+                "max": lat[-1] if lat else None,
+            },
+        }
+
+
+class MonitorSequencia:
+    """Um fluxo por dispositivo (tópico do nó)."""
+
+    def __init__(self):
+        self.fluxos = {}
+
+    def duplicada(self, dispositivo, amostra):
+        """True se a seq da amostra já foi registrada; não altera o fluxo."""
+        seq = amostra.get("seq")
+        fluxo = self.fluxos.get(dispositivo)
+        if seq is None or fluxo is None:
+            return False
+        if fluxo.duplicada(int(seq), amostra.get("boot")):
+            fluxo.duplicadas += 1
+            return True
+        return False
+
+    def registrar(self, dispositivo, amostra, recebido_ms=None):
+        """Retorna False se a amostra é duplicata (ou não tem seq: True)."""
+        seq = amostra.get("seq")
+        if seq is None:
+            return True
+        if recebido_ms is None:
+            recebido_ms = int(time.time() * 1000)
+        fluxo = self.fluxos.setdefault(dispositivo, _Fluxo())
+        return fluxo.registrar(int(seq), amostra.get("boot"), amostra.get("ts"), recebido_ms)
+
+    def resumo(self):
+        return {d: f.resumo() for d, f in self.fluxos.items()}
+
+    def imprimir(self):
+        for dispositivo, r in self.resumo().items():
+            lat = r["latencia_ms"]
+            print(f"📈 {dispositivo}: {r['recebidas']} recebidas, {r['perdidas']} perdidas, "
+                  f"{r['duplicadas']} duplicadas, {r['fora_de_ordem']} fora de ordem "
+                  f"(boot {r['boot']}, seq {r['seq_min']}..{r['seq_max']})")
+            if lat["n"]:
+                print(f"   ⏱️  Latência leitura→servidor: p50 {lat['p50']} ms, p90 {lat['p90']} ms, "
+                      f"p99 {lat['p99']} ms, máx {lat['max']} ms ({lat['n']} amostras)")
+            if r["sem_horario"]:
+                print(f"   ⚠️  {r['sem_horario']} amostras sem horário (nó sem SNTP)")
+
+
+def amostras_da_mensagem(topico, payload):
+    """(dispositivo, [amostras]) de uma mensagem JSON ou de lote."""
+    if topico.endswith("/lote"):
+        from lote_decoder import decodificar_lote
+        _, amostras = decodificar_lote(payload)
+        return topico[:-len("/lote")], amostras
+    return topico, [json.loads(payload.decode())]
+
+
+if __name__ == "__main__":
+    import paho.mqtt.client as mqtt
+
+    parser = argparse.ArgumentParser(description="Perdas, duplicatas e latência das amostras N01/N02")
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--intervalo", type=int, default=60, help="segundos entre relatórios")
+    args = parser.parse_args()
+
+    monitor = MonitorSequencia()
+    ultimo = [time.time()]
+
+    def on_message(client, userdata, msg):
+        try:
+            dispositivo, amostras = amostras_da_mensagem(msg.topic, msg.payload)
+            for amostra in amostras:
+                monitor.registrar(dispositivo, amostra)
+        except Exception as e:
+            print(f"❌ {msg.topic}: {e}")
+        if time.time() - ultimo[0] >= args.intervalo:
+            monitor.imprimir()
+            ultimo[0] = time.time()
+
+    cliente = mqtt.Client()
+    cliente.on_message = on_message
+    cliente.connect(args.host, args.port, 60)
+    for topico in ("estufa/germinar", "estufa/maturar", "estufa/germinar/lote", "estufa/maturar/lote"):
+        cliente.subscribe(topico, qos=1)
+    cliente.loop_forever()
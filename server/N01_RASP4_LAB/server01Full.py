@@ -7,10 +7,12 @@ from datetime import datetime
 import threading
 import config
 import os
+import re
 from flask import send_from_directory
 import numpy as np
 import csv
 from queue import Queue
+from sequencia import MonitorSequencia, amostras_da_mensagem
 
 # ========== CONFIGURAÇÕES ==========
 INFLUXDB_HOST = "localhost"
@@ -283,6 +285,9 @@ def serve_ultima_imagem():
 
     return send_from_directory(diretorio_fotos, "ultima.jpg")
 
+# Nome de foto aceito no X-Foto: sem diretório, sem começar com ponto
+NOME_FOTO_RE = re.compile(r"[A-Za-z0-9_-][A-Za-z0-9_.-]*\.jpg")
+
 @app.route("/upload", methods=["POST"])
 def upload_foto():
     """Upload de imagens das câmeras"""
@@ -305,25 +310,37 @@ def upload_foto():
         if not conteudo:
             return jsonify({"erro": "Imagem vazia"}), 400
 
-        # Salva arquivo com timestamp
-        nome_arquivo = datetime.now().strftime(f"{camera_id}_%Y%m%d_%H%M%S.jpg")
+        # Reenvio do diário de pendentes: X-Foto traz o nome da foto no SD
+        # (hora da captura, não da chegada). Só aceita nome simples.
+        nome_sd = request.headers.get("X-Foto")
+        if nome_sd is not None:
+            if not NOME_FOTO_RE.fullmatch(nome_sd):
+                return jsonify({"erro": f"X-Foto inválido: {nome_sd!r}"}), 400
+            nome_arquivo = f"{camera_id}_{nome_sd}"
+        else:
+            # Salva arquivo com timestamp
+            nome_arquivo = datetime.now().strftime(f"{camera_id}_%Y%m%d_%H%M%S.jpg")
         caminho = os.path.join(diretorio_fotos, nome_arquivo)
         
         with open(caminho, "wb") as f:
             f.write(conteudo)
 
-        # Cria symlink para última imagem
+        # Cria symlink para última imagem (só foto ao vivo: reenvio é antiga)
         link_fixo = os.path.join(diretorio_fotos, "ultima.jpg")
-        try:
-            if os.path.exists(link_fixo):
-                os.remove(link_fixo)
-            os.symlink(os.path.abspath(caminho), link_fixo)
-        except Exception as e:
-            print(f"⚠️ Erro ao criar symlink: {e}")
-
-        # Limpeza de arquivos antigos
+        if nome_sd is None:
+            try:
+                if os.path.lexists(link_fixo):
+                    os.remove(link_fixo)
+                os.symlink(os.path.abspath(caminho), link_fixo)
+            except Exception as e:
+                print(f"⚠️ Erro ao criar symlink: {e}")
+
+        # Limpeza de arquivos antigos (mantém a foto para onde ultima.jpg aponta)
+        manter = {nome_arquivo, "ultima.jpg"}
+        if os.path.islink(link_fixo):
+            manter.add(os.path.basename(os.readlink(link_fixo)))
         for filename in os.listdir(diretorio_fotos):
-            if filename not in [os.path.basename(caminho), "ultima.jpg"]:
+            if filename not in manter:
                 file_path = os.path.join(diretorio_fotos, filename)
                 try:
                     if os.path.isfile(file_path):
@@ -333,7 +350,7 @@ def upload_foto():
 
         print("📷 IMAGEM RECEBIDA:")
         print(f"   📁 Câmera: {camera_id}")
-        print(f"   💾 Arquivo: {caminho}")
+        print(f"   💾 Arquivo: {caminho}" + (" (reenvio)" if nome_sd is not None else ""))
         print(f"   📏 Tamanho: {len(conteudo)} bytes")
         print(f"   🕒 Horário: {datetime.now().strftime('%Y-%m-%d %H%M%S')}")
 
@@ -414,12 +431,23 @@ def processar_dados_mqtt(topic, data):
         print(f"⚠️ Tópico desconhecido: {topic}")
         return
 
+    # Amostras escoadas da fila do nó chegam atrasadas: grava no instante da leitura
+    # (horário SNTP do nó; sem ele, estima pelo atraso na fila)
+    ts = data.get("ts")
+    atraso_ms = data.get("atraso_ms")
+    if ts is not None:
+        json_body[0]["time"] = int(ts) * 1000000
+    elif atraso_ms is not None:
+        json_body[0]["time"] = int((datetime.now().timestamp() * 1000 - float(atraso_ms)) * 1000000)
+
     client_influx.write_points(json_body)
     
     # PRINT DETALHADO DOS DADOS MQTT
     print(f"📡 DADO MQTT SALVO ({dispositivo}):")
     print(f"   📍 Tópico: {topic}")
     print(f"   🕒 Horário: {datetime.now().strftime('%Y-%m-%d %H%M%S')}")
+    if 'seq' in data:
+        print(f"   🔢 Seq: {data.get('seq')} boot {data.get('boot', 'N/A')} (fila no nó: {data.get('fila', 'N/A')}, atraso: {data.get('atraso_ms', 'N/A')} ms)")
 
     if 'temp' in data:
         print(f"   🌡️  Temperatura: {data.get('temp', 'N/A')}°C")
@@ -448,14 +476,36 @@ def processar_dados_mqtt(topic, data):
     
     print(f"   📊 Total de campos: {len(data)}")
 
+# Perdas, duplicatas e latência por nó (seq/boot/ts das amostras N01/N02)
+monitor_seq = MonitorSequencia()
+monitor_ultimo = [datetime.now()]
+
 def on_message(client, userdata, msg):
     """Callback para mensagens MQTT"""
     try:
-        data = json.loads(msg.payload.decode())
-        processar_dados_mqtt(msg.topic, data)
+        # Lote binário dos nós N01/N02: cada amostra segue o caminho do JSON
+        dispositivo, amostras = amostras_da_mensagem(msg.topic, msg.payload)
+        if msg.topic.endswith("/lote"):
+            print(f"📦 LOTE {msg.topic}: {len(amostras)} amostras, {len(msg.payload)} bytes")
+        for amostra in amostras:
+            # Reentrega QoS 1 ou reenvio após queda: já está no banco
+            if monitor_seq.duplicada(dispositivo, amostra):
+                print(f"🔁 Duplicata ignorada: {dispositivo} seq {amostra.get('seq')}")
+                continue
+            try:
+                processar_dados_mqtt(dispositivo, amostra)
+            except Exception as e:
+                # Não registra a seq: a reentrega desta amostra ainda é gravada
+                print(f"❌ Erro ao gravar {dispositivo} seq {amostra.get('seq')}: {e}")
+                continue
+            monitor_seq.registrar(dispositivo, amostra)
     except Exception as e:
         print(f"❌ Erro ao processar MQTT: {e}")
 
+    if (datetime.now() - monitor_ultimo[0]).total_seconds() >= 60:
+        monitor_seq.imprimir()
+        monitor_ultimo[0] = datetime.now()
+
 def start_mqtt():
     """Inicia cliente MQTT (modo legado)"""
     client_mqtt = mqtt.Client()
@@ -463,12 +513,15 @@ def start_mqtt():
     client_mqtt.connect("localhost", 1883, 60)
     client_mqtt.subscribe("estufa/germinar")
     client_mqtt.subscribe("estufa/maturar")
+    client_mqtt.subscribe("estufa/germinar/lote")
+    client_mqtt.subscribe("estufa/maturar/lote")
     client_mqtt.subscribe("estufa3/esp32")
 
     print("🔌 MQTT rodando (modo legado)")
     print("   👂 Aguardando mensagens nos tópicos:")
     print("      - estufa/germinar")
     print("      - estufa/maturar") 
+    print("      - estufa/germinar/lote, estufa/maturar/lote (binário)")
     print("      - estufa3/esp32")
     
     client_mqtt.loop_forever()
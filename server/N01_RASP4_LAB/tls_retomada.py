@@ -0,0 +1,92 @@
+"""
+Verificação da retomada de sessão TLS usada pelos nós N01/N02
+(client/N0x/main/conexoes/tls_sessao.h).
+
+Modo cliente: conecta várias vezes no broker oferecendo a sessão da
+conexão anterior e mostra se o servidor retomou e quanto custou cada
+handshake. Serve para conferir se o proxy WSS emite tickets:
+
+    python3 tls_retomada.py cliente --host mqtt.greense.com.br --port 443
+
+Modo servidor: aceita TLS, registra cada handshake (retomado ou não) e
+fecha. Apontando um nó para ele (MQTT_BROKER "ip:8443" e o certificado
+de teste no lugar de certs/greense_cert.pem), cada reconexão do esp-mqtt
+aparece aqui; a partir da segunda deve vir "retomado":
+
+    openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes \\
+        -keyout teste.key -out teste.pem -days 30 -subj "/CN=192.168.0.10" \\
+        -addext "subjectAltName=IP:192.168.0.10"
+    python3 tls_retomada.py servidor --port 8443 --cert teste.pem --key teste.key
+"""
+
+import argparse
+import socket
+import ssl
+import time
+
+
+def _ms(inicio):
+    return (time.perf_counter() - inicio) * 1000
+
+
+def cliente(host, port, vezes, cafile, tls12):
+    ctx = ssl.create_default_context(cafile=cafile)
+    if tls12:
+        # Os nós negociam TLS 1.2; no 1.3 o ticket só chega depois do handshake
+        ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    sessao = None
+    retomados = 0
+    for i in range(vezes):
+        inicio = time.perf_counter()
+        with socket.create_connection((host, port), timeout=10) as sock:
+            with ctx.wrap_socket(sock, server_hostname=host, session=sessao) as tls:
+                dt = _ms(inicio)
+                retomado = tls.session_reused
+                retomados += retomado
+                print(f"{i + 1:3d}: {tls.version()} {'retomado' if retomado else 'completo'} "
+                      f"em {dt:.0f} ms (ticket: {'sim' if tls.session.has_ticket else 'não'})")
+                sessao = tls.session
+    print(f"{retomados}/{vezes - 1} reconexões retomadas")
+    return retomados
+
+
+def servidor(port, cert, key, tls12):
+    ctx = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+    ctx.load_cert_chain(cert, key)
+    if tls12:
+        ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    with socket.create_server(("", port)) as srv:
+        print(f"Aguardando TLS na porta {port}")
+        while True:
+            sock, endereco = srv.accept()
+            inicio = time.perf_counter()
+            try:
+                with ctx.wrap_socket(sock, server_side=True) as tls:
+                    print(f"{time.strftime('%H:%M:%S')} {endereco[0]}: {tls.version()} "
+                          f"{'retomado' if tls.session_reused else 'completo'} em {_ms(inicio):.0f} ms")
+            except (ssl.SSLError, OSError) as e:
+                print(f"{time.strftime('%H:%M:%S')} {endereco[0]}: falha no handshake ({e})")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Retomada de sessão TLS (nós N01/N02)")
+    modos = parser.add_subparsers(dest="modo", required=True)
+
+    p = modos.add_parser("cliente")
+    p.add_argument("--host", default="mqtt.greense.com.br")
+    p.add_argument("--port", type=int, default=443)
+    p.add_argument("--vezes", type=int, default=5)
+    p.add_argument("--cafile", help="CA (ex.: certs/greense_cert.pem); padrão: do sistema")
+    p.add_argument("--tls13", action="store_true", help="permite TLS 1.3")
+
+    p = modos.add_parser("servidor")
+    p.add_argument("--port", type=int, default=8443)
+    p.add_argument("--cert", required=True)
+    p.add_argument("--key", required=True)
+    p.add_argument("--tls13", action="store_true", help="permite TLS 1.3")
+
+    args = parser.parse_args()
+    if args.modo == "cliente":
+        cliente(args.host, args.port, args.vezes, args.cafile, not args.tls13)
+    else:
+        servidor(args.port, args.cert, args.key, not args.tls13)